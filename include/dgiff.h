@@ -99,5 +99,22 @@ typedef struct {
      /* Raw pixel data follows, "height * pitch" bytes. */
 } DGIFFGlyphRow;
 
+/*
+ * Optional trailer of glyph caches written at runtime, following the last face.
+ *
+ * Identifies the font file and description the glyphs were rendered from.
+ */
+typedef struct {
+     unsigned char  magic[5];      /* "DGSRC" magic */
+
+     unsigned char  __pad[3];
+
+     uint32_t       description;   /* Hash of the font file name and description */
+     uint32_t       __pad2;
+
+     uint64_t       file_size;     /* Size of the font file */
+     int64_t        file_mtime;    /* Modification time of the font file */
+} DGIFFSourceInfo;
+
 #endif
 
@@ -1007,6 +1007,11 @@ typedef enum {
      DWCAPS_ALL          = 0x0000313F   /* All of these. */
 } DFBWindowCapabilities;
 
+/*
+ * Maximum number of regions passed to IDirectFBWindow::SetOpaqueRegions().
+ */
+#define DFB_WINDOW_OPAQUE_REGIONS_MAX        8
+
 /*
  * Flags controlling the appearance and behaviour of the window.
  */
@@ -6883,6 +6888,22 @@ D_DEFINE_INTERFACE(   IDirectFBWindow,
           DFBWindowHintFlags             clear,
           DFBWindowHintFlags             set
      );
+
+     /*
+      * Disable alpha channel blending for several regions of the window.
+      *
+      * Same as SetOpaqueRegion(), but with up to DFB_WINDOW_OPAQUE_REGIONS_MAX
+      * regions in window coordinates, e.g. for panels with translucent
+      * borders or gaps between opaque parts.
+      *
+      * The window manager can skip drawing anything hidden behind these
+      * regions. Regions outside of the window are ignored.
+      */
+     DFBResult (*SetOpaqueRegions) (
+          IDirectFBWindow               *thiz,
+          const DFBRegion               *regions,
+          unsigned int                   num_regions
+     );
 )
 
 
@@ -6895,6 +6916,19 @@ typedef DFBEnumerationResult (*DFBTextEncodingCallback) (
      void                *context
 );
 
+/*
+ * Flags controlling IDirectFBFont::Prerender().
+ */
+typedef enum {
+     DFPRF_NONE          = 0x00000000,  /* Render the glyphs before returning. */
+     DFPRF_ASYNC         = 0x00000001,  /* Render the glyphs in a background thread
+                                           and return immediately. */
+     DFPRF_OUTLINE       = 0x00000002,  /* Render the outline layer, too
+                                           (requires DFFA_OUTLINED). */
+
+     DFPRF_ALL           = 0x00000003   /* All of these. */
+} DFBFontPrerenderFlags;
+
 /*****************
  * IDirectFBFont *
  *****************/
@@ -7166,6 +7200,26 @@ D_DEFINE_INTERFACE(   IDirectFBFont,
           IDirectFBFont            *thiz,
           DFBFontDescription       *ret_description
      );
+
+
+   /** Resources **/
+
+     /*
+      * Render the glyphs of the characters in the text into the glyph cache.
+      *
+      * The text is interpreted using the encoding set via SetEncoding().
+      * If bytes is -1 the text is zero terminated.
+      *
+      * Drawing the characters later on doesn't need to wait for glyph
+      * rendering, e.g. when a new screen appears. With DFPRF_ASYNC the
+      * glyphs are rendered in a background thread.
+      */
+     DFBResult (*Prerender) (
+          IDirectFBFont            *thiz,
+          const void               *text,
+          int                       bytes,
+          DFBFontPrerenderFlags     flags
+     );
 )
 
 /*
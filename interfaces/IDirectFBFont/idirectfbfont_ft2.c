@@ -37,6 +37,12 @@
 #include <unistd.h>
 #include <stdarg.h>
 #include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
 
 #include <directfb.h>
 
@@ -49,15 +55,19 @@
 
 #include <media/idirectfbfont.h>
 
+#include <direct/hash.h>
 #include <direct/mem.h>
 #include <direct/memcpy.h>
 #include <direct/messages.h>
+#include <direct/print.h>
 #include <direct/utf8.h>
 #include <direct/util.h>
 
 #include <misc/conf.h>
 #include <misc/util.h>
 
+#include <dgiff.h>
+
 #undef SIZEOF_LONG
 #include <ft2build.h>
 #include FT_GLYPH_H
@@ -93,20 +103,46 @@ static FT_Library      library           = NULL;
 static int             library_ref_count = 0;
 static pthread_mutex_t library_mutex     = PTHREAD_MUTEX_INITIALIZER;
 
-#define KERNING_CACHE_MIN    0
-#define KERNING_CACHE_MAX  127
-#define KERNING_CACHE_SIZE (KERNING_CACHE_MAX - KERNING_CACHE_MIN + 1)
-
-#define KERNING_DO_CACHE(a,b)      ((a) >= KERNING_CACHE_MIN && \
-                                    (a) <= KERNING_CACHE_MAX && \
-                                    (b) >= KERNING_CACHE_MIN && \
-                                    (b) <= KERNING_CACHE_MAX)
+#define KERNING_CACHE_SIZE  2048      /* character pairs, power of two */
 
 #define KERNING_CACHE_ENTRY(a,b)   \
-     (data->kerning[(a)-KERNING_CACHE_MIN][(b)-KERNING_CACHE_MIN])
+     (data->kerning[((a) * 2654435761u ^ (b)) & (KERNING_CACHE_SIZE - 1)])
+
+#define GLYPH_CACHE_SIZE    1024      /* glyph metrics, power of two */
+
+#define GLYPH_CACHE_ENTRY(index)   \
+     (data->glyphs[((index) * 2654435761u >> 8) & (GLYPH_CACHE_SIZE - 1)])
 
 #define CHAR_INDEX(c)    (((c) < 256) ? data->indices[c] : FT_Get_Char_Index( data->face, c ))
 
+/*
+ * Metrics of a loaded glyph, so loading it again only needs to render it.
+ */
+typedef struct {
+     bool         initialised;
+     unsigned int index;
+     int          width;
+     int          height;
+     int          xadvance;
+     int          yadvance;
+} GlyphCacheEntry;
+
+/*
+ * Glyph cache file in DGIFF format, see 'font-cache-dir'.
+ */
+typedef struct {
+     char             *path;
+     DGIFFSourceInfo   source;
+
+     void             *map;          /* memory map of the file if it matched */
+     size_t            size;
+     DGIFFFaceHeader  *face;
+     DGIFFGlyphRow   **rows;
+     DirectHash       *glyphs;       /* glyph index -> DGIFFGlyphInfo */
+
+     DirectHash       *rendered;     /* indices of glyphs FreeType rendered successfully since loading */
+} FT2CacheFile;
+
 typedef struct {
      FT_Face      face;
      int          disable_charmap;
@@ -117,18 +153,27 @@ typedef struct {
      int          outline_opacity;
      float        up_unit_x;     /* unit vector pointing 'up' in for */
      float        up_unit_y;     /* this font's rotation             */
+
+     bool         slot_valid;    /* glyph slot of the face holds the */
+     unsigned int slot_index;    /* rendered glyph with this index   */
+
+     GlyphCacheEntry glyphs[GLYPH_CACHE_SIZE];
+
+     FT2CacheFile   *cache_file;
 } FT2ImplData;
 
 typedef struct {
-     bool        initialised;
-     signed char x;
-     signed char y;
+     bool         initialised;
+     unsigned int prev;
+     unsigned int current;
+     short        x;
+     short        y;
 } KerningCacheEntry;
 
 typedef struct {
      FT2ImplData base;
 
-     KerningCacheEntry kerning[KERNING_CACHE_SIZE][KERNING_CACHE_SIZE];
+     KerningCacheEntry kerning[KERNING_CACHE_SIZE];
 } FT2ImplKerningData;
 
 /**********************************************************************************************************************/
@@ -259,6 +304,57 @@ static const CoreFontEncodingFuncs ft2Latin1Funcs = {
 
 /**********************************************************************************************************************/
 
+static inline const DGIFFGlyphInfo *
+cache_file_lookup( const FT2ImplData *data,
+                   unsigned int       index )
+{
+     if (!data->cache_file || !data->cache_file->glyphs)
+          return NULL;
+
+     return direct_hash_lookup( data->cache_file->glyphs, index );
+}
+
+/*
+ * Remembers a glyph FreeType rendered successfully, only those are written to the cache file.
+ */
+static void
+cache_file_add_rendered( FT2ImplData  *data,
+                         unsigned int  index )
+{
+     FT2CacheFile *file = data->cache_file;
+
+     if (!file->rendered && direct_hash_create( 1023, &file->rendered ))
+          return;
+
+     if (!direct_hash_lookup( file->rendered, index ))
+          direct_hash_insert( file->rendered, index, (void*) 1 );
+}
+
+static DFBResult
+render_cached_glyph( CoreFont             *thiz,
+                     const DGIFFGlyphInfo *glyph,
+                     CoreGlyphData        *info )
+{
+     FT2ImplData         *data    = thiz->impl_data;
+     CoreSurface         *surface = info->surface;
+     const DGIFFGlyphRow *row     = data->cache_file->rows[glyph->row];
+     DFBRectangle         rect;
+
+     rect.x = info->start;
+     rect.y = info->start_y;
+     rect.w = MIN( glyph->width,  surface->config.size.w - info->start );
+     rect.h = MIN( glyph->height, surface->config.size.h - info->start_y );
+
+     info->width  = rect.w;
+     info->height = rect.h;
+     info->left   = glyph->left;
+     info->top    = glyph->top;
+
+     return dfb_surface_write_buffer( surface, CSBR_BACK,
+                                      (const u8*) (row + 1) + DFB_BYTES_PER_LINE( surface->config.format, glyph->offset ),
+                                      row->pitch, &rect );
+}
+
 static DFBResult
 render_glyph( CoreFont      *thiz,
               unsigned int   index,
@@ -273,20 +369,40 @@ render_glyph( CoreFont      *thiz,
      CoreSurface *surface = info->surface;
      CoreSurfaceBufferLock  lock;
 
-     pthread_mutex_lock ( &library_mutex );
-
      face = data->face;
 
-     load_flags = (unsigned long) face->generic.data;
-     load_flags |= FT_LOAD_RENDER;
+     /* Copy the glyph from the cache file instead of rendering it. */
+     if (info->layer == 0) {
+          const DGIFFGlyphInfo *glyph = cache_file_lookup( data, index );
 
-     if ((err = FT_Load_Glyph( face, index, load_flags ))) {
-          D_DEBUG( "DirectFB/FontFT2: Could not render glyph for character index #%d!\n", index );
-          pthread_mutex_unlock ( &library_mutex );
-          return DFB_FAILURE;
+          if (glyph)
+               return render_cached_glyph( thiz, glyph, info );
+
+          /* Forget an earlier success in case rendering fails this time. */
+          if (data->cache_file && data->cache_file->rendered)
+               direct_hash_remove( data->cache_file->rendered, index );
      }
 
-     pthread_mutex_unlock ( &library_mutex );
+     /* The glyph is usually still in the slot after get_glyph_info(). */
+     if (!data->slot_valid || data->slot_index != index) {
+          pthread_mutex_lock ( &library_mutex );
+
+          load_flags = (unsigned long) face->generic.data;
+          load_flags |= FT_LOAD_RENDER;
+
+          data->slot_valid = false;
+
+          if ((err = FT_Load_Glyph( face, index, load_flags ))) {
+               D_DEBUG( "DirectFB/FontFT2: Could not render glyph for character index #%d!\n", index );
+               pthread_mutex_unlock ( &library_mutex );
+               return DFB_FAILURE;
+          }
+
+          data->slot_valid = true;
+          data->slot_index = index;
+
+          pthread_mutex_unlock ( &library_mutex );
+     }
 
      err = dfb_surface_lock_buffer( surface, CSBR_BACK, CSAID_CPU, CSAF_WRITE, &lock );
      if (err) {
@@ -299,8 +415,8 @@ render_glyph( CoreFont      *thiz,
           info->width = surface->config.size.w - info->start;
 
      info->height = face->glyph->bitmap.rows;
-     if (info->height > surface->config.size.h)
-          info->height = surface->config.size.h;
+     if (info->height + info->start_y > surface->config.size.h)
+          info->height = surface->config.size.h - info->start_y;
 
      /* bitmap_left and bitmap_top are relative to the glyph's origin on the
         baseline.  info->left and info->top are relative to the top-left of the
@@ -358,7 +474,7 @@ render_glyph( CoreFont      *thiz,
           info->top    -= (radius - 1) / 2;
 
           if (blurred) {
-               addr = lock.addr + DFB_BYTES_PER_LINE(surface->config.format, info->start);
+               addr = lock.addr + DFB_BYTES_PER_LINE(surface->config.format, info->start) + info->start_y * lock.pitch;
                src  = blurred;
 
                for (y=0; y < info->height; y++) {
@@ -419,7 +535,7 @@ render_glyph( CoreFont      *thiz,
           }
 
           src = face->glyph->bitmap.buffer;
-          lock.addr += DFB_BYTES_PER_LINE(surface->config.format, info->start);
+          lock.addr += DFB_BYTES_PER_LINE(surface->config.format, info->start) + info->start_y * lock.pitch;
 
           for (y=0; y < info->height; y++) {
                int  i, j, n;
@@ -670,6 +786,9 @@ render_glyph( CoreFont      *thiz,
 
      dfb_surface_unlock_buffer( surface, &lock );
 
+     if (info->layer == 0 && data->cache_file)
+          cache_file_add_rendered( data, index );
+
      return DFB_OK;
 }
 
@@ -679,51 +798,72 @@ get_glyph_info( CoreFont      *thiz,
                 unsigned int   index,
                 CoreGlyphData *info )
 {
-     FT_Error err;
-     FT_Face  face;
-     FT_Int   load_flags;
-     FT2ImplData *data = (FT2ImplData*) thiz->impl_data;
+     FT_Error         err;
+     FT_Face          face;
+     FT_Int           load_flags;
+     FT2ImplData     *data  = (FT2ImplData*) thiz->impl_data;
+     GlyphCacheEntry *cache = &GLYPH_CACHE_ENTRY( index );
+
+     if (!cache->initialised || cache->index != index) {
+          const DGIFFGlyphInfo *glyph = cache_file_lookup( data, index );
+
+          if (glyph) {
+               /* Metrics of the glyph from the cache file. */
+               cache->width    = glyph->width;
+               cache->height   = glyph->height;
+               cache->xadvance = glyph->advance << 8;
+               cache->yadvance = 0;
+          }
+          else {
+               pthread_mutex_lock ( &library_mutex );
 
-     pthread_mutex_lock ( &library_mutex );
+               face = data->face;
 
-     face = data->face;
+               /* Load the glyph like render_glyph() would, so it can use the slot right away. */
+               load_flags = (unsigned long) face->generic.data;
+               load_flags |= FT_LOAD_RENDER;
 
-     load_flags = (unsigned long) face->generic.data;
+               data->slot_valid = false;
 
-     if ((err = FT_Load_Glyph( face, index, load_flags ))) {
-          D_DEBUG( "DirectFB/FontFT2: Could not load glyph for character index #%d!\n", index );
+               if ((err = FT_Load_Glyph( face, index, load_flags ))) {
+                    D_DEBUG( "DirectFB/FontFT2: Could not load glyph for character index #%d!\n", index );
 
-          pthread_mutex_unlock ( &library_mutex );
+                    pthread_mutex_unlock ( &library_mutex );
 
-          return DFB_FAILURE;
-     }
+                    return DFB_FAILURE;
+               }
 
-     if (face->glyph->format != ft_glyph_format_bitmap) {
-          err = FT_Render_Glyph( face->glyph,
-                                 (load_flags & FT_LOAD_TARGET_MONO) ? ft_render_mode_mono : ft_render_mode_normal );
-          if (err) {
-               D_ERROR( "DirectFB/FontFT2: Could not render glyph for character index #%d!\n", index );
+               data->slot_valid = true;
+               data->slot_index = index;
 
                pthread_mutex_unlock ( &library_mutex );
 
-               return DFB_FAILURE;
-          }
-     }
+               cache->width  = face->glyph->bitmap.width;
+               cache->height = face->glyph->bitmap.rows;
 
-     pthread_mutex_unlock ( &library_mutex );
+               /* Empty glyphs are never passed to render_glyph(). */
+               if (info->layer == 0 && data->cache_file && (!cache->width || !cache->height))
+                    cache_file_add_rendered( data, index );
 
-     info->width   = face->glyph->bitmap.width;
-     info->height  = face->glyph->bitmap.rows;
+               if (data->fixed_advance) {
+                    cache->xadvance = - data->fixed_advance * thiz->up_unit_y;
+                    cache->yadvance =   data->fixed_advance * thiz->up_unit_x;
+               }
+               else {
+                    cache->xadvance =   face->glyph->advance.x << 2;
+                    cache->yadvance = - face->glyph->advance.y << 2;
+               }
+          }
 
-     if (data->fixed_advance) {
-          info->xadvance = - data->fixed_advance * thiz->up_unit_y;
-          info->yadvance =   data->fixed_advance * thiz->up_unit_x;
-     }
-     else {
-          info->xadvance =   face->glyph->advance.x << 2;
-          info->yadvance = - face->glyph->advance.y << 2;
+          cache->initialised = true;
+          cache->index       = index;
      }
 
+     info->width    = cache->width;
+     info->height   = cache->height;
+     info->xadvance = cache->xadvance;
+     info->yadvance = cache->yadvance;
+
      if (data->fixed_clip && info->width > data->fixed_advance)
           info->width = data->fixed_advance;
 
@@ -743,63 +883,661 @@ get_kerning( CoreFont     *thiz,
              int          *kern_x,
              int          *kern_y)
 {
-     FT_Vector vector;
-
-     FT2ImplKerningData *data = thiz->impl_data;
-     KerningCacheEntry *cache = NULL;
+     FT2ImplKerningData *data  = thiz->impl_data;
+     KerningCacheEntry  *cache = &KERNING_CACHE_ENTRY( prev, current );
 
      D_ASSUME( (kern_x != NULL) || (kern_y != NULL) );
 
      /*
-      * Use cached values if characters are in the
-      * cachable range and the cache entry is already filled.
+      * Look up the pair in the cache, replacing the entry on a miss.
       */
-     if (KERNING_DO_CACHE (prev, current)) {
-          cache = &KERNING_CACHE_ENTRY (prev, current);
+     if (!cache->initialised || cache->prev != prev || cache->current != current) {
+          FT_Vector vector;
 
-          if (!cache->initialised && FT_HAS_KERNING(data->base.face)) {
-               FT_Vector vector;
+          pthread_mutex_lock ( &library_mutex );
 
-               pthread_mutex_lock ( &library_mutex );
+          /* Lookup kerning values for the character pair. */
+          /* The vector returned by FreeType does not allow for any rotation. */
+          FT_Get_Kerning( data->base.face,
+                          prev, current, ft_kerning_default, &vector );
+
+          pthread_mutex_unlock ( &library_mutex );
+
+          /* Convert to integer. */
+          cache->x = (int)(- vector.x*thiz->up_unit_y + vector.y*thiz->up_unit_x) >> 6;
+          cache->y = (int)(  vector.y*thiz->up_unit_y + vector.x*thiz->up_unit_x) >> 6;
+
+          cache->prev        = prev;
+          cache->current     = current;
+          cache->initialised = true;
+     }
 
-               /* Lookup kerning values for the character pair. */
-               FT_Get_Kerning( data->base.face,
-                               prev, current, ft_kerning_default, &vector );
+     if (kern_x)
+          *kern_x = cache->x;
 
-               cache->x = (signed char) ((int)(- vector.x*data->base.up_unit_x + vector.y*data->base.up_unit_x) >> 6);
-               cache->y = (signed char) ((int)(  vector.y*data->base.up_unit_y + vector.x*data->base.up_unit_x) >> 6);
+     if (kern_y)
+          *kern_y = cache->y;
 
-               cache->initialised = true;
+     return DFB_OK;
+}
 
+/**********************************************************************************************************************/
+
+/*
+ * Identifies the font file and the parts of the description affecting rendered glyphs.
+ */
+static u32
+cache_file_hash( const char               *filename,
+                 const DFBFontDescription *desc,
+                 FT_Int                    load_flags,
+                 const CoreFont           *font )
+{
+     int  i;
+     u32  hash = 2166136261u;
+     struct {
+          DFBFontDescriptionFlags flags;
+          DFBFontAttributes       attributes;
+          int                     height;
+          int                     width;
+          unsigned int            index;
+          int                     fixed_advance;
+          int                     fract_height;
+          int                     fract_width;
+          int                     outline_width;
+          int                     outline_opacity;
+          int                     load_flags;
+          DFBSurfacePixelFormat   format;
+          DFBSurfaceCapabilities  caps;
+     } key;
+
+     memset( &key, 0, sizeof(key) );
+
+     key.flags      = desc->flags;
+     key.load_flags = load_flags;
+     key.format     = font->pixel_format;
+     key.caps       = font->surface_caps;
+
+     if (desc->flags & DFDESC_ATTRIBUTES)      key.attributes      = desc->attributes;
+     if (desc->flags & DFDESC_HEIGHT)          key.height          = desc->height;
+     if (desc->flags & DFDESC_WIDTH)           key.width           = desc->width;
+     if (desc->flags & DFDESC_INDEX)           key.index           = desc->index;
+     if (desc->flags & DFDESC_FIXEDADVANCE)    key.fixed_advance   = desc->fixed_advance;
+     if (desc->flags & DFDESC_FRACT_HEIGHT)    key.fract_height    = desc->fract_height;
+     if (desc->flags & DFDESC_FRACT_WIDTH)     key.fract_width     = desc->fract_width;
+     if (desc->flags & DFDESC_OUTLINE_WIDTH)   key.outline_width   = desc->outline_width;
+     if (desc->flags & DFDESC_OUTLINE_OPACITY) key.outline_opacity = desc->outline_opacity;
+
+     for (i=0; filename[i]; i++)
+          hash = (hash ^ (u8) filename[i]) * 16777619u;
+
+     for (i=0; i<sizeof(key); i++)
+          hash = (hash ^ ((const u8*) &key)[i]) * 16777619u;
+
+     return hash;
+}
+
+/*
+ * Maps the file if it was written for the same font file and description, checking its layout.
+ */
+static void
+cache_file_load( FT2CacheFile *file,
+                 FT2ImplData  *data,
+                 CoreFont     *font )
+{
+     int                    i;
+     int                    fd;
+     struct stat            st;
+     void                  *map;
+     void                  *end;
+     const DGIFFHeader     *header;
+     const DGIFFSourceInfo *source;
+     DGIFFFaceHeader       *face;
+     DGIFFGlyphInfo        *glyphs;
+     DGIFFGlyphRow         *row;
+
+     fd = open( file->path, O_RDONLY );
+     if (fd < 0)
+          return;
+
+     if (fstat( fd, &st ) < 0 ||
+         st.st_size < sizeof(DGIFFHeader) + sizeof(DGIFFFaceHeader) + sizeof(DGIFFSourceInfo)) {
+          close( fd );
+          return;
+     }
+
+     map = mmap( NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+
+     close( fd );
+
+     if (map == MAP_FAILED) {
+          D_PERROR( "DirectFB/FontFT2: Failure during mmap() of '%s'!\n", file->path );
+          return;
+     }
+
+     file->map  = map;
+     file->size = st.st_size;
+
+     header = map;
+     source = map + st.st_size - sizeof(DGIFFSourceInfo);
+     face   = map + sizeof(DGIFFHeader);
+     glyphs = (void*)(face + 1);
+     end    = (void*) source;
+
+     if (strncmp( (const char*) header->magic, "DGIFF", 5 ) || header->num_faces != 1 ||
+#ifdef WORDS_BIGENDIAN
+         (header->flags & DGIFF_FLAG_LITTLE_ENDIAN) ||
+#else
+         !(header->flags & DGIFF_FLAG_LITTLE_ENDIAN) ||
+#endif
+         strncmp( (const char*) source->magic, "DGSRC", 5 ) ||
+         source->description != file->source.description ||
+         source->file_size   != file->source.file_size ||
+         source->file_mtime  != file->source.file_mtime)
+     {
+          D_DEBUG( "DirectFB/FontFT2: Glyph cache '%s' is outdated.\n", file->path );
+          goto error;
+     }
+
+     if (face->pixelformat != font->pixel_format || face->num_rows < 1 ||
+         face->num_glyphs > (end - (void*) glyphs) / sizeof(DGIFFGlyphInfo))
+          goto error;
+
+     file->rows = D_CALLOC( face->num_rows, sizeof(DGIFFGlyphRow*) );
+     if (!file->rows) {
+          D_OOM();
+          goto error;
+     }
+
+     row = (void*)(glyphs + face->num_glyphs);
+
+     for (i=0; i<face->num_rows; i++) {
+          if ((void*)(row + 1) > end || row->width < 1 || row->height < 1 || row->pitch < 1 ||
+              row->pitch < DFB_BYTES_PER_LINE( face->pixelformat, row->width ) ||
+              (size_t) row->pitch * row->height > end - (void*)(row + 1))
+               goto error;
+
+          file->rows[i] = row;
+
+          row = (void*)(row + 1) + row->pitch * row->height;
+     }
+
+     if (direct_hash_create( face->num_glyphs * 2 + 17, &file->glyphs ))
+          goto error;
+
+     for (i=0; i<face->num_glyphs; i++) {
+          DGIFFGlyphInfo *glyph = &glyphs[i];
+          unsigned int    index = glyph->unicode;
+
+          if (glyph->row >= face->num_rows || glyph->width < 0 || glyph->height < 0 ||
+              glyph->offset < 0 || glyph->offset + glyph->width > file->rows[glyph->row]->width ||
+              glyph->height > file->rows[glyph->row]->height)
+               goto error;
+
+          if (!data->disable_charmap) {
+               pthread_mutex_lock ( &library_mutex );
+               index = FT_Get_Char_Index( data->face, glyph->unicode );
                pthread_mutex_unlock ( &library_mutex );
+
+               if (!index)
+                    continue;
           }
 
-          if (kern_x)
-               *kern_x = (int) cache->x;
+          direct_hash_insert( file->glyphs, index, glyph );
+     }
+
+     file->face = face;
+
+     D_DEBUG( "DirectFB/FontFT2: Using %d glyphs from '%s'.\n", face->num_glyphs, file->path );
+
+     return;
+
+
+error:
+     if (file->glyphs) {
+          direct_hash_destroy( file->glyphs );
+          file->glyphs = NULL;
+     }
+
+     if (file->rows) {
+          D_FREE( file->rows );
+          file->rows = NULL;
+     }
+
+     munmap( file->map, file->size );
+
+     file->map  = NULL;
+     file->size = 0;
+}
+
+static void
+cache_file_open( FT2ImplData              *data,
+                 CoreFont                 *font,
+                 const char               *filename,
+                 const DFBFontDescription *desc,
+                 FT_Int                    load_flags )
+{
+     int           len;
+     struct stat   st;
+     const char   *base;
+     FT2CacheFile *file;
+
+     if (stat( filename, &st ) < 0)
+          return;
+
+     file = D_CALLOC( 1, sizeof(FT2CacheFile) );
+     if (!file) {
+          D_OOM();
+          return;
+     }
+
+     memcpy( file->source.magic, "DGSRC", 5 );
+
+     file->source.description = cache_file_hash( filename, desc, load_flags, font );
+     file->source.file_size   = st.st_size;
+     file->source.file_mtime  = st.st_mtime;
+
+     base = strrchr( filename, '/' );
+     base = base ? base + 1 : filename;
 
-          if (kern_y)
-               *kern_y = (int) cache->y;
+     len = strlen( dfb_config->font_cache_dir ) + strlen( base ) + 16;
 
+     file->path = D_MALLOC( len );
+     if (!file->path) {
+          D_OOM();
+          D_FREE( file );
+          return;
+     }
+
+     direct_snprintf( file->path, len, "%s/%s-%08x", dfb_config->font_cache_dir, base, file->source.description );
+
+     cache_file_load( file, data, font );
+
+     data->cache_file = file;
+}
+
+/**********************************************************************************************************************/
+
+typedef struct {
+     unsigned int          index;
+     const CoreGlyphData  *data;      /* rendered glyph or */
+     const DGIFFGlyphInfo *cached;    /* glyph from the loaded file */
+     DGIFFGlyphInfo        info;
+} CacheFileGlyph;
+
+typedef struct {
+     FT2CacheFile   *file;
+     DirectHash     *codes;     /* glyph index -> character code + 1 */
+     DirectHash     *added;     /* glyph indices of rendered glyphs  */
+     bool            raw;       /* glyph indices used as character codes */
+     CacheFileGlyph *glyphs;
+     int             num;
+     int             max;
+} CacheFileContext;
+
+static bool
+cache_file_add_glyph( CacheFileContext     *ctx,
+                      unsigned int          index,
+                      const CoreGlyphData  *data,
+                      const DGIFFGlyphInfo *cached )
+{
+     unsigned long   code = ctx->raw ? index + 1 : (unsigned long) direct_hash_lookup( ctx->codes, index );
+     CacheFileGlyph *glyph;
+
+     if (!code || ctx->num == ctx->max)
+          return false;
+
+     glyph = &ctx->glyphs[ctx->num++];
+
+     glyph->index  = index;
+     glyph->data   = data;
+     glyph->cached = cached;
+
+     if (cached) {
+          glyph->info = *cached;
+     }
+     else {
+          memset( &glyph->info, 0, sizeof(glyph->info) );
+
+          glyph->info.width   = data->width;
+          glyph->info.height  = data->height;
+          glyph->info.left    = data->left;
+          glyph->info.top     = data->top;
+          glyph->info.advance = data->xadvance >> 8;
+     }
+
+     glyph->info.unicode = code - 1;
+
+     return true;
+}
+
+static bool
+cache_file_collect_rendered( DirectHash    *hash,
+                             unsigned long  key,
+                             void          *value,
+                             void          *ctx )
+{
+     CacheFileContext    *context = ctx;
+     const CoreGlyphData *data    = value;
+
+     D_MAGIC_ASSERT( data, CoreGlyphData );
+
+     /* Skip glyphs which failed or came from the file, and those with advances not in whole pixels. */
+     if (!direct_hash_lookup( context->file->rendered, key ))
+          return true;
+
+     if (data->retry || data->yadvance || (data->xadvance & 0xff) || (data->width && !data->surface))
+          return true;
+
+     cache_file_add_glyph( ctx, key, data, NULL );
+
+     return true;
+}
+
+static bool
+cache_file_collect_cached( DirectHash    *hash,
+                           unsigned long  key,
+                           void          *value,
+                           void          *ctx )
+{
+     CacheFileContext *context = ctx;
+
+     /* Keep glyphs evicted from the glyph cache since loading. */
+     if (!direct_hash_lookup( context->added, key ))
+          cache_file_add_glyph( context, key, NULL, value );
+
+     return true;
+}
+
+/*
+ * Writes the glyphs rendered so far and those of the loaded file to a new cache file.
+ */
+static DFBResult
+cache_file_save( FT2ImplData *data,
+                 CoreFont    *font )
+{
+     DFBResult         ret = DFB_OK;
+     int               i;
+     int               num_rows = 0;
+     int               offset   = 0;
+     int               align    = DFB_PIXELFORMAT_ALIGNMENT( font->pixel_format );
+     int               next_face;
+     int               len;
+     int               fd;
+     char             *tmp;
+     FILE             *f;
+     FT_ULong          code;
+     FT_UInt           index;
+     FT2CacheFile     *file     = data->cache_file;
+     DGIFFHeader       header   = { { 'D', 'G', 'I', 'F', 'F' }, 0, 0, 0, 1, 0 };
+     DGIFFFaceHeader   face;
+     DGIFFGlyphRow    *rows     = NULL;
+     u8              **row_data = NULL;
+     CacheFileContext  ctx;
+
+     memset( &ctx, 0, sizeof(ctx) );
+
+     ctx.file = file;
+     ctx.max  = direct_hash_count( font->layers[0].glyph_hash ) + (file->face ? file->face->num_glyphs : 0);
+
+     if (!ctx.max)
           return DFB_OK;
+
+     ctx.glyphs = D_CALLOC( ctx.max, sizeof(CacheFileGlyph) );
+     if (!ctx.glyphs)
+          return D_OOM();
+
+     if (direct_hash_create( 1023, &ctx.codes ) || direct_hash_create( ctx.max * 2 + 17, &ctx.added )) {
+          ret = DFB_NOSYSTEMMEMORY;
+          goto out;
      }
 
-     pthread_mutex_lock ( &library_mutex );
+     /* Map glyph indices back to character codes. */
+     ctx.raw = data->disable_charmap;
 
-     /* Lookup kerning values for the character pair. */
-     /* The vector returned by FreeType does not allow for any rotation. */
-     FT_Get_Kerning( data->base.face,
-                     prev, current, ft_kerning_default, &vector );
+     if (!ctx.raw) {
+          pthread_mutex_lock ( &library_mutex );
 
-     pthread_mutex_unlock ( &library_mutex );
+          for (code = FT_Get_First_Char( data->face, &index ); index; code = FT_Get_Next_Char( data->face, code, &index )) {
+               if (!direct_hash_lookup( ctx.codes, index ))
+                    direct_hash_insert( ctx.codes, index, (void*)(unsigned long)(code + 1) );
+          }
 
-     /* Convert to integer. */
-     if (kern_x)
-          *kern_x = (int)(- vector.x*thiz->up_unit_y + vector.y*thiz->up_unit_x) >> 6;
+          pthread_mutex_unlock ( &library_mutex );
+     }
 
-     if (kern_y)
-          *kern_y = (int)(  vector.y*thiz->up_unit_y + vector.x*thiz->up_unit_x) >> 6;
+     dfb_font_lock( font );
 
-     return DFB_OK;
+     direct_hash_iterate( font->layers[0].glyph_hash, cache_file_collect_rendered, &ctx );
+
+     for (i=0; i<ctx.num; i++)
+          direct_hash_insert( ctx.added, ctx.glyphs[i].index, &ctx.glyphs[i] );
+
+     if (file->glyphs)
+          direct_hash_iterate( file->glyphs, cache_file_collect_cached, &ctx );
+
+     /* Pack the glyphs into rows. */
+     rows     = D_CALLOC( ctx.num + 1, sizeof(DGIFFGlyphRow) );
+     row_data = D_CALLOC( ctx.num + 1, sizeof(u8*) );
+     if (!rows || !row_data) {
+          ret = D_OOM();
+          goto out_unlock;
+     }
+
+     for (i=0; i<ctx.num; i++) {
+          DGIFFGlyphInfo *glyph = &ctx.glyphs[i].info;
+
+          if (!glyph->width || !glyph->height) {
+               glyph->row    = 0;
+               glyph->offset = 0;
+               continue;
+          }
+
+          if (!num_rows || offset + glyph->width > dfb_config->max_font_row_width) {
+               num_rows++;
+               offset = 0;
+          }
+
+          glyph->row    = num_rows - 1;
+          glyph->offset = offset;
+
+          offset += (glyph->width + align) & ~align;
+
+          rows[glyph->row].width = offset;
+
+          if (rows[glyph->row].height < glyph->height)
+               rows[glyph->row].height = glyph->height;
+     }
+
+     if (!num_rows)
+          goto out_unlock;
+
+     next_face = sizeof(DGIFFFaceHeader) + ctx.num * sizeof(DGIFFGlyphInfo) + num_rows * sizeof(DGIFFGlyphRow);
+
+     for (i=0; i<num_rows; i++) {
+          rows[i].pitch = (DFB_BYTES_PER_LINE( font->pixel_format, rows[i].width ) + 7) & ~7;
+
+          row_data[i] = D_CALLOC( rows[i].height, rows[i].pitch );
+          if (!row_data[i]) {
+               ret = D_OOM();
+               goto out_unlock;
+          }
+
+          next_face += rows[i].height * rows[i].pitch;
+     }
+
+     /* Copy the pixels from the glyph cache surfaces or the loaded file. */
+     for (i=0; i<ctx.num; i++) {
+          CacheFileGlyph *glyph = &ctx.glyphs[i];
+          DGIFFGlyphRow  *row   = &rows[glyph->info.row];
+          u8             *dst   = row_data[glyph->info.row] + DFB_BYTES_PER_LINE( font->pixel_format, glyph->info.offset );
+
+          if (!glyph->info.width || !glyph->info.height)
+               continue;
+
+          if (glyph->data) {
+               DFBRectangle rect = { glyph->data->start, glyph->data->start_y, glyph->data->width, glyph->data->height };
+
+               dfb_surface_read_buffer( glyph->data->surface, CSBR_BACK, dst, row->pitch, &rect );
+          }
+          else {
+               int                  y;
+               const DGIFFGlyphRow *src_row = file->rows[glyph->cached->row];
+               const u8            *src     = (const u8*)(src_row + 1) +
+                                              DFB_BYTES_PER_LINE( font->pixel_format, glyph->cached->offset );
+
+               for (y=0; y<glyph->info.height; y++) {
+                    direct_memcpy( dst, src, DFB_BYTES_PER_LINE( font->pixel_format, glyph->info.width ) );
+
+                    src += src_row->pitch;
+                    dst += row->pitch;
+               }
+          }
+     }
+
+     dfb_font_unlock( font );
+
+     /* Write to a temporary file, replacing the cache at once. */
+     memset( &face, 0, sizeof(face) );
+
+     face.next_face     = next_face;
+     face.size          = (font->description.flags & DFDESC_HEIGHT) ? font->description.height : font->height;
+     face.ascender      = font->ascender;
+     face.descender     = font->descender;
+     face.height        = font->height;
+     face.max_advance   = font->maxadvance;
+     face.pixelformat   = font->pixel_format;
+     face.num_glyphs    = ctx.num;
+     face.num_rows      = num_rows;
+     face.blittingflags = font->blittingflags;
+
+#ifndef WORDS_BIGENDIAN
+     header.flags = DGIFF_FLAG_LITTLE_ENDIAN;
+#endif
+
+     len = strlen( file->path ) + 8;
+
+     tmp = D_MALLOC( len );
+     if (!tmp) {
+          ret = D_OOM();
+          goto out;
+     }
+
+     /* Unique name, another process may be saving the same cache. */
+     direct_snprintf( tmp, len, "%s.XXXXXX", file->path );
+
+     fd = mkstemp( tmp );
+     if (fd < 0) {
+          ret = errno2result( errno );
+          D_PERROR( "DirectFB/FontFT2: Could not create glyph cache '%s'!\n", tmp );
+          D_FREE( tmp );
+          goto out;
+     }
+
+     fchmod( fd, 0644 );
+
+     f = fdopen( fd, "w" );
+     if (!f) {
+          ret = errno2result( errno );
+          D_PERROR( "DirectFB/FontFT2: Could not open glyph cache '%s'!\n", tmp );
+          close( fd );
+          unlink( tmp );
+          D_FREE( tmp );
+          goto out;
+     }
+
+     fwrite( &header, sizeof(header), 1, f );
+     fwrite( &face, sizeof(face), 1, f );
+
+     for (i=0; i<ctx.num; i++)
+          fwrite( &ctx.glyphs[i].info, sizeof(DGIFFGlyphInfo), 1, f );
+
+     for (i=0; i<num_rows; i++) {
+          fwrite( &rows[i], sizeof(DGIFFGlyphRow), 1, f );
+          fwrite( row_data[i], rows[i].pitch, rows[i].height, f );
+     }
+
+     fwrite( &file->source, sizeof(DGIFFSourceInfo), 1, f );
+
+     /* Make sure the data is on disk before the file gets published. */
+     if (fflush( f ) || ferror( f ) || fsync( fd ))
+          ret = DFB_IO;
+
+     if (fclose( f ))
+          ret = DFB_IO;
+
+     if (ret) {
+          D_ERROR( "DirectFB/FontFT2: Could not write glyph cache '%s'!\n", tmp );
+          unlink( tmp );
+     }
+     else if (rename( tmp, file->path )) {
+          ret = errno2result( errno );
+          D_PERROR( "DirectFB/FontFT2: Could not rename '%s'!\n", tmp );
+          unlink( tmp );
+     }
+     else
+          D_DEBUG( "DirectFB/FontFT2: Wrote %d glyphs in %d rows to '%s'.\n", ctx.num, num_rows, file->path );
+
+     D_FREE( tmp );
+
+     goto out;
+
+
+out_unlock:
+     dfb_font_unlock( font );
+
+out:
+     if (row_data) {
+          for (i=0; i<num_rows; i++) {
+               if (row_data[i])
+                    D_FREE( row_data[i] );
+          }
+
+          D_FREE( row_data );
+     }
+
+     if (rows)
+          D_FREE( rows );
+
+     if (ctx.added)
+          direct_hash_destroy( ctx.added );
+
+     if (ctx.codes)
+          direct_hash_destroy( ctx.codes );
+
+     D_FREE( ctx.glyphs );
+
+     return ret;
+}
+
+static void
+cache_file_close( FT2ImplData *data,
+                  CoreFont    *font )
+{
+     FT2CacheFile *file = data->cache_file;
+
+     if (!file)
+          return;
+
+     /* Only write the file if FreeType had to render glyphs. */
+     if (file->rendered) {
+          cache_file_save( data, font );
+
+          direct_hash_destroy( file->rendered );
+     }
+
+     data->cache_file = NULL;
+
+     if (file->glyphs)
+          direct_hash_destroy( file->glyphs );
+
+     if (file->rows)
+          D_FREE( file->rows );
+
+     if (file->map)
+          munmap( file->map, file->size );
+
+     D_FREE( file->path );
+     D_FREE( file );
 }
 
 static DFBResult
@@ -848,9 +1586,14 @@ IDirectFBFont_FT2_Destruct( IDirectFBFont *thiz )
 {
      IDirectFBFont_data *data = (IDirectFBFont_data*)thiz->priv;
 
+     /* Stop background rendering before the implementation data goes away. */
+     dfb_font_prerender_cancel( data->font );
+
      if (data->font->impl_data) {
           FT2ImplData *impl_data = (FT2ImplData*) data->font->impl_data;
 
+          cache_file_close( impl_data, data->font );
+
           pthread_mutex_lock ( &library_mutex );
           FT_Done_Face( impl_data->face );
           pthread_mutex_unlock ( &library_mutex );
@@ -1192,6 +1935,13 @@ Construct( IDirectFBFont               *thiz,
 
      font->impl_data = data;
 
+     /* Glyphs rendered by a previous run, DGIFF only supports unrotated horizontal layout. */
+     if (dfb_config->font_cache_dir && filename &&
+         !((desc->flags & DFDESC_ROTATION) && desc->rotation) &&
+         !(load_flags & FT_LOAD_VERTICAL_LAYOUT) &&
+         DFB_BYTES_PER_PIXEL( font->pixel_format ) > 0)
+          cache_file_open( data, font, filename, desc, load_flags );
+
      dfb_font_register_encoding( font, "UTF8",   &ft2UTF8Funcs,   DTEID_UTF8 );
      dfb_font_register_encoding( font, "Latin1", &ft2Latin1Funcs, DTEID_OTHER );
 
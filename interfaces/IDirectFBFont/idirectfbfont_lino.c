@@ -424,8 +424,8 @@ render_glyph( CoreFont      *thiz,
           info->width = surface->config.size.w - info->start;
 
      info->height = glyph_map->height;
-     if (info->height > surface->config.size.h)
-          info->height = surface->config.size.h;
+     if (info->height + info->start_y > surface->config.size.h)
+          info->height = surface->config.size.h - info->start_y;
 
      /* bitmap_left and bitmap_top are relative to the glyph's origin on the
         baseline.  info->left and info->top are relative to the top-left of the
@@ -446,7 +446,7 @@ render_glyph( CoreFont      *thiz,
 
      /*src = face->glyph->bitmap.buffer;*/
      src = glyph_map->bits;
-     lock.addr += DFB_BYTES_PER_LINE(surface->config.format, info->start);
+     lock.addr += DFB_BYTES_PER_LINE(surface->config.format, info->start) + info->start_y * lock.pitch;
 
      for (y=0; y < info->height; y++) {
           int  i, j, n;
@@ -867,6 +867,9 @@ IDirectFBFont_IT_Destruct( IDirectFBFont *thiz )
 {
      IDirectFBFont_data *data = (IDirectFBFont_data*)thiz->priv;
 
+     /* Stop background rendering before the implementation data goes away. */
+     dfb_font_prerender_cancel( data->font );
+
      if (data->font->impl_data) {
           ITImplData *impl_data = (ITImplData*) data->font->impl_data;
 
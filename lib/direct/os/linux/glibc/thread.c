@@ -379,6 +379,59 @@ direct_thread_sleep( long long micros )
      usleep( micros );
 }
 
+DirectResult
+direct_thread_set_cpu( int cpu )
+{
+#ifdef CPU_SET
+     cpu_set_t set;
+
+     D_DEBUG_AT( Direct_Thread, "%s( %d )\n", __FUNCTION__, cpu );
+
+     D_ASSERT( cpu >= 0 );
+
+     CPU_ZERO( &set );
+     CPU_SET( cpu, &set );
+
+     if (sched_setaffinity( 0, sizeof(set), &set ))
+          return errno2result( errno );
+
+     return DR_OK;
+#else
+     return DR_UNSUPPORTED;
+#endif
+}
+
+DirectResult
+direct_thread_get_cpus( int *ret_cpus,
+                        int  max,
+                        int *ret_num )
+{
+#ifdef CPU_SET
+     int       i;
+     int       num = 0;
+     cpu_set_t set;
+
+     D_DEBUG_AT( Direct_Thread, "%s( %d )\n", __FUNCTION__, max );
+
+     D_ASSERT( ret_cpus != NULL );
+     D_ASSERT( ret_num != NULL );
+
+     if (sched_getaffinity( 0, sizeof(set), &set ))
+          return errno2result( errno );
+
+     for (i=0; i<CPU_SETSIZE && num<max; i++) {
+          if (CPU_ISSET( i, &set ))
+               ret_cpus[num++] = i;
+     }
+
+     *ret_num = num;
+
+     return DR_OK;
+#else
+     return DR_UNSUPPORTED;
+#endif
+}
+
 /**********************************************************************************************************************/
 /**********************************************************************************************************************/
 
@@ -351,6 +351,20 @@ direct_thread_sleep( long long micros )
      sceKernelDelayThread( micros );
 }
 
+DirectResult
+direct_thread_set_cpu( int cpu )
+{
+     return DR_UNSUPPORTED;
+}
+
+DirectResult
+direct_thread_get_cpus( int *ret_cpus,
+                        int  max,
+                        int *ret_num )
+{
+     return DR_UNSUPPORTED;
+}
+
 /**********************************************************************************************************************/
 /**********************************************************************************************************************/
 
@@ -84,5 +84,17 @@ void         DIRECT_API   direct_thread_kill       ( DirectThread *thread,
 
 void         DIRECT_API   direct_thread_sleep      ( long long     micros );
 
+/*
+ * Restrict the calling thread to run on the given CPU only.
+ */
+DirectResult DIRECT_API   direct_thread_set_cpu    ( int           cpu );
+
+/*
+ * Returns up to 'max' CPUs the calling thread is allowed to run on, e.g. within a cpuset.
+ */
+DirectResult DIRECT_API   direct_thread_get_cpus   ( int          *ret_cpus,
+                                                     int           max,
+                                                     int          *ret_num );
+
 #endif
 
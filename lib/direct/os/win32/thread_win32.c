@@ -181,3 +181,21 @@ direct_thread_sleep( long long micros )
 {
      Sleep( (DWORD)(micros / 1000) );
 }
+
+DirectResult
+direct_thread_set_cpu( int cpu )
+{
+     D_UNIMPLEMENTED();
+
+     return DR_UNIMPLEMENTED;
+}
+
+DirectResult
+direct_thread_get_cpus( int *ret_cpus,
+                        int  max,
+                        int *ret_num )
+{
+     D_UNIMPLEMENTED();
+
+     return DR_UNIMPLEMENTED;
+}
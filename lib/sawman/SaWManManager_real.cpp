@@ -358,8 +358,18 @@ ISaWManManager_Real::SetWindowConfig(
      if (flags & SWMCF_COLOR_KEY)
           window->config.color_key = config->color_key;
 
-     if (flags & SWMCF_OPAQUE)
-          window->config.opaque = config->opaque;
+     if (flags & (SWMCF_OPAQUE | SWMCF_OPAQUE_REGIONS)) {
+          window->config.opaque             = config->opaque;
+          window->config.num_opaque_regions = 0;
+
+          /* Callers only knowing the single region may leave the others uninitialized. */
+          if (flags & SWMCF_OPAQUE_REGIONS) {
+               window->config.num_opaque_regions = MIN( config->num_opaque_regions, DFB_WINDOW_OPAQUE_REGIONS_MAX );
+
+               direct_memcpy( window->config.opaque_regions, config->opaque_regions,
+                              window->config.num_opaque_regions * sizeof(DFBRegion) );
+          }
+     }
 
      if (flags & CWCF_STACKING)
           sawman_restack_window( sawman, sawwin, sawwin, 0, config->stacking );
@@ -399,6 +409,10 @@ ISaWManManager_Real::SetWindowConfig(
           }
      }
 
+     /* Keep the opaque regions within the (new) window size. */
+     if ((flags & SWMCF_SIZE) || window->config.num_opaque_regions)
+          dfb_window_clip_opaque_regions( &window->config );
+
      if (flags & SWMCF_SRC_GEOMETRY)
           window->config.src_geometry = config->src_geometry;
 
@@ -348,7 +348,7 @@ ISaWManManager_SetWindowConfig ( ISaWManManager           *thiz,
        SWMCF_KEY_SELECTION, SWMCF_CURSOR_FLAGS, SWMCF_CURSOR_RESOLUTION
      */
 
-     if (flags & ~(SWMCF_ALL - SWMCF_KEY_SELECTION - SWMCF_CURSOR_FLAGS - SWMCF_CURSOR_RESOLUTION))
+     if (flags & ~((SWMCF_ALL - SWMCF_KEY_SELECTION - SWMCF_CURSOR_FLAGS - SWMCF_CURSOR_RESOLUTION) | SWMCF_OPAQUE_REGIONS))
           return DFB_INVARG;
 
      if (config == NULL)
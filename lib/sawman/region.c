@@ -114,8 +114,25 @@ SOFTWARE.
 
 #include <fusion/shmalloc.h>
 
+#include <misc/conf.h>
+
 #include "region.h"
 
+#ifdef USE_SSE2
+#include <emmintrin.h>
+
+#define SSE2_FUNC __attribute__((target("sse2")))
+#endif
+
+#ifdef USE_NEON
+#include <arm_neon.h>
+
+#if !defined(__aarch64__) && defined(HAVE_GETAUXVAL)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#endif
+
 
 typedef misc_box_t          box_type_t;
 typedef misc_region_data_t  region_data_type_t;
@@ -259,13 +276,44 @@ allocData(region_type_t * region, size_t n)
      if (!sz)
           return NULL;
 
+     if (region->arena)
+          return misc_region_arena_alloc( region->arena, sz );
+
      return region->shmpool ? SHMALLOC( region->shmpool, sz ) : D_MALLOC( sz );
 }
 
+static void *
+reallocData(region_type_t * region, size_t n)
+{
+     size_t sz;
+
+     MISC_REGION_ASSERT( region );
+
+     sz = PIXREGION_SZOF(n);
+     if (!sz)
+          return NULL;
+
+     if (region->arena)
+          return misc_region_arena_realloc( region->arena, region->data, PIXREGION_SZOF(region->data->size), sz );
+
+     return region->shmpool ? SHREALLOC( region->shmpool, region->data, sz ) : D_REALLOC( region->data, sz );
+}
+
+static void
+releaseData(region_type_t * region, region_data_type_t * data)
+{
+     if (region->arena)
+          misc_region_arena_free( region->arena, data );
+     else if (region->shmpool)
+          SHFREE( region->shmpool, data );
+     else
+          D_FREE( data );
+}
+
 #define freeData(reg)                             \
      do {                                         \
           if ((reg)->data && (reg)->data->size) { \
-               if ((reg)->shmpool) SHFREE((reg)->shmpool, (reg)->data); else D_FREE((reg)->data);               \
+               releaseData((reg), (reg)->data);   \
                (reg)->data = NULL;                \
           }                                       \
      } while (0)
@@ -304,13 +352,7 @@ if (!(pReg)->data || (((pReg)->data->numRects + (n)) > (pReg)->data->size)) \
     if (((numRects) < ((reg)->data->size >> 1)) && ((reg)->data->size > 50)) \
     {                                                                   \
         region_data_type_t * NewData;                           \
-        size_t data_size = PIXREGION_SZOF(numRects);                    \
-        if (!data_size)                                                 \
-            NewData = NULL;                                             \
-        else                                                            \
-            NewData = (reg)->shmpool ?                                  \
-               SHREALLOC( (reg)->shmpool, (reg)->data, data_size ) :    \
-                    D_REALLOC( (reg)->data, data_size );                \
+        NewData = reallocData((reg), (numRects));                       \
         if (NewData)                                                    \
         {                                                               \
             NewData->size = (numRects);                                 \
@@ -351,6 +393,7 @@ misc_region_init (region_type_t       *region,
      region->extents = *misc_region_emptyBox;
      region->data = misc_region_emptyData;
      region->shmpool = shmpool;
+     region->arena = NULL;
 
      D_MAGIC_SET( region, misc_region_t );
 }
@@ -366,6 +409,7 @@ misc_region_init_rect (region_type_t *region,
      region->extents.y2 = y + height;
      region->data = NULL;
      region->shmpool = shmpool;
+     region->arena = NULL;
 
      D_MAGIC_SET( region, misc_region_t );
 }
@@ -378,10 +422,34 @@ misc_region_init_with_extents (region_type_t *region,
      region->extents = *extents;
      region->data = NULL;
      region->shmpool = shmpool;
+     region->arena = NULL;
 
      D_MAGIC_SET( region, misc_region_t );
 }
 
+void
+misc_region_init_in_arena (region_type_t       *region,
+                           misc_region_arena_t *arena)
+{
+     D_MAGIC_ASSERT( arena, misc_region_arena_t );
+
+     misc_region_init (region, NULL);
+
+     region->arena = arena;
+}
+
+void
+misc_region_init_with_extents_in_arena (region_type_t       *region,
+                                        misc_region_arena_t *arena,
+                                        box_type_t          *extents)
+{
+     D_MAGIC_ASSERT( arena, misc_region_arena_t );
+
+     misc_region_init_with_extents (region, NULL, extents);
+
+     region->arena = arena;
+}
+
 void
 misc_region_deinit (region_type_t *region)
 {
@@ -468,20 +536,13 @@ misc_rect_alloc (region_type_t * region, int n)
           region->data->numRects = 0;
      }
      else {
-          size_t data_size;
           if (n == 1) {
                n = region->data->numRects;
                if (n > 500) /* XXX pick numbers out of a hat */
                     n = 250;
           }
           n += region->data->numRects;
-          data_size = PIXREGION_SZOF(n);
-          if (!data_size)
-               data = NULL;
-          else
-               data = region->shmpool ?
-                         SHREALLOC( region->shmpool, region->data, PIXREGION_SZOF(n) ) :
-                              D_REALLOC( region->data, PIXREGION_SZOF(n) );
+          data = reallocData(region, n);
           if (!data)
                return misc_break (region);
           region->data = data;
@@ -794,12 +855,8 @@ misc_op(
           newReg->data->numRects = 0;
      if (newSize > newReg->data->size) {
           if (!misc_rect_alloc(newReg, newSize)) {
-               if (oldData) {
-                    if (newReg->shmpool)
-                         SHFREE(newReg->shmpool, oldData);
-                    else
-                         D_FREE(oldData);
-               }
+               if (oldData)
+                    releaseData(newReg, oldData);
                return false;
           }
      }
@@ -930,12 +987,8 @@ misc_op(
           AppendRegions(newReg, r2BandEnd, r2End);
      }
 
-     if (oldData) {
-          if (newReg->shmpool)
-               SHFREE(newReg->shmpool, oldData);
-          else
-               D_FREE(oldData);
-     }
+     if (oldData)
+          releaseData(newReg, oldData);
 
      if (!(numRects = newReg->data->numRects)) {
           freeData(newReg);
@@ -1075,6 +1128,11 @@ misc_region_intersectO (region_type_t *region,
      return true;
 }
 
+static bool
+misc_region_clip (region_type_t *newReg,
+                  region_type_t *reg,
+                  const box_type_t *clip);
+
 bool
 misc_region_intersect (region_type_t *     newReg,
                        region_type_t *        reg1,
@@ -1119,6 +1177,16 @@ misc_region_intersect (region_type_t *     newReg,
      else if (reg1 == reg2) {
           return misc_region_copy (newReg, reg1);
      }
+     else if (!reg2->data || !reg1->data) {
+          /* Clipping to a rectangle, e.g. visible region to update extents */
+          if (!reg2->data) {
+               if (!misc_region_clip(newReg, reg1, &reg2->extents))
+                    return false;
+          }
+          else if (!misc_region_clip(newReg, reg2, &reg1->extents))
+               return false;
+          misc_set_extents(newReg);
+     }
      else {
           /* General purpose intersection */
           int overlap; /* result ignored */
@@ -1477,7 +1545,13 @@ validate (region_type_t * badreg,
 
      /* Set up the first region to be the first rectangle in badreg */
      /* Note that step 2 code will never overflow the ri[0].reg rects array */
-     ri = (RegionInfo *) D_CALLOC (4, sizeof(RegionInfo));
+     if (badreg->arena) {
+          ri = (RegionInfo *) misc_region_arena_alloc (badreg->arena, 4 * sizeof(RegionInfo));
+          if (ri)
+               memset (ri, 0, 4 * sizeof(RegionInfo));
+     }
+     else
+          ri = (RegionInfo *) D_CALLOC (4, sizeof(RegionInfo));
      if (!ri)
           return misc_break (badreg);
      sizeRI = 4;
@@ -1542,7 +1616,10 @@ validate (region_type_t * badreg,
                data_size = sizeRI * sizeof(RegionInfo);
                if (data_size / sizeRI != sizeof(RegionInfo))
                     goto bail;
-               rit = (RegionInfo *) D_REALLOC(ri, data_size);
+               if (badreg->arena)
+                    rit = (RegionInfo *) misc_region_arena_realloc(badreg->arena, ri, data_size / 2, data_size);
+               else
+                    rit = (RegionInfo *) D_REALLOC(ri, data_size);
                if (!rit)
                     goto bail;
                ri = rit;
@@ -1554,6 +1631,7 @@ validate (region_type_t * badreg,
           rit->reg.extents = *box;
           rit->reg.data = NULL;
           rit->reg.shmpool = NULL;
+          rit->reg.arena = badreg->arena;
           D_MAGIC_SET( &rit->reg, misc_region_t );
           if (!misc_rect_alloc(&rit->reg, (i+numRI) / numRI)) /* MUST force allocation */
                goto bail;
@@ -1599,7 +1677,10 @@ validate (region_type_t * badreg,
                goto bail;
      }
      *badreg = ri[0].reg;
-     D_FREE(ri);
+     if (badreg->arena)
+          misc_region_arena_free(badreg->arena, ri);
+     else
+          D_FREE(ri);
      good(badreg);
      return ret;
 
@@ -1608,7 +1689,10 @@ bail:
           freeData( &ri[i].reg );
           D_MAGIC_CLEAR( &ri[i].reg );
      }
-     D_FREE (ri);
+     if (badreg->arena)
+          misc_region_arena_free(badreg->arena, ri);
+     else
+          D_FREE (ri);
 
      return misc_break (badreg);
 }
@@ -2197,16 +2281,14 @@ region_type_t * reg;
      }
 }
 
-bool
-misc_region_init_boxes (region_type_t *region,
-                        FusionSHMPoolShared *shmpool,
-                        const DFBBox *boxes, int count)
+static bool
+init_boxes (region_type_t *region,
+            FusionSHMPoolShared *shmpool,
+            misc_region_arena_t *arena,
+            const DFBBox *boxes, int count)
 {
      int overlap;
 
-     D_DEBUG_AT( Misc_Region, "%s( %p, %p, %p [%d] )\n", __FUNCTION__, region, shmpool, boxes, count );
-//     DFB_BOXES_DEBUG_AT( Misc_Region, boxes, count );
-
      /* if it's 1, then we just want to set the extents, so call
       * the existing method. */
      if (count == 1) {
@@ -2215,11 +2297,14 @@ misc_region_init_boxes (region_type_t *region,
                                  boxes[0].y1,
                                  boxes[0].x2 - boxes[0].x1,
                                  boxes[0].y2 - boxes[0].y1);
+          region->arena = arena;
           return true;
      }
 
      misc_region_init (region, shmpool);
 
+     region->arena = arena;
+
      D_MAGIC_ASSERT( region, misc_region_t );
 
      /* if it's 0, don't call misc_rect_alloc -- 0 rectangles is
@@ -2244,3 +2329,644 @@ misc_region_init_boxes (region_type_t *region,
      return validate (region, &overlap);
 }
 
+bool
+misc_region_init_boxes (region_type_t *region,
+                        FusionSHMPoolShared *shmpool,
+                        const DFBBox *boxes, int count)
+{
+     D_DEBUG_AT( Misc_Region, "%s( %p, %p, %p [%d] )\n", __FUNCTION__, region, shmpool, boxes, count );
+//     DFB_BOXES_DEBUG_AT( Misc_Region, boxes, count );
+
+     return init_boxes (region, shmpool, NULL, boxes, count);
+}
+
+bool
+misc_region_init_boxes_in_arena (region_type_t *region,
+                                 misc_region_arena_t *arena,
+                                 const DFBBox *boxes, int count)
+{
+     D_DEBUG_AT( Misc_Region, "%s( %p, %p, %p [%d] )\n", __FUNCTION__, region, arena, boxes, count );
+
+     D_MAGIC_ASSERT( arena, misc_region_arena_t );
+
+     return init_boxes (region, NULL, arena, boxes, count);
+}
+
+/**********************************************************************************************************************/
+
+#define ARENA_ALIGN(n)      (((n) + 15) & ~(size_t) 15)
+#define ARENA_MIN_CHUNK     4096
+
+typedef struct {
+     void   *next;
+     size_t  size;
+} ArenaChunk;
+
+#define ARENA_CHUNK_HEADER  ARENA_ALIGN(sizeof(ArenaChunk))
+
+void
+misc_region_arena_init( misc_region_arena_t *arena,
+                        void                *buffer,
+                        size_t               size )
+{
+     unsigned long addr = (unsigned long) buffer;
+
+     D_ASSERT( arena != NULL );
+     D_ASSERT( buffer != NULL || size == 0 );
+
+     /* align the caller's block */
+     if (buffer && (addr & 15)) {
+          size_t skip = 16 - (addr & 15);
+
+          if (size > skip) {
+               buffer  = (u8*) buffer + skip;
+               size   -= skip;
+          }
+          else {
+               buffer = NULL;
+               size   = 0;
+          }
+     }
+
+     arena->initial      = buffer;
+     arena->initial_size = buffer ? size : 0;
+     arena->base         = arena->initial;
+     arena->size         = arena->initial_size;
+     arena->used         = 0;
+     arena->last         = NULL;
+     arena->chunks       = NULL;
+
+     D_MAGIC_SET( arena, misc_region_arena_t );
+}
+
+void
+misc_region_arena_reset( misc_region_arena_t *arena )
+{
+     ArenaChunk *chunk;
+
+     D_MAGIC_ASSERT( arena, misc_region_arena_t );
+
+     chunk = arena->chunks;
+
+     /* keep the largest chunk for the next round */
+     if (chunk) {
+          ArenaChunk *next = chunk->next;
+
+          chunk->next = NULL;
+
+          while (next) {
+               ArenaChunk *free_chunk = next;
+
+               next = next->next;
+
+               D_FREE( free_chunk );
+          }
+
+          arena->base = (u8*) chunk + ARENA_CHUNK_HEADER;
+          arena->size = chunk->size;
+     }
+     else {
+          arena->base = arena->initial;
+          arena->size = arena->initial_size;
+     }
+
+     arena->used = 0;
+     arena->last = NULL;
+}
+
+void
+misc_region_arena_deinit( misc_region_arena_t *arena )
+{
+     ArenaChunk *chunk;
+
+     D_MAGIC_ASSERT( arena, misc_region_arena_t );
+
+     chunk = arena->chunks;
+
+     while (chunk) {
+          ArenaChunk *next = chunk->next;
+
+          D_FREE( chunk );
+
+          chunk = next;
+     }
+
+     D_MAGIC_CLEAR( arena );
+}
+
+void *
+misc_region_arena_alloc( misc_region_arena_t *arena,
+                         size_t               size )
+{
+     void *ptr;
+
+     D_MAGIC_ASSERT( arena, misc_region_arena_t );
+
+     size = ARENA_ALIGN( size );
+
+     if (arena->size - arena->used < size) {
+          ArenaChunk *chunk;
+          size_t      chunk_size = MAX( arena->size * 2, ARENA_MIN_CHUNK );
+
+          if (chunk_size < size)
+               chunk_size = size;
+
+          chunk = D_MALLOC( ARENA_CHUNK_HEADER + chunk_size );
+          if (!chunk) {
+               D_WARN( "out of memory" );
+               return NULL;
+          }
+
+          D_DEBUG_AT( Misc_Region, "%s( %p ) -> new chunk of %zu bytes\n", __FUNCTION__, arena, chunk_size );
+
+          chunk->next = arena->chunks;
+          chunk->size = chunk_size;
+
+          arena->chunks = chunk;
+          arena->base   = (u8*) chunk + ARENA_CHUNK_HEADER;
+          arena->size   = chunk_size;
+          arena->used   = 0;
+     }
+
+     ptr = arena->base + arena->used;
+
+     arena->used += size;
+     arena->last  = ptr;
+
+     return ptr;
+}
+
+void *
+misc_region_arena_realloc( misc_region_arena_t *arena,
+                           void                *ptr,
+                           size_t               old_size,
+                           size_t               size )
+{
+     void *ret;
+
+     D_MAGIC_ASSERT( arena, misc_region_arena_t );
+
+     if (!ptr)
+          return misc_region_arena_alloc( arena, size );
+
+     /* grow or shrink the most recent allocation in place */
+     if (ptr == arena->last) {
+          size_t offset = (u8*) ptr - arena->base;
+
+          if (arena->size - offset >= ARENA_ALIGN( size )) {
+               arena->used = offset + ARENA_ALIGN( size );
+
+               return ptr;
+          }
+     }
+     else if (size <= old_size)
+          return ptr;
+
+     ret = misc_region_arena_alloc( arena, size );
+     if (ret)
+          memcpy( ret, ptr, MIN( old_size, size ) );
+
+     return ret;
+}
+
+void
+misc_region_arena_free( misc_region_arena_t *arena,
+                        void                *ptr )
+{
+     D_MAGIC_ASSERT( arena, misc_region_arena_t );
+
+     if (ptr && ptr == arena->last) {
+          arena->used = (u8*) ptr - arena->base;
+          arena->last = NULL;
+     }
+}
+
+/**********************************************************************************************************************/
+
+#ifdef USE_SSE2
+static bool
+has_sse2( void )
+{
+     __builtin_cpu_init();
+
+     return __builtin_cpu_supports( "sse2" );
+}
+
+static inline SSE2_FUNC unsigned int
+boxes_test_SSE2( const misc_boxes_t *boxes,
+                 int                 base,
+                 const misc_box_t   *box )
+{
+     __m128i x1 = _mm_loadu_si128( (const __m128i*) &boxes->x1[base] );
+     __m128i y1 = _mm_loadu_si128( (const __m128i*) &boxes->y1[base] );
+     __m128i x2 = _mm_loadu_si128( (const __m128i*) &boxes->x2[base] );
+     __m128i y2 = _mm_loadu_si128( (const __m128i*) &boxes->y2[base] );
+     __m128i m;
+
+     m = _mm_and_si128( _mm_cmplt_epi32( x1, _mm_set1_epi32( box->x2 ) ),
+                        _mm_cmplt_epi32( _mm_set1_epi32( box->x1 ), x2 ) );
+     m = _mm_and_si128( m, _mm_cmplt_epi32( y1, _mm_set1_epi32( box->y2 ) ) );
+     m = _mm_and_si128( m, _mm_cmplt_epi32( _mm_set1_epi32( box->y1 ), y2 ) );
+
+     return _mm_movemask_ps( _mm_castsi128_ps( m ) );
+}
+
+static SSE2_FUNC int
+boxes_find_last_SSE2( const misc_boxes_t *boxes,
+                      int                 start,
+                      const misc_box_t   *box )
+{
+     int          base = start & ~3;
+     unsigned int mask = boxes_test_SSE2( boxes, base, box ) & ((2 << (start - base)) - 1);
+
+     while (!mask) {
+          base -= 4;
+          if (base < 0)
+               return -1;
+
+          mask = boxes_test_SSE2( boxes, base, box );
+     }
+
+     return base + 31 - __builtin_clz( mask );
+}
+
+static SSE2_FUNC int
+boxes_find_next_SSE2( const misc_boxes_t *boxes,
+                      int                 start,
+                      const misc_box_t   *box )
+{
+     int          base = start & ~3;
+     unsigned int mask = boxes_test_SSE2( boxes, base, box ) & ~((1 << (start - base)) - 1);
+
+     while (!mask) {
+          base += 4;
+          if (base >= boxes->num)
+               return -1;
+
+          mask = boxes_test_SSE2( boxes, base, box );
+     }
+
+     return base + __builtin_ctz( mask );
+}
+
+/*
+ * Clips one box per vector, the stores are unconditional and only advance for boxes not clipped away.
+ */
+static SSE2_FUNC int
+clip_band_SSE2( box_type_t       *dst,
+                const box_type_t *src,
+                int               num,
+                const box_type_t *clip )
+{
+     int     i, n = 0;
+     __m128i c     = _mm_loadu_si128( (const __m128i*) clip );
+     __m128i lower = _mm_set_epi32( 0, 0, -1, -1 );    /* maximum for x1/y1, minimum for x2/y2 */
+
+     for (i=0; i<num; i++) {
+          __m128i b  = _mm_loadu_si128( (const __m128i*) &src[i] );
+          __m128i gt = _mm_cmpgt_epi32( b, c );
+          __m128i mx = _mm_or_si128( _mm_and_si128( gt, b ), _mm_andnot_si128( gt, c ) );
+          __m128i mn = _mm_or_si128( _mm_and_si128( gt, c ), _mm_andnot_si128( gt, b ) );
+          __m128i r  = _mm_or_si128( _mm_and_si128( lower, mx ), _mm_andnot_si128( lower, mn ) );
+
+          /* x2 > x1 and y2 > y1 */
+          __m128i e  = _mm_cmpgt_epi32( _mm_shuffle_epi32( r, _MM_SHUFFLE( 1, 0, 3, 2 ) ), r );
+
+          _mm_storeu_si128( (__m128i*) &dst[n], r );
+
+          n += (_mm_movemask_ps( _mm_castsi128_ps( e ) ) & 3) == 3;
+     }
+
+     return n;
+}
+#endif
+
+#ifdef USE_NEON
+static bool
+has_neon( void )
+{
+#if defined(__aarch64__) || !defined(HAVE_GETAUXVAL)
+     return true;
+#else
+     return (getauxval( AT_HWCAP ) & HWCAP_NEON) ? true : false;
+#endif
+}
+
+static inline unsigned int
+boxes_test_NEON( const misc_boxes_t *boxes,
+                 int                 base,
+                 const misc_box_t   *box )
+{
+     static const uint32_t bits[4] = { 1, 2, 4, 8 };
+
+     uint32x4_t m;
+     uint32x2_t s;
+
+     m = vandq_u32( vcltq_s32( vld1q_s32( &boxes->x1[base] ), vdupq_n_s32( box->x2 ) ),
+                    vcltq_s32( vdupq_n_s32( box->x1 ), vld1q_s32( &boxes->x2[base] ) ) );
+     m = vandq_u32( m, vcltq_s32( vld1q_s32( &boxes->y1[base] ), vdupq_n_s32( box->y2 ) ) );
+     m = vandq_u32( m, vcltq_s32( vdupq_n_s32( box->y1 ), vld1q_s32( &boxes->y2[base] ) ) );
+     m = vandq_u32( m, vld1q_u32( bits ) );
+
+     s = vpadd_u32( vget_low_u32( m ), vget_high_u32( m ) );
+     s = vpadd_u32( s, s );
+
+     return vget_lane_u32( s, 0 );
+}
+
+static int
+clip_band_NEON( box_type_t       *dst,
+                const box_type_t *src,
+                int               num,
+                const box_type_t *clip )
+{
+     int       i, n = 0;
+     int32x4_t c = vld1q_s32( &clip->x1 );
+
+     for (i=0; i<num; i++) {
+          int32x4_t  b  = vld1q_s32( &src[i].x1 );
+          int32x2_t  lo = vmax_s32( vget_low_s32( b ), vget_low_s32( c ) );
+          int32x2_t  hi = vmin_s32( vget_high_s32( b ), vget_high_s32( c ) );
+          uint32x2_t e  = vclt_s32( lo, hi );
+
+          vst1q_s32( &dst[n].x1, vcombine_s32( lo, hi ) );
+
+          n += vget_lane_u32( e, 0 ) & vget_lane_u32( e, 1 ) & 1;
+     }
+
+     return n;
+}
+#endif
+
+static int
+clip_band_C( box_type_t       *dst,
+             const box_type_t *src,
+             int               num,
+             const box_type_t *clip )
+{
+     int i, n = 0;
+
+     for (i=0; i<num; i++) {
+          box_type_t box;
+
+          box.x1 = MAX( src[i].x1, clip->x1 );
+          box.y1 = MAX( src[i].y1, clip->y1 );
+          box.x2 = MIN( src[i].x2, clip->x2 );
+          box.y2 = MIN( src[i].y2, clip->y2 );
+
+          if (box.x1 < box.x2 && box.y1 < box.y2)
+               dst[n++] = box;
+     }
+
+     return n;
+}
+
+static inline unsigned int
+boxes_test_C( const misc_boxes_t *boxes,
+              int                 base,
+              const misc_box_t   *box )
+{
+     int          i;
+     unsigned int mask = 0;
+
+     for (i=0; i<4; i++) {
+          if (boxes->x1[base+i] < box->x2 && box->x1 < boxes->x2[base+i] &&
+              boxes->y1[base+i] < box->y2 && box->y1 < boxes->y2[base+i])
+               mask |= 1 << i;
+     }
+
+     return mask;
+}
+
+static inline unsigned int
+boxes_test( const misc_boxes_t *boxes,
+            int                 base,
+            const misc_box_t   *box )
+{
+#ifdef USE_NEON
+     if (boxes->simd)
+          return boxes_test_NEON( boxes, base, box );
+#endif
+
+     return boxes_test_C( boxes, base, box );
+}
+
+bool
+misc_boxes_init( misc_boxes_t        *boxes,
+                 misc_region_arena_t *arena,
+                 int                  num )
+{
+     int  i;
+     int  padded = (num + 3) & ~3;
+     int *data;
+
+     D_ASSERT( boxes != NULL );
+     D_MAGIC_ASSERT( arena, misc_region_arena_t );
+     D_ASSERT( num >= 0 );
+
+     /* at least one group, so the search functions need no special case */
+     if (!padded)
+          padded = 4;
+
+     data = misc_region_arena_alloc( arena, padded * 4 * sizeof(int) );
+     if (!data)
+          return false;
+
+     boxes->num  = num;
+     boxes->simd = false;
+     boxes->x1   = data;
+     boxes->y1   = data + padded;
+     boxes->x2   = data + padded * 2;
+     boxes->y2   = data + padded * 3;
+
+     for (i=num; i<padded; i++) {
+          boxes->x1[i] = INT_MAX;
+          boxes->y1[i] = INT_MAX;
+          boxes->x2[i] = INT_MIN;
+          boxes->y2[i] = INT_MIN;
+     }
+
+     if (!dfb_config || dfb_config->simd) {
+#ifdef USE_SSE2
+          boxes->simd = has_sse2();
+#endif
+#ifdef USE_NEON
+          boxes->simd = has_neon();
+#endif
+     }
+
+     return true;
+}
+
+int
+misc_boxes_find_last( const misc_boxes_t *boxes,
+                      int                 start,
+                      const misc_box_t   *box )
+{
+     int          base;
+     unsigned int mask;
+
+     D_ASSERT( boxes != NULL );
+     D_ASSERT( box != NULL );
+     D_ASSERT( start < boxes->num );
+
+     if (start < 0)
+          return -1;
+
+#ifdef USE_SSE2
+     if (boxes->simd)
+          return boxes_find_last_SSE2( boxes, start, box );
+#endif
+
+     base = start & ~3;
+     mask = boxes_test( boxes, base, box ) & ((2 << (start - base)) - 1);
+
+     while (!mask) {
+          base -= 4;
+          if (base < 0)
+               return -1;
+
+          mask = boxes_test( boxes, base, box );
+     }
+
+     return base + 31 - __builtin_clz( mask );
+}
+
+int
+misc_boxes_find_next( const misc_boxes_t *boxes,
+                      int                 start,
+                      const misc_box_t   *box )
+{
+     int          base;
+     unsigned int mask;
+
+     D_ASSERT( boxes != NULL );
+     D_ASSERT( box != NULL );
+     D_ASSERT( start >= 0 );
+
+     if (start >= boxes->num)
+          return -1;
+
+#ifdef USE_SSE2
+     if (boxes->simd)
+          return boxes_find_next_SSE2( boxes, start, box );
+#endif
+
+     base = start & ~3;
+     mask = boxes_test( boxes, base, box ) & ~((1 << (start - base)) - 1);
+
+     while (!mask) {
+          base += 4;
+          if (base >= boxes->num)
+               return -1;
+
+          mask = boxes_test( boxes, base, box );
+     }
+
+     return base + __builtin_ctz( mask );
+}
+
+/**********************************************************************************************************************/
+
+typedef int (*ClipBandFunc)( box_type_t *dst, const box_type_t *src, int num, const box_type_t *clip );
+
+static ClipBandFunc
+clip_band_func( void )
+{
+     static int simd = -1;
+
+     if (simd < 0) {
+#if defined(USE_SSE2)
+          simd = has_sse2();
+#elif defined(USE_NEON)
+          simd = has_neon();
+#else
+          simd = 0;
+#endif
+     }
+
+     if (simd && (!dfb_config || dfb_config->simd)) {
+#if defined(USE_SSE2)
+          return clip_band_SSE2;
+#elif defined(USE_NEON)
+          return clip_band_NEON;
+#endif
+     }
+
+     return clip_band_C;
+}
+
+/*
+ * Intersection with a rectangle. Each band is clipped box by box, which is data parallel unlike the
+ * band merging of misc_op(), and coalesced with the previous one, giving the same result as misc_op().
+ *
+ * The destination may be the source region, it is clipped in place then, never producing more boxes
+ * than it has read. It may also be the region of the clip box, which is copied first.
+ */
+static bool
+misc_region_clip (region_type_t    *newReg,
+                  region_type_t    *reg,
+                  const box_type_t *clip)
+{
+     box_type_t    c         = *clip;
+     box_type_t   *r         = PIXREGION_RECTS(reg);
+     box_type_t   *rEnd      = r + PIXREGION_NUM_RECTS(reg);
+     int           prevBand  = 0;
+     int           curBand;
+     int           numRects;
+     ClipBandFunc  clip_band = clip_band_func();
+
+     MISC_REGION_ASSERT( newReg );
+     MISC_REGION_ASSERT( reg );
+
+     if (PIXREGION_NAR (reg))
+          return misc_break (newReg);
+
+     if (newReg != reg) {
+          numRects = rEnd - r;
+
+          if (!newReg->data)
+               newReg->data = misc_region_emptyData;
+          else if (newReg->data->size)
+               newReg->data->numRects = 0;
+
+          if (numRects > newReg->data->size && !misc_rect_alloc(newReg, numRects))
+               return false;
+     }
+     else
+          newReg->data->numRects = 0;
+
+     /* skip bands above the clip box */
+     while (r != rEnd && r->y2 <= c.y1)
+          r++;
+
+     while (r != rEnd && r->y1 < c.y2) {
+          box_type_t *rBandEnd = r + 1;
+
+          while (rBandEnd != rEnd && rBandEnd->y1 == r->y1)
+               rBandEnd++;
+
+          curBand = newReg->data->numRects;
+
+          newReg->data->numRects += clip_band( PIXREGION_TOP(newReg), r, rBandEnd - r, &c );
+
+          Coalesce(newReg, prevBand, curBand);
+
+          r = rBandEnd;
+     }
+
+     if (!(numRects = newReg->data->numRects)) {
+          freeData(newReg);
+          newReg->data = misc_region_emptyData;
+     }
+     else if (numRects == 1) {
+          newReg->extents = *PIXREGION_BOXPTR(newReg);
+          freeData(newReg);
+          newReg->data = (region_data_type_t *)NULL;
+     }
+     else {
+          DOWNSIZE(newReg, numRects);
+     }
+
+     return true;
+}
@@ -100,6 +100,8 @@ SOFTWARE.
 #ifndef __DFB__MISC__REGION_H__
 #define __DFB__MISC__REGION_H__
 
+#include <limits.h>
+
 #include <directfb_util.h>
 
 #include <fusion/types.h>
@@ -121,6 +123,7 @@ typedef DFBRectangle             misc_rectangle_t;
 
 typedef struct misc_region       misc_region_t;
 typedef struct misc_region_data  misc_region_data_t;
+typedef struct misc_region_arena misc_region_arena_t;
 
 struct misc_region_data {
      long                size;
@@ -134,9 +137,49 @@ struct misc_region {
      misc_box_t           extents;
 
      FusionSHMPoolShared *shmpool;
+     misc_region_arena_t *arena;
      misc_region_data_t  *data;
 };
 
+/*
+ * arena for temporary regions
+ *
+ * Allocations are served from a caller provided block first, then from heap chunks of growing size.
+ * Memory is only given back by misc_region_arena_reset() or misc_region_arena_deinit(), except for
+ * the most recent allocation, which is also grown and released in place.
+ */
+
+struct misc_region_arena {
+     int                  magic;
+
+     u8                  *base;        /* current block */
+     size_t               size;
+     size_t               used;
+     void                *last;        /* most recent allocation */
+
+     u8                  *initial;     /* caller provided block */
+     size_t               initial_size;
+
+     void                *chunks;      /* heap chunks, most recent (largest) first */
+};
+
+/*
+ * box sets
+ *
+ * Boxes stored as separate coordinate arrays, padded to a multiple of four entries,
+ * for testing many boxes against one box at once (SSE2/NEON if available).
+ */
+
+typedef struct {
+     int                  num;
+     bool                 simd;
+
+     int                 *x1;
+     int                 *y1;
+     int                 *x2;
+     int                 *y2;
+} misc_boxes_t;
+
 /**********************************************************************************************************************/
 
 #if D_DEBUG_ENABLED
@@ -219,6 +262,19 @@ void                  misc_region_init_with_extents ( misc_region_t       *regio
 
 void                  misc_region_deinit            ( misc_region_t       *region );
 
+/* creation within an arena, deinit is optional */
+void                  misc_region_init_in_arena     ( misc_region_t       *region,
+                                                      misc_region_arena_t *arena );
+
+bool                  misc_region_init_boxes_in_arena( misc_region_t       *region,
+                                                       misc_region_arena_t *arena,
+                                                       const DFBBox        *boxes,
+                                                       int                  count );
+
+void                  misc_region_init_with_extents_in_arena( misc_region_t       *region,
+                                                              misc_region_arena_t *arena,
+                                                              misc_box_t          *extents );
+
 /**********************************************************************************************************************/
 
 /* manipulation */
@@ -285,6 +341,68 @@ void                  misc_region_collapse          ( misc_region_t       *regio
 
 /**********************************************************************************************************************/
 
+/* arena */
+void                  misc_region_arena_init        ( misc_region_arena_t *arena,
+                                                      void                *buffer,
+                                                      size_t               size );
+
+void                  misc_region_arena_reset       ( misc_region_arena_t *arena );
+
+void                  misc_region_arena_deinit      ( misc_region_arena_t *arena );
+
+void *                misc_region_arena_alloc       ( misc_region_arena_t *arena,
+                                                      size_t               size );
+
+void *                misc_region_arena_realloc     ( misc_region_arena_t *arena,
+                                                      void                *ptr,
+                                                      size_t               old_size,
+                                                      size_t               size );
+
+void                  misc_region_arena_free        ( misc_region_arena_t *arena,
+                                                      void                *ptr );
+
+/**********************************************************************************************************************/
+
+/* box sets */
+bool                  misc_boxes_init               ( misc_boxes_t        *boxes,
+                                                      misc_region_arena_t *arena,
+                                                      int                  num );
+
+/* index of the last box at or below 'start' intersecting 'box', or -1 */
+int                   misc_boxes_find_last          ( const misc_boxes_t  *boxes,
+                                                      int                  start,
+                                                      const misc_box_t    *box );
+
+/* index of the first box at or above 'start' intersecting 'box', or -1 */
+int                   misc_boxes_find_next          ( const misc_boxes_t  *boxes,
+                                                      int                  start,
+                                                      const misc_box_t    *box );
+
+static inline void
+misc_boxes_set( misc_boxes_t     *boxes,
+                int               index,
+                const misc_box_t *box )
+{
+     D_ASSERT( index >= 0 );
+     D_ASSERT( index < boxes->num );
+
+     /* empty boxes must never intersect */
+     if (box && box->x1 < box->x2 && box->y1 < box->y2) {
+          boxes->x1[index] = box->x1;
+          boxes->y1[index] = box->y1;
+          boxes->x2[index] = box->x2;
+          boxes->y2[index] = box->y2;
+     }
+     else {
+          boxes->x1[index] = INT_MAX;
+          boxes->y1[index] = INT_MAX;
+          boxes->x2[index] = INT_MIN;
+          boxes->y2[index] = INT_MIN;
+     }
+}
+
+/**********************************************************************************************************************/
+
 static inline void
 misc_region_boxes_to_rects( DFBRectangle     *rects,
                             const misc_box_t *boxes,
@@ -380,6 +498,18 @@ misc_region_init_updates( misc_region_t       *region,
      return misc_region_init_boxes( region, shmpool, boxes, updates->num_regions );
 }
 
+static inline bool
+misc_region_init_updates_in_arena( misc_region_t       *region,
+                                   misc_region_arena_t *arena,
+                                   const DFBUpdates    *updates )
+{
+     misc_box_t boxes[updates->num_regions];
+
+     misc_region_regions_to_boxes( boxes, updates->regions, updates->num_regions );
+
+     return misc_region_init_boxes_in_arena( region, arena, boxes, updates->num_regions );
+}
+
 static inline bool
 misc_region_union_rects( misc_region_t      *dest,
                          misc_region_t      *region,
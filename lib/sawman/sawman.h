@@ -150,6 +150,8 @@ typedef enum {
      SWMCF_SRC_GEOMETRY  = DWCONF_SRC_GEOMETRY,
      SWMCF_DST_GEOMETRY  = DWCONF_DST_GEOMETRY,
 
+     SWMCF_OPAQUE_REGIONS = 0x00400000,   /* 'opaque_regions', otherwise none are set with SWMCF_OPAQUE */
+
      SWMCF_ALL           = DWCONF_ALL
 } SaWManWindowConfigFlags;
 
@@ -163,6 +165,8 @@ typedef struct {
      DFBColor                 color;          /* constant color (no surface needed) */
      u32                      color_key;      /* transparent pixel */
      DFBRegion                opaque;         /* region of the window forced to be opaque */
+     DFBRegion                opaque_regions[DFB_WINDOW_OPAQUE_REGIONS_MAX]; /* all opaque regions, if any */
+     unsigned int             num_opaque_regions; /* number of opaque regions, only used with SWMCF_OPAQUE_REGIONS */
 
      DFBWindowKeySelection    key_selection;  /* how to filter keys in focus */
      DFBInputDeviceKeySymbol *keys;           /* list of keys for DWKS_LIST */
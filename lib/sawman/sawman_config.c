@@ -72,7 +72,7 @@ static const char *config_usage =
      "  hw-cursor=<layer-id>               Set HW Cursor mode\n"
      "  resolution=<width>x<height>        Set virtual SaWMan resolution\n"
      "  [no-]static-layer                  Disable layer reconfiguration\n"
-     "  update-region-mode=<num>           Set internal update region mode (1-3, default 2)\n"
+     "  update-region-mode=<num>           Set internal update region mode (1-5, default 4)\n"
      "  keep-implicit-key-grabs            Causes implicit key grabs to stay even when window is withdrawn\n"
      "  hide-cursor-without-window         Hides the cursor when no window has control over it\n"
      "\n";
@@ -402,7 +402,7 @@ sawman_config_set( const char *name, const char *value )
                     D_ERROR("SaWMan/Config '%s': Could not parse value!\n", name);
                     return DFB_INVARG;
                }
-               if (mode < 1 || mode > 4) {
+               if (mode < 1 || mode > 5) {
                     D_ERROR("SaWMan/Config '%s': Value %d out of bounds!\n", name, mode);
                     return DFB_INVARG;
                }
@@ -41,6 +41,7 @@ extern "C"
 
 #include <direct/list.h>
 #include <direct/interface.h>
+#include <direct/memcpy.h>
 
 #include <fusion/call.h>
 #include <fusion/lock.h>
@@ -87,6 +88,8 @@ extern "C"
      (a)->color        = (b)->color;        \
      (a)->color_key    = (b)->color_key;    \
      (a)->opaque       = (b)->opaque;       \
+     (a)->num_opaque_regions = (b)->num_opaque_regions; \
+     direct_memcpy( (a)->opaque_regions, (b)->opaque_regions, sizeof((a)->opaque_regions) ); \
      (a)->association  = (b)->association;  \
      (a)->cursor_flags = (b)->cursor_flags; \
      (a)->cursor_resolution = (b)->cursor_resolution; \
@@ -105,7 +108,9 @@ extern "C"
      if (f & CWCF_EVENTS)       (a)->events       = (b)->events;       \
      if (f & CWCF_COLOR)        (a)->color        = (b)->color;        \
      if (f & CWCF_COLOR_KEY)    (a)->color_key    = (b)->color_key;    \
-     if (f & CWCF_OPAQUE)       (a)->opaque       = (b)->opaque;       \
+     if (f & CWCF_OPAQUE)     { (a)->opaque       = (b)->opaque;       \
+                                (a)->num_opaque_regions = (b)->num_opaque_regions; \
+                                direct_memcpy( (a)->opaque_regions, (b)->opaque_regions, sizeof((a)->opaque_regions) ); } \
      if (f & CWCF_ASSOCIATION)  (a)->association  = (b)->association;  \
      if (f & CWCF_CURSOR_FLAGS) (a)->cursor_flags = (b)->cursor_flags; \
      if (f & CWCF_CURSOR_RESOLUTION) (a)->cursor_resolution = (b)->cursor_resolution; \
@@ -84,22 +84,36 @@ typedef struct {
 } DFBLinkRegion;
 
 typedef struct {
-     DFBLinkRegion *regions;
-     DFBLinkRegion *malloc;
+     misc_region_arena_t *arena;
+     DFBLinkRegion       *regions;
      int number;
      int free;
 } DFBLinkRegionPool;
 
-typedef struct {
+typedef struct __DFBUpdateBin DFBUpdateBin;
+
+struct __DFBUpdateBin {
      DFBRegion     region;
      int           cap;
      int           size;
      int           curr;
+     DFBUpdateBin *next;     /* free list */
      SaWManWindow *windows;
      /* hidden array of SaWManWindow* at the end of this struct */
-} DFBUpdateBin;
+};
 
-static inline DFBUpdateBin *dfb_update_bin_get( const DFBUpdateBin *src, SaWManWindow *window, const int x1, const int y1, const int x2, const int y2, const int max)
+/*
+ * State of the update_region variants during repaint_tier(), the update arena is reset for each update.
+ */
+typedef struct {
+     misc_region_arena_t  layout;      /* for the window bounds */
+     misc_boxes_t         windows;     /* window bounds in layout order, empty if not drawn in the tier */
+
+     misc_region_arena_t  arena;
+     DFBUpdateBin        *bins;        /* released update bins */
+} UpdateContext;
+
+static inline DFBUpdateBin *dfb_update_bin_get( UpdateContext *ctx, const DFBUpdateBin *src, SaWManWindow *window, const int x1, const int y1, const int x2, const int y2, const int max)
 {
      int           cap  = max;
      int           size = 0;
@@ -113,8 +127,16 @@ static inline DFBUpdateBin *dfb_update_bin_get( const DFBUpdateBin *src, SaWManW
 
      D_ASSERT(cap > 0);
 
-     bin = malloc( sizeof(DFBUpdateBin) + (cap - 1) * sizeof(SaWManWindow*) );
-     D_ASSERT(NULL != bin);
+     if (ctx->bins && ctx->bins->cap >= cap) {
+          bin = ctx->bins;
+          ctx->bins = bin->next;
+
+          cap = bin->cap;
+     }
+     else {
+          bin = misc_region_arena_alloc( &ctx->arena, sizeof(DFBUpdateBin) + (cap - 1) * sizeof(SaWManWindow*) );
+          D_ASSERT(NULL != bin);
+     }
 
      bin->region = (DFBRegion){ x1, y1, x2, y2 };
      bin->size = size;
@@ -135,6 +157,12 @@ static inline DFBUpdateBin *dfb_update_bin_get( const DFBUpdateBin *src, SaWManW
      return bin;
 }
 
+static inline void dfb_update_bin_put( UpdateContext *ctx, DFBUpdateBin *bin )
+{
+     bin->next = ctx->bins;
+     ctx->bins = bin;
+}
+
 static inline SaWManWindow *dfb_update_bin_window_get( const DFBUpdateBin *bin, const int index )
 {
      D_ASSERT(NULL != bin);
@@ -144,45 +172,30 @@ static inline SaWManWindow *dfb_update_bin_window_get( const DFBUpdateBin *bin,
      return *(&bin->windows + index);
 }
 
-static inline void dfb_linkregionpool_init( DFBLinkRegionPool *pool, DFBLinkRegion *regions, int number )
+static inline void dfb_linkregionpool_init( DFBLinkRegionPool *pool, misc_region_arena_t *arena, int number )
 {
-     pool->regions = regions;
-     pool->malloc  = 0;
+     pool->arena   = arena;
+     pool->regions = NULL;
      pool->number  = number;
-     pool->free    = 0;
-}
-
-static inline void dfb_linkregionpool_delete( DFBLinkRegionPool *pool )
-{
-     if (pool->malloc)
-          free(pool->malloc);
+     pool->free    = number;
 }
 
 static inline DFBLinkRegion *dfb_linkregionpool_get( DFBLinkRegionPool *pool, DFBRegion *r )
 {
      DFBLinkRegion *lr;
 
-     /* check OOM */
+     /* get the next batch */
      if (pool->free == pool->number) {
-          if (pool->malloc) {
-               D_WARN("Out of link regions!");
+          pool->regions = misc_region_arena_alloc( pool->arena, sizeof(DFBLinkRegion) * pool->number );
+          if (!pool->regions) {
+               D_WARN("out of memory!");
                return NULL;
           }
-          else {
-               pool->free   = 0;
-               pool->number = 400;
-               pool->malloc = malloc( sizeof(DFBLinkRegion) * 400 );
-               if (!pool->malloc) {
-                    D_WARN("out of memory!");
-                    return NULL;
-               }
-          }
+
+          pool->free = 0;
      }
 
-     if (pool->malloc)
-          lr = pool->malloc + pool->free;
-     else
-          lr = pool->regions + pool->free;
+     lr = pool->regions + pool->free;
 
      pool->free++;
 
@@ -283,6 +296,7 @@ static void
 update_region( SaWMan          *sawman,
                SaWManTier      *tier,
                CardState       *state,
+               UpdateContext   *ctx,
                int              start,
                int              x1,
                int              y1,
@@ -290,8 +304,9 @@ update_region( SaWMan          *sawman,
                int              y2,
                bool             right_eye )
 {
-     int           i      = start;
+     int           i;
      DFBRegion     region = { x1, y1, x2, y2 };
+     misc_box_t    box    = { x1, y1, x2 + 1, y2 + 1 };
      CoreWindow   *window = NULL;
      SaWManWindow *sawwin = NULL;
 
@@ -308,26 +323,17 @@ update_region( SaWMan          *sawman,
           return;
 
      /* Find next intersecting window. */
-     while (i >= 0) {
+     i = misc_boxes_find_last( &ctx->windows, start, &box );
+
+     /* Intersecting window found? */
+     if (i >= 0) {
           sawwin = fusion_vector_at( &sawman->layout, i );
           D_MAGIC_ASSERT( sawwin, SaWManWindow );
 
           window = sawwin->window;
           D_MAGIC_COREWINDOW_ASSERT( window );
 
-          if (SAWMAN_VISIBLE_WINDOW( window ) && (tier->classes & (1 << window->config.stacking))) {
-               if (dfb_region_intersect( &region,
-                                         DFB_REGION_VALS_FROM_RECTANGLE( &sawwin->bounds )))
-                    break;
-          }
-
-          i--;
-     }
-
-     /* Intersecting window found? */
-     if (i >= 0) {
-          D_MAGIC_ASSERT( sawwin, SaWManWindow );
-          D_MAGIC_COREWINDOW_ASSERT( window );
+          dfb_region_intersect( &region, DFB_REGION_VALS_FROM_RECTANGLE( &sawwin->bounds ) );
 
           if (D_FLAGS_ARE_SET( window->config.options, DWOP_ALPHACHANNEL | DWOP_OPAQUE_REGION )) {
                DFBRegion opaque = DFB_REGION_INIT_TRANSLATED( &window->config.opaque,
@@ -335,31 +341,31 @@ update_region( SaWMan          *sawman,
                                                               sawwin->bounds.y );
 
                if (!dfb_region_region_intersect( &opaque, &region )) {
-                    update_region( sawman, tier, state, i-1, x1, y1, x2, y2, right_eye );
+                    update_region( sawman, tier, state, ctx, i-1, x1, y1, x2, y2, right_eye );
 
                     sawman_draw_window( tier, sawwin, state, &region, true, right_eye );
                }
                else {
                     if ((window->config.opacity < 0xff) || (window->config.options & DWOP_COLORKEYING)) {
                          /* draw everything below */
-                         update_region( sawman, tier, state, i-1, x1, y1, x2, y2, right_eye );
+                         update_region( sawman, tier, state, ctx, i-1, x1, y1, x2, y2, right_eye );
                     }
                     else {
                          /* left */
                          if (opaque.x1 != x1)
-                              update_region( sawman, tier, state, i-1, x1, opaque.y1, opaque.x1-1, opaque.y2, right_eye );
+                              update_region( sawman, tier, state, ctx, i-1, x1, opaque.y1, opaque.x1-1, opaque.y2, right_eye );
 
                          /* upper */
                          if (opaque.y1 != y1)
-                              update_region( sawman, tier, state, i-1, x1, y1, x2, opaque.y1-1, right_eye );
+                              update_region( sawman, tier, state, ctx, i-1, x1, y1, x2, opaque.y1-1, right_eye );
 
                          /* right */
                          if (opaque.x2 != x2)
-                              update_region( sawman, tier, state, i-1, opaque.x2+1, opaque.y1, x2, opaque.y2, right_eye );
+                              update_region( sawman, tier, state, ctx, i-1, opaque.x2+1, opaque.y1, x2, opaque.y2, right_eye );
 
                          /* lower */
                          if (opaque.y2 != y2)
-                              update_region( sawman, tier, state, i-1, x1, opaque.y2+1, x2, y2, right_eye );
+                              update_region( sawman, tier, state, ctx, i-1, x1, opaque.y2+1, x2, y2, right_eye );
                     }
 
                     /* left */
@@ -393,7 +399,7 @@ update_region( SaWMan          *sawman,
           else {
                if (SAWMAN_TRANSLUCENT_WINDOW( window )) {
                     /* draw everything below */
-                    update_region( sawman, tier, state, i-1, x1, y1, x2, y2, right_eye );
+                    update_region( sawman, tier, state, ctx, i-1, x1, y1, x2, y2, right_eye );
                }
                else {
                     DFBRegion dst = DFB_REGION_INIT_FROM_RECTANGLE( &sawwin->dst );
@@ -402,19 +408,19 @@ update_region( SaWMan          *sawman,
 
                     /* left */
                     if (dst.x1 != x1)
-                         update_region( sawman, tier, state, i-1, x1, dst.y1, dst.x1-1, dst.y2, right_eye );
+                         update_region( sawman, tier, state, ctx, i-1, x1, dst.y1, dst.x1-1, dst.y2, right_eye );
 
                     /* upper */
                     if (dst.y1 != y1)
-                         update_region( sawman, tier, state, i-1, x1, y1, x2, dst.y1-1, right_eye );
+                         update_region( sawman, tier, state, ctx, i-1, x1, y1, x2, dst.y1-1, right_eye );
 
                     /* right */
                     if (dst.x2 != x2)
-                         update_region( sawman, tier, state, i-1, dst.x2+1, dst.y1, x2, dst.y2, right_eye );
+                         update_region( sawman, tier, state, ctx, i-1, dst.x2+1, dst.y1, x2, dst.y2, right_eye );
 
                     /* lower */
                     if (dst.y2 != y2)
-                         update_region( sawman, tier, state, i-1, x1, dst.y2+1, x2, y2, right_eye );
+                         update_region( sawman, tier, state, ctx, i-1, x1, dst.y2+1, x2, y2, right_eye );
                }
 
                sawman_draw_window( tier, sawwin, state, &region, true, right_eye  );
@@ -428,6 +434,7 @@ static void
 update_region2( SaWMan          *sawman,
                 SaWManTier      *tier,
                 CardState       *state,
+                UpdateContext   *ctx,
                 int              start,
                 int              x1,
                 int              y1,
@@ -458,7 +465,7 @@ update_region2( SaWMan          *sawman,
      stack = tier->stack;
      D_ASSERT( stack != NULL );
 
-     misc_region_init_with_extents( &dirty, NULL, &extents );
+     misc_region_init_with_extents_in_arena( &dirty, &ctx->arena, &extents );
 
      fusion_vector_foreach (sawwin, i, sawman->layout) {
           CoreWindow *window;
@@ -479,14 +486,14 @@ update_region2( SaWMan          *sawman,
 
                /* visible (window) */
                if (right_eye)
-                    misc_region_init_updates( &visible, NULL, &sawwin->right.visible );
+                    misc_region_init_updates_in_arena( &visible, &ctx->arena, &sawwin->right.visible );
                else
-                    misc_region_init_updates( &visible, NULL, &sawwin->left.visible );
+                    misc_region_init_updates_in_arena( &visible, &ctx->arena, &sawwin->left.visible );
 
                /* render (extents) */
-               misc_region_init_with_extents( &render, NULL, &extents );
+               misc_region_init_with_extents_in_arena( &render, &ctx->arena, &extents );
 
-               misc_region_init( &opt, NULL );
+               misc_region_init_in_arena( &opt, &ctx->arena );
 
                /* render = visible & render(extents) */
                misc_region_intersect( &render, &visible, &render );
@@ -502,7 +509,7 @@ update_region2( SaWMan          *sawman,
                {
                     misc_region_t blend;
 
-                    misc_region_init( &blend, NULL );
+                    misc_region_init_in_arena( &blend, &ctx->arena );
 
                     /* blend = render - opt */
                     misc_region_subtract( &blend, &render, &opt );
@@ -611,6 +618,7 @@ static void
 update_region3( SaWMan          *sawman,
                 SaWManTier      *tier,
                 CardState       *state,
+                UpdateContext   *ctx,
                 int              start,
                 int              x1,
                 int              y1,
@@ -625,10 +633,8 @@ update_region3( SaWMan          *sawman,
      int u;
      int windows_to_optimize = 2;
 
-     DFBRegion updateRegion = {x1,y1,x2,y2};
-
      DFBLinkRegionPool  regionpool;
-     DFBLinkRegion     *regionstorage;
+     misc_box_t         box = { x1, y1, x2 + 1, y2 + 1 };
 
      DirectLink *backgroundNotNeeded = 0;
      DirectLink *backgroundNeeded    = 0;
@@ -654,24 +660,31 @@ update_region3( SaWMan          *sawman,
      D_ASSERT( stack != NULL );
 
      /* we need some intermediate storage */
-     /* 50 = arbitrary */
-     regionstorage = alloca(sizeof(DFBLinkRegion) * 50);
-     dfb_linkregionpool_init( &regionpool, regionstorage, 50 );
+     /* 64 = arbitrary */
+     dfb_linkregionpool_init( &regionpool, &ctx->arena, 64 );
 
      const int numberOfWindows  = fusion_vector_size( &sawman->layout );
      DirectLink *updatesBlend[numberOfWindows];
      DirectLink *updatesNoBlend[numberOfWindows];
 
+     for (winNum=0; winNum<numberOfWindows; winNum++) {
+          updatesBlend[winNum]   = 0;
+          updatesNoBlend[winNum] = 0;
+     }
+
      /* TODO: if we have a background picture,
       * there is a very strong case for optimizing using double blit. */
 
      blackBackground = (stack->bg.mode == DLBM_COLOR) && !stack->bg.color.a && !stack->bg.color.r &&  !stack->bg.color.g && !stack->bg.color.b;
 
-     /* z-order: bottom to top */
-     fusion_vector_foreach (sawwin, winNum, sawman->layout) {
+     /* z-order: bottom to top, only windows whose bounding boxes overlap the update region */
+     for (winNum = misc_boxes_find_next( &ctx->windows, 0, &box ); winNum >= 0;
+          winNum = misc_boxes_find_next( &ctx->windows, winNum + 1, &box ))
+     {
           CoreWindow *window;
           DFBUpdates *visible;
 
+          sawwin = fusion_vector_at( &sawman->layout, winNum );
           D_MAGIC_ASSERT( sawwin, SaWManWindow );
 
           window = sawwin->window;
@@ -681,137 +694,124 @@ update_region3( SaWMan          *sawman,
 
           D_DEBUG_AT( SaWMan_Update, "  -> visible  %4d,%4d-%4dx%4d\n", DFB_RECTANGLE_VALS_FROM_REGION( &visible->bounding ) );
 
-          updatesBlend[winNum]   = 0;
-          updatesNoBlend[winNum] = 0;
-
-          if (SAWMAN_VISIBLE_WINDOW( window ) && (tier->classes & (1 << window->config.stacking))) {
-               DFBRectangle bounds = window->config.bounds;
-
-               bounds.x += right_eye ? -window->config.z : window->config.z;
-
-               D_DEBUG_AT( SaWMan_Update, " -=> [%d] <=- %d\n", winNum, SAWMAN_TRANSLUCENT_WINDOW(window) );
+          D_DEBUG_AT( SaWMan_Update, " -=> [%d] <=- %d\n", winNum, SAWMAN_TRANSLUCENT_WINDOW(window) );
+
+          /* Optimizing. Only possible when the opacity is max and
+             there is no color keying because this requires additional blending */
+          if (      (window->config.opacity == 0xff)
+                &&   window->surface
+                &&  (window->surface->config.caps & DSCAPS_PREMULTIPLIED)
+                &&  (window->config.options & DWOP_ALPHACHANNEL)
+                && !(window->config.options & DWOP_COLORKEYING)
+                &&  (window->config.dst_geometry.mode == DWGM_DEFAULT)
+                &&   blackBackground
+                &&   windows_to_optimize--)
+          {
+               DirectLink *updates    = 0;
 
-               /* check against bounding boxes to quickly discard non-overlapping windows */
-               if (!dfb_rectangle_region_intersects(&bounds, &updateRegion) )
-                    continue;
+               D_DEBUG_AT( SaWMan_Update, " ---> window optimized\n" );
 
-               /* Optimizing. Only possible when the opacity is max and
-                  there is no color keying because this requires additional blending */
-               if (      (window->config.opacity == 0xff)
-                     &&   window->surface
-                     &&  (window->surface->config.caps & DSCAPS_PREMULTIPLIED)
-                     &&  (window->config.options & DWOP_ALPHACHANNEL)
-                     && !(window->config.options & DWOP_COLORKEYING)
-                     &&  (window->config.dst_geometry.mode == DWGM_DEFAULT)
-                     &&   blackBackground
-                     &&   windows_to_optimize--)
-               {
-                    DirectLink *updates    = 0;
+               /* copy all applicable updates in a separate structure */
+               for (u=0; u < visible->num_regions; u++) {
 
-                    D_DEBUG_AT( SaWMan_Update, " ---> window optimized\n" );
+                    /* clip the visible regions to the update region */
+                    if (!dfb_region_intersects( &visible->regions[u], x1, y1, x2, y2 ))
+                         continue;
 
-                    /* copy all applicable updates in a separate structure */
-                    for (u=0; u < visible->num_regions; u++) {
-
-                         /* clip the visible regions to the update region */
-                         if (!dfb_region_intersects( &visible->regions[u], x1, y1, x2, y2 ))
-                              continue;
-
-                         lr = dfb_linkregionpool_get( &regionpool, &visible->regions[u] );
-                         dfb_region_clip( &lr->region, x1, y1, x2, y2 );
-                         direct_list_append( &updates, &lr->link );
-                    }
+                    lr = dfb_linkregionpool_get( &regionpool, &visible->regions[u] );
+                    dfb_region_clip( &lr->region, x1, y1, x2, y2 );
+                    direct_list_append( &updates, &lr->link );
+               }
 
-                    DFBLinkRegion *linkRegion = 0;
-                    direct_list_foreach(linkRegion, updates) {
-
-                         /* optimizing!
-                            check for intersections between to-be-drawn lower windows
-                            and this window.
-                              If intersection with blend: -> blend.
-                              If intersection with noBlend: -> blend, double source
-                              Else: draw opaque (add to noBlend).
-                         */
-
-                         for (u=winNum-1; u>=0; u--) {
-                              direct_list_foreach(lr, updatesBlend[u]) {
-                                   DFBRegion *R = &linkRegion->region;
-                                   r = &lr->region;
-                                   if (dfb_region_region_intersects( R, r )) {
-                                        /* overlap with other window! */
-
-                                        /* re-add remaing sections to reconsider */
-                                        dfb_linkregionpool_add_allowedpartofregion( &regionpool, &updates, R, r );
-
-                                        /* add intersection to updatesBlend[winNum] */
-                                        dfb_region_clip( R, r->x1, r->y1, r->x2, r->y2 );
-                                        DFBLinkRegion *lnk = dfb_linkregionpool_get( &regionpool, R );
-                                        direct_list_append( &updatesBlend[winNum], &lnk->link );
-
-                                        goto continueupdates;
-                                   }
+               DFBLinkRegion *linkRegion = 0;
+               direct_list_foreach(linkRegion, updates) {
+
+                    /* optimizing!
+                       check for intersections between to-be-drawn lower windows
+                       and this window.
+                         If intersection with blend: -> blend.
+                         If intersection with noBlend: -> blend, double source
+                         Else: draw opaque (add to noBlend).
+                    */
+
+                    for (u=winNum-1; u>=0; u--) {
+                         direct_list_foreach(lr, updatesBlend[u]) {
+                              DFBRegion *R = &linkRegion->region;
+                              r = &lr->region;
+                              if (dfb_region_region_intersects( R, r )) {
+                                   /* overlap with other window! */
+
+                                   /* re-add remaing sections to reconsider */
+                                   dfb_linkregionpool_add_allowedpartofregion( &regionpool, &updates, R, r );
+
+                                   /* add intersection to updatesBlend[winNum] */
+                                   dfb_region_clip( R, r->x1, r->y1, r->x2, r->y2 );
+                                   DFBLinkRegion *lnk = dfb_linkregionpool_get( &regionpool, R );
+                                   direct_list_append( &updatesBlend[winNum], &lnk->link );
+
+                                   goto continueupdates;
                               }
-                              direct_list_foreach(lr, updatesNoBlend[u]) {
-                                   DFBRegion *R = &linkRegion->region;
-                                   r = &lr->region;
-                                   if (dfb_region_region_intersects( R, r )) {
-                                        /* overlap with other window! */
-                                        /* intersection, blend double source */
-
-                                        /* reorganise overlapped window;
-                                         * we need to cut out the intersection,
-                                         * and change the original entry to new ones */
-                                        dfb_linkregionpool_add_allowedpartofregion( &regionpool, &updatesNoBlend[u], r, R );
-                                        direct_list_remove( &updatesNoBlend[u], &lr->link );
-
-                                        /* re-add remaing sections to reconsider */
-                                        dfb_linkregionpool_add_allowedpartofregion( &regionpool, &updates, R, r );
-
-                                        /* proceed to draw immediately
-                                         * we can store the window in another list, but this is more efficient */
-                                        dfb_region_clip( R, r->x1, r->y1, r->x2, r->y2 );
-                                        SaWManWindow *sw = fusion_vector_at( &sawman->layout, u );
-                                        D_DEBUG_AT( SaWMan_Update, "     > window %d and %d\n", u, winNum );
-                                        D_DEBUG_AT( SaWMan_Update, "     > nb %4d,%4d-%4dx%4d\n", DFB_RECTANGLE_VALS_FROM_REGION(R) );
-                                        sawman_draw_two_windows( tier, sw, sawwin, state, R, right_eye );
-
-                                        goto continueupdates;
-                                   }
+                         }
+                         direct_list_foreach(lr, updatesNoBlend[u]) {
+                              DFBRegion *R = &linkRegion->region;
+                              r = &lr->region;
+                              if (dfb_region_region_intersects( R, r )) {
+                                   /* overlap with other window! */
+                                   /* intersection, blend double source */
+
+                                   /* reorganise overlapped window;
+                                    * we need to cut out the intersection,
+                                    * and change the original entry to new ones */
+                                   dfb_linkregionpool_add_allowedpartofregion( &regionpool, &updatesNoBlend[u], r, R );
+                                   direct_list_remove( &updatesNoBlend[u], &lr->link );
+
+                                   /* re-add remaing sections to reconsider */
+                                   dfb_linkregionpool_add_allowedpartofregion( &regionpool, &updates, R, r );
+
+                                   /* proceed to draw immediately
+                                    * we can store the window in another list, but this is more efficient */
+                                   dfb_region_clip( R, r->x1, r->y1, r->x2, r->y2 );
+                                   SaWManWindow *sw = fusion_vector_at( &sawman->layout, u );
+                                   D_DEBUG_AT( SaWMan_Update, "     > window %d and %d\n", u, winNum );
+                                   D_DEBUG_AT( SaWMan_Update, "     > nb %4d,%4d-%4dx%4d\n", DFB_RECTANGLE_VALS_FROM_REGION(R) );
+                                   sawman_draw_two_windows( tier, sw, sawwin, state, R, right_eye );
+
+                                   goto continueupdates;
                               }
                          }
+                    }
 
-                         /* if we came here, it is a non-overlapping dull window */
-                         DFBLinkRegion *lnk;
+                    /* if we came here, it is a non-overlapping dull window */
+                    DFBLinkRegion *lnk;
 
-                         lnk = dfb_linkregionpool_get( &regionpool, &linkRegion->region );
-                         direct_list_append( &updatesNoBlend[winNum], &lnk->link );
-                         lnk = dfb_linkregionpool_get( &regionpool, &linkRegion->region );
-                         direct_list_append( &backgroundNotNeeded, &lnk->link );
+                    lnk = dfb_linkregionpool_get( &regionpool, &linkRegion->region );
+                    direct_list_append( &updatesNoBlend[winNum], &lnk->link );
+                    lnk = dfb_linkregionpool_get( &regionpool, &linkRegion->region );
+                    direct_list_append( &backgroundNotNeeded, &lnk->link );
 
-                         continueupdates:
-                              ;
-                    }
+                    continueupdates:
+                         ;
                }
-               else {
-                    int translucent = SAWMAN_TRANSLUCENT_WINDOW(window);
-
-                    D_DEBUG_AT( SaWMan_Update, " ---> default %s window\n",
-                                   translucent ? "blended" : "opaque" );
-
-                    /* store the updates of this window inside the update region */
-                    for (u=0; u < visible->num_regions; u++) {
-                         if (dfb_region_intersects( &visible->regions[u], x1, y1, x2, y2 )) {
-                              /* make a new region */
-                              lr = dfb_linkregionpool_get( &regionpool, &visible->regions[u] );
-                              dfb_region_clip( &lr->region, x1, y1, x2, y2 );
-                              if (translucent)
-                                   direct_list_append( &updatesBlend[winNum], &lr->link );
-                              else {
-                                   /* ignore background */
-                                   direct_list_append( &updatesNoBlend[winNum], &lr->link );
-                                   DFBLinkRegion *lrbg = dfb_linkregionpool_get( &regionpool, &lr->region );
-                                   direct_list_append( &backgroundNotNeeded, &lrbg->link );
-                              }
+          }
+          else {
+               int translucent = SAWMAN_TRANSLUCENT_WINDOW(window);
+
+               D_DEBUG_AT( SaWMan_Update, " ---> default %s window\n",
+                              translucent ? "blended" : "opaque" );
+
+               /* store the updates of this window inside the update region */
+               for (u=0; u < visible->num_regions; u++) {
+                    if (dfb_region_intersects( &visible->regions[u], x1, y1, x2, y2 )) {
+                         /* make a new region */
+                         lr = dfb_linkregionpool_get( &regionpool, &visible->regions[u] );
+                         dfb_region_clip( &lr->region, x1, y1, x2, y2 );
+                         if (translucent)
+                              direct_list_append( &updatesBlend[winNum], &lr->link );
+                         else {
+                              /* ignore background */
+                              direct_list_append( &updatesNoBlend[winNum], &lr->link );
+                              DFBLinkRegion *lrbg = dfb_linkregionpool_get( &regionpool, &lr->region );
+                              direct_list_append( &backgroundNotNeeded, &lrbg->link );
                          }
                     }
                }
@@ -925,8 +925,6 @@ update_region3( SaWMan          *sawman,
           }
      }
 
-     dfb_linkregionpool_delete( &regionpool );
-
      D_DEBUG_AT( SaWMan_Update, " -=> done <=-\n" );
 }
 
@@ -934,15 +932,16 @@ static void
 update_region4_r( SaWMan          *sawman,
                   SaWManTier      *tier,
                   CardState       *state,
+                  UpdateContext   *ctx,
                   int              start,
                   bool             right_eye,
                   DFBUpdateBin    *bin )
 {
-     int           i      = start;
+     int           i;
      CoreWindow   *window = NULL;
      SaWManWindow *sawwin = NULL;
      DFBRegion     region;
-     int           offset;
+     misc_box_t    box    = { bin->region.x1, bin->region.y1, bin->region.x2 + 1, bin->region.y2 + 1 };
 
      D_DEBUG_AT( SaWMan_Update, "%s( %p, %d, bin (%d,%d - %d,%d) )\n", __FUNCTION__, tier, start, bin->region.x1, bin->region.y1, bin->region.x2, bin->region.y2 );
 
@@ -951,56 +950,41 @@ update_region4_r( SaWMan          *sawman,
      D_MAGIC_ASSERT( state, CardState );
      D_ASSERT( start < fusion_vector_size( &sawman->layout ) );
 
-     /* find next intersecting window */
-     while (i >= 0) {
+     /* find next intersecting window, the window boxes include the stereo offset */
+     i = misc_boxes_find_last( &ctx->windows, start, &box );
+
+     /* intersecting window found? */
+     if (i >= 0) {
           sawwin = fusion_vector_at( &sawman->layout, i );
           D_MAGIC_ASSERT( sawwin, SaWManWindow );
 
           window = sawwin->window;
           D_MAGIC_COREWINDOW_ASSERT( window );
 
-          /* modify stereo offset */
-          offset = window->config.z;
-          offset *= right_eye ? -1 : 1;
-          region = DFB_REGION_INIT_FROM_RECTANGLE(&sawwin->bounds);
-          region.x1 += offset;
-          region.x2 += offset;
+          region.x1 = ctx->windows.x1[i];
+          region.y1 = ctx->windows.y1[i];
+          region.x2 = ctx->windows.x2[i] - 1;
+          region.y2 = ctx->windows.y2[i] - 1;
 
-          D_DEBUG_AT( SaWMan_Update, "%s --> window (%d,%d - %d,%d)\n", __FUNCTION__, region.x1, region.y1, region.x2, region.y2 );
-
-          D_DEBUG_AT( SaWMan_Update, "  -> %d,%d - %d,%d\n", region.x1, region.y1, region.x2, region.y2 );
-
-          if (SAWMAN_VISIBLE_WINDOW( window ) && (tier->classes & (1 << window->config.stacking))) {
-               D_DEBUG_AT( SaWMan_Update, "%s --> check intersection window (%d,%d - %d,%d) bin (%d,%d - %d,%d)\n", __FUNCTION__, region.x1, region.y1, region.x2, region.y2, bin->region.x1, bin->region.y1, bin->region.x2, bin->region.y2 );
-               if (dfb_region_intersect( &region, bin->region.x1, bin->region.y1, bin->region.x2, bin->region.y2)) {
-                    D_DEBUG_AT( SaWMan_Update, "%s --> intersection (%d,%d - %d,%d)\n", __FUNCTION__, region.x1, region.y1, region.x2, region.y2 );
-                    break;
-               }
-          }
-
-          i--;
-     }
+          dfb_region_intersect( &region, bin->region.x1, bin->region.y1, bin->region.x2, bin->region.y2 );
 
-     /* intersecting window found? */
-     if (i >= 0) {
-          D_MAGIC_ASSERT( sawwin, SaWManWindow );
-          D_MAGIC_COREWINDOW_ASSERT( window );
+          D_DEBUG_AT( SaWMan_Update, "%s --> intersection (%d,%d - %d,%d)\n", __FUNCTION__, region.x1, region.y1, region.x2, region.y2 );
 
           /* continue recursion with left intersection? */
           if (bin->region.x1 != region.x1)
-               update_region4_r( sawman, tier, state, i - 1, right_eye, dfb_update_bin_get( bin, NULL, bin->region.x1, region.y1, region.x1 - 1, region.y2, i + 1) );
+               update_region4_r( sawman, tier, state, ctx, i - 1, right_eye, dfb_update_bin_get( ctx, bin, NULL, bin->region.x1, region.y1, region.x1 - 1, region.y2, i + 1) );
 
           /* continue recursion with upper intersection? */
           if (bin->region.y1 != region.y1)
-               update_region4_r( sawman, tier, state, i - 1, right_eye, dfb_update_bin_get( bin, NULL, bin->region.x1, bin->region.y1, bin->region.x2, region.y1 - 1, i + 1) );
+               update_region4_r( sawman, tier, state, ctx, i - 1, right_eye, dfb_update_bin_get( ctx, bin, NULL, bin->region.x1, bin->region.y1, bin->region.x2, region.y1 - 1, i + 1) );
 
           /* continue recursion with right intersection? */
           if (bin->region.x2 != region.x2)
-               update_region4_r( sawman, tier, state, i - 1, right_eye, dfb_update_bin_get( bin, NULL, region.x2 + 1, region.y1, bin->region.x2, region.y2, i + 1) );
+               update_region4_r( sawman, tier, state, ctx, i - 1, right_eye, dfb_update_bin_get( ctx, bin, NULL, region.x2 + 1, region.y1, bin->region.x2, region.y2, i + 1) );
 
           /* continue recursion with lower intersection? */
           if (bin->region.y2 != region.y2)
-               update_region4_r( sawman, tier, state, i - 1, right_eye, dfb_update_bin_get( bin, NULL, bin->region.x1, region.y2 + 1, bin->region.x2, bin->region.y2, i + 1) );
+               update_region4_r( sawman, tier, state, ctx, i - 1, right_eye, dfb_update_bin_get( ctx, bin, NULL, bin->region.x1, region.y2 + 1, bin->region.x2, bin->region.y2, i + 1) );
 
           if (D_FLAGS_ARE_SET( window->config.options, DWOP_OPAQUE_REGION )) {
                DFBRegion opaque = DFB_REGION_INIT_TRANSLATED( &window->config.opaque, sawwin->bounds.x, sawwin->bounds.y );
@@ -1013,47 +997,47 @@ update_region4_r( SaWMan          *sawman,
                     /* continue recursion with left outer intersection? */
                     if (opaque.x1 != region.x1) {
                          D_DEBUG_AT( SaWMan_Update, "%s --> recursing left region(%d,%d - %d,%d)\n", __FUNCTION__, region.x1, opaque.y1, opaque.x1 - 1, opaque.y2 );
-                         update_region4_r( sawman, tier, state, i - 1, right_eye, dfb_update_bin_get( bin, sawwin, region.x1, opaque.y1, opaque.x1 - 1, opaque.y2, i + 1) );
+                         update_region4_r( sawman, tier, state, ctx, i - 1, right_eye, dfb_update_bin_get( ctx, bin, sawwin, region.x1, opaque.y1, opaque.x1 - 1, opaque.y2, i + 1) );
                     }
 
                     /* continue recursion with upper outer intersection? */
                     if (opaque.y1 != region.y1) {
                          D_DEBUG_AT( SaWMan_Update, "%s --> recursing upper region(%d,%d - %d,%d)\n",__FUNCTION__,  region.x1, region.y1, region.x2, opaque.y1 - 1 );
-                         update_region4_r( sawman, tier, state, i - 1, right_eye, dfb_update_bin_get( bin, sawwin, region.x1, region.y1, region.x2, opaque.y1 - 1, i + 1) );
+                         update_region4_r( sawman, tier, state, ctx, i - 1, right_eye, dfb_update_bin_get( ctx, bin, sawwin, region.x1, region.y1, region.x2, opaque.y1 - 1, i + 1) );
                     }
 
                     /* continue recursion with right outer intersection? */
                     if (opaque.x2 != region.x2) {
                          D_DEBUG_AT( SaWMan_Update, "%s --> recursing right region(%d,%d - %d,%d)\n", __FUNCTION__, opaque.x2 + 1, opaque.y1, region.x2, opaque.y2 );
-                         update_region4_r( sawman, tier, state, i - 1, right_eye, dfb_update_bin_get( bin, sawwin, opaque.x2 + 1, opaque.y1, region.x2, opaque.y2, i + 1) );
+                         update_region4_r( sawman, tier, state, ctx, i - 1, right_eye, dfb_update_bin_get( ctx, bin, sawwin, opaque.x2 + 1, opaque.y1, region.x2, opaque.y2, i + 1) );
                     }
 
                     /* continue recursion with lower outer intersection? */
                     if (opaque.y2 != region.y2) {
                          D_DEBUG_AT( SaWMan_Update, "%s --> recursing lower region(%d,%d - %d,%d)\n", __FUNCTION__, region.x1, opaque.y2 + 1, region.x2, region.y2 );
-                         update_region4_r( sawman, tier, state, i - 1, right_eye, dfb_update_bin_get( bin, sawwin, region.x1, opaque.y2 + 1, region.x2, region.y2, i + 1) );
+                         update_region4_r( sawman, tier, state, ctx, i - 1, right_eye, dfb_update_bin_get( ctx, bin, sawwin, region.x1, opaque.y2 + 1, region.x2, region.y2, i + 1) );
                     }
 
                     /* recursion ends on opaque inner window */
-                    update_region4_r( sawman, tier, state, -1, right_eye, dfb_update_bin_get( bin, sawwin, opaque.x1, opaque.y1, opaque.x2, opaque.y2, i + 1) );
+                    update_region4_r( sawman, tier, state, ctx, -1, right_eye, dfb_update_bin_get( ctx, bin, sawwin, opaque.x1, opaque.y1, opaque.x2, opaque.y2, i + 1) );
                }
                else {
                     D_DEBUG_AT( SaWMan_Update, "%s: no intersection found, opaque region out of the screen\n", __FUNCTION__ );
 
                     /* only draw non-opaque region */
-                    update_region4_r( sawman, tier, state, i - 1, right_eye, dfb_update_bin_get( bin, sawwin, region.x1, region.y1, region.x2, region.y2, i + 1) );
+                    update_region4_r( sawman, tier, state, ctx, i - 1, right_eye, dfb_update_bin_get( ctx, bin, sawwin, region.x1, region.y1, region.x2, region.y2, i + 1) );
                }
           }
           else if (SAWMAN_TRANSLUCENT_WINDOW( window )) {
                /* continue recursion on window */
-               update_region4_r( sawman, tier, state, i - 1, right_eye, dfb_update_bin_get( bin, sawwin, region.x1, region.y1, region.x2, region.y2, i + 1) );
+               update_region4_r( sawman, tier, state, ctx, i - 1, right_eye, dfb_update_bin_get( ctx, bin, sawwin, region.x1, region.y1, region.x2, region.y2, i + 1) );
           }
           else {
                /* recursion ends on opaque window */
-               update_region4_r( sawman, tier, state, -1, right_eye, dfb_update_bin_get( bin, sawwin, region.x1, region.y1, region.x2, region.y2, i + 1) );
+               update_region4_r( sawman, tier, state, ctx, -1, right_eye, dfb_update_bin_get( ctx, bin, sawwin, region.x1, region.y1, region.x2, region.y2, i + 1) );
           }
 
-          free( bin );
+          dfb_update_bin_put( ctx, bin );
      }
      else {
           D_DEBUG_AT( SaWMan_Update, "%s --> terminate bin->curr=%d bin->size=%d bin (%d,%d - %d,%d)\n", __FUNCTION__, bin->curr, bin->size, bin->region.x1, bin->region.y1, bin->region.x2, bin->region.y2 );
@@ -1062,7 +1046,7 @@ update_region4_r( SaWMan          *sawman,
           if (bin->size < 1) {
                sawman_draw_background( tier, state, &bin->region );
 
-               free( bin );
+               dfb_update_bin_put( ctx, bin );
           }
           else {
                CoreWindow      *window  = dfb_update_bin_window_get(bin, bin->curr - 1)->window;
@@ -1098,9 +1082,9 @@ update_region4_r( SaWMan          *sawman,
                     }
                     /* continue with next window on top? */
                     if (bin->curr >= 1)
-                         update_region4_r( sawman, tier, state, -1, right_eye, bin );
+                         update_region4_r( sawman, tier, state, ctx, -1, right_eye, bin );
                     else
-                         free( bin );
+                         dfb_update_bin_put( ctx, bin );
                }
                else {
                     /* single blend */
@@ -1110,10 +1094,10 @@ update_region4_r( SaWMan          *sawman,
                     if (bin->curr > 1) {
                          bin->curr--;
 
-                         update_region4_r( sawman, tier, state, -1, right_eye, bin );
+                         update_region4_r( sawman, tier, state, ctx, -1, right_eye, bin );
                     }
                     else {
-                         free( bin );
+                         dfb_update_bin_put( ctx, bin );
                     }
                }
           }
@@ -1124,6 +1108,7 @@ static void
 update_region4( SaWMan          *sawman,
                 SaWManTier      *tier,
                 CardState       *state,
+                UpdateContext   *ctx,
                 int              start,
                 int              x1,
                 int              y1,
@@ -1146,7 +1131,211 @@ update_region4( SaWMan          *sawman,
           sawman_draw_background( tier, state, &region);
      }
      else {
-          update_region4_r( sawman, tier, state, start, right_eye, dfb_update_bin_get( NULL, NULL, x1, y1, x2, y2, start + 1) );
+          update_region4_r( sawman, tier, state, ctx, start, right_eye, dfb_update_bin_get( ctx, NULL, NULL, x1, y1, x2, y2, start + 1) );
+     }
+}
+
+/*
+ * Window drawn by update_region5() with its area not covered by opaque content above.
+ */
+typedef struct {
+     SaWManWindow  *sawwin;
+     misc_region_t  draw;        /* visible part within the update */
+     misc_region_t  opaque;      /* part of 'draw' without blending */
+} OcclusionEntry;
+
+static bool
+window_opaque_regions( const CoreWindow   *window,
+                       const DFBRectangle *dst,
+                       misc_box_t         *boxes,
+                       int                *ret_num )
+{
+     int              i, num;
+     const DFBRegion *regions;
+
+     if (window->config.opacity < 0xff || (window->config.options & (DWOP_COLORKEYING | DWOP_INPUTONLY)) ||
+         (window->caps & DWCAPS_INPUTONLY) || window->config.dst_geometry.mode != DWGM_DEFAULT)
+          return false;
+
+     /* whole window */
+     if (!(window->config.options & DWOP_ALPHACHANNEL)) {
+          misc_region_rects_to_boxes( boxes, dst, 1 );
+
+          *ret_num = 1;
+
+          return true;
+     }
+
+     if (!(window->config.options & DWOP_OPAQUE_REGION))
+          return false;
+
+     if (window->config.num_opaque_regions) {
+          regions = window->config.opaque_regions;
+          num     = window->config.num_opaque_regions;
+     }
+     else {
+          regions = &window->config.opaque;
+          num     = 1;
+     }
+
+     for (i=0; i<num; i++) {
+          boxes[i].x1 = dst->x + regions[i].x1;
+          boxes[i].y1 = dst->y + regions[i].y1;
+          boxes[i].x2 = dst->x + regions[i].x2 + 1;
+          boxes[i].y2 = dst->y + regions[i].y2 + 1;
+     }
+
+     *ret_num = num;
+
+     return true;
+}
+
+static void
+draw_region_boxes( SaWManTier    *tier,
+                   SaWManWindow  *sawwin,
+                   CardState     *state,
+                   misc_region_t *region,
+                   bool           alpha_channel,
+                   bool           right_eye )
+{
+     int         n, num;
+     misc_box_t *boxes = misc_region_boxes( region, &num );
+
+     for (n=0; n<num; n++) {
+          DFBRegion draw = { boxes[n].x1, boxes[n].y1, boxes[n].x2 - 1, boxes[n].y2 - 1 };
+
+          if (sawwin)
+               sawman_draw_window( tier, sawwin, state, &draw, alpha_channel, right_eye );
+          else
+               sawman_draw_background( tier, state, &draw );
+     }
+}
+
+/*
+ * Builds an occlusion map front to back, i.e. the union of all opaque content from the top window down, and gives
+ * each window only the part of the update not covered yet. The walk ends as soon as the update is fully covered.
+ * Windows are then drawn back to front, opaque parts without blending, so nothing hidden is blended or copied.
+ */
+static void
+update_region5( SaWMan          *sawman,
+                SaWManTier      *tier,
+                CardState       *state,
+                UpdateContext   *ctx,
+                int              start,
+                int              x1,
+                int              y1,
+                int              x2,
+                int              y2,
+                bool             right_eye )
+{
+     int             i, n;
+     int             num     = 0;
+     misc_box_t      extents = { x1, y1, x2 + 1, y2 + 1 };
+     misc_region_t   covered;
+     misc_region_t   clear;
+     OcclusionEntry *entries;
+
+     D_DEBUG_AT( SaWMan_Update, "%s( %p, %d, %d,%d - %d,%d )\n", __FUNCTION__, tier, start, x1, y1, x2, y2 );
+
+     D_MAGIC_ASSERT( sawman, SaWMan );
+     D_MAGIC_ASSERT( tier, SaWManTier );
+     D_MAGIC_ASSERT( state, CardState );
+     D_ASSERT( start < fusion_vector_size( &sawman->layout ) );
+     D_ASSUME( x1 <= x2 );
+     D_ASSUME( y1 <= y2 );
+
+     if (x1 > x2 || y1 > y2)
+          return;
+
+     entries = misc_region_arena_alloc( &ctx->arena, MAX( start + 1, 1 ) * sizeof(OcclusionEntry) );
+     if (!entries) {
+          update_region4( sawman, tier, state, ctx, start, x1, y1, x2, y2, right_eye );
+          return;
+     }
+
+     misc_region_init_in_arena( &covered, &ctx->arena );
+
+     /* front to back, collecting the uncovered part of each window */
+     for (i = misc_boxes_find_last( &ctx->windows, start, &extents ); i >= 0;
+          i = misc_boxes_find_last( &ctx->windows, i - 1, &extents ))
+     {
+          SaWManWindow   *sawwin;
+          CoreWindow     *window;
+          OcclusionEntry *entry;
+          DFBRectangle    dst;
+          misc_box_t      box;
+          misc_box_t      opaque[DFB_WINDOW_OPAQUE_REGIONS_MAX];
+          int             num_opaque;
+
+          sawwin = fusion_vector_at( &sawman->layout, i );
+          D_MAGIC_ASSERT( sawwin, SaWManWindow );
+
+          window = sawwin->window;
+          D_MAGIC_COREWINDOW_ASSERT( window );
+
+          entry = &entries[num];
+
+          box.x1 = MAX( extents.x1, ctx->windows.x1[i] );
+          box.y1 = MAX( extents.y1, ctx->windows.y1[i] );
+          box.x2 = MIN( extents.x2, ctx->windows.x2[i] );
+          box.y2 = MIN( extents.y2, ctx->windows.y2[i] );
+
+          /* draw = window & update - covered */
+          misc_region_init_with_extents_in_arena( &entry->draw, &ctx->arena, &box );
+          misc_region_subtract( &entry->draw, &entry->draw, &covered );
+
+          if (misc_region_is_empty( &entry->draw )) {
+               D_DEBUG_AT( SaWMan_Update, "  -> [%d] occluded\n", i );
+               continue;
+          }
+
+          entry->sawwin = sawwin;
+
+          misc_region_init_in_arena( &entry->opaque, &ctx->arena );
+
+          dst = sawwin->dst;
+          dfb_rectangle_translate( &dst, right_eye ? -window->config.z : window->config.z, 0 );
+
+          if (window_opaque_regions( window, &dst, opaque, &num_opaque )) {
+               misc_region_t region;
+
+               if (misc_region_init_boxes_in_arena( &region, &ctx->arena, opaque, num_opaque )) {
+                    /* opaque = draw & opaque regions */
+                    misc_region_intersect( &entry->opaque, &entry->draw, &region );
+
+                    /* covered |= opaque */
+                    misc_region_union( &covered, &covered, &entry->opaque );
+               }
+          }
+
+          MISC_REGION_DEBUG_AT( SaWMan_Update, &entry->draw, "draw" );
+          MISC_REGION_DEBUG_AT( SaWMan_Update, &entry->opaque, "opaque" );
+
+          num++;
+
+          if (misc_region_contains_rectangle( &covered, &extents ) == MISC_REGION_IN) {
+               D_DEBUG_AT( SaWMan_Update, "  -> [%d] covers the rest\n", i );
+               break;
+          }
+     }
+
+     /* background where nothing opaque is on top */
+     misc_region_init_with_extents_in_arena( &clear, &ctx->arena, &extents );
+     misc_region_subtract( &clear, &clear, &covered );
+
+     draw_region_boxes( tier, NULL, state, &clear, false, right_eye );
+
+     /* back to front */
+     for (n=num-1; n>=0; n--) {
+          OcclusionEntry *entry = &entries[n];
+
+          if (misc_region_not_empty( &entry->opaque )) {
+               draw_region_boxes( tier, entry->sawwin, state, &entry->opaque, false, right_eye );
+
+               misc_region_subtract( &entry->draw, &entry->draw, &entry->opaque );
+          }
+
+          draw_region_boxes( tier, entry->sawwin, state, &entry->draw, true, right_eye );
      }
 }
 
@@ -1221,7 +1410,7 @@ sawman_flush_updating( SaWMan     *sawman,
           dfb_layer_region_flip_update( tier->region, &tier->left.updated.bounding, DSFLIP_ONSYNC | DSFLIP_SWAP );
 
 
-     if (left_num_regions) {
+     if (left_num_regions && !sawman_use_damage_history( tier )) {
           D_DEBUG_AT( SaWMan_Surface, "  -> copying %d updated regions (F->B)\n", left_num_regions );
 
           for (i=0; i<left_num_regions; i++) {
@@ -1248,6 +1437,74 @@ sawman_flush_updating( SaWMan     *sawman,
      }
 }
 
+/*
+ * Collects the window bounds as used by the update_region variant.
+ */
+static void
+update_context_init( UpdateContext *ctx,
+                     SaWMan        *sawman,
+                     SaWManTier    *tier,
+                     int            mode,
+                     bool           right_eye,
+                     void          *buffer,
+                     size_t         size )
+{
+     int           i;
+     SaWManWindow *sawwin;
+
+     misc_region_arena_init( &ctx->layout, buffer, size / 4 );
+     misc_region_arena_init( &ctx->arena, (u8*) buffer + size / 4, size - size / 4 );
+
+     ctx->bins = NULL;
+
+     /* update_region2 does not look up windows by bounds */
+     if (mode == 2 || !misc_boxes_init( &ctx->windows, &ctx->layout, fusion_vector_size( &sawman->layout ) )) {
+          ctx->windows.num = 0;
+          return;
+     }
+
+     fusion_vector_foreach (sawwin, i, sawman->layout) {
+          CoreWindow   *window = sawwin->window;
+          DFBRectangle  bounds;
+          misc_box_t    box;
+
+          D_MAGIC_ASSERT( sawwin, SaWManWindow );
+          D_MAGIC_COREWINDOW_ASSERT( window );
+
+          if (!SAWMAN_VISIBLE_WINDOW( window ) || !(tier->classes & (1 << window->config.stacking))) {
+               misc_boxes_set( &ctx->windows, i, NULL );
+               continue;
+          }
+
+          switch (mode) {
+               case 1:
+                    bounds = sawwin->bounds;
+                    break;
+
+               case 3:
+                    bounds = window->config.bounds;
+                    bounds.x += right_eye ? -window->config.z : window->config.z;
+                    break;
+
+               default:
+                    bounds = sawwin->bounds;
+                    bounds.x += right_eye ? -window->config.z : window->config.z;
+                    break;
+          }
+
+          misc_region_rects_to_boxes( &box, &bounds, 1 );
+
+          misc_boxes_set( &ctx->windows, i, &box );
+     }
+}
+
+static void
+update_context_deinit( UpdateContext *ctx )
+{
+     misc_region_arena_deinit( &ctx->arena );
+     misc_region_arena_deinit( &ctx->layout );
+}
+
 static void
 repaint_tier( SaWMan              *sawman,
               SaWManTier          *tier,
@@ -1263,6 +1520,8 @@ repaint_tier( SaWMan              *sawman,
      CoreSurface     *surface;
      DFBRegion        cursor_inter;
      CoreWindowStack *stack;
+     UpdateContext    ctx;
+     long             ctx_buffer[1024];
 
      D_MAGIC_ASSERT( sawman, SaWMan );
      D_MAGIC_ASSERT( tier, SaWManTier );
@@ -1289,7 +1548,7 @@ repaint_tier( SaWMan              *sawman,
 
      D_DEBUG_AT( SaWMan_Update, "%s( %p, %p )\n", __FUNCTION__, sawman, tier );
 
-     sawman_dispatch_tier_update( sawman, tier, right_eye, updates, num_updates );
+     update_context_init( &ctx, sawman, tier, sawman_config->update_region_mode, right_eye, ctx_buffer, sizeof(ctx_buffer) );
 
      for (i=0; i<num_updates; i++) {
           const DFBRegion *update = &updates[i];
@@ -1316,23 +1575,34 @@ repaint_tier( SaWMan              *sawman,
           dfb_state_set_clip( state, update );
 
           /* Compose updated region. */
+          misc_region_arena_reset( &ctx.arena );
+
+          ctx.bins = NULL;
+
           switch (sawman_config->update_region_mode) {
                case 1:
-                    update_region( sawman, tier, state,
+                    update_region( sawman, tier, state, &ctx,
                                    fusion_vector_size( &sawman->layout ) - 1,
                                    update->x1, update->y1, update->x2, update->y2,
                                    right_eye );
 
                     break;
                case 3:
-                    update_region3( sawman, tier, state,
+                    update_region3( sawman, tier, state, &ctx,
                                     fusion_vector_size( &sawman->layout ) - 1,
                                     update->x1, update->y1, update->x2, update->y2,
                                     right_eye );
 
                     break;
                case 4:
-                    update_region4( sawman, tier, state,
+                    update_region4( sawman, tier, state, &ctx,
+                                    fusion_vector_size( &sawman->layout ) - 1,
+                                    update->x1, update->y1, update->x2, update->y2,
+                                    right_eye );
+
+                    break;
+               case 5:
+                    update_region5( sawman, tier, state, &ctx,
                                     fusion_vector_size( &sawman->layout ) - 1,
                                     update->x1, update->y1, update->x2, update->y2,
                                     right_eye );
@@ -1340,7 +1610,7 @@ repaint_tier( SaWMan              *sawman,
                     break;
                case 2:
                default:
-                    update_region2( sawman, tier, state,
+                    update_region2( sawman, tier, state, &ctx,
                                     fusion_vector_size( &sawman->layout ) - 1,
                                     update->x1, update->y1, update->x2, update->y2,
                                     right_eye );
@@ -1375,6 +1645,8 @@ repaint_tier( SaWMan              *sawman,
           }
      }
 
+     update_context_deinit( &ctx );
+
      /* Reset destination. */
      state->destination  = NULL;
      state->modified    |= SMF_DESTINATION;
@@ -1955,6 +2227,56 @@ set_config( SaWMan     *sawman,
      return DFB_OK;
 }
 
+/*
+ * Using the damage history of the region, the back buffer is brought up to date by repainting
+ * everything that changed since it has been shown, instead of copying back after each flip.
+ */
+bool
+sawman_use_damage_history( SaWManTier *tier )
+{
+     CoreLayerRegion *region;
+
+     D_MAGIC_ASSERT( tier, SaWManTier );
+
+     region = tier->region;
+     D_ASSERT( region != NULL );
+
+     if (dfb_config->wm_fullscreen_updates || (region->config.options & DLOP_STEREO))
+          return false;
+
+     return region->config.buffermode == DLBM_BACKVIDEO || region->config.buffermode == DLBM_TRIPLE;
+}
+
+void
+sawman_repair_back_buffer( SaWMan     *sawman,
+                           SaWManTier *tier,
+                           WMData     *wmdata )
+{
+     DFBRegion  regions[16];
+     DFBUpdates damage;
+
+     D_MAGIC_ASSERT( sawman, SaWMan );
+     D_MAGIC_ASSERT( tier, SaWManTier );
+
+     if (!sawman_use_damage_history( tier ))
+          return;
+
+     /* With triple buffering the back buffer is repaired by the first update of a frame only. */
+     if (tier->region->config.buffermode == DLBM_TRIPLE && tier->left.updating.num_regions)
+          return;
+
+     dfb_updates_init( &damage, regions, D_ARRAY_SIZE(regions) );
+
+     if (dfb_layer_region_get_damage( tier->region, &damage )) {
+          dfb_updates_reset( &damage );
+          dfb_updates_add_rect( &damage, 0, 0, tier->size.w, tier->size.h );
+     }
+
+     D_DEBUG_AT( SaWMan_Update, "%s( %p, %p ) <- %d region(s)\n", __FUNCTION__, sawman, tier, damage.num_regions );
+
+     repaint_tier( sawman, tier, damage.regions, damage.num_regions, DSFLIP_NONE, false, wmdata );
+}
+
 static DFBResult
 process_updates( SaWMan              *sawman,
                  SaWManTier          *tier,
@@ -1977,11 +2299,13 @@ process_updates( SaWMan              *sawman,
 
      if (dfb_config->wm_fullscreen_updates) {
           if (tier->left.updates.num_regions > 0) {
+               sawman_dispatch_tier_update( sawman, tier, false, &full_tier_region, 1 );
                repaint_tier( sawman, tier, &full_tier_region, 1, flags, false, wmdata );
                dfb_updates_reset( &tier->left.updates );
           }
 
           if (tier->right.updates.num_regions > 0) {
+               sawman_dispatch_tier_update( sawman, tier, true, &full_tier_region, 1 );
                repaint_tier( sawman, tier, &full_tier_region, 1, flags, true, wmdata );
                dfb_updates_reset( &tier->right.updates );
           }
@@ -2032,12 +2356,23 @@ process_updates( SaWMan              *sawman,
      if (left_num) {
           dfb_regions_unite( &left_united, left_updates, left_num );
 
+          sawman_dispatch_tier_update( sawman, tier, false, left_updates, left_num );
+
+          /* Repaint what the back buffer is missing. */
+          sawman_repair_back_buffer( sawman, tier, wmdata );
+
           repaint_tier( sawman, tier, left_updates, left_num, flags, false, wmdata );
+
+          /* Record the actual damage for the flip. */
+          if (sawman_use_damage_history( tier ))
+               dfb_layer_region_add_damage( tier->region, left_updates, left_num );
      }
 
      if (right_num) {
           dfb_regions_unite( &right_united, right_updates, right_num );
 
+          sawman_dispatch_tier_update( sawman, tier, true, right_updates, right_num );
+
           repaint_tier( sawman, tier, right_updates, right_num, flags, true, wmdata );
      }
 
@@ -2093,7 +2428,7 @@ process_updates( SaWMan              *sawman,
                     /* Flip the whole region. */
                     dfb_layer_region_flip_update( tier->region, &left_united, flags | DSFLIP_WAITFORSYNC | DSFLIP_SWAP );
 
-                    if (!dfb_config->wm_fullscreen_updates) {
+                    if (!dfb_config->wm_fullscreen_updates && !sawman_use_damage_history( tier )) {
                          /* Copy back the updated region. */
                          dfb_gfx_copy_regions_client( tier->region->surface, CSBR_FRONT, DSSE_LEFT, tier->region->surface, CSBR_BACK, DSSE_LEFT, left_updates, left_num, 0, 0, &wmdata->client );
                     }
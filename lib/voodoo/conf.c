@@ -59,6 +59,8 @@ static const char *config_usage =
      "  compression-min=<bytes>        Enable compression (if != 0) for packets with at least num bytes\n"
      "  [no-]link-raw                  Set link mode to 'raw'\n"
      "  [no-]link-packet               Set link mode to 'packet'\n"
+     "  [no-]link-shm                  Use shared memory for packet links via Unix Domain sockets (default: no)\n"
+     "  [no-]surface-delta             Send only changed tiles of surface data written by clients (default: no)\n"
      "\n";
 
 /**********************************************************************************************************************/
@@ -260,6 +262,18 @@ voodoo_config_set( const char *name, const char *value )
      } else
      if (strcmp (name, "no-link-packet" ) == 0) {
           voodoo_config->link_packet = false;
+     } else
+     if (strcmp (name, "link-shm" ) == 0) {
+          voodoo_config->link_shm = true;
+     } else
+     if (strcmp (name, "no-link-shm" ) == 0) {
+          voodoo_config->link_shm = false;
+     } else
+     if (strcmp (name, "surface-delta" ) == 0) {
+          voodoo_config->surface_delta = true;
+     } else
+     if (strcmp (name, "no-surface-delta" ) == 0) {
+          voodoo_config->surface_delta = false;
      } else
           return DR_UNSUPPORTED;
 
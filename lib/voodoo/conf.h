@@ -50,6 +50,8 @@ struct __V_VoodooConfig {
      unsigned int    compression_min;
      bool            link_raw;
      bool            link_packet;
+     bool            link_shm;
+     bool            surface_delta;
 };
 
 extern VoodooConfig VOODOO_API *voodoo_config;
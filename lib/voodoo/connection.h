@@ -73,6 +73,9 @@ public:
      virtual VoodooPacket *GetPacket( size_t        length ) = 0;
      virtual void          PutPacket( VoodooPacket *packet,
                                       bool          flush ) = 0;
+
+     /* Flush the packet being filled by the calling thread, if any */
+     virtual void          FlushPacket() = 0;
 };
 
 
@@ -201,6 +201,22 @@ VoodooConnectionLink::PutPacket( VoodooPacket *packet, bool flush )
      }
 }
 
+void
+VoodooConnectionLink::FlushPacket()
+{
+     D_DEBUG_AT( Voodoo_Connection, "VoodooConnectionLink::%s( %p )\n", __func__, this );
+
+     D_MAGIC_ASSERT( this, VoodooConnection );
+
+     Packets *packets = (Packets*) direct_tls_get( output.tls );
+
+     if (packets && packets->active) {
+          Flush( packets->active );
+
+          packets->active = NULL;
+     }
+}
+
 void
 VoodooConnectionLink::Stop()
 {
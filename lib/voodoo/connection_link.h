@@ -72,6 +72,7 @@ public:
      virtual VoodooPacket *GetPacket( size_t        length );
      virtual void          PutPacket( VoodooPacket *packet,
                                       bool          flush );
+     virtual void          FlushPacket();
 
      virtual void          Stop     ();
      virtual void          WakeUp   ();
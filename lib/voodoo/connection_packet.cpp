@@ -159,7 +159,10 @@ VoodooConnectionPacket::io_loop()
 
                          D_ASSERT( packet->sending );
 
-                         if (voodoo_config->compression_min && packet->size() >= voodoo_config->compression_min) {
+                         /* Compression does not pay off when copying through shared memory */
+                         if (!(link->code & VOODOO_LINK_CODE_SHM) &&
+                             voodoo_config->compression_min && packet->size() >= voodoo_config->compression_min)
+                         {
                               output.sending = VoodooPacket::Compressed( packet );
 
                               if (output.sending->flags() & VPHF_COMPRESSED) {
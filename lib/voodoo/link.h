@@ -36,6 +36,10 @@
 #include <voodoo/types.h>
 
 
+/* Bit in the link code of packet links exchanging data via shared memory */
+#define VOODOO_LINK_CODE_SHM   0x00010000
+
+
 typedef struct {
      void   *ptr;
      size_t  length;
@@ -165,6 +165,12 @@ VoodooManager::~VoodooManager()
      /* Remove connection */
      delete connection;
 
+     /* Free responses to deferred requests never collected. */
+     for (ResponseMap::iterator it = response.deferred.begin(); it != response.deferred.end(); it++) {
+          if (it->second)
+               D_FREE( it->second );
+     }
+
      /* Destroy conditions. */
      direct_waitqueue_deinit( &response.wait_get );
      direct_waitqueue_deinit( &response.wait_put );
@@ -391,6 +397,33 @@ VoodooManager::handle_response( VoodooResponseMessage *msg )
 
      direct_mutex_lock( &response.lock );
 
+     /* Responses to deferred requests are copied, not blocking the dispatch until collected */
+     if (!response.deferred.empty() || !response.discarded.empty()) {
+          ResponseMap::iterator it = response.deferred.find( msg->request );
+
+          if (it != response.deferred.end()) {
+               D_ASSERT( it->second == NULL );
+
+               it->second = (VoodooResponseMessage*) D_MALLOC( msg->header.size );
+               if (it->second)
+                    direct_memcpy( it->second, msg, msg->header.size );
+               else
+                    D_OOM();
+
+               direct_waitqueue_broadcast( &response.wait_get );
+
+               direct_mutex_unlock( &response.lock );
+               return;
+          }
+
+          if (response.discarded.erase( msg->request )) {
+               D_DEBUG_AT( Voodoo_Dispatch, "  -> discarded\n" );
+
+               direct_mutex_unlock( &response.lock );
+               return;
+          }
+     }
+
      D_ASSERT( response.current == NULL );
 
      response.current = msg;
@@ -697,17 +730,15 @@ VoodooManager::write_blocks( void                     *dst,
 }
 
 DirectResult
-VoodooManager::do_request( VoodooInstanceID         instance,
-                           VoodooMethodID           method,
-                           VoodooRequestFlags       flags,
-                           VoodooResponseMessage  **ret_response,
-                           VoodooMessageBlock      *blocks,
-                           size_t                   num_blocks,
-                           size_t                   data_size )
+VoodooManager::send_request( VoodooInstanceID         instance,
+                             VoodooMethodID           method,
+                             VoodooRequestFlags       flags,
+                             bool                     deferred,
+                             VoodooMessageBlock      *blocks,
+                             size_t                   num_blocks,
+                             size_t                   data_size,
+                             VoodooMessageSerial     *ret_serial )
 {
-     D_DEBUG_AT( Voodoo_Manager, "VoodooManager::%s( %p )\n", __func__, this );
-
-     DirectResult          ret;
      size_t                size;
      VoodooPacket         *packet;
      VoodooMessageSerial   serial;
@@ -715,8 +746,6 @@ VoodooManager::do_request( VoodooInstanceID         instance,
 
      D_MAGIC_ASSERT( this, VoodooManager );
      D_ASSERT( instance != VOODOO_INSTANCE_NONE );
-     D_ASSERT( ret_response != NULL || !(flags & VREQ_RESPOND) );
-     D_ASSUME( (flags & (VREQ_RESPOND | VREQ_QUEUE)) != (VREQ_RESPOND | VREQ_QUEUE) );
 
      D_DEBUG_AT( Voodoo_Manager, "  -> Instance %u, method %u, flags 0x%08x...\n", instance, method, flags );
 
@@ -752,13 +781,51 @@ VoodooManager::do_request( VoodooInstanceID         instance,
      /* Append custom data. */
      write_blocks( msg + 1, blocks, num_blocks );
 
+     /* Announce the deferred request before the response can arrive. */
+     if (deferred) {
+          direct_mutex_lock( &response.lock );
+
+          response.deferred[serial] = NULL;
+
+          direct_mutex_unlock( &response.lock );
+     }
+
 
-     D_DEBUG_AT( Voodoo_Manager, "  -> Sending REQUEST message %llu to %u::%u %s(" _ZU " bytes).\n",
-                 (unsigned long long)serial, instance, method, (flags & VREQ_RESPOND) ? "[RESPONDING] " : "", size );
+     D_DEBUG_AT( Voodoo_Manager, "  -> Sending REQUEST message %llu to %u::%u %s%s(" _ZU " bytes).\n",
+                 (unsigned long long)serial, instance, method, (flags & VREQ_RESPOND) ? "[RESPONDING] " : "",
+                 deferred ? "[DEFERRED] " : "", size );
 
      /* Unlock the output buffer. */
      connection->PutPacket( packet, !(flags & VREQ_QUEUE) );
 
+     *ret_serial = serial;
+
+     return DR_OK;
+}
+
+DirectResult
+VoodooManager::do_request( VoodooInstanceID         instance,
+                           VoodooMethodID           method,
+                           VoodooRequestFlags       flags,
+                           VoodooResponseMessage  **ret_response,
+                           VoodooMessageBlock      *blocks,
+                           size_t                   num_blocks,
+                           size_t                   data_size )
+{
+     D_DEBUG_AT( Voodoo_Manager, "VoodooManager::%s( %p )\n", __func__, this );
+
+     DirectResult          ret;
+     VoodooMessageSerial   serial;
+
+     D_MAGIC_ASSERT( this, VoodooManager );
+     D_ASSERT( instance != VOODOO_INSTANCE_NONE );
+     D_ASSERT( ret_response != NULL || !(flags & VREQ_RESPOND) );
+     D_ASSUME( (flags & (VREQ_RESPOND | VREQ_QUEUE)) != (VREQ_RESPOND | VREQ_QUEUE) );
+
+     ret = send_request( instance, method, flags, false, blocks, num_blocks, data_size, &serial );
+     if (ret)
+          return ret;
+
      /* Wait for and lock the response buffer. */
      if (flags & VREQ_RESPOND) {
           VoodooResponseMessage *response;
@@ -825,6 +892,115 @@ VoodooManager::finish_request( VoodooResponseMessage *response )
      return unlock_response( response );
 }
 
+DirectResult
+VoodooManager::do_request_deferred( VoodooInstanceID         instance,
+                                    VoodooMethodID           method,
+                                    VoodooRequestFlags       flags,
+                                    VoodooMessageSerial     *ret_serial,
+                                    VoodooMessageBlock      *blocks,
+                                    size_t                   num_blocks,
+                                    size_t                   data_size )
+{
+     D_DEBUG_AT( Voodoo_Manager, "VoodooManager::%s( %p )\n", __func__, this );
+
+     D_MAGIC_ASSERT( this, VoodooManager );
+     D_ASSERT( ret_serial != NULL );
+
+     return send_request( instance, method, (VoodooRequestFlags)(flags | VREQ_RESPOND), true,
+                          blocks, num_blocks, data_size, ret_serial );
+}
+
+DirectResult
+VoodooManager::collect_response( VoodooMessageSerial     serial,
+                                 VoodooResponseMessage **ret_response )
+{
+     D_DEBUG_AT( Voodoo_Manager, "VoodooManager::%s( %p, serial %llu )\n", __func__, this, (unsigned long long)serial );
+
+     ResponseMap::iterator it;
+
+     D_MAGIC_ASSERT( this, VoodooManager );
+     D_ASSERT( ret_response != NULL );
+
+     /* The request may still be queued by this thread. */
+     connection->FlushPacket();
+
+     direct_mutex_lock( &response.lock );
+
+     it = response.deferred.find( serial );
+     if (it == response.deferred.end()) {
+          D_BUG( "no deferred request %llu", (unsigned long long)serial );
+          direct_mutex_unlock( &response.lock );
+          return DR_ITEMNOTFOUND;
+     }
+
+     while (!it->second && !is_quit)
+          direct_waitqueue_wait( &response.wait_get, &response.lock );
+
+     if (!it->second) {
+          D_ERROR( "Voodoo/Manager: Quit while waiting for response!\n" );
+          response.deferred.erase( it );
+          direct_mutex_unlock( &response.lock );
+          return DR_DESTROYED;
+     }
+
+     *ret_response = it->second;
+
+     response.deferred.erase( it );
+
+     direct_mutex_unlock( &response.lock );
+
+     D_DEBUG_AT( Voodoo_Manager, "  -> Got response %llu (%s) with instance %u for request %llu "
+                 "(%d bytes).\n", (unsigned long long)(*ret_response)->header.serial,
+                 DirectResultString( (*ret_response)->result ), (*ret_response)->instance,
+                 (unsigned long long)(*ret_response)->request, (*ret_response)->header.size );
+
+     return DR_OK;
+}
+
+DirectResult
+VoodooManager::release_response( VoodooResponseMessage *response )
+{
+     D_DEBUG_AT( Voodoo_Manager, "VoodooManager::%s( %p )\n", __func__, this );
+
+     D_MAGIC_ASSERT( this, VoodooManager );
+     D_ASSERT( response != NULL );
+     D_ASSERT( response != this->response.current );
+
+     D_FREE( response );
+
+     return DR_OK;
+}
+
+DirectResult
+VoodooManager::discard_response( VoodooMessageSerial serial )
+{
+     D_DEBUG_AT( Voodoo_Manager, "VoodooManager::%s( %p, serial %llu )\n", __func__, this, (unsigned long long)serial );
+
+     ResponseMap::iterator it;
+
+     D_MAGIC_ASSERT( this, VoodooManager );
+
+     direct_mutex_lock( &response.lock );
+
+     it = response.deferred.find( serial );
+     if (it == response.deferred.end()) {
+          D_BUG( "no deferred request %llu", (unsigned long long)serial );
+          direct_mutex_unlock( &response.lock );
+          return DR_ITEMNOTFOUND;
+     }
+
+     if (it->second)
+          D_FREE( it->second );
+     else
+          response.discarded.insert( serial );
+
+     response.deferred.erase( it );
+
+     direct_mutex_unlock( &response.lock );
+
+     return DR_OK;
+}
+
 DirectResult
 VoodooManager::do_respond( bool                 flush,
                            VoodooMessageSerial  request,
@@ -44,6 +44,7 @@ extern "C" {
 }
 
 #include <map>
+#include <set>
 
 #include <voodoo/instance.h>
 
@@ -58,6 +59,9 @@ typedef struct {
 
 typedef std::map<VoodooInstanceID,VoodooInstance*> InstanceMap;
 
+typedef std::map<VoodooMessageSerial,VoodooResponseMessage*> ResponseMap;
+typedef std::set<VoodooMessageSerial>                        SerialSet;
+
 
 class VoodooDispatcher;
 
@@ -99,6 +103,9 @@ private:
           DirectWaitQueue        wait_get;
           DirectWaitQueue        wait_put;
           VoodooResponseMessage *current;
+
+          ResponseMap            deferred;   /* copies of responses to deferred requests, NULL until arrived */
+          SerialSet              discarded;  /* deferred requests whose responses are dropped */
      } response;
 
 
@@ -163,6 +170,21 @@ public:
 
      DirectResult finish_request       ( VoodooResponseMessage   *response );
 
+     DirectResult do_request_deferred  ( VoodooInstanceID         instance,
+                                         VoodooMethodID           method,
+                                         VoodooRequestFlags       flags,
+                                         VoodooMessageSerial     *ret_serial,
+                                         VoodooMessageBlock      *blocks = NULL,
+                                         size_t                   num_blocks = 0,
+                                         size_t                   data_size = 0 );
+
+     DirectResult collect_response     ( VoodooMessageSerial      serial,
+                                         VoodooResponseMessage  **ret_response );
+
+     DirectResult release_response     ( VoodooResponseMessage   *response );
+
+     DirectResult discard_response     ( VoodooMessageSerial      serial );
+
      DirectResult do_respond           ( bool                     flush,
                                          VoodooMessageSerial      request,
                                          DirectResult             result,
@@ -176,6 +198,15 @@ private:
                                          const VoodooMessageBlock *blocks,
                                          size_t                    num_blocks );
 
+     DirectResult send_request         ( VoodooInstanceID         instance,
+                                         VoodooMethodID           method,
+                                         VoodooRequestFlags       flags,
+                                         bool                     deferred,
+                                         VoodooMessageBlock      *blocks,
+                                         size_t                   num_blocks,
+                                         size_t                   data_size,
+                                         VoodooMessageSerial     *ret_serial );
+
      DirectResult lock_response        ( VoodooMessageSerial      request,
                                          VoodooResponseMessage  **ret_response );
 
@@ -242,6 +273,33 @@ DirectResult VOODOO_API voodoo_manager_finish_request ( VoodooManager
                                                         VoodooResponseMessage   *response );
 
 
+/*
+ * Deferred requests
+ *
+ * The request is sent with VREQ_RESPOND, but the caller does not wait. The response is kept aside until it is
+ * collected via the returned serial, so several requests can be in flight at once. Pass VREQ_QUEUE to keep the
+ * request in the output buffer, collecting any response flushes it.
+ *
+ * Each deferred request has to be either collected (and the response released) or discarded.
+ */
+
+DirectResult VOODOO_API voodoo_manager_request_deferred( VoodooManager          *manager,
+                                                         VoodooInstanceID        instance,
+                                                         VoodooMethodID          method,
+                                                         VoodooRequestFlags      flags,
+                                                         VoodooMessageSerial    *ret_serial, ... );
+
+DirectResult VOODOO_API voodoo_manager_collect_response( VoodooManager          *manager,
+                                                         VoodooMessageSerial     serial,
+                                                         VoodooResponseMessage **ret_response );
+
+DirectResult VOODOO_API voodoo_manager_release_response( VoodooManager          *manager,
+                                                         VoodooResponseMessage  *response );
+
+DirectResult VOODOO_API voodoo_manager_discard_response( VoodooManager          *manager,
+                                                         VoodooMessageSerial     serial );
+
+
 /* Response */
 
 DirectResult VOODOO_API voodoo_manager_respond        ( VoodooManager           *manager,
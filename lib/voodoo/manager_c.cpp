@@ -391,6 +391,64 @@ voodoo_manager_finish_request( VoodooManager         *manager,
      return manager->finish_request( response );
 }
 
+DirectResult
+voodoo_manager_request_deferred( VoodooManager          *manager,
+                                 VoodooInstanceID        instance,
+                                 VoodooMethodID          method,
+                                 VoodooRequestFlags      flags,
+                                 VoodooMessageSerial    *ret_serial, ... )
+{
+     DirectResult ret;
+
+     D_MAGIC_ASSERT( manager, VoodooManager );
+
+     va_list ap;
+
+     va_start( ap, ret_serial );
+
+
+     VoodooMessageBlock    blocks[VOODOO_MANAGER_MESSAGE_BLOCKS_MAX];
+     size_t                num_blocks;
+     size_t                data_size;
+
+     data_size = calc_blocks( ap, blocks, &num_blocks );
+
+
+     ret = manager->do_request_deferred( instance, method, flags, ret_serial, blocks, num_blocks, data_size );
+
+     va_end( ap );
+
+     return ret;
+}
+
+DirectResult
+voodoo_manager_collect_response( VoodooManager          *manager,
+                                 VoodooMessageSerial     serial,
+                                 VoodooResponseMessage **ret_response )
+{
+     D_MAGIC_ASSERT( manager, VoodooManager );
+
+     return manager->collect_response( serial, ret_response );
+}
+
+DirectResult
+voodoo_manager_release_response( VoodooManager         *manager,
+                                 VoodooResponseMessage *response )
+{
+     D_MAGIC_ASSERT( manager, VoodooManager );
+
+     return manager->release_response( response );
+}
+
+DirectResult
+voodoo_manager_discard_response( VoodooManager       *manager,
+                                 VoodooMessageSerial  serial )
+{
+     D_MAGIC_ASSERT( manager, VoodooManager );
+
+     return manager->discard_response( serial );
+}
+
 DirectResult
 voodoo_manager_respond( VoodooManager          *manager,
                         bool                    flush,
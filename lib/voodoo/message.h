@@ -197,6 +197,17 @@ typedef struct {
           __VOODOO_PARSER_EPILOG( parser );                           \
      } while (0)
 
+#define VOODOO_PARSER_GET_SIZED_DATA( parser, ret_data, ret_length )  \
+     do {                                                             \
+          __VOODOO_PARSER_PROLOG( parser, VMBT_DATA );                \
+                                                                      \
+          /* Return pointer to data and its length. */                \
+          (ret_data)   = (__typeof__(ret_data))(_vp_ptr + 8);         \
+          (ret_length) = _vp_length;                                  \
+                                                                      \
+          __VOODOO_PARSER_EPILOG( parser );                           \
+     } while (0)
+
 #define VOODOO_PARSER_READ_DATA( parser, dst, max_len )               \
      do {                                                             \
           __VOODOO_PARSER_PROLOG( parser, VMBT_DATA );                \
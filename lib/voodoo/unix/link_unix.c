@@ -34,25 +34,35 @@
 #include <config.h>
 
 //#include <aio.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include <sys/mman.h>
 #include <sys/poll.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 
+#ifdef HAVE_SYS_EVENTFD_H
+#include <sys/eventfd.h>
+#endif
+
 #include <netinet/in.h>
 #include <netinet/ip.h>
 #include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <netdb.h>
 
+#include <direct/atomic.h>
 #include <direct/debug.h>
 #include <direct/list.h>
 #include <direct/mem.h>
+#include <direct/memcpy.h>
 #include <direct/messages.h>
 #include <direct/util.h>
 
@@ -339,6 +349,678 @@ WaitForData( VoodooLink *link,
 
 /**********************************************************************************************************************/
 
+/*
+ * Shared memory links
+ *
+ * When both peers are on the same host (connected via Unix Domain socket) the client may create a shared memory
+ * area with one ring buffer per direction and pass it to the server along with two doorbells (eventfd or pipe).
+ *
+ * The socket is kept open to detect disconnection of the peer, but no data is transferred via the socket anymore.
+ *
+ * Each ring has a single producer advancing 'head' and a single consumer advancing 'tail'. Before going to sleep,
+ * the reader or writer announces itself in 'reader_waiting' or 'writer_waiting' and the peer rings the doorbell
+ * after making progress. Both are atomic read-modify-write operations acting as full memory barriers, so no
+ * wake up can be lost between checking the ring and going to sleep.
+ */
+
+#define SHM_RING_SIZE   (1024 * 1024)
+
+typedef struct {
+     u32  head;
+     u32  tail;
+     int  reader_waiting;
+     int  writer_waiting;
+
+     u8   pad[48];
+
+     u8   data[SHM_RING_SIZE];
+} ShmRing;
+
+typedef struct {
+     ShmRing rings[2];   /* [0] client to server, [1] server to client */
+} ShmArea;
+
+typedef struct {
+     int       fd;
+
+     ShmArea  *area;
+
+     ShmRing  *in;
+     ShmRing  *out;
+
+     int       bell[2];
+     int       peer_bell[2];
+
+     int       wakeup_fds[2];
+} ShmLink;
+
+/**********************************************************************************************************************/
+
+static DirectResult
+doorbell_create( int fds[2] )
+{
+#ifdef HAVE_SYS_EVENTFD_H
+     fds[0] = eventfd( 0, EFD_NONBLOCK );
+     if (fds[0] < 0)
+          return errno2result( errno );
+
+     fds[1] = fds[0];
+#else
+     if (pipe( fds ))
+          return errno2result( errno );
+
+     fcntl( fds[0], F_SETFL, O_NONBLOCK );
+     fcntl( fds[1], F_SETFL, O_NONBLOCK );
+#endif
+
+     return DR_OK;
+}
+
+static void
+doorbell_ring( int fds[2] )
+{
+     u64 value = 1;
+
+     /* Failing with EAGAIN is fine, the doorbell is pending anyway */
+     if (write( fds[1], &value, sizeof(value) ) < 0 && errno != EAGAIN)
+          D_PERROR( "Voodoo/Link: Could not ring doorbell!\n" );
+}
+
+static void
+doorbell_clear( int fds[2] )
+{
+     u64 values[16];
+
+     while (read( fds[0], values, sizeof(values) ) > 0);
+}
+
+static void
+doorbell_close( int fds[2] )
+{
+     if (fds[0] >= 0)
+          close( fds[0] );
+
+     if (fds[1] >= 0 && fds[1] != fds[0])
+          close( fds[1] );
+
+     fds[0] = fds[1] = -1;
+}
+
+/**********************************************************************************************************************/
+
+static inline size_t
+ring_used( ShmRing *ring )
+{
+     return D_SYNC_ADD_AND_FETCH( &ring->head, 0 ) - D_SYNC_ADD_AND_FETCH( &ring->tail, 0 );
+}
+
+static size_t
+ring_write( ShmRing    *ring,
+            const void *data,
+            size_t      length )
+{
+     size_t pos   = ring->head & (SHM_RING_SIZE - 1);
+     size_t space = SHM_RING_SIZE - ring_used( ring );
+     size_t first;
+
+     if (length > space)
+          length = space;
+
+     if (!length)
+          return 0;
+
+     first = MIN( length, SHM_RING_SIZE - pos );
+
+     direct_memcpy( ring->data + pos, data, first );
+     direct_memcpy( ring->data, (const u8*) data + first, length - first );
+
+     /* Publish the data */
+     D_SYNC_ADD( &ring->head, length );
+
+     return length;
+}
+
+static size_t
+ring_read( ShmRing *ring,
+           void    *data,
+           size_t   length )
+{
+     size_t pos  = ring->tail & (SHM_RING_SIZE - 1);
+     size_t used = ring_used( ring );
+     size_t first;
+
+     if (length > used)
+          length = used;
+
+     if (!length)
+          return 0;
+
+     first = MIN( length, SHM_RING_SIZE - pos );
+
+     direct_memcpy( data, ring->data + pos, first );
+     direct_memcpy( (u8*) data + first, ring->data, length - first );
+
+     /* Release the space */
+     D_SYNC_ADD( &ring->tail, length );
+
+     return length;
+}
+
+/**********************************************************************************************************************/
+
+static void
+shm_link_destroy( ShmLink *l )
+{
+     if (l->fd >= 0)
+          close( l->fd );
+
+     if (l->area)
+          munmap( l->area, sizeof(ShmArea) );
+
+     doorbell_close( l->bell );
+     doorbell_close( l->peer_bell );
+
+     if (l->wakeup_fds[0] >= 0)
+          close( l->wakeup_fds[0] );
+
+     if (l->wakeup_fds[1] >= 0)
+          close( l->wakeup_fds[1] );
+
+     D_FREE( l );
+}
+
+static ShmLink *
+shm_link_alloc( void )
+{
+     ShmLink *l;
+
+     l = D_CALLOC( 1, sizeof(ShmLink) );
+     if (!l)
+          return NULL;
+
+     l->fd            = -1;
+     l->bell[0]       = l->bell[1]       = -1;
+     l->peer_bell[0]  = l->peer_bell[1]  = -1;
+     l->wakeup_fds[0] = l->wakeup_fds[1] = -1;
+
+     return l;
+}
+
+static void
+shm_waiting( ShmLink *l,
+             size_t   num_send,
+             size_t   num_recv,
+             int      delta )
+{
+     if (num_recv)
+          D_SYNC_ADD( &l->in->reader_waiting, delta );
+
+     if (num_send)
+          D_SYNC_ADD( &l->out->writer_waiting, delta );
+}
+
+static bool
+shm_ready( ShmLink *l,
+           size_t   num_send,
+           size_t   num_recv )
+{
+     return (num_recv && ring_used( l->in )) || (num_send && ring_used( l->out ) < SHM_RING_SIZE);
+}
+
+static void
+ShmClose( VoodooLink *link )
+{
+     D_INFO( "Voodoo/Link: Closing shared memory connection.\n" );
+
+     shm_link_destroy( link->priv );
+
+     link->priv = NULL;
+}
+
+static DirectResult
+ShmSendReceive( VoodooLink  *link,
+                VoodooChunk *sends,
+                size_t       num_send,
+                VoodooChunk *recvs,
+                size_t       num_recv )
+{
+     ShmLink *l = link->priv;
+     size_t   i;
+
+     D_DEBUG_AT( Voodoo_Link, "%s( link %p, sends %p, num_send %zu, recvs %p, num_recv %zu )\n",
+                 __func__, link, sends, num_send, recvs, num_recv );
+
+     while (true) {
+          int           ret;
+          size_t        sent     = 0;
+          size_t        received = 0;
+          struct pollfd pfds[3];
+
+          for (i=0; i<num_send; i++) {
+               size_t length = sends[i].length - sends[i].done;
+               size_t done   = ring_write( l->out, (const u8*) sends[i].ptr + sends[i].done, length );
+
+               sends[i].done += done;
+               sent          += done;
+
+               if (done < length)
+                    break;
+          }
+
+          for (i=0; i<num_recv; i++) {
+               recvs[i].done = ring_read( l->in, recvs[i].ptr, recvs[i].length );
+
+               received += recvs[i].done;
+
+               if (recvs[i].done < recvs[i].length)
+                    break;
+          }
+
+          if ((sent && D_SYNC_ADD_AND_FETCH( &l->out->reader_waiting, 0 )) ||
+              (received && D_SYNC_ADD_AND_FETCH( &l->in->writer_waiting, 0 )))
+               doorbell_ring( l->peer_bell );
+
+          if (sent || received) {
+               D_DEBUG_AT( Voodoo_Link, "  => sent %zu, received %zu\n", sent, received );
+               return DR_OK;
+          }
+
+
+          shm_waiting( l, num_send, num_recv, 1 );
+
+          /* Check again after announcing, the peer might have made progress in between */
+          if (shm_ready( l, num_send, num_recv )) {
+               shm_waiting( l, num_send, num_recv, -1 );
+               continue;
+          }
+
+          pfds[0].fd     = l->bell[0];
+          pfds[0].events = POLLIN;
+          pfds[1].fd     = l->wakeup_fds[0];
+          pfds[1].events = POLLIN;
+          pfds[2].fd     = l->fd;
+          pfds[2].events = POLLIN;
+
+          D_DEBUG_AT( Voodoo_Link, "  -> poll( %s%s )...\n", num_recv ? "R" : " ", num_send ? "W" : " " );
+
+          ret = poll( pfds, D_ARRAY_SIZE(pfds), 1000 );
+
+          shm_waiting( l, num_send, num_recv, -1 );
+
+          if (ret < 0) {
+               if (errno == EINTR)
+                    continue;
+
+               D_PERROR( "Voodoo/Link: poll() failed!\n" );
+               return DR_FAILURE;
+          }
+
+          if (ret == 0) {
+               D_DEBUG_AT( Voodoo_Link, "  => TIMEOUT\n" );
+               return DR_TIMEOUT;
+          }
+
+          /* Nothing is sent via the socket anymore, so it only gets readable when the peer is gone */
+          if (pfds[2].revents) {
+               D_DEBUG_AT( Voodoo_Link, "  => CLOSED\n" );
+               return DR_IO;
+          }
+
+          if (pfds[0].revents)
+               doorbell_clear( l->bell );
+
+          if (pfds[1].revents) {
+               char buf[1000];
+
+               D_DEBUG_AT( Voodoo_Link, "  => WAKE UP\n" );
+
+               if (read( l->wakeup_fds[0], buf, sizeof(buf) ) < 0)
+                    return errno2result( errno );
+
+               return DR_INTERRUPTED;
+          }
+     }
+
+     return DR_OK;
+}
+
+static ssize_t
+ShmRead( VoodooLink *link,
+         void       *buffer,
+         size_t      count )
+{
+     VoodooChunk chunk = { buffer, count, 0 };
+
+     while (true) {
+          switch (ShmSendReceive( link, NULL, 0, &chunk, 1 )) {
+               case DR_OK:
+                    if (chunk.done)
+                         return chunk.done;
+                    break;
+
+               case DR_TIMEOUT:
+               case DR_INTERRUPTED:
+                    break;
+
+               case DR_IO:
+                    return 0;
+
+               default:
+                    return -1;
+          }
+     }
+}
+
+static ssize_t
+ShmWrite( VoodooLink *link,
+          const void *buffer,
+          size_t      count )
+{
+     VoodooChunk chunk = { (void*) buffer, count, 0 };
+
+     while (chunk.done < count) {
+          switch (ShmSendReceive( link, &chunk, 1, NULL, 0 )) {
+               case DR_OK:
+               case DR_TIMEOUT:
+               case DR_INTERRUPTED:
+                    break;
+
+               default:
+                    return -1;
+          }
+     }
+
+     return count;
+}
+
+static DirectResult
+ShmWakeUp( VoodooLink *link )
+{
+     ShmLink *l = link->priv;
+     char     c = 0;
+
+     if (write( l->wakeup_fds[1], &c, 1 ) < 0)
+          return errno2result( errno );
+
+     return DR_OK;
+}
+
+static DirectResult
+ShmWaitForData( VoodooLink *link,
+                int         timeout_ms )
+{
+     int            ret;
+     ShmLink       *l = link->priv;
+     struct pollfd  pfds[2];
+
+     while (true) {
+          if (ring_used( l->in ))
+               return DR_OK;
+
+          shm_waiting( l, 0, 1, 1 );
+
+          if (ring_used( l->in )) {
+               shm_waiting( l, 0, 1, -1 );
+               return DR_OK;
+          }
+
+          pfds[0].fd     = l->bell[0];
+          pfds[0].events = POLLIN;
+          pfds[1].fd     = l->fd;
+          pfds[1].events = POLLIN;
+
+          ret = poll( pfds, D_ARRAY_SIZE(pfds), timeout_ms );
+
+          shm_waiting( l, 0, 1, -1 );
+
+          if (ret < 0)
+               return errno2result( errno );
+
+          if (ret == 0)
+               return DR_TIMEOUT;
+
+          if (pfds[1].revents)
+               return DR_IO;
+
+          doorbell_clear( l->bell );
+     }
+}
+
+static void
+shm_link_setup( VoodooLink *link,
+                ShmLink    *l )
+{
+     link->priv        = l;
+     link->Close       = ShmClose;
+     link->Read        = ShmRead;
+     link->Write       = ShmWrite;
+     link->SendReceive = ShmSendReceive;
+     link->WakeUp      = ShmWakeUp;
+     link->WaitForData = ShmWaitForData;
+}
+
+/*
+ * Client side: create the area and doorbells before anything is sent, so that failure falls back to the socket
+ */
+static DirectResult
+shm_link_create( ShmLink **ret_link )
+{
+     DirectResult  ret;
+     int           fd;
+     char          name[64];
+     ShmLink      *l;
+     static int    counter;
+
+     l = shm_link_alloc();
+     if (!l)
+          return D_OOM();
+
+     snprintf( name, sizeof(name), "/dev/shm/voodoo.%d.%d", getpid(), D_SYNC_ADD_AND_FETCH( &counter, 1 ) );
+
+     fd = open( name, O_RDWR | O_CREAT | O_EXCL, 0600 );
+     if (fd < 0) {
+          ret = errno2result( errno );
+          D_PERROR( "Voodoo/Link: Could not create '%s'!\n", name );
+          shm_link_destroy( l );
+          return ret;
+     }
+
+     unlink( name );
+
+     if (ftruncate( fd, sizeof(ShmArea) )) {
+          ret = errno2result( errno );
+          D_PERROR( "Voodoo/Link: Could not resize '%s' to %zu bytes!\n", name, sizeof(ShmArea) );
+          close( fd );
+          shm_link_destroy( l );
+          return ret;
+     }
+
+     l->area = mmap( NULL, sizeof(ShmArea), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+     if (l->area == MAP_FAILED) {
+          ret = errno2result( errno );
+          D_PERROR( "Voodoo/Link: Could not map '%s'!\n", name );
+          l->area = NULL;
+          close( fd );
+          shm_link_destroy( l );
+          return ret;
+     }
+
+     /* Only needed for passing it to the server */
+     l->fd = fd;
+
+     l->out = &l->area->rings[0];
+     l->in  = &l->area->rings[1];
+
+     ret = doorbell_create( l->bell );
+     if (ret == DR_OK)
+          ret = doorbell_create( l->peer_bell );
+     if (ret == DR_OK && pipe( l->wakeup_fds ))
+          ret = errno2result( errno );
+
+     if (ret) {
+          D_DERROR( ret, "Voodoo/Link: Could not create doorbells!\n" );
+          shm_link_destroy( l );
+          return ret;
+     }
+
+     *ret_link = l;
+
+     return DR_OK;
+}
+
+static DirectResult
+shm_link_connect( VoodooLink *link,
+                  ShmLink    *l,
+                  int         fd )
+{
+     struct msghdr   msg;
+     struct iovec    iov;
+     struct cmsghdr *cmsg;
+     char            byte = 0;
+     int             fds[5];
+     char            buf[CMSG_SPACE(sizeof(fds))];
+
+     link->code = 0x80008676 | VOODOO_LINK_CODE_SHM;
+
+     if (write( fd, &link->code, sizeof(link->code) ) != 4) {
+          D_ERROR( "Voodoo/Link: Coult not write initial four bytes!\n" );
+          return DR_IO;
+     }
+
+     fds[0] = l->fd;
+     fds[1] = l->bell[0];
+     fds[2] = l->bell[1];
+     fds[3] = l->peer_bell[0];
+     fds[4] = l->peer_bell[1];
+
+     iov.iov_base = &byte;
+     iov.iov_len  = 1;
+
+     memset( &msg, 0, sizeof(msg) );
+     memset( buf, 0, sizeof(buf) );
+
+     msg.msg_iov        = &iov;
+     msg.msg_iovlen     = 1;
+     msg.msg_control    = buf;
+     msg.msg_controllen = sizeof(buf);
+
+     cmsg = CMSG_FIRSTHDR( &msg );
+     cmsg->cmsg_level = SOL_SOCKET;
+     cmsg->cmsg_type  = SCM_RIGHTS;
+     cmsg->cmsg_len   = CMSG_LEN( sizeof(fds) );
+
+     memcpy( CMSG_DATA( cmsg ), fds, sizeof(fds) );
+
+     if (sendmsg( fd, &msg, 0 ) != 1) {
+          D_PERROR( "Voodoo/Link: Could not pass shared memory to server!\n" );
+          return DR_IO;
+     }
+
+     /* Keep the socket only for detecting disconnection */
+     close( l->fd );
+
+     l->fd = fd;
+
+     D_INFO( "Voodoo/Link: Sent link code (packet, shared memory).\n" );
+
+     shm_link_setup( link, l );
+
+     return DR_OK;
+}
+
+/*
+ * Server side: receive the area and doorbells passed by the client
+ */
+static DirectResult
+shm_link_accept( VoodooLink *link,
+                 int         fd )
+{
+     DirectResult    ret;
+     struct msghdr   msg;
+     struct iovec    iov;
+     struct cmsghdr *cmsg;
+     struct stat     st;
+     char            byte;
+     int             fds[5];
+     char            buf[CMSG_SPACE(sizeof(fds))];
+     ShmLink        *l;
+
+     iov.iov_base = &byte;
+     iov.iov_len  = 1;
+
+     memset( &msg, 0, sizeof(msg) );
+
+     msg.msg_iov        = &iov;
+     msg.msg_iovlen     = 1;
+     msg.msg_control    = buf;
+     msg.msg_controllen = sizeof(buf);
+
+     if (recvmsg( fd, &msg, 0 ) != 1) {
+          D_PERROR( "Voodoo/Link: Could not receive shared memory from client!\n" );
+          close( fd );
+          return DR_IO;
+     }
+
+     cmsg = CMSG_FIRSTHDR( &msg );
+     if (!cmsg || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS ||
+         cmsg->cmsg_len != CMSG_LEN( sizeof(fds) ))
+     {
+          D_ERROR( "Voodoo/Link: Invalid shared memory message from client!\n" );
+          close( fd );
+          return DR_IO;
+     }
+
+     memcpy( fds, CMSG_DATA( cmsg ), sizeof(fds) );
+
+     l = shm_link_alloc();
+     if (!l) {
+          close( fd );
+          return D_OOM();
+     }
+
+     l->fd           = fd;
+     l->peer_bell[0] = fds[1];
+     l->peer_bell[1] = fds[2];
+     l->bell[0]      = fds[3];
+     l->bell[1]      = fds[4];
+
+     if (fstat( fds[0], &st ) || st.st_size < (off_t) sizeof(ShmArea)) {
+          D_ERROR( "Voodoo/Link: Shared memory from client is too small!\n" );
+          close( fds[0] );
+          shm_link_destroy( l );
+          return DR_IO;
+     }
+
+     l->area = mmap( NULL, sizeof(ShmArea), PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0 );
+
+     close( fds[0] );
+
+     if (l->area == MAP_FAILED) {
+          ret = errno2result( errno );
+          D_PERROR( "Voodoo/Link: Could not map shared memory from client!\n" );
+          l->area = NULL;
+          shm_link_destroy( l );
+          return ret;
+     }
+
+     l->in  = &l->area->rings[0];
+     l->out = &l->area->rings[1];
+
+     if (pipe( l->wakeup_fds )) {
+          ret = errno2result( errno );
+          shm_link_destroy( l );
+          return ret;
+     }
+
+     D_INFO( "Voodoo/Link: Using shared memory.\n" );
+
+     shm_link_setup( link, l );
+
+     return DR_OK;
+}
+
+/**********************************************************************************************************************/
+
 DirectResult
 voodoo_link_init_connect( VoodooLink *link,
                           const char *hostname,
@@ -539,6 +1221,29 @@ voodoo_link_init_local( VoodooLink *link,
      DUMP_SOCKET_OPTION( l->fd[0], SO_SNDBUF );
      DUMP_SOCKET_OPTION( l->fd[0], SO_RCVBUF );
 
+     if (!raw && voodoo_config->link_shm) {
+          ShmLink *shm = NULL;
+
+          ret = shm_link_create( &shm );
+          if (ret == DR_OK) {
+               D_ASSERT( shm != NULL );
+
+               ret = shm_link_connect( link, shm, l->fd[0] );
+               if (ret) {
+                    /* the link code may have been sent already, so there's no falling back */
+                    close( l->fd[0] );
+                    shm_link_destroy( shm );
+               }
+
+               D_FREE( l );
+               return ret;
+          }
+
+          D_ASSERT( shm == NULL );
+
+          D_DERROR( ret, "Voodoo/Link: Falling back to socket without shared memory!\n" );
+     }
+
      if (!raw) {
           link->code = 0x80008676;
 
@@ -580,6 +1285,13 @@ voodoo_link_init_fd( VoodooLink *link,
           return DR_IO;
      }
 
+     if (link->code & VOODOO_LINK_CODE_SHM) {
+          if (fd[1] != fd[0])
+               close( fd[1] );
+
+          return shm_link_accept( link, fd[0] );
+     }
+
      l = D_CALLOC( 1, sizeof(Link) );
      if (!l)
           return D_OOM();
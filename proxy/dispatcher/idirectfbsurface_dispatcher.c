@@ -41,6 +41,7 @@
 
 #include <directfb.h>
 
+#include <direct/fastlz.h>
 #include <direct/interface.h>
 #include <direct/mem.h>
 #include <direct/memcpy.h>
@@ -84,6 +85,14 @@ typedef struct {
      VoodooManager         *manager;
 
      VoodooInstanceID       remote;
+
+     struct {
+          u8                    *shadow;  /* data written so far, same as the requestor's */
+          int                    width;
+          int                    height;
+          int                    pitch;
+          int                    bpp;
+     } delta;
 } IDirectFBSurface_Dispatcher_data;
 
 /**************************************************************************************************/
@@ -99,6 +108,9 @@ IDirectFBSurface_Dispatcher_Destruct( IDirectFBSurface *thiz )
 
      data->real->Release( data->real );
 
+     if (data->delta.shadow)
+          D_FREE( data->delta.shadow );
+
      DIRECT_DEALLOCATE_INTERFACE( thiz );
 }
 
@@ -1612,23 +1624,36 @@ Dispatch_ReleaseSource( IDirectFBSurface *thiz, IDirectFBSurface *real,
 
 #define RLE16_KEY   0xf001
 
-static void
+/*
+ * Decodes exactly 'num' values, failing if the data would end early or a run would exceed them.
+ */
+static DFBResult
 rle16_decode( const u16    *src,
+              unsigned int  src_num,
               u16          *dst,
               unsigned int  num )
 {
      unsigned int n = 0, last, count, out = 0;
 
      while (out < num) {
+          if (n == src_num)
+               return DFB_INVARG;
+
           last = src[n++];
 
           if (last == RLE16_KEY) {
+               if (n == src_num)
+                    return DFB_INVARG;
+
                count = src[n++];
 
                if (count == RLE16_KEY) {
                     dst[out++] = RLE16_KEY;
                }
                else {
+                    if (n == src_num || count > num - out)
+                         return DFB_INVARG;
+
                     last = src[n++];
 
                     while (count >= 4) {
@@ -1657,28 +1682,41 @@ rle16_decode( const u16    *src,
                dst[out++] = last;
      }
 
-     D_ASSERT( out == num );
+     return (out == num) ? DFB_OK : DFB_INVARG;
 }
 
 #define RLE32_KEY   0xf0012345
 
-static void
+/*
+ * Decodes exactly 'num' values, failing if the data would end early or a run would exceed them.
+ */
+static DFBResult
 rle32_decode( const u32    *src,
+              unsigned int  src_num,
               u32          *dst,
               unsigned int  num )
 {
      unsigned int n = 0, last, count, out = 0;
 
      while (out < num) {
+          if (n == src_num)
+               return DFB_INVARG;
+
           last = src[n++];
 
           if (last == RLE32_KEY) {
+               if (n == src_num)
+                    return DFB_INVARG;
+
                count = src[n++];
 
                if (count == RLE32_KEY) {
                     dst[out++] = RLE32_KEY;
                }
                else {
+                    if (n == src_num || count > num - out)
+                         return DFB_INVARG;
+
                     last = src[n++];
 
                     while (count >= 4) {
@@ -1707,17 +1745,19 @@ rle32_decode( const u32    *src,
                dst[out++] = last;
      }
 
-     D_ASSERT( out == num );
+     return (out == num) ? DFB_OK : DFB_INVARG;
 }
 
 static DirectResult
 Dispatch_Write( IDirectFBSurface *thiz, IDirectFBSurface *real,
                 VoodooManager *manager, VoodooRequestMessage *msg )
 {
+     DFBResult            ret = DFB_OK;
      VoodooMessageParser  parser;
      unsigned int         encoded;
      const DFBRectangle  *rect;
      const void          *ptr;
+     int                  length;
      int                  pitch;
 
      DIRECT_INTERFACE_GET_DATA(IDirectFBSurface_Dispatcher)
@@ -1725,20 +1765,23 @@ Dispatch_Write( IDirectFBSurface *thiz, IDirectFBSurface *real,
      VOODOO_PARSER_BEGIN( parser, msg );
      VOODOO_PARSER_GET_UINT( parser, encoded );
      VOODOO_PARSER_GET_DATA( parser, rect );
-     VOODOO_PARSER_GET_DATA( parser, ptr );
+     VOODOO_PARSER_GET_SIZED_DATA( parser, ptr, length );
      VOODOO_PARSER_GET_INT( parser, pitch );
      VOODOO_PARSER_END( parser );
 
      if (encoded) {
+          if (rect->w < 1 || length < 0)
+               return DFB_INVARG;
+
           switch (encoded) {
                case 2: {
                     if (rect->w > 2048) {
                          u16 *buf = D_MALLOC( rect->w * 2 );
 
                          if (buf) {
-                              rle16_decode( ptr, buf, rect->w );
-
-                              real->Write( real, rect, buf, pitch );
+                              ret = rle16_decode( ptr, length / 2, buf, rect->w );
+                              if (!ret)
+                                   real->Write( real, rect, buf, pitch );
 
                               D_FREE( buf );
                          }
@@ -1748,9 +1791,9 @@ Dispatch_Write( IDirectFBSurface *thiz, IDirectFBSurface *real,
                     else {
                          u16 buf[2048];
 
-                         rle16_decode( ptr, buf, rect->w );
-
-                         real->Write( real, rect, buf, pitch );
+                         ret = rle16_decode( ptr, length / 2, buf, rect->w );
+                         if (!ret)
+                              real->Write( real, rect, buf, pitch );
                     }
                     break;
                }
@@ -1760,9 +1803,9 @@ Dispatch_Write( IDirectFBSurface *thiz, IDirectFBSurface *real,
                          u32 *buf = D_MALLOC( rect->w * 4 );
 
                          if (buf) {
-                              rle32_decode( ptr, buf, rect->w );
-
-                              real->Write( real, rect, buf, pitch );
+                              ret = rle32_decode( ptr, length / 4, buf, rect->w );
+                              if (!ret)
+                                   real->Write( real, rect, buf, pitch );
 
                               D_FREE( buf );
                          }
@@ -1772,9 +1815,9 @@ Dispatch_Write( IDirectFBSurface *thiz, IDirectFBSurface *real,
                     else {
                          u32 buf[1024];
 
-                         rle32_decode( ptr, buf, rect->w );
-
-                         real->Write( real, rect, buf, pitch );
+                         ret = rle32_decode( ptr, length / 4, buf, rect->w );
+                         if (!ret)
+                              real->Write( real, rect, buf, pitch );
                     }
                     break;
                }
@@ -1787,9 +1830,161 @@ Dispatch_Write( IDirectFBSurface *thiz, IDirectFBSurface *real,
      else
           real->Write( real, rect, ptr, pitch );
 
+     return ret;
+}
+
+/*
+ * Allocates the shadow, zeroed like the requestor's, and again after the surface has been resized.
+ */
+static DFBResult
+delta_shadow_update( IDirectFBSurface_Dispatcher_data *data,
+                     IDirectFBSurface                 *real )
+{
+     DFBResult             ret;
+     DFBSurfacePixelFormat format;
+     int                   width, height;
+
+     ret = real->GetPixelFormat( real, &format );
+     if (ret)
+          return ret;
+
+     ret = real->GetSize( real, &width, &height );
+     if (ret)
+          return ret;
+
+     if (data->delta.shadow) {
+          if (data->delta.width == width && data->delta.height == height &&
+              data->delta.bpp == DFB_BYTES_PER_PIXEL( format ))
+               return DFB_OK;
+
+          D_FREE( data->delta.shadow );
+          data->delta.shadow = NULL;
+     }
+
+     if (DFB_PLANAR_PIXELFORMAT( format ) || DFB_BYTES_PER_PIXEL( format ) < 1 || DFB_BYTES_PER_PIXEL( format ) > 4)
+          return DFB_UNSUPPORTED;
+
+     data->delta.shadow = D_CALLOC( height, width * DFB_BYTES_PER_PIXEL( format ) );
+     if (!data->delta.shadow)
+          return D_OOM();
+
+     data->delta.width  = width;
+     data->delta.height = height;
+     data->delta.bpp    = DFB_BYTES_PER_PIXEL( format );
+     data->delta.pitch  = width * data->delta.bpp;
+
+     return DFB_OK;
+}
+
+static DirectResult
+Dispatch_WriteTile( IDirectFBSurface *thiz, IDirectFBSurface *real,
+                    VoodooManager *manager, VoodooRequestMessage *msg )
+{
+     DFBResult            ret;
+     VoodooMessageParser  parser;
+     unsigned int         encoding;
+     const DFBRectangle  *rect;
+     unsigned int         size;
+     const void          *ptr;
+     int                  length;
+     int                  y, len;
+     u8                  *dst;
+     u32                  tile[IDIRECTFBSURFACE_DELTA_TILE_SIZE * IDIRECTFBSURFACE_DELTA_TILE_SIZE];
+
+     DIRECT_INTERFACE_GET_DATA(IDirectFBSurface_Dispatcher)
+
+     VOODOO_PARSER_BEGIN( parser, msg );
+     VOODOO_PARSER_GET_UINT( parser, encoding );
+     VOODOO_PARSER_GET_DATA( parser, rect );
+     VOODOO_PARSER_GET_UINT( parser, size );
+     VOODOO_PARSER_GET_SIZED_DATA( parser, ptr, length );
+     VOODOO_PARSER_END( parser );
+
+     if (length < 0 || size != (unsigned int) length)
+          return DFB_INVARG;
+
+     ret = delta_shadow_update( data, real );
+     if (ret)
+          return ret;
+
+     if (rect->x < 0 || rect->y < 0 || rect->w < 1 || rect->h < 1 ||
+         rect->w > IDIRECTFBSURFACE_DELTA_TILE_SIZE || rect->h > IDIRECTFBSURFACE_DELTA_TILE_SIZE ||
+         rect->x + rect->w > data->delta.width || rect->y + rect->h > data->delta.height)
+          return DFB_INVARG;
+
+     len = rect->w * data->delta.bpp;
+
+     switch (encoding) {
+          case IDIRECTFBSURFACE_TILE_RAW:
+               if (size != len * rect->h)
+                    return DFB_INVARG;
+
+               direct_memcpy( tile, ptr, size );
+               break;
+
+          case IDIRECTFBSURFACE_TILE_RLE:
+               switch (data->delta.bpp) {
+                    case 2:
+                         ret = rle16_decode( ptr, size / 2, (u16*) tile, rect->w * rect->h );
+                         if (ret)
+                              return ret;
+                         break;
+
+                    case 4:
+                         ret = rle32_decode( ptr, size / 4, tile, rect->w * rect->h );
+                         if (ret)
+                              return ret;
+                         break;
+
+                    default:
+                         return DFB_INVARG;
+               }
+               break;
+
+          case IDIRECTFBSURFACE_TILE_LZ:
+               if (direct_fastlz_decompress( ptr, size, tile, sizeof(tile) ) != len * rect->h)
+                    return DFB_INVARG;
+               break;
+
+          default:
+               D_UNIMPLEMENTED();
+               return DFB_UNIMPLEMENTED;
+     }
+
+     dst = data->delta.shadow + rect->y * data->delta.pitch + rect->x * data->delta.bpp;
+
+     for (y=0; y<rect->h; y++)
+          direct_memcpy( dst + y * data->delta.pitch, (u8*) tile + y * len, len );
+
      return DFB_OK;
 }
 
+static DirectResult
+Dispatch_WriteDelta( IDirectFBSurface *thiz, IDirectFBSurface *real,
+                     VoodooManager *manager, VoodooRequestMessage *msg )
+{
+     DFBResult            ret;
+     VoodooMessageParser  parser;
+     const DFBRectangle  *rect;
+
+     DIRECT_INTERFACE_GET_DATA(IDirectFBSurface_Dispatcher)
+
+     VOODOO_PARSER_BEGIN( parser, msg );
+     VOODOO_PARSER_GET_DATA( parser, rect );
+     VOODOO_PARSER_END( parser );
+
+     /* no tile sent so far or resized, i.e. all zero */
+     ret = delta_shadow_update( data, real );
+     if (ret)
+          return ret;
+
+     if (rect->x < 0 || rect->y < 0 || rect->w < 1 || rect->h < 1 ||
+         rect->x + rect->w > data->delta.width || rect->y + rect->h > data->delta.height)
+          return DFB_INVARG;
+
+     return real->Write( real, rect, data->delta.shadow + rect->y * data->delta.pitch + rect->x * data->delta.bpp, data->delta.pitch );
+}
+
 #define RLE16_KEY   0xf001
 
 static bool
@@ -2195,6 +2390,12 @@ Dispatch( void *dispatcher, void *real, VoodooManager *manager, VoodooRequestMes
 
           case IDIRECTFBSURFACE_METHOD_ID_GetFrameTime:
                return Dispatch_GetFrameTime( dispatcher, real, manager, msg );
+
+          case IDIRECTFBSURFACE_METHOD_ID_WriteTile:
+               return Dispatch_WriteTile( dispatcher, real, manager, msg );
+
+          case IDIRECTFBSURFACE_METHOD_ID_WriteDelta:
+               return Dispatch_WriteDelta( dispatcher, real, manager, msg );
      }
 
      return DFB_NOSUCHMETHOD;
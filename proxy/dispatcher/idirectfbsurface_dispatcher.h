@@ -95,5 +95,22 @@
 #define IDIRECTFBSURFACE_METHOD_ID_FillTrapezoids            60
 #define IDIRECTFBSURFACE_METHOD_ID_BatchStretchBlit          61
 #define IDIRECTFBSURFACE_METHOD_ID_GetFrameTime              62
+#define IDIRECTFBSURFACE_METHOD_ID_WriteTile                 63
+#define IDIRECTFBSURFACE_METHOD_ID_WriteDelta                64
+
+
+/*
+ * Delta transfer of surface data (voodoo option 'surface-delta')
+ *
+ * Requestor and dispatcher keep a shadow copy of the data written so far. Only tiles differing from
+ * the shadow are sent via WriteTile, WriteDelta then writes the rectangle from the dispatcher's shadow.
+ */
+#define IDIRECTFBSURFACE_DELTA_TILE_SIZE                     32
+
+typedef enum {
+     IDIRECTFBSURFACE_TILE_RAW      = 0,
+     IDIRECTFBSURFACE_TILE_RLE      = 1,
+     IDIRECTFBSURFACE_TILE_LZ       = 2
+} IDirectFBSurface_TileEncoding;
 
 #endif
@@ -52,6 +52,8 @@
 #include <idirectfb.h>
 #include <idirectfb_dispatcher.h>
 
+#include "idirectfbsurface_requestor.h"
+
 
 static DFBResult Probe( void );
 static DFBResult Construct( IDirectFB *thiz, const char *host, int session );
@@ -339,6 +341,22 @@ IDirectFB_Requestor_CreateSurface( IDirectFB                    *thiz,
           ret = voodoo_construct_requestor( data->manager, "IDirectFBSurface",
                                             instance_id, thiz, &interface_ptr );
 
+     /* Only primary surfaces may change their size, no need to ask for known properties of others */
+     if (ret == DR_OK && !(caps & DSCAPS_PRIMARY)) {
+          IDirectFBSurface_Requestor_data *surface_data = ((IDirectFBSurface*) interface_ptr)->priv;
+
+          surface_data->cache.fixed = true;
+
+          if ((desc.flags & (DSDESC_WIDTH | DSDESC_HEIGHT)) == (DSDESC_WIDTH | DSDESC_HEIGHT)) {
+               surface_data->cache.size.w     = desc.width;
+               surface_data->cache.size.h     = desc.height;
+               surface_data->cache.size_valid = true;
+          }
+
+          if (desc.flags & DSDESC_PIXELFORMAT)
+               surface_data->format = desc.pixelformat;
+     }
+
      *ret_interface = interface_ptr;
 
      return ret;
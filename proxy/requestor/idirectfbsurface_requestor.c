@@ -42,6 +42,7 @@
 #include <directfb.h>
 #include <directfb_util.h>
 
+#include <direct/fastlz.h>
 #include <direct/interface.h>
 #include <direct/mem.h>
 #include <direct/memcpy.h>
@@ -93,6 +94,17 @@ IDirectFBSurface_Requestor_Destruct( IDirectFBSurface *thiz )
      if (data->flip.buffer)
           data->flip.buffer->Release( data->flip.buffer );
 
+     if (data->lock.buffer) {
+          D_FREE( data->lock.buffer );
+          D_FREE( data->lock.reference );
+     }
+
+     if (data->delta.shadow)
+          D_FREE( data->delta.shadow );
+
+     if (data->cache.format_pending)
+          voodoo_manager_discard_response( data->manager, data->cache.format_serial );
+
      if (data->local != VOODOO_INSTANCE_NONE)
           voodoo_manager_unregister_local( data->manager, data->local );
 
@@ -127,6 +139,28 @@ IDirectFBSurface_Requestor_Release( IDirectFBSurface *thiz )
 }
 
 
+static void
+collect_pixelformat( IDirectFBSurface_Requestor_data *data )
+{
+     DFBResult              ret;
+     VoodooResponseMessage *response;
+     VoodooMessageParser    parser;
+
+     data->cache.format_pending = false;
+
+     ret = voodoo_manager_collect_response( data->manager, data->cache.format_serial, &response );
+     if (ret)
+          return;
+
+     if (response->result == DR_OK) {
+          VOODOO_PARSER_BEGIN( parser, response );
+          VOODOO_PARSER_GET_INT( parser, data->format );
+          VOODOO_PARSER_END( parser );
+     }
+
+     voodoo_manager_release_response( data->manager, response );
+}
+
 static DFBResult
 IDirectFBSurface_Requestor_GetPixelFormat( IDirectFBSurface      *thiz,
                                            DFBSurfacePixelFormat *ret_format )
@@ -136,6 +170,10 @@ IDirectFBSurface_Requestor_GetPixelFormat( IDirectFBSurface      *thiz,
      if (!ret_format)
           return DFB_INVARG;
 
+     /* Requested by Construct() already */
+     if (!data->format && data->cache.format_pending)
+          collect_pixelformat( data );
+
      if (!data->format) {
           DFBResult              ret;
           VoodooResponseMessage *response;
@@ -264,6 +302,16 @@ IDirectFBSurface_Requestor_GetSize( IDirectFBSurface *thiz,
      if (!width && !height)
           return DFB_INVARG;
 
+     if (data->cache.size_valid) {
+          if (width)
+               *width = data->cache.size.w;
+
+          if (height)
+               *height = data->cache.size.h;
+
+          return DFB_OK;
+     }
+
      ret = voodoo_manager_request( data->manager, data->instance,
                                    IDIRECTFBSURFACE_METHOD_ID_GetSize, VREQ_RESPOND, &response,
                                    VMBT_NONE );
@@ -286,6 +334,11 @@ IDirectFBSurface_Requestor_GetSize( IDirectFBSurface *thiz,
      if (height)
           *height = dimension->h;
 
+     if (data->cache.fixed) {
+          data->cache.size       = *dimension;
+          data->cache.size_valid = true;
+     }
+
      voodoo_manager_finish_request( data->manager, response );
 
      return DFB_OK;
@@ -304,6 +357,12 @@ IDirectFBSurface_Requestor_GetVisibleRectangle( IDirectFBSurface *thiz,
      if (!rect)
           return DFB_INVARG;
 
+     if (data->cache.visible_valid) {
+          *rect = data->cache.visible;
+
+          return DFB_OK;
+     }
+
      ret = voodoo_manager_request( data->manager, data->instance,
                                    IDIRECTFBSURFACE_METHOD_ID_GetVisibleRectangle,
                                    VREQ_RESPOND, &response,
@@ -321,6 +380,11 @@ IDirectFBSurface_Requestor_GetVisibleRectangle( IDirectFBSurface *thiz,
      VOODOO_PARSER_READ_DATA( parser, rect, sizeof(DFBRectangle) );
      VOODOO_PARSER_END( parser );
 
+     if (data->cache.fixed) {
+          data->cache.visible       = *rect;
+          data->cache.visible_valid = true;
+     }
+
      voodoo_manager_finish_request( data->manager, response );
 
      return DFB_OK;
@@ -406,14 +470,85 @@ IDirectFBSurface_Requestor_Lock( IDirectFBSurface *thiz,
                                  DFBSurfaceLockFlags flags,
                                  void **ret_ptr, int *ret_pitch )
 {
+     DFBResult             ret;
+     DFBSurfacePixelFormat format;
+     int                   width, height, pitch;
+     DFBRectangle          rect;
+
      DIRECT_INTERFACE_GET_DATA(IDirectFBSurface_Requestor)
 
      if (!flags || !ret_ptr || !ret_pitch)
           return DFB_INVARG;
 
-     D_UNIMPLEMENTED();
+     if (data->lock.flags)
+          return DFB_LOCKED;
 
-     return DFB_UNIMPLEMENTED;
+     /*
+      * Locking returns a client side copy of the surface. With DSLF_READ it is fetched from the server,
+      * because the surface may have been drawn to since the last lock. Write only locks skip the read,
+      * Unlock() then fetches just the modified tiles to merge the written pixels into them.
+      */
+     ret = thiz->GetPixelFormat( thiz, &format );
+     if (ret)
+          return ret;
+
+     if (DFB_PLANAR_PIXELFORMAT( format ))
+          return DFB_UNSUPPORTED;
+
+     ret = thiz->GetSize( thiz, &width, &height );
+     if (ret)
+          return ret;
+
+     if (!data->lock.buffer || data->lock.format != format ||
+         data->lock.width != width || data->lock.height != height)
+     {
+          pitch = (DFB_BYTES_PER_LINE( format, width ) + 7) & ~7;
+
+          if (data->lock.buffer) {
+               D_FREE( data->lock.buffer );
+               D_FREE( data->lock.reference );
+
+               data->lock.buffer    = NULL;
+               data->lock.reference = NULL;
+          }
+
+          data->lock.buffer = D_CALLOC( height, pitch );
+          if (!data->lock.buffer)
+               return D_OOM();
+
+          data->lock.reference = D_MALLOC( height * pitch );
+          if (!data->lock.reference) {
+               D_FREE( data->lock.buffer );
+               data->lock.buffer = NULL;
+               return D_OOM();
+          }
+
+          data->lock.format = format;
+          data->lock.width  = width;
+          data->lock.height = height;
+          data->lock.pitch  = pitch;
+     }
+
+     if (flags & DSLF_READ) {
+          rect.x = 0;
+          rect.y = 0;
+          rect.w = data->lock.width;
+          rect.h = data->lock.height;
+
+          ret = thiz->Read( thiz, &rect, data->lock.buffer, data->lock.pitch );
+          if (ret)
+               return ret;
+     }
+
+     if (flags & DSLF_WRITE)
+          direct_memcpy( data->lock.reference, data->lock.buffer, data->lock.height * data->lock.pitch );
+
+     data->lock.flags = flags;
+
+     *ret_ptr   = data->lock.buffer;
+     *ret_pitch = data->lock.pitch;
+
+     return DFB_OK;
 }
 
 static DFBResult
@@ -425,9 +560,8 @@ IDirectFBSurface_Requestor_GetFramebufferOffset( IDirectFBSurface *thiz,
      if (!offset)
           return DFB_INVARG;
 
-     D_UNIMPLEMENTED();
-
-     return DFB_UNIMPLEMENTED;
+     /* The locked buffer is a copy in client memory. */
+     return DFB_FAILURE;
 }
 
 static DFBResult
@@ -439,19 +573,124 @@ IDirectFBSurface_Requestor_GetPhysicalAddress( IDirectFBSurface *thiz,
      if (!addr)
           return DFB_INVARG;
 
-     D_UNIMPLEMENTED();
+     if (!data->lock.flags)
+          return DFB_ACCESSDENIED;
 
-     return DFB_UNIMPLEMENTED;
+     /* The locked buffer is a copy in client memory. */
+     return DFB_UNSUPPORTED;
+}
+
+/*
+ * Merges the pixels written during a write only lock into the current contents of the server.
+ *
+ * The client side copy was not read, so only bytes differing from the reference have been written.
+ * Everything else in the rectangle is replaced by the server's contents before it is written back.
+ * Writing a value equal to the stale one is lost, it can't be told apart from an untouched byte.
+ */
+static DFBResult
+lock_merge( IDirectFBSurface                *thiz,
+            IDirectFBSurface_Requestor_data *data,
+            const DFBRectangle              *rect,
+            u8                              *scratch )
+{
+     DFBResult  ret;
+     int        x, y;
+     int        offset = rect->y * data->lock.pitch + DFB_BYTES_PER_LINE( data->lock.format, rect->x );
+     int        len    = DFB_BYTES_PER_LINE( data->lock.format, rect->w );
+
+     ret = thiz->Read( thiz, rect, scratch, data->lock.pitch );
+     if (ret)
+          return ret;
+
+     for (y=0; y<rect->h; y++) {
+          u8       *buffer    = data->lock.buffer    + offset + y * data->lock.pitch;
+          const u8 *reference = data->lock.reference + offset + y * data->lock.pitch;
+          const u8 *current   = scratch + y * data->lock.pitch;
+
+          for (x=0; x<len; x++) {
+               if (buffer[x] == reference[x])
+                    buffer[x] = current[x];
+          }
+     }
+
+     return DFB_OK;
 }
 
 static DFBResult
 IDirectFBSurface_Requestor_Unlock( IDirectFBSurface *thiz )
 {
+     DFBResult  ret     = DFB_OK;
+     u8        *scratch = NULL;
+     int        tx, ty, y;
+
      DIRECT_INTERFACE_GET_DATA(IDirectFBSurface_Requestor)
 
-     D_UNIMPLEMENTED();
+     if (!data->lock.flags)
+          return DFB_OK;
 
-     return DFB_UNIMPLEMENTED;
+     /* One row of tiles from the server, for merging after a write only lock. */
+     if ((data->lock.flags & (DSLF_READ | DSLF_WRITE)) == DSLF_WRITE) {
+          scratch = D_MALLOC( IDIRECTFBSURFACE_DELTA_TILE_SIZE * data->lock.pitch );
+          if (!scratch) {
+               data->lock.flags = 0;
+               return D_OOM();
+          }
+     }
+
+     /* Write back modified tiles, one rectangle per run of adjacent tiles, all queued without waiting for the server. */
+     if (data->lock.flags & DSLF_WRITE) {
+          for (ty=0; ty<data->lock.height && !ret; ty+=IDIRECTFBSURFACE_DELTA_TILE_SIZE) {
+               int x1 = -1;
+               int h  = MIN( IDIRECTFBSURFACE_DELTA_TILE_SIZE, data->lock.height - ty );
+
+               for (tx=0; tx<data->lock.width; tx+=IDIRECTFBSURFACE_DELTA_TILE_SIZE) {
+                    int w      = MIN( IDIRECTFBSURFACE_DELTA_TILE_SIZE, data->lock.width - tx );
+                    int offset = ty * data->lock.pitch + DFB_BYTES_PER_LINE( data->lock.format, tx );
+                    int len    = DFB_BYTES_PER_LINE( data->lock.format, w );
+
+                    for (y=0; y<h; y++) {
+                         if (memcmp( data->lock.buffer + offset + y * data->lock.pitch,
+                                     data->lock.reference + offset + y * data->lock.pitch, len ))
+                              break;
+                    }
+
+                    if (y < h) {
+                         if (x1 < 0)
+                              x1 = tx;
+
+                         if (tx + w < data->lock.width)
+                              continue;
+
+                         tx += w;
+                    }
+
+                    /* End of a run, either at an unmodified tile or at the right edge. */
+                    if (x1 >= 0) {
+                         DFBRectangle rect = { x1, ty, tx - x1, h };
+
+                         if (scratch) {
+                              ret = lock_merge( thiz, data, &rect, scratch );
+                              if (ret)
+                                   break;
+                         }
+
+                         ret = thiz->Write( thiz, &rect, data->lock.buffer + ty * data->lock.pitch +
+                                            DFB_BYTES_PER_LINE( data->lock.format, x1 ), data->lock.pitch );
+                         if (ret)
+                              break;
+
+                         x1 = -1;
+                    }
+               }
+          }
+     }
+
+     if (scratch)
+          D_FREE( scratch );
+
+     data->lock.flags = 0;
+
+     return ret;
 }
 
 static DirectResult
@@ -1221,6 +1460,14 @@ IDirectFBSurface_Requestor_GetSubSurface( IDirectFBSurface    *thiz,
           ret = voodoo_construct_requestor( data->manager, "IDirectFBSurface",
                                             instance_id, data->idirectfb, &interface_ptr );
 
+     /* Sub surfaces of surfaces with fixed size have a fixed size, too */
+     if (ret == DR_OK) {
+          IDirectFBSurface_Requestor_data *sub_data = ((IDirectFBSurface*) interface_ptr)->priv;
+
+          sub_data->cache.fixed = data->cache.fixed;
+          sub_data->format      = data->format;
+     }
+
      *ret_interface = interface_ptr;
 
      return ret;
@@ -1254,6 +1501,14 @@ IDirectFBSurface_Requestor_MakeSubSurface( IDirectFBSurface   *thiz,
 
      voodoo_manager_finish_request( data->manager, response );
 
+     /* This surface now shows an area of the other one */
+     if (ret == DR_OK) {
+          data->format              = surface_data->format;
+          data->cache.fixed         = surface_data->cache.fixed;
+          data->cache.size_valid    = false;
+          data->cache.visible_valid = false;
+     }
+
      return ret;
 }
 
@@ -1441,6 +1696,139 @@ rle32_encode( const u32    *src,
      return true;
 }
 
+static DFBResult
+write_delta( IDirectFBSurface                *thiz,
+             IDirectFBSurface_Requestor_data *data,
+             DFBSurfacePixelFormat            format,
+             const DFBRectangle              *rect,
+             const void                      *ptr,
+             int                              pitch )
+{
+     DFBResult     ret;
+     int           tx, ty, y;
+     int           width, height;
+     int           bpp = DFB_BYTES_PER_PIXEL( format );
+     DFBRectangle  r   = *rect;
+     u32           tile[IDIRECTFBSURFACE_DELTA_TILE_SIZE * IDIRECTFBSURFACE_DELTA_TILE_SIZE];
+     u32           rle[IDIRECTFBSURFACE_DELTA_TILE_SIZE * IDIRECTFBSURFACE_DELTA_TILE_SIZE];
+     u8            lz[sizeof(tile) * 2];     /* fastlz needs some headroom */
+
+     D_ASSERT( bpp > 0 && bpp <= 4 );
+
+     ret = thiz->GetSize( thiz, &width, &height );
+     if (ret)
+          return ret;
+
+     /* the dispatcher also starts over from zero when the surface has been resized */
+     if (data->delta.shadow &&
+         (width != data->delta.width || height != data->delta.height || bpp != data->delta.bpp))
+     {
+          D_FREE( data->delta.shadow );
+          data->delta.shadow = NULL;
+     }
+
+     if (!data->delta.shadow) {
+          /* zeroed like the dispatcher's */
+          data->delta.shadow = D_CALLOC( height, width * bpp );
+          if (!data->delta.shadow)
+               return D_OOM();
+
+          data->delta.width  = width;
+          data->delta.height = height;
+          data->delta.bpp    = bpp;
+          data->delta.pitch  = width * bpp;
+     }
+
+     if (!dfb_rectangle_intersect( &r, &(DFBRectangle){ 0, 0, data->delta.width, data->delta.height } ))
+          return DFB_OK;
+
+     ptr = (const u8*) ptr + (r.y - rect->y) * pitch + (r.x - rect->x) * bpp;
+
+     for (ty = r.y & ~(IDIRECTFBSURFACE_DELTA_TILE_SIZE - 1); ty < r.y + r.h; ty += IDIRECTFBSURFACE_DELTA_TILE_SIZE) {
+          for (tx = r.x & ~(IDIRECTFBSURFACE_DELTA_TILE_SIZE - 1); tx < r.x + r.w; tx += IDIRECTFBSURFACE_DELTA_TILE_SIZE) {
+               DFBRectangle                   t   = { tx, ty, IDIRECTFBSURFACE_DELTA_TILE_SIZE, IDIRECTFBSURFACE_DELTA_TILE_SIZE };
+               const u8                      *src;
+               u8                            *dst;
+               int                            len;
+               unsigned int                   size, num;
+               const void                    *payload;
+               IDirectFBSurface_TileEncoding  encoding;
+
+               dfb_rectangle_intersect( &t, &r );
+
+               src = (const u8*) ptr + (t.y - r.y) * pitch + (t.x - r.x) * bpp;
+               dst = data->delta.shadow + t.y * data->delta.pitch + t.x * bpp;
+               len = t.w * bpp;
+
+               for (y=0; y<t.h; y++) {
+                    if (memcmp( src + y * pitch, dst + y * data->delta.pitch, len ))
+                         break;
+               }
+
+               if (y == t.h)
+                    continue;
+
+               /* update the shadow and gather the tile's lines */
+               for (y=0; y<t.h; y++) {
+                    direct_memcpy( dst + y * data->delta.pitch, src + y * pitch, len );
+                    direct_memcpy( (u8*) tile + y * len, src + y * pitch, len );
+               }
+
+               encoding = IDIRECTFBSURFACE_TILE_RAW;
+               payload  = tile;
+               size     = len * t.h;
+
+               switch (bpp) {
+                    case 2:
+                         if (rle16_encode( (u16*) tile, (u16*) rle, t.w * t.h, &num )) {
+                              encoding = IDIRECTFBSURFACE_TILE_RLE;
+                              payload  = rle;
+                              size     = num * 2;
+                         }
+                         break;
+
+                    case 4:
+                         if (rle32_encode( (u32*) tile, (u32*) rle, t.w * t.h, &num )) {
+                              encoding = IDIRECTFBSURFACE_TILE_RLE;
+                              payload  = rle;
+                              size     = num * 4;
+                         }
+                         break;
+
+                    default:
+                         break;
+               }
+
+               /* no LZ for tiles if Voodoo is compressing packets already */
+               if (!voodoo_config->compression_min && size > 64) {
+                    int lz_size = direct_fastlz_compress( tile, len * t.h, lz );
+
+                    if (lz_size > 0 && (unsigned int) lz_size < size) {
+                         encoding = IDIRECTFBSURFACE_TILE_LZ;
+                         payload  = lz;
+                         size     = lz_size;
+                    }
+               }
+
+               ret = voodoo_manager_request( data->manager, data->instance,
+                                             IDIRECTFBSURFACE_METHOD_ID_WriteTile, VREQ_QUEUE, NULL,
+                                             VMBT_UINT, encoding,
+                                             VMBT_DATA, sizeof(DFBRectangle), &t,
+                                             VMBT_UINT, size,
+                                             VMBT_DATA, size, payload,
+                                             VMBT_NONE );
+               if (ret)
+                    return ret;
+          }
+     }
+
+     /* always write the whole rectangle, the surface buffer may hold older contents than the shadow */
+     return voodoo_manager_request( data->manager, data->instance,
+                                    IDIRECTFBSURFACE_METHOD_ID_WriteDelta, VREQ_QUEUE, NULL,
+                                    VMBT_DATA, sizeof(DFBRectangle), &r,
+                                    VMBT_NONE );
+}
+
 static DFBResult
 IDirectFBSurface_Requestor_Write( IDirectFBSurface   *thiz,
                                   const DFBRectangle *rect,
@@ -1459,6 +1847,10 @@ IDirectFBSurface_Requestor_Write( IDirectFBSurface   *thiz,
 
      thiz->GetPixelFormat( thiz, &format );
 
+     if (voodoo_config->surface_delta && !DFB_PLANAR_PIXELFORMAT( format ) &&
+         DFB_BYTES_PER_PIXEL( format ) > 0 && DFB_BYTES_PER_PIXEL( format ) <= 4)
+          return write_delta( thiz, data, format, rect, ptr, pitch );
+
      r.x = rect->x;
      r.y = rect->y;
      r.w = rect->w;
@@ -1914,6 +2306,13 @@ Construct( IDirectFBSurface *thiz,
           }
      }
 
+     /* Ask for the pixel format without waiting, it's collected when needed */
+     if (voodoo_manager_request_deferred( manager, instance,
+                                          IDIRECTFBSURFACE_METHOD_ID_GetPixelFormat, VREQ_NONE,
+                                          &data->cache.format_serial,
+                                          VMBT_NONE ) == DR_OK)
+          data->cache.format_pending = true;
+
      thiz->AddRef = IDirectFBSurface_Requestor_AddRef;
      thiz->Release = IDirectFBSurface_Requestor_Release;
 
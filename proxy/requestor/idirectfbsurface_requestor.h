@@ -57,6 +57,17 @@ typedef struct {
 
      DFBSurfacePixelFormat  format;
 
+     struct {
+          bool                   format_pending;  /* deferred GetPixelFormat sent by Construct() */
+          VoodooMessageSerial    format_serial;
+
+          bool                   fixed;           /* size (and visible rectangle) never change */
+          bool                   size_valid;
+          DFBDimension           size;
+          bool                   visible_valid;
+          DFBRectangle           visible;
+     } cache;
+
      struct {
           bool                   use_notify;
 
@@ -78,6 +89,24 @@ typedef struct {
           IDirectFBEventBuffer  *buffer;
           IDirectFBWindow       *window;
      } flip;
+
+     struct {
+          DFBSurfaceLockFlags    flags;      /* flags of the current lock, zero if not locked */
+          DFBSurfacePixelFormat  format;
+          u8                    *buffer;     /* client side copy of the surface returned by Lock() */
+          u8                    *reference;  /* contents at Lock() time, to find modified tiles */
+          int                    width;
+          int                    height;
+          int                    pitch;
+     } lock;
+
+     struct {
+          u8                    *shadow;  /* data written so far, same as the dispatcher's */
+          int                    width;
+          int                    height;
+          int                    bpp;
+          int                    pitch;
+     } delta;
 } IDirectFBSurface_Requestor_data;
 
 #endif
@@ -368,12 +368,14 @@ CoreGraphicsStateClient_Init( CoreGraphicsStateClient *client,
           if (dfb_config->call_nodirect) {
                if (direct_thread_get_tid( direct_thread_self() ) == fusion_dispatcher_tid(state->core->world)) {
                     client->renderer = new Graphics::Renderer( client->state, client->gfx_state );
+                    client->renderer->SetTileLayout( dfb_config->software_tiles );
                }
           }
           else if (!fusion_config->secure_fusion || dfb_core_is_master( client->core )) {
                client->renderer = new Graphics::Renderer( client->state, client->gfx_state );
                client->throttle = new ThrottleBlocking( *client->renderer );
                client->renderer->SetThrottle( client->throttle );
+               client->renderer->SetTileLayout( dfb_config->software_tiles );
           }
      }
 
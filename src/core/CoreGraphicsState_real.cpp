@@ -396,6 +396,7 @@ CoreGraphicsState_SetupRenderer( CoreGraphicsState *state )
          state->renderer = new Graphics::Renderer( &state->state, state );
 
          state->renderer->SetThrottle( new ThrottleGraphicsState(*state->renderer, state) );
+         state->renderer->SetTileLayout( dfb_config->software_tiles );
     }
 }
 
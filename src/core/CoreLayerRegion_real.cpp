@@ -224,6 +224,12 @@ dfb_layer_region_flip_update2( CoreLayerRegion      *region,
      if (ret_task)
           *ret_task = NULL;
 
+     /* Record the damage of this flip for the current back buffer, no history for stereo regions. */
+     if (region->config.options & DLOP_STEREO)
+          dfb_layer_region_damage_reset( region );
+     else if (!(flags & DSFLIP_UPDATE))
+          dfb_layer_region_damage_flip( region, surface, left_update, flags );
+
      if (flags & DSFLIP_UPDATE)
           goto update_only;
 
@@ -363,6 +363,17 @@ IWindow_Real::SetOpaque( const DFBRegion *opaque )
      return dfb_window_set_opaque( obj, opaque );
 }
 
+DFBResult
+IWindow_Real::SetOpaqueRegions( const DFBRegion *regions,
+                                u32              num_regions )
+{
+     D_DEBUG_AT( Core_Window, "IWindow_Real::%s( %p, %u )\n", __FUNCTION__, obj, num_regions );
+
+     D_MAGIC_ASSERT( obj, CoreWindow );
+
+     return dfb_window_set_opaque_regions( obj, regions, num_regions );
+}
+
 DFBResult
 IWindow_Real::SetOpacity( u8 opacity )
 {
@@ -38,9 +38,12 @@
 extern "C" {
 #endif
 
+#include <direct/atomic.h>
+#include <direct/clock.h>
 #include <direct/fifo.h>
 #include <direct/os/mutex.h>
 #include <direct/os/waitqueue.h>
+#include <direct/system.h>
 
 
 
@@ -226,6 +229,171 @@ private:
 };
 
 
+/*
+ * FIFO for many producers and a single consumer
+ *
+ * Producers push onto a lock-free stack using compare and swap. The consumer takes the whole stack at once
+ * and reverses it into its private list, so each item is touched by one atomic operation on either side.
+ *
+ * The consumer only sleeps (on a futex) when there's nothing pushed, producers only make a system call
+ * for waking it up when it announced going to sleep.
+ */
+template <typename T>
+class LockFreeFIFO
+{
+     class Node {
+     public:
+          Node *next;     // must be first for D_SYNC_PUSH_MULTI
+          T     val;
+     };
+
+public:
+     LockFreeFIFO()
+          :
+          pushed( NULL ),
+          head( NULL ),
+          sleeping( 0 )
+     {
+     }
+
+     ~LockFreeFIFO()
+     {
+          grab();
+
+          while (head) {
+               Node *node = head;
+
+               head = node->next;
+
+               delete node;
+          }
+     }
+
+     void
+     push( T e )
+     {
+          Node *node = new Node;
+
+          node->val = e;
+
+          D_SYNC_PUSH_MULTI( &pushed, node );
+
+          /* Wake up the consumer if it's about to sleep or sleeping already. */
+          if (*(volatile int*) &sleeping && D_SYNC_BOOL_COMPARE_AND_SWAP( &sleeping, 1, 0 ))
+               direct_futex_wake( &sleeping, 1 );
+     }
+
+     T
+     pull()
+     {
+          while (!head && !grab())
+               sleep( 0 );
+
+          return take();
+     }
+
+     DirectResult
+     pull( T         *ret_item,
+           long long  timeout_us,  // timeout target timestamp (monotic clock) in micro seconds
+           long long  now = 0 )
+     {
+          DirectResult ret;
+
+          while (!head && !grab()) {
+               if (now == 0)
+                    now = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
+
+               if (now >= timeout_us)
+                    return DR_TIMEOUT;
+
+               ret = sleep( (timeout_us - now + 999) / 1000 );
+               if (ret && ret != DR_TIMEOUT)
+                    return ret;
+
+               now = 0;
+          }
+
+          *ret_item = take();
+
+          return DR_OK;
+     }
+
+     bool
+     empty()
+     {
+          return !head && !*(Node* volatile*) &pushed;
+     }
+
+private:
+     Node * volatile pushed;     // pushed by producers, newest first
+     Node           *head;       // owned by the consumer, oldest first
+     int             sleeping;
+
+     bool
+     grab()
+     {
+          Node *list;
+          Node *prev = NULL;
+
+          do {
+               list = pushed;
+          } while (list && !D_SYNC_BOOL_COMPARE_AND_SWAP( &pushed, list, (Node*) NULL ));
+
+          if (!list)
+               return false;
+
+          /* Reverse to get the oldest first. */
+          while (list) {
+               Node *next = list->next;
+
+               list->next = prev;
+               prev       = list;
+               list       = next;
+          }
+
+          head = prev;
+
+          return true;
+     }
+
+     T
+     take()
+     {
+          Node *node = head;
+          T     val  = node->val;
+
+          head = node->next;
+
+          delete node;
+
+          return val;
+     }
+
+     DirectResult
+     sleep( int timeout_ms )
+     {
+          DirectResult ret;
+
+          D_SYNC_BOOL_COMPARE_AND_SWAP( &sleeping, 0, 1 );
+
+          /* Check again after announcing, a producer may have missed the flag. */
+          if (pushed) {
+               D_SYNC_BOOL_COMPARE_AND_SWAP( &sleeping, 1, 0 );
+               return DR_OK;
+          }
+
+          if (timeout_ms)
+               ret = direct_futex_wait_timed( &sleeping, 1, timeout_ms );
+          else
+               ret = direct_futex_wait( &sleeping, 1 );
+
+          D_SYNC_BOOL_COMPARE_AND_SWAP( &sleeping, 1, 0 );
+
+          return ret;
+     }
+};
+
+
 template <typename T>
 class FastFIFO
 {
@@ -40,9 +40,11 @@ extern "C" {
 #include <directfb.h>
 
 #include <direct/debug.h>
+#include <direct/memcpy.h>
 #include <direct/messages.h>
 
 #include <core/core.h>
+#include <core/fonts.h>
 #include <core/graphics_state.h>
 #include <core/surface_allocation.h>
 #include <core/surface_pool.h>
@@ -56,6 +58,8 @@ extern "C" {
 #include <core/TaskManager.h>
 #include <core/Util.h>
 
+#include <vector>
+
 
 D_DEBUG_DOMAIN( DirectFB_Renderer,          "DirectFB/Renderer",          "DirectFB Renderer" );
 D_DEBUG_DOMAIN( DirectFB_Renderer_Throttle, "DirectFB/Renderer/Throttle", "DirectFB Renderer Throttle" );
@@ -108,6 +112,12 @@ Renderer_DeleteEngines()
      Graphics::Renderer::DeleteEngines();
 }
 
+void
+Renderer_DumpStatistics()
+{
+     Graphics::Renderer::DumpStatistics();
+}
+
 static RendererTLS *
 Renderer_GetTLS( void )
 {
@@ -170,6 +180,15 @@ public:
           return num_rects;
      }
 
+     virtual unsigned long pixels() const {
+          unsigned long ret = 0;
+
+          for (unsigned int i=0; i<num_rects; i++)
+               ret += (accel == DFXL_DRAWRECTANGLE) ? 2 * (rects[i].w + rects[i].h) : rects[i].w * rects[i].h;
+
+          return ret;
+     }
+
      virtual Base *tesselate( DFBAccelerationMask  accel,
                               const DFBRegion     *clip,
                               const s32           *matrix );
@@ -210,6 +229,15 @@ public:
           return num_rects;
      }
 
+     virtual unsigned long pixels() const {
+          unsigned long ret = 0;
+
+          for (unsigned int i=0; i<num_rects; i++)
+               ret += rects[i].w * rects[i].h;
+
+          return ret;
+     }
+
      virtual Base *tesselate( DFBAccelerationMask  accel,
                               const DFBRegion     *clip,
                               const s32           *matrix );
@@ -251,6 +279,15 @@ public:
           return num_rects;
      }
 
+     virtual unsigned long pixels() const {
+          unsigned long ret = 0;
+
+          for (unsigned int i=0; i<num_rects; i++)
+               ret += drects[i].w * drects[i].h;
+
+          return ret;
+     }
+
      virtual Base *tesselate( DFBAccelerationMask  accel,
                               const DFBRegion     *clip,
                               const s32           *matrix );
@@ -347,6 +384,15 @@ public:
           return num_rects;
      }
 
+     virtual unsigned long pixels() const {
+          unsigned long ret = 0;
+
+          for (unsigned int i=0; i<num_rects; i++)
+               ret += rects[i].w * rects[i].h;
+
+          return ret;
+     }
+
      virtual Base *tesselate( DFBAccelerationMask  accel,
                               const DFBRegion     *clip,
                               const s32           *matrix );
@@ -385,6 +431,15 @@ public:
           return num_lines;
      }
 
+     virtual unsigned long pixels() const {
+          unsigned long ret = 0;
+
+          for (unsigned int i=0; i<num_lines; i++)
+               ret += MAX( ABS(lines[i].x2 - lines[i].x1), ABS(lines[i].y2 - lines[i].y1) ) + 1;
+
+          return ret;
+     }
+
      virtual Base *tesselate( DFBAccelerationMask  accel,
                               const DFBRegion     *clip,
                               const s32           *matrix );
@@ -423,6 +478,15 @@ public:
           return num_spans;
      }
 
+     virtual unsigned long pixels() const {
+          unsigned long ret = 0;
+
+          for (unsigned int i=0; i<num_spans; i++)
+               ret += spans[i].w;
+
+          return ret;
+     }
+
      virtual Base *tesselate( DFBAccelerationMask  accel,
                               const DFBRegion     *clip,
                               const s32           *matrix );
@@ -460,6 +524,15 @@ public:
           return num_traps;
      }
 
+     virtual unsigned long pixels() const {
+          unsigned long ret = 0;
+
+          for (unsigned int i=0; i<num_traps; i++)
+               ret += (traps[i].w1 + traps[i].w2) * ABS(traps[i].y2 - traps[i].y1) / 2;
+
+          return ret;
+     }
+
      virtual Base *tesselate( DFBAccelerationMask  accel,
                               const DFBRegion     *clip,
                               const s32           *matrix );
@@ -496,6 +569,16 @@ public:
           return num_tris;
      }
 
+     virtual unsigned long pixels() const {
+          unsigned long ret = 0;
+
+          for (unsigned int i=0; i<num_tris; i++)
+               ret += ABS( (tris[i].x2 - tris[i].x1) * (tris[i].y3 - tris[i].y1) -
+                           (tris[i].x3 - tris[i].x1) * (tris[i].y2 - tris[i].y1) ) / 2;
+
+          return ret;
+     }
+
      virtual Base *tesselate( DFBAccelerationMask  accel,
                               const DFBRegion     *clip,
                               const s32           *matrix );
@@ -610,6 +693,19 @@ public:
           return num_quads;
      }
 
+     virtual unsigned long pixels() const {
+          unsigned long ret = 0;
+
+          for (unsigned int i=0; i<num_quads; i++) {
+               const DFBPoint *p = &points[i*4];
+
+               ret += ABS( (p[2].x - p[0].x) * (p[3].y - p[1].y) -
+                           (p[3].x - p[1].x) * (p[2].y - p[0].y) ) / 2;
+          }
+
+          return ret;
+     }
+
      virtual Base *tesselate( DFBAccelerationMask  accel,
                               const DFBRegion     *clip,
                               const s32           *matrix );
@@ -2158,6 +2254,325 @@ Throttle::Hook::finalise( SurfaceTask *task )
 
 /**********************************************************************************************************************/
 
+void
+Statistics::Add( const Statistics &other )
+{
+     operations    += other.operations;
+     primitives    += other.primitives;
+     pixels        += other.pixels;
+     coalesced     += other.coalesced;
+     state_changes += other.state_changes;
+     binds         += other.binds;
+     rebinds       += other.rebinds;
+     flushes       += other.flushes;
+     tasks         += other.tasks;
+     setup_time    += other.setup_time;
+     run_time      += other.run_time;
+
+     for (int i=0; i<ACCEL_MAX; i++) {
+          accel_primitives[i] += other.accel_primitives[i];
+          accel_pixels[i]     += other.accel_pixels[i];
+     }
+}
+
+void
+Statistics::Count( DFBAccelerationMask  accel,
+                   unsigned int         num,
+                   unsigned long        pixels )
+{
+     int index = D_BITn32( accel );
+
+     D_ASSERT( index >= 0 && index < ACCEL_MAX );
+
+     Count( operations );
+     Count( primitives, num );
+     Count( this->pixels, pixels );
+
+     Count( accel_primitives[index], num );
+     Count( accel_pixels[index], pixels );
+}
+
+void
+Statistics::Dump( const Direct::String &name ) const
+{
+     D_INFO( "DirectFB/Renderer: %-24s %8lu ops %8lu prims %10lu pixels %6lu coalesced %6lu states\n",
+             *name, operations, primitives, pixels, coalesced, state_changes );
+     D_INFO( "DirectFB/Renderer: %-24s %8lu binds %6lu rebinds %6lu flushes %6lu tasks (setup %lu.%03lums, run %lu.%03lums)\n",
+             "", binds, rebinds, flushes, tasks, setup_time / 1000, setup_time % 1000, run_time / 1000, run_time % 1000 );
+
+     for (int i=0; i<ACCEL_MAX; i++) {
+          if (accel_primitives[i])
+               D_INFO( "DirectFB/Renderer: %-24s   %-16s %8lu prims %10lu pixels\n", "",
+                       *ToString<DFBAccelerationMask>( (DFBAccelerationMask)(1 << i) ), accel_primitives[i], accel_pixels[i] );
+     }
+}
+
+void
+Statistics::Hook::finalise( SurfaceTask *task )
+{
+     Count( stats.tasks );
+     Count( stats.setup_time, task->SetupTime() );
+     Count( stats.run_time, task->RunTime() );
+}
+
+/**********************************************************************************************************************/
+
+/*
+ * State of an operation, except for the destination, keeping references to the source surfaces
+ */
+class Renderer::SavedState
+{
+public:
+     SavedState()
+          :
+          source( NULL ),
+          source2( NULL ),
+          source_mask( NULL )
+     {
+     }
+
+     ~SavedState()
+     {
+          if (source)
+               dfb_surface_unref( source );
+
+          if (source2)
+               dfb_surface_unref( source2 );
+
+          if (source_mask)
+               dfb_surface_unref( source_mask );
+     }
+
+     void save   ( const CardState *state );
+     void apply  ( CardState       *state ) const;
+     bool matches( const CardState *state ) const;
+
+     DFBSurfaceDrawingFlags   drawingflags;
+     DFBSurfaceBlittingFlags  blittingflags;
+     DFBRegion                clip;
+     DFBColor                 color;
+     unsigned int             color_index;
+     DFBSurfaceBlendFunction  src_blend;
+     DFBSurfaceBlendFunction  dst_blend;
+     u32                      src_colorkey;
+     u32                      dst_colorkey;
+     DFBSurfaceRenderOptions  render_options;
+     DFBColorKey              colorkey;
+     s32                      matrix[9];
+     CoreSurface             *source;
+     u32                      source_flip_count;
+     bool                     source_flip_count_used;
+     CoreSurfaceBufferRole    from;
+     DFBSurfaceStereoEye      from_eye;
+     CoreSurface             *source2;
+     CoreSurface             *source_mask;
+     DFBPoint                 src_mask_offset;
+     DFBSurfaceMaskFlags      src_mask_flags;
+};
+
+void
+Renderer::SavedState::save( const CardState *state )
+{
+     D_ASSERT( source == NULL );
+     D_ASSERT( source2 == NULL );
+     D_ASSERT( source_mask == NULL );
+
+     drawingflags    = state->drawingflags;
+     blittingflags   = state->blittingflags;
+     clip            = state->clip;
+     color           = state->color;
+     color_index     = state->color_index;
+     src_blend       = state->src_blend;
+     dst_blend       = state->dst_blend;
+     src_colorkey    = state->src_colorkey;
+     dst_colorkey    = state->dst_colorkey;
+     render_options  = state->render_options;
+     colorkey        = state->colorkey;
+     src_mask_offset = state->src_mask_offset;
+     src_mask_flags  = state->src_mask_flags;
+     from            = state->from;
+     from_eye        = state->from_eye;
+
+     source_flip_count      = state->source_flip_count;
+     source_flip_count_used = state->source_flip_count_used;
+
+     direct_memcpy( matrix, state->matrix, sizeof(matrix) );
+
+     if (state->source && !dfb_surface_ref( state->source ))
+          source = state->source;
+
+     if (state->source2 && !dfb_surface_ref( state->source2 ))
+          source2 = state->source2;
+
+     if (state->source_mask && !dfb_surface_ref( state->source_mask ))
+          source_mask = state->source_mask;
+}
+
+void
+Renderer::SavedState::apply( CardState *state ) const
+{
+     dfb_state_set_drawing_flags( state, drawingflags );
+     dfb_state_set_blitting_flags( state, blittingflags );
+     dfb_state_set_clip( state, &clip );
+     dfb_state_set_color( state, &color );
+     dfb_state_set_color_index( state, color_index );
+     dfb_state_set_src_blend( state, src_blend );
+     dfb_state_set_dst_blend( state, dst_blend );
+     dfb_state_set_src_colorkey( state, src_colorkey );
+     dfb_state_set_dst_colorkey( state, dst_colorkey );
+     dfb_state_set_render_options( state, render_options );
+     dfb_state_set_colorkey( state, &colorkey );
+     dfb_state_set_matrix( state, matrix );
+     dfb_state_set_from( state, from, from_eye );
+
+     if (source_flip_count_used)
+          dfb_state_set_source_2( state, source, source_flip_count );
+     else {
+          dfb_state_set_source( state, source );
+
+          if (state->source_flip_count_used) {
+               state->source_flip_count_used = false;
+               state->modified               = (StateModificationFlags)(state->modified | SMF_SOURCE);
+          }
+     }
+
+     dfb_state_set_source2( state, source2 );
+     dfb_state_set_source_mask( state, source_mask );
+     dfb_state_set_source_mask_vals( state, &src_mask_offset, src_mask_flags );
+}
+
+bool
+Renderer::SavedState::matches( const CardState *state ) const
+{
+     return drawingflags   == state->drawingflags &&
+            blittingflags  == state->blittingflags &&
+            DFB_REGION_EQUAL( clip, state->clip ) &&
+            DFB_COLOR_EQUAL( color, state->color ) &&
+            color_index    == state->color_index &&
+            src_blend      == state->src_blend &&
+            dst_blend      == state->dst_blend &&
+            src_colorkey   == state->src_colorkey &&
+            dst_colorkey   == state->dst_colorkey &&
+            render_options == state->render_options &&
+            source         == state->source &&
+            from           == state->from &&
+            from_eye       == state->from_eye &&
+            source_flip_count_used == state->source_flip_count_used &&
+            (!source_flip_count_used || source_flip_count == state->source_flip_count) &&
+            source2        == state->source2 &&
+            source_mask    == state->source_mask &&
+            src_mask_flags == state->src_mask_flags &&
+            DFB_POINT_EQUAL( src_mask_offset, state->src_mask_offset ) &&
+            !memcmp( &colorkey, &state->colorkey, sizeof(colorkey) ) &&
+            !memcmp( matrix, state->matrix, sizeof(matrix) );
+}
+
+/*
+ * Fill rectangles or blits issued with the same state, waiting to be passed to the engine as one call
+ */
+class Renderer::Batch
+{
+public:
+     /* destination buffer, which the saved state leaves alone */
+     class Target {
+     public:
+          Target( const CardState *state )
+               :
+               destination( state->destination ),
+               to( state->to ),
+               to_eye( state->to_eye ),
+               flip_count( state->destination_flip_count ),
+               flip_count_used( state->destination_flip_count_used )
+          {
+               if (destination && dfb_surface_ref( destination ))
+                    destination = NULL;
+          }
+
+          ~Target()
+          {
+               if (destination)
+                    dfb_surface_unref( destination );
+          }
+
+          bool matches( const CardState *state ) const
+          {
+               return destination     == state->destination &&
+                      to              == state->to &&
+                      to_eye          == state->to_eye &&
+                      flip_count_used == state->destination_flip_count_used &&
+                      (!flip_count_used || flip_count == state->destination_flip_count);
+          }
+
+          void apply( CardState *state ) const
+          {
+               dfb_state_set_to( state, to, to_eye );
+
+               if (flip_count_used)
+                    dfb_state_set_destination_2( state, destination, flip_count );
+               else {
+                    dfb_state_set_destination( state, destination );
+
+                    if (state->destination_flip_count_used) {
+                         state->destination_flip_count_used = false;
+                         state->modified                    = (StateModificationFlags)(state->modified | SMF_DESTINATION);
+                    }
+               }
+          }
+
+          CoreSurface           *destination;
+          CoreSurfaceBufferRole  to;
+          DFBSurfaceStereoEye    to_eye;
+          u32                    flip_count;
+          bool                   flip_count_used;
+     };
+
+     Batch( CardState           *state,
+            DFBAccelerationMask  accel )
+          :
+          target( state ),
+          accel( accel ),
+          reads_destination( ReadsDestination( state, accel ) )
+     {
+          this->state.save( state );
+     }
+
+     /* Blits from the destination itself, e.g. for scrolling, depend on all operations before. */
+     static bool ReadsDestination( const CardState     *state,
+                                   DFBAccelerationMask  accel )
+     {
+          return (accel & DFXL_ALL_BLIT) && state->destination &&
+                 (state->source      == state->destination ||
+                  state->source2     == state->destination ||
+                  state->source_mask == state->destination);
+     }
+
+     void add( const DFBRectangle *rects,
+               const DFBPoint     *points,
+               unsigned int        num,
+               const DFBRegion    &bounds )
+     {
+          this->rects.insert( this->rects.end(), rects, rects + num );
+
+          if (points)
+               this->points.insert( this->points.end(), points, points + num );
+
+          if (this->rects.size() == num)
+               this->bounds = bounds;
+          else
+               dfb_region_region_union( &this->bounds, &bounds );
+     }
+
+     SavedState                 state;
+     Target                     target;
+     DFBAccelerationMask        accel;
+     bool                       reads_destination;
+     std::vector<DFBRectangle>  rects;
+     std::vector<DFBPoint>      points;
+     DFBRegion                  bounds;
+};
+
+/**********************************************************************************************************************/
+
 Renderer::Renderer( CardState            *state,
                     CoreGraphicsState    *gfx_state,
                     const Direct::String &name )
@@ -2168,6 +2583,7 @@ Renderer::Renderer( CardState            *state,
      state_mod( SMF_NONE ),
      transform_type( WTT_IDENTITY ),
      throttle( NULL ),
+     tile_layout( DCST_ROWS ),
      thread( NULL ),
      engine( NULL ),
      setup( NULL ),
@@ -2195,6 +2611,23 @@ Renderer::SetThrottle( Throttle *throttle )
      this->throttle = throttle;
 }
 
+void
+Renderer::SetTileLayout( DFBConfigSoftwareTiles layout )
+{
+     D_DEBUG_AT( DirectFB_Renderer, "Renderer::%s( %p, layout %d )\n", __FUNCTION__, this, layout );
+
+     CHECK_MAGIC();
+
+     if (tile_layout == layout)
+          return;
+
+     /* Tiles are set up when binding an engine, so the new layout applies from the next flush on. */
+     if (engine || !batches.empty())
+          Flush( 0 );
+
+     tile_layout = layout;
+}
+
 Renderer::~Renderer()
 {
      D_DEBUG_AT( DirectFB_Renderer, "Renderer::%s( %p )\n", __FUNCTION__, this );
@@ -2215,6 +2648,9 @@ Renderer::Flush( u32 cookie, CoreGraphicsStateClientFlushFlags flags )
 
      CHECK_MAGIC();
 
+     if (!batches.empty())
+          flushBatches();
+
      if (engine) {
           unbindEngine( cookie, flags );
 
@@ -2384,6 +2820,9 @@ Renderer::update( DFBAccelerationMask accel )
 
                /// loop, clip switch, task mask (total clip)
 
+               Statistics::Count( stats.state_changes );
+               Statistics::Count( engine->stats.state_changes );
+
                for (unsigned int i=0; i<setup->tiles; i++) {
                     state->clip = setup->clips_clipped[i];
 
@@ -2418,6 +2857,10 @@ Renderer::render( Primitives::Base *primitives )
      D_DEBUG_AT( DirectFB_Renderer, "  -> '%s' (modified 0x%08x)\n",
                  ToString<DFBAccelerationMask>(primitives->accel).buffer(), state->modified );
 
+     /* Operations that are not coalesced must not overtake pending ones. */
+     if (!batches.empty())
+          flushBatches();
+
 
      RendererTLS *tls = Renderer_GetTLS();
 
@@ -2547,7 +2990,6 @@ Renderer::render( Primitives::Base *primitives )
      } while (!next_engine);
 
 
-
      D_DEBUG_AT( DirectFB_Renderer, "  -> next_engine %p\n", next_engine );
      D_DEBUG_AT( DirectFB_Renderer, "  -> engine      %p\n", engine );
 
@@ -2578,9 +3020,16 @@ Renderer::render( Primitives::Base *primitives )
      ret = update( accel );
      if (ret)
           unbindEngine( 0, CGSCFF_NONE, true );
-     else
+     else {
+          unsigned int  num    = tesselated->count();
+          unsigned long pixels = tesselated->pixels();
+
           tesselated->render( setup, engine );
 
+          stats.Count( accel, num, pixels );
+          engine->stats.Count( accel, num, pixels );
+     }
+
 out:
      if (tesselated != primitives)
           delete tesselated;
@@ -2616,6 +3065,9 @@ Renderer::FillRectangles( const DFBRectangle *rects,
 {
      D_DEBUG_AT( DirectFB_Renderer, "Renderer::%s( %p, %p [%d] )\n", __FUNCTION__, this, rects, num_rects );
 
+     if (coalesce( DFXL_FILLRECTANGLE, rects, NULL, num_rects ))
+          return;
+
      Primitives::Rectangles primitives( rects, num_rects, DFXL_FILLRECTANGLE );
 
      render( &primitives );
@@ -2673,6 +3125,9 @@ Renderer::Blit( const DFBRectangle     *rects,
 {
      D_DEBUG_AT( DirectFB_Renderer, "Renderer::%s( %p, %p %p [%d] )\n", __FUNCTION__, this, rects, points, num );
 
+     if (coalesce( DFXL_BLIT, rects, points, num ))
+          return;
+
      Primitives::Blits primitives( rects, points, num, DFXL_BLIT );
 
      render( &primitives );
@@ -2700,10 +3155,9 @@ Renderer::StretchBlit( const DFBRectangle     *srects,
 
      if (num == 1) {
           if (srects[0].w == drects[0].w && srects[0].h == drects[0].h) {
-               DFBPoint          point = { drects[0].x, drects[0].y };
-               Primitives::Blits primitives( srects, &point, 1, DFXL_BLIT );
+               DFBPoint point = { drects[0].x, drects[0].y };
 
-               render( &primitives );
+               Blit( srects, &point, 1 );
 
                return;
           }
@@ -2741,6 +3195,146 @@ Renderer::TextureTriangles( const DFBVertex      *vertices,
 
 /**********************************************************************************************************************/
 
+/*
+ * Queues fill rectangles or blits instead of rendering them, returns false if not possible.
+ *
+ * Operations are appended to the most recent pending batch with an identical state. They may be moved
+ * in front of batches with a different state as long as they do not overlap with any of them,
+ * otherwise a new batch is started. Blits reading the destination never pass another batch,
+ * nor does anything pass them.
+ */
+bool
+Renderer::coalesce( DFBAccelerationMask  accel,
+                    const DFBRectangle  *rects,
+                    const DFBPoint      *points,
+                    unsigned int         num )
+{
+     D_DEBUG_AT( DirectFB_Renderer, "Renderer::%s( %p, '%s', %u )\n", __FUNCTION__, this,
+                 ToString<DFBAccelerationMask>(accel).buffer(), num );
+
+     CHECK_MAGIC();
+
+     if (!dfb_config->renderer_coalesce || num == 0 || num > COALESCE_PRIMITIVES_MAX ||
+         (state->render_options & DSRO_MATRIX))
+          return false;
+
+     if (!batches.empty() && !batches.back()->target.matches( state ))
+          flushBatches();
+
+
+     RendererTLS *tls = Renderer_GetTLS();
+
+     if (tls->last_renderer != this) {
+          if (tls->last_renderer)
+               tls->last_renderer->Flush( 0 );
+
+          tls->last_renderer = this;
+     }
+
+
+     /* Bounding box in the destination, ignoring rotation by using the larger size for both directions */
+     DFBRegion bounds = { INT_MAX, INT_MAX, INT_MIN, INT_MIN };
+
+     for (unsigned int i=0; i<num; i++) {
+          int x    = points ? points[i].x : rects[i].x;
+          int y    = points ? points[i].y : rects[i].y;
+          int size = points ? MAX( rects[i].w, rects[i].h ) : 0;
+          int x2   = x + (points ? size : rects[i].w) - 1;
+          int y2   = y + (points ? size : rects[i].h) - 1;
+
+          if (bounds.x1 > x)  bounds.x1 = x;
+          if (bounds.y1 > y)  bounds.y1 = y;
+          if (bounds.x2 < x2) bounds.x2 = x2;
+          if (bounds.y2 < y2) bounds.y2 = y2;
+     }
+
+     Batch *target            = NULL;
+     bool   reads_destination = Batch::ReadsDestination( state, accel );
+
+     for (std::list<Batch*>::reverse_iterator it = batches.rbegin(); it != batches.rend(); ++it) {
+          Batch *batch = *it;
+
+          if (batch->accel == accel && batch->rects.size() + num <= COALESCE_PRIMITIVES_MAX &&
+              batch->state.matches( state ))
+          {
+               target = batch;
+
+               Statistics::Count( stats.coalesced );
+               break;
+          }
+
+          if (reads_destination || batch->reads_destination ||
+              dfb_region_region_intersects( &batch->bounds, &bounds ))
+               break;
+     }
+
+     if (!target) {
+          if (batches.size() == COALESCE_BATCHES_MAX)
+               flushBatches();
+
+          target = new Batch( state, accel );
+
+          batches.push_back( target );
+     }
+
+     D_DEBUG_AT( DirectFB_Renderer, "  -> batch %p [%zu]\n", target, target->rects.size() );
+
+     target->add( rects, points, num, bounds );
+
+     return true;
+}
+
+void
+Renderer::flushBatches()
+{
+     D_DEBUG_AT( DirectFB_Renderer, "Renderer::%s( %p ) <- %zu batches\n", __FUNCTION__, this, batches.size() );
+
+     CHECK_MAGIC();
+
+     std::list<Batch*> pending;
+
+     /* Taken out of the list first, render() would flush them again otherwise. */
+     pending.swap( batches );
+
+     SavedState         saved;
+     Batch::Target      saved_target( state );
+
+     saved.save( state );
+
+     for (std::list<Batch*>::const_iterator it = pending.begin(); it != pending.end(); ++it) {
+          Batch *batch = *it;
+
+          D_DEBUG_AT( DirectFB_Renderer, "  -> batch %p '%s' [%zu]\n", batch,
+                      ToString<DFBAccelerationMask>(batch->accel).buffer(), batch->rects.size() );
+
+          /* The destination may have been changed before the next operation showed up. */
+          if (!batch->target.matches( state ))
+               batch->target.apply( state );
+
+          batch->state.apply( state );
+
+          if (batch->accel == DFXL_BLIT) {
+               Primitives::Blits primitives( &batch->rects[0], &batch->points[0], batch->rects.size(), DFXL_BLIT );
+
+               render( &primitives );
+          }
+          else {
+               Primitives::Rectangles primitives( &batch->rects[0], batch->rects.size(), batch->accel );
+
+               render( &primitives );
+          }
+
+          delete batch;
+     }
+
+     if (!saved_target.matches( state ))
+          saved_target.apply( state );
+
+     saved.apply( state );
+}
+
+/**********************************************************************************************************************/
+
 DFBAccelerationMask
 Renderer::getTransformAccel( DFBAccelerationMask accel,
                              WaterTransformType  type )
@@ -2890,7 +3484,7 @@ Renderer::bindEngine( Engine              *engine,
 
      /// loop
      if (!setup)
-          setup = new Setup( state->destination->config.size.w, state->destination->config.size.h, engine->caps.cores );
+          setup = new Setup( state->destination->config.size.w, state->destination->config.size.h, engine->caps.cores, tile_layout );
 
      D_ASSERT( setup != NULL );
 
@@ -2911,6 +3505,14 @@ Renderer::bindEngine( Engine              *engine,
      for (unsigned int i=1; i<setup->tiles; i++)
           setup->tasks[0]->AddSlave( setup->tasks[i] );
 
+     if (dfb_config->renderer_stats) {
+          for (unsigned int i=0; i<setup->tiles; i++)
+               setup->tasks[i]->AddHook( &engine->stats_hook );
+     }
+
+     Statistics::Count( stats.binds );
+     Statistics::Count( engine->stats.binds );
+
      state->modified = SMF_NONE;
      state->mod_hw   = SMF_ALL;
      state->set      = DFXL_NONE;
@@ -2962,6 +3564,9 @@ Renderer::rebindEngine( DFBAccelerationMask  accel )
 
      D_ASSUME( thread == direct_thread_self() );
 
+     Statistics::Count( stats.rebinds );
+     Statistics::Count( last_engine->stats.rebinds );
+
      flushTask( 0, CGSCFF_NONE );
 
      memset( setup->tasks, 0, sizeof(SurfaceTask*) * setup->tiles );
@@ -3002,6 +3607,12 @@ Renderer::flushTask( u32                               cookie,
 
           /// par flush
           setup->tasks[0]->Flush();
+
+          Statistics::Count( stats.flushes );
+          Statistics::Count( engine->stats.flushes );
+
+          if (dfb_config->renderer_stats)
+               dumpStatistics();
      }
 
      engine     = NULL;
@@ -3012,6 +3623,47 @@ Renderer::flushTask( u32                               cookie,
 
 /*********************************************************************************************************************/
 
+void
+Renderer::DumpStatistics()
+{
+     D_DEBUG_AT( DirectFB_Renderer, "Renderer::%s()\n", __FUNCTION__ );
+
+     for (std::list<Engine*>::const_iterator it = engines.begin(); it != engines.end(); ++it) {
+          Engine *engine = *it;
+
+          engine->stats.Dump( engine->desc.name );
+     }
+
+     /* The glyph cache is filled by the same process, e.g. for DrawString(). */
+     if (core_dfb && core_dfb->font_manager)
+          dfb_font_manager_dump_stats( core_dfb->font_manager );
+}
+
+void
+Renderer::dumpStatistics()
+{
+     static DirectMutex lock = DIRECT_MUTEX_INITIALIZER( lock );
+     static long long   last;
+
+     long long now = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
+
+     /* Any renderer may be the one flushing, the first one due prints the engine counters. */
+     if (direct_mutex_trylock( &lock ))
+          return;
+
+     if (!last)
+          last = now;
+     else if (now - last >= dfb_config->renderer_stats * 1000LL) {
+          DumpStatistics();
+
+          last = now;
+     }
+
+     direct_mutex_unlock( &lock );
+}
+
+/*********************************************************************************************************************/
+
 std::list<Engine*>  Renderer::engines;
 
 
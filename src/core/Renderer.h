@@ -45,6 +45,8 @@ extern "C" {
 #include <core/state.h>
 #include <core/surface.h>
 
+#include <misc/conf.h>
+
 #include <directfb.h>
 #include <directfb_graphics.h>
 
@@ -56,11 +58,14 @@ void Renderer_TLS__deinit( void );
 
 void Renderer_DeleteEngines( void );
 
+void Renderer_DumpStatistics( void );
+
 #ifdef __cplusplus
 }
 
 
 extern "C" {
+#include <direct/atomic.h>
 #include <direct/thread.h>
 
 #include <core/CoreGraphicsStateClient.h>
@@ -99,6 +104,10 @@ TODO
 
  - lock mask surface?
 
+ - display lists (recorded operations replayed without validation or tesselation)
+   not provided: client calls are already buffered by CoreGraphicsState (flux 'buffer'),
+   a useful version needs engine specific command buffers and new CoreGraphicsState calls
+
 */
 
 
@@ -155,12 +164,84 @@ private:
      Direct::LockWQ     lwq;
 };
 
+
+/*
+ * Throughput counters kept by each Renderer and Engine
+ *
+ * Counters are updated atomically as engines are shared by renderers in different threads,
+ * they are native words and wrap around, so readers should look at differences over time.
+ */
+class Statistics
+{
+public:
+     class Hook : public SurfaceTask::Hook {
+     public:
+          Hook( Statistics &stats )
+               :
+               stats( stats )
+          {
+          }
+
+     private:
+          void finalise( SurfaceTask *task );
+
+          Statistics &stats;
+     };
+
+     enum {
+          ACCEL_MAX = 32        /* one slot per DFXL_* bit */
+     };
+
+     unsigned long operations;                     // calls passed to the engine, e.g. FillRectangles()
+     unsigned long primitives;                     // rectangles, blits etc. after tesselation
+     unsigned long pixels;                         // estimated from unclipped destination area
+     unsigned long coalesced;                      // operations merged into a pending batch
+     unsigned long state_changes;                  // state updates passed to the engine
+     unsigned long binds;                          // including rebinds
+     unsigned long rebinds;
+     unsigned long flushes;
+     unsigned long tasks;                          // finished tasks (accounted by Hook, only with renderer-stats)
+     unsigned long setup_time;                     // micro seconds in Task::Setup()
+     unsigned long run_time;                       // micro seconds from Task::Run() until Task::Done()
+
+     unsigned long accel_primitives[ACCEL_MAX];
+     unsigned long accel_pixels[ACCEL_MAX];
+
+     Statistics()
+     {
+          Reset();
+     }
+
+     void Reset()
+     {
+          memset( this, 0, sizeof(Statistics) );
+     }
+
+     void Add ( const Statistics          &other );
+     void Dump( const Direct::String      &name ) const;
+
+     void Count( DFBAccelerationMask  accel,
+                 unsigned int         num,
+                 unsigned long        pixels );
+
+     static inline void Count( unsigned long &counter,
+                               unsigned long  value = 1 )
+     {
+          D_SYNC_ADD( &counter, value );
+     }
+};
+
 class Renderer : public Direct::Magic<Renderer>
 {
 public:
      class Setup
      {
      public:
+          enum {
+               TILE_MAX        = 32,     /* limited by task_mask */
+               TILE_BLOCK_SIZE = 256     /* edge length of DCST_BLOCKS tiles in pixels */
+          };
+
           unsigned int   tiles;
           SurfaceTask  **tasks;
           DFBRegion     *clips;
@@ -170,44 +251,89 @@ public:
 
           SurfaceAllocationMap     allocations;
 
-          Setup( int width, int height, unsigned int tiles = 1 )
-               :
-               tiles( tiles ),
-               tiles_render( tiles )
+          Setup( int                     width,
+                 int                     height,
+                 unsigned int            cores  = 1,
+                 DFBConfigSoftwareTiles  layout = DCST_ROWS )
           {
-               D_ASSERT( tiles > 0 );
+               unsigned int columns = 1;
+               unsigned int rows    = 1;
 
-               tasks         = new SurfaceTask*[tiles];
-               clips         = new DFBRegion[tiles*2];
-               clips_clipped = clips + tiles;
+               D_ASSERT( width > 0 );
+               D_ASSERT( height > 0 );
+               D_ASSERT( cores > 0 );
 
-               memset( tasks, 0, sizeof(SurfaceTask*) * tiles );
+               if (cores > 1) {
+                    switch (layout) {
+                         case DCST_COLUMNS:
+                              columns = cores;
+                              break;
+
+                         case DCST_BLOCKS: {
+                              /* Use at least one block per core, more if the blocks would exceed the cache size. */
+                              unsigned int blocks = ((unsigned int) width * height) / (TILE_BLOCK_SIZE * TILE_BLOCK_SIZE);
+
+                              if (blocks < cores)
+                                   blocks = cores;
 
-               // FIXME: add Renderer control API for this
-               if (0) {
-                    int tw = ((width / tiles) + 7) & ~7;
+                              if (blocks > TILE_MAX)
+                                   blocks = TILE_MAX;
 
-                    tiles = (width / tw) + !!(tiles % tw);
+                              /* Keep the blocks roughly square, i.e. columns ~ sqrt( blocks * width / height ). */
+                              while (columns < blocks && (columns+1) * (columns+1) * (unsigned int) height <= blocks * width)
+                                   columns++;
 
-                    for (unsigned int i=0; i<tiles; i++) {
-                         clips[i].x1 = tw * i;
-                         clips[i].x2 = (i == tiles-1) ? width - 1 : (clips[i].x1 + tw - 1); // TODO: may move remainder to first task,
-                                                                                            // assuming it is emitted slightly earlier
+                              rows = (blocks + columns - 1) / columns;
 
-                         clips[i].y1 = 0;
-                         clips[i].y2 = height - 1;
+                              if (columns * rows > TILE_MAX)
+                                   rows = TILE_MAX / columns;
+                              break;
+                         }
+
+                         default:
+                              rows = cores;
+                              break;
                     }
+
+                    if (columns > (unsigned int) width)
+                         columns = width;
+
+                    if (rows > (unsigned int) height)
+                         rows = height;
                }
-               else {
-                    int th = height / tiles;
 
-                    for (unsigned int i=0; i<tiles; i++) {
-                         clips[i].x1 = 0;
-                         clips[i].x2 = width - 1;
+               tiles        = columns * rows;
+               tiles_render = tiles;
 
-                         clips[i].y1 = th * i;
-                         clips[i].y2 = (i == tiles-1) ? height - 1 : (clips[i].y1 + th - 1); // TODO: may move remainder to first task,
-                                                                                             // assuming it is emitted slightly earlier
+               D_ASSERT( tiles > 0 );
+               D_ASSERT( tiles <= TILE_MAX );
+
+               tasks         = new SurfaceTask*[tiles];
+               clips         = new DFBRegion[tiles*2];
+               clips_clipped = clips + tiles;
+
+               memset( tasks, 0, sizeof(SurfaceTask*) * tiles );
+
+               /*
+                * Spread the remainder over all tiles, keeping vertical edges on 8 pixel boundaries where possible.
+                *
+                * Each inner edge is computed once and used as x2 + 1 of one tile and x1 of the next (same for y),
+                * the outer edges are 0 and width/height, so the tiles cover the destination without gaps or
+                * overlaps for any size. Tiles are never empty: there are no more rows than lines, and alignment
+                * is only used with at least 8 pixels per column, e.g. 13 pixels in 3 columns are 0-3, 4-7, 8-12,
+                * while 100 pixels in 3 columns are 0-31, 32-63, 64-99 (see coretest_tiles).
+                */
+               unsigned int align = (width / columns >= 8) ? 8 : 1;
+
+               for (unsigned int y=0; y<rows; y++) {
+                    for (unsigned int x=0; x<columns; x++) {
+                         DFBRegion *clip = &clips[y * columns + x];
+
+                         clip->x1 = x ? ((width * x / columns) & ~(align - 1)) : 0;
+                         clip->x2 = (x == columns-1) ? width - 1 : (((width * (x+1) / columns) & ~(align - 1)) - 1);
+
+                         clip->y1 = height * y / rows;
+                         clip->y2 = height * (y+1) / rows - 1;
                     }
                }
           }
@@ -226,12 +352,18 @@ public:
      ~Renderer();
 
      void SetThrottle( Throttle *throttle );
+     void SetTileLayout( DFBConfigSoftwareTiles layout );
 
      void Flush( u32 cookie = 0, CoreGraphicsStateClientFlushFlags flags = CGSCFF_NONE );
 
      static void      FlushCurrent( u32 cookie = 0 );
      static Renderer *GetCurrent();
 
+     const Statistics &GetStatistics() const { return stats; }
+     void              ResetStatistics()     { stats.Reset(); }
+
+     static void       DumpStatistics();
+
 
      void DrawRectangles  ( const DFBRectangle     *rects,
                             unsigned int            num_rects );
@@ -289,12 +421,25 @@ private:
      WaterTransformType     transform_type;
 
      Throttle              *throttle;
+     DFBConfigSoftwareTiles tile_layout;   // set by the creator, from the software-tiles option
 
      DirectThread          *thread;     // where the renderer is used (while engine is bound)
      Engine                *engine;
      Setup                 *setup;
      unsigned int           operations;
 
+     enum {
+          COALESCE_BATCHES_MAX    = 4,      /* batches kept pending for reordering */
+          COALESCE_PRIMITIVES_MAX = 512     /* primitives merged into one batch */
+     };
+
+     class SavedState;
+     class Batch;
+
+     std::list<Batch*>      batches;    // coalesced operations not rendered yet
+
+     Statistics             stats;
+
 
      DFBAccelerationMask getTransformAccel( DFBAccelerationMask accel,
                                             WaterTransformType  type );
@@ -314,8 +459,16 @@ private:
 
      void      render    ( Primitives::Base       *primitives );
 
+     bool      coalesce  ( DFBAccelerationMask     accel,
+                           const DFBRectangle     *rects,
+                           const DFBPoint         *points,
+                           unsigned int            num );
+     void      flushBatches();
+
      DFBResult update    ( DFBAccelerationMask     accel );
 
+     static void dumpStatistics();
+
      /* Engines */
 
 private:
@@ -325,6 +478,8 @@ public:
      static DFBResult RegisterEngine  ( Engine *engine );
      static void      UnregisterEngine( Engine *engine );
      static void      DeleteEngines   ();
+
+     static const std::list<Engine*> &GetEngines() { return engines; }
 };
 
 
@@ -358,14 +513,19 @@ public:
 
      virtual unsigned int count() const = 0;
 
+     /* estimated number of destination pixels, 0 if unknown */
+     virtual unsigned long pixels() const {
+          return 0;
+     }
+
      virtual void render( Renderer::Setup *setup,
-                          Engine          *engine ) = 0;
-};
+                          Engine          *engine ) = 0;};
 
 }
 
 
 
+
 class Engine {
      friend class Renderer;
 
@@ -398,9 +558,12 @@ public:
 
      Capabilities             caps;
      Description              desc;
+     Statistics               stats;
 
 protected:
      Engine()
+          :
+          stats_hook( stats )
      {
      }
 
@@ -501,6 +664,10 @@ public:
                                          const DFBVertex1616    *vertices,
                                          unsigned int           &num,
                                          DFBTriangleFormation    formation );
+
+
+private:
+     Statistics::Hook         stats_hook;    // added to each task for accounting its times
 };
 
 
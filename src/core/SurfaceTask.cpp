@@ -320,7 +320,7 @@ SurfaceTask::Setup()
                          D_DEBUG_AT( DirectFB_Task, "       [%zu] %s\n", r, *ToString<Task>(*read_task) );
 
                          read_task->AddNotify( this, (read_task->accessor == accessor && read_task->qid == qid) ||
-                                                     (flags & TASK_FLAG_FOLLOW_READER) );
+                                                     (flags & TASK_FLAG_FOLLOW_READER), access.allocation );
                     }
 
                     read_tasks.Clear();
@@ -340,7 +340,7 @@ SurfaceTask::Setup()
                          D_FLAGS_CLEAR( write_access->flags, CSAF_CACHE_FLUSH );
 
                     write_task->AddNotify( this, (write_task->accessor == accessor && write_task->qid == qid) ||
-                                                 (flags & TASK_FLAG_FOLLOW_WRITER) );
+                                                 (flags & TASK_FLAG_FOLLOW_WRITER), access.allocation );
                }
                else
                     D_ASSERT( access.allocation->write_access == NULL );
@@ -367,7 +367,7 @@ SurfaceTask::Setup()
                     // and to carry on the flush flag to the read task
 
                     write_task->AddNotify( this, (write_task->accessor == accessor && write_task->qid == qid) ||
-                                                 (flags & TASK_FLAG_FOLLOW_WRITER) );
+                                                 (flags & TASK_FLAG_FOLLOW_WRITER), access.allocation );
                }
 
                // TODO: optimise in case we are already added, then just replace the task, maybe use static array with entry per accessor
@@ -57,6 +57,7 @@ extern "C" {
 #include <core/Debug.h>
 #include <core/Task.h>
 #include <core/TaskManager.h>
+#include <core/TaskTrace.h>
 #include <core/Util.h>
 
 /*********************************************************************************************************************/
@@ -248,6 +249,9 @@ Task::Task()
      next( NULL ),
      hwid( 0 ),
      ts_emit( 0 ),
+     ts_run( 0 ),
+     setup_time( 0 ),
+     run_time( 0 ),
      dump( false )
 {
      D_DEBUG_AT( DirectFB_Task, "Task::%s( %p )\n", __FUNCTION__, this );
@@ -417,6 +421,8 @@ Task::Flush()
      ts_flushed = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
 #endif
 
+     TaskTrace::Record( TaskTrace::FLUSH, this );
+
      TaskManager::pushTask( this );
 }
 
@@ -446,6 +452,8 @@ Task::emit()
      ts_running = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
 #endif
 
+     TaskTrace::Record( TaskTrace::EMIT, this );
+
      ret = Push();
      switch (ret) {
           case DFB_BUSY:
@@ -473,6 +481,8 @@ Task::emit()
                ts_running = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
 #endif
 
+               TaskTrace::Record( TaskTrace::EMIT, slave );
+
                ret = slave->Push();
                switch (ret) {
                     case DFB_BUSY:
@@ -585,10 +595,15 @@ Task::Done( DFBResult ret )
 
      state = TASK_DONE;
 
+     if (ts_run)
+          run_time = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC ) - ts_run;
+
 #if DFB_TASK_DEBUG_TIMING
      ts_done = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
 #endif
 
+     TaskTrace::Record( TaskTrace::DONE, this );
+
      if (ret)
           enableDump();
 
@@ -616,6 +631,8 @@ Task::Setup()
      ts_ready = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
 #endif
 
+     TaskTrace::Record( TaskTrace::READY, this );
+
      return DFB_OK;
 }
 
@@ -691,10 +708,11 @@ Task::Describe( Direct::String &string ) const
 }
 
 void
-Task::AddNotify( Task *notified,
-                 bool  follow )
+Task::AddNotify( Task                  *notified,
+                 bool                   follow,
+                 CoreSurfaceAllocation *allocation )
 {
-     D_DEBUG_AT( DirectFB_Task, "Task::%s( %p, notified %p, %sfollow )\n", __FUNCTION__, this, notified, follow ? "" : "NO " );
+     D_DEBUG_AT( DirectFB_Task, "Task::%s( %p, notified %p, %sfollow, allocation %p )\n", __FUNCTION__, this, notified, follow ? "" : "NO ", allocation );
 
      D_MAGIC_ASSERT( this, Task );
 
@@ -750,6 +768,8 @@ Task::AddNotify( Task *notified,
 
      notified->block_count++;
 
+     TaskTrace::Record( TaskTrace::EDGE, this, notified, allocation, (allocation && allocation->surface) ? allocation->surface->object.id : 0 );
+
      D_DEBUG_AT( DirectFB_Task, "Task::%s() done\n", __FUNCTION__ );
 }
 
@@ -44,6 +44,8 @@ extern "C" {
 
 #include <gfx/util.h>
 
+#include <misc/conf.h>
+
 #include <directfb.h>
 
 #if D_DEBUG_ENABLED
@@ -165,6 +167,7 @@ D_DEBUG_DOMAIN( DirectFB_Task, "DirectFB/Task", "DirectFB Task" );
 #include <direct/String.h>
 
 #include <core/Fifo.h>
+#include <core/TaskTrace.h>
 #include <core/Util.h>
 
 #include <list>
@@ -231,8 +234,9 @@ public:
      void      AddRef();
      void      Release();
 
-     void      AddNotify( Task *notified,
-                          bool  follow );
+     void      AddNotify( Task                  *notified,
+                          bool                   follow,
+                          CoreSurfaceAllocation *allocation = NULL );  // allocation causing the dependency, for tracing
      void      AddSlave ( Task *slave );
      void      AddToList( DFB_TaskList *list );
      void      RemoveFromList( DFB_TaskList *list );
@@ -250,6 +254,9 @@ public:
      virtual void                  Describe( Direct::String &string ) const;
      virtual const Direct::String &TypeName() const;
 
+     long long SetupTime() const { return setup_time; }
+     long long RunTime() const   { return run_time; }
+
 protected:
      TaskState state;
      TaskFlags flags;
@@ -290,6 +297,9 @@ protected:
 
      /* timing */
      long long                ts_emit;
+     long long                ts_run;       // when Run() was called by the task threads
+     long long                setup_time;   // micro seconds spent in Setup()
+     long long                run_time;     // micro seconds from Run() until Done()
 
 #if DFB_TASK_DEBUG_TIMING
      long long                ts_flushed;
@@ -393,6 +403,11 @@ public:
                     return NULL;
                }
 
+               if (dfb_config->renderer_stats)
+                    task->ts_run = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
+
+               TaskTrace::Record( TaskTrace::RUN, task );
+
                ret = task->Run();
                if (ret) {
                     D_DERROR( ret, "TaskThreads: Task::Run() failed! [%s]\n", *task->Description() );
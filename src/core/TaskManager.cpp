@@ -56,6 +56,7 @@ extern "C" {
 
 #include <core/Debug.h>
 #include <core/TaskManager.h>
+#include <core/TaskTrace.h>
 #include <core/Util.h>
 
 /*********************************************************************************************************************/
@@ -102,13 +103,13 @@ TaskManager_DumpTasks()
 
 /*********************************************************************************************************************/
 
-bool              TaskManager::running;
-DirectThread     *TaskManager::thread;
-FIFO<Task*>       TaskManager::fifo;
-TaskThreads      *TaskManager::threads;
+bool                TaskManager::running;
+DirectThread       *TaskManager::thread;
+LockFreeFIFO<Task*> TaskManager::fifo;
+TaskThreads        *TaskManager::threads;
 #if DFB_TASK_DEBUG_TASKS
-std::list<Task*>  TaskManager::tasks;
-DirectMutex       TaskManager::tasks_lock;
+std::list<Task*>    TaskManager::tasks;
+DirectMutex         TaskManager::tasks_lock;
 #endif
 long long                     TaskManager::pull_timeout;
 std::set<Task*,TaskManager>   TaskManager::timed_emits;
@@ -125,6 +126,8 @@ TaskManager::Initialise()
      direct_recursive_mutex_init( &tasks_lock );
 #endif
 
+     TaskTrace::Initialise( dfb_config->task_trace );
+
      if (dfb_config->task_manager) {
           running = true;
 
@@ -162,6 +165,16 @@ TaskManager::Shutdown()
           threads = NULL;
      }
 
+     if (TaskTrace::Enabled()) {
+          /* Clients may still flush, stop recording before exporting and freeing the events */
+          TaskTrace::Stop();
+
+          if (dfb_config->task_trace_file)
+               TaskTrace::Dump( dfb_config->task_trace_file );
+
+          TaskTrace::Shutdown();
+     }
+
 #if DFB_TASK_DEBUG_TASKS
      direct_mutex_deinit( &tasks_lock );
 #endif
@@ -251,9 +264,7 @@ DFBResult
 TaskManager::handleTask( Task *task )
 {
      DFBResult ret;
-#if DFB_TASK_DEBUG_TIMES
      long long t1, t2;
-#endif
 
      D_DEBUG_AT( DirectFB_Task, "TaskManager::%s( %p )\n", __FUNCTION__, task );
 
@@ -261,9 +272,8 @@ TaskManager::handleTask( Task *task )
           case TASK_FLUSHED:
                D_DEBUG_AT( DirectFB_Task, "  -> FLUSHED\n" );
 
-#if DFB_TASK_DEBUG_TIMES
-               t1 = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
-#endif
+               /* only measured for the renderer statistics (or debugging) */
+               t1 = (dfb_config->renderer_stats || DFB_TASK_DEBUG_TIMES) ? direct_clock_get_time( DIRECT_CLOCK_MONOTONIC ) : 0;
 
                ret = task->Setup();
                if (ret) {
@@ -273,8 +283,11 @@ TaskManager::handleTask( Task *task )
                     goto finish;
                }
 
+               t2 = t1 ? direct_clock_get_time( DIRECT_CLOCK_MONOTONIC ) : 0;
+
+               task->setup_time = t2 - t1;
+
 #if DFB_TASK_DEBUG_TIMES
-               t2 = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
                if (t2 - t1 > DFB_TASK_WARN_SETUP) {
                     D_WARN( "Task::Setup took more than %dus (%lld)  [%s]", DFB_TASK_WARN_SETUP, t2 - t1, task->Description().buffer() );
                     task->enableDump();
@@ -93,16 +93,16 @@ public:
 private:
      friend class Task;
 
-     static bool               running;
+     static bool                running;
 
-     static DirectThread      *thread;
-     static FIFO<Task*>        fifo;
+     static DirectThread       *thread;
+     static LockFreeFIFO<Task*> fifo;
 
-     static TaskThreads       *threads;
+     static TaskThreads        *threads;
 
 #if DFB_TASK_DEBUG_TASKS
-     static std::list<Task*>   tasks;
-     static DirectMutex        tasks_lock;
+     static std::list<Task*>    tasks;
+     static DirectMutex         tasks_lock;
 #endif
 
      static long long                        pull_timeout;
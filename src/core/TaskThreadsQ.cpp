@@ -56,6 +56,7 @@ extern "C" {
 
 #include <core/TaskManager.h>
 #include <core/TaskThreadsQ.h>
+#include <core/TaskTrace.h>
 #include <core/Util.h>
 
 D_DEBUG_DOMAIN( DirectFB_TaskThreadsQ, "DirectFB/TaskThreadsQ", "DirectFB TaskThreadsQ" );
@@ -75,32 +76,100 @@ extern "C" {
 /*********************************************************************************************************************/
 
 TaskThreadsQ::Runner::Runner( TaskThreadsQ         *threads,
-                              unsigned int          index,
-                              DirectThreadType      type,
-                              const Direct::String &name )
+                              unsigned int          index )
      :
      threads( threads ),
-     index( index )
+     index( index ),
+     cpu( -1 ),
+     thread( NULL )
 {
-     thread = direct_thread_create( type, taskLoop, this, name.buffer() );
 }
 
 TaskThreadsQ::Runner::~Runner()
 {
-     direct_thread_join( thread );
-     direct_thread_destroy( thread );
+     if (thread) {
+          direct_thread_join( thread );
+          direct_thread_destroy( thread );
+     }
+}
+
+void
+TaskThreadsQ::Runner::start( DirectThreadType      type,
+                             const Direct::String &name )
+{
+     thread = direct_thread_create( type, taskLoop, this, name.buffer() );
+}
+
+Task *
+TaskThreadsQ::Runner::take( bool steal )
+{
+     Task *task = NULL;
+
+     lock.lock();
+
+     if (!tasks.empty()) {
+          /* Own tasks in order, stolen ones from the other end to keep away from the owner. */
+          if (steal) {
+               task = tasks.back();
+               tasks.pop_back();
+          }
+          else {
+               task = tasks.front();
+               tasks.pop_front();
+          }
+     }
+
+     lock.unlock();
+
+     return task;
+}
+
+void
+TaskThreadsQ::Runner::queue( Task *task )
+{
+     lock.lock();
+
+     tasks.push_back( task );
+
+     lock.unlock();
 }
 
 /*********************************************************************************************************************/
 
-TaskThreadsQ::TaskThreadsQ( const std::string &name, size_t num, DirectThreadType type )
+TaskThreadsQ::TaskThreadsQ( const std::string &name, size_t num, DirectThreadType type, bool pinning )
+     :
+     stop( false ),
+     pending( 0 ),
+     idle( 0 )
 {
-     D_DEBUG_AT( DirectFB_TaskThreadsQ, "TaskThreadsQ::%s( '%s', num %zu, type %d )\n", __FUNCTION__, name.c_str(), num, type );
+     D_DEBUG_AT( DirectFB_TaskThreadsQ, "TaskThreadsQ::%s( '%s', num %zu, type %d, pinning %d )\n",
+                 __FUNCTION__, name.c_str(), num, type, pinning );
+
+     /* All runners need to exist before any of them starts stealing. */
+     for (size_t i=0; i<num; i++)
+          runners.push_back( new Runner( this, i ) );
+
+     /* Pick CPUs out of those the process may use, but only if every runner gets one of its own. */
+     if (pinning && num) {
+          std::vector<int> cpus( num );
+          int              num_cpus = 0;
+          DirectResult     ret;
+
+          ret = direct_thread_get_cpus( &cpus[0], num, &num_cpus );
+          if (ret)
+               D_DERROR( (DFBResult) ret, "TaskThreadsQ: Could not query available CPUs, not pinning!\n" );
+          else if ((size_t) num_cpus < num)
+               D_INFO( "TaskThreadsQ: Only %d CPUs available for %zu runners, not pinning.\n", num_cpus, num );
+          else {
+               for (size_t i=0; i<num; i++)
+                    runners[i]->cpu = cpus[i];
+          }
+     }
 
      for (size_t i=0; i<num; i++) {
-          runners.push_back( new Runner( this, i, type, (num > 1) ?
-                                                            Direct::String::F( "%s/%zu", name.c_str(), i ) :
-                                                            Direct::String::F( "%s", name.c_str() ) ) );
+          runners[i]->start( type, (num > 1) ?
+                                   Direct::String::F( "%s/%zu", name.c_str(), i ) :
+                                   Direct::String::F( "%s", name.c_str() ) );
      }
 
      D_ASSUME( runners.size() == num );
@@ -108,15 +177,76 @@ TaskThreadsQ::TaskThreadsQ( const std::string &name, size_t num, DirectThreadTyp
 
 TaskThreadsQ::~TaskThreadsQ()
 {
-     for (size_t i=0; i<runners.size(); i++)
-          fifo.push( NULL );
+     idle_lwq.lock();
+
+     stop = true;
+
+     idle_lwq.notifyAll();
+
+     idle_lwq.unlock();
 
      for (std::vector<Runner*>::const_iterator it = runners.begin(); it != runners.end(); it++)
           delete *it;
 }
 
+void
+TaskThreadsQ::queue( Task *task )
+{
+     D_MAGIC_ASSERT( task, Task );
+
+     /* Same allocation and tile go to the same runner, different tiles of an allocation are spread. */
+     Runner *runner = runners[ ((u32)(task->qid >> 32) + (u32) task->qid) % runners.size() ];
+
+     D_DEBUG_AT( DirectFB_TaskThreadsQ, "  -> queueing task %p to runner %u\n", task, runner->index );
+
+     runner->queue( task );
+
+     D_SYNC_ADD( &pending, 1 );
+
+     if (*(volatile int*) &idle) {
+          idle_lwq.lock();
+          idle_lwq.notify();
+          idle_lwq.unlock();
+     }
+}
 
-void TaskThreadsQ::Push( Task *task )
+Task *
+TaskThreadsQ::pull( Runner *runner )
+{
+     size_t num = runners.size();
+
+     while (true) {
+          Task *task = runner->take( false );
+
+          for (size_t i=1; !task && i<num; i++)
+               task = runners[(runner->index + i) % num]->take( true );
+
+          if (task) {
+               D_SYNC_ADD( &pending, -1 );
+               return task;
+          }
+
+          idle_lwq.lock();
+
+          D_SYNC_ADD( &idle, 1 );
+
+          /* Checked after announcing idle, a queueing thread either sees it or we see the task. */
+          while (!*(volatile int*) &pending && !stop)
+               idle_lwq.wait();
+
+          D_SYNC_ADD( &idle, -1 );
+
+          if (stop && !*(volatile int*) &pending) {
+               idle_lwq.unlock();
+               return NULL;
+          }
+
+          idle_lwq.unlock();
+     }
+}
+
+void
+TaskThreadsQ::Push( Task *task )
 {
      static D_PERF_COUNTER( TaskThreadsQ__Push, "TaskThreadsQ::Push" );
 
@@ -144,7 +274,7 @@ void TaskThreadsQ::Push( Task *task )
      else {
           D_DEBUG_AT( DirectFB_TaskThreadsQ, "  -> pushing task %p\n", task );
 
-          fifo.push( task );
+          queue( task );
      }
 }
 
@@ -173,7 +303,7 @@ void TaskThreadsQ::Finalise( Task *task )
 
                D_DEBUG_AT( DirectFB_TaskThreadsQ, "  -> pushing task %p to resume operation\n", task->next );
 
-               fifo.push( task->next );
+               queue( task->next );
           }
           else {
                D_ASSERT( queues[task->qid] == task );
@@ -196,10 +326,16 @@ TaskThreadsQ::taskLoop( DirectThread *thread,
 
      D_DEBUG_AT( DirectFB_TaskThreadsQ, "TaskThreadsQ::%s()\n", __FUNCTION__ );
 
+     if (runner->cpu >= 0) {
+          ret = (DFBResult) direct_thread_set_cpu( runner->cpu );
+          if (ret)
+               D_DERROR( ret, "TaskThreadsQ: Could not pin runner %u to CPU %d!\n", runner->index, runner->cpu );
+     }
+
      while (true) {
-          task = thiz->fifo.pull();
+          task = thiz->pull( runner );
           if (!task) {
-               D_DEBUG_AT( DirectFB_TaskThreadsQ, "TaskThreadsQ::%s()  -> got NULL task (exit signal)\n", __FUNCTION__ );
+               D_DEBUG_AT( DirectFB_TaskThreadsQ, "TaskThreadsQ::%s()  -> stopped\n", __FUNCTION__ );
                return NULL;
           }
 
@@ -231,6 +367,11 @@ next:
 
           D_PERF_COUNT_N( thiz->perfs[task->qid].counter, -1 );  // not fully thread safe
 
+          if (dfb_config->renderer_stats)
+               task->ts_run = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
+
+          TaskTrace::Record( TaskTrace::RUN, task );
+
           ret = task->Run();
           if (ret) {
                D_DERROR( ret, "TaskThreadsQ: Task::Run() failed! [%s]\n", *task->Description() );
@@ -248,7 +389,7 @@ next:
 
                D_MAGIC_ASSERT( next, Task );
 
-               thiz->fifo.push( next );
+               thiz->queue( next );
           }
      }
 
@@ -56,6 +56,7 @@ extern "C" {
 }
 
 
+#include <direct/LockWQ.h>
 #include <direct/Magic.h>
 #include <direct/Mutex.h>
 #include <direct/Performer.h>
@@ -64,6 +65,7 @@ extern "C" {
 #include <core/Fifo.h>
 #include <core/Util.h>
 
+#include <deque>
 #include <list>
 #include <map>
 #include <queue>
@@ -79,30 +81,44 @@ class TaskManager;
 class TaskThreads;
 
 
+/*
+ * Runs tasks on a set of threads, tasks with the same queue id (qid) are run sequentially
+ *
+ * Each runner has its own deque of ready tasks. A task is queued to the runner selected by its qid,
+ * e.g. the allocation and tile for Genefx, so work on the same memory tends to stay on the same core.
+ * Runners take their own tasks from the front and steal from the back of the others when running dry.
+ */
 class TaskThreadsQ : public Direct::Magic<TaskThreadsQ> {
 private:
      class Runner : public Direct::Magic<Runner> {
      public:
-          TaskThreadsQ *threads;
-          unsigned int  index;
-          DirectThread *thread;
+          TaskThreadsQ     *threads;
+          unsigned int      index;
+          int               cpu;        // CPU the thread is bound to, -1 if not pinned
+          DirectThread     *thread;
+
+          Direct::Mutex     lock;
+          std::deque<Task*> tasks;
 
           Runner( TaskThreadsQ         *threads,
-                  unsigned int          index,
-                  DirectThreadType      type,
-                  const Direct::String &name );
+                  unsigned int          index );
 
           ~Runner();
+
+          void  start( DirectThreadType      type,
+                       const Direct::String &name );
+
+          Task *take ( bool steal );
+          void  queue( Task *task );
      };
 
 public:
-     DirectFB::FIFO<Task*>              fifo;   // TODO: try to find better structure without lock, maybe futex
      std::vector<Runner*>               runners;
      std::map<u64,Task*>                queues;
      std::map<u64,Direct::PerfCounter>  perfs;
 
 public:
-     TaskThreadsQ( const std::string &name, size_t num, DirectThreadType type = DTT_DEFAULT );
+     TaskThreadsQ( const std::string &name, size_t num, DirectThreadType type = DTT_DEFAULT, bool pinning = false );
 
      ~TaskThreadsQ();
 
@@ -111,6 +127,14 @@ public:
      void Finalise( Task *task );
 
 private:
+     bool                               stop;
+     int                                pending;    // tasks queued in all runners
+     int                                idle;       // runners waiting for tasks
+     Direct::LockWQ                     idle_lwq;
+
+     void  queue( Task *task );
+     Task *pull ( Runner *runner );
+
      static void *
      taskLoop( DirectThread *thread,
                void         *arg );
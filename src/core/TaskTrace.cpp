@@ -0,0 +1,449 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+
+
+//#define DIRECT_ENABLE_DEBUG
+
+#include <config.h>
+
+#include <directfb.h>
+#include <directfb_util.h>
+
+#include <direct/Types++.h>
+
+
+extern "C" {
+#include <stdio.h>
+#include <string.h>
+
+#include <direct/atomic.h>
+#include <direct/clock.h>
+#include <direct/debug.h>
+#include <direct/messages.h>
+#include <direct/system.h>
+#include <direct/thread.h>
+
+#include <misc/conf.h>
+}
+
+#include <direct/String.h>
+
+#include <core/Task.h>
+#include <core/TaskTrace.h>
+
+#include <map>
+#include <vector>
+
+
+D_DEBUG_DOMAIN( DirectFB_TaskTrace, "DirectFB/TaskTrace", "DirectFB Task Trace" );
+
+/*********************************************************************************************************************/
+
+namespace DirectFB {
+
+
+extern "C" {
+
+DFBResult
+TaskTrace_Dump( const char *filename )
+{
+     D_DEBUG_AT( DirectFB_TaskTrace, "%s( '%s' )\n", __FUNCTION__, filename );
+
+     return TaskTrace::Dump( filename );
+}
+
+}
+
+/*********************************************************************************************************************/
+
+TaskTrace::Event *TaskTrace::events;
+unsigned int      TaskTrace::mask;
+unsigned long     TaskTrace::pos;
+int               TaskTrace::recording;
+int               TaskTrace::writers;
+DirectMutex       TaskTrace::lock = DIRECT_MUTEX_INITIALIZER( TaskTrace::lock );
+
+
+DFBResult
+TaskTrace::Initialise( unsigned int size )
+{
+     unsigned int num = 1;
+
+     D_DEBUG_AT( DirectFB_TaskTrace, "TaskTrace::%s( %u )\n", __FUNCTION__, size );
+
+     D_ASSERT( events == NULL );
+
+     if (!size)
+          return DFB_OK;
+
+     /* power of two for masking the ring buffer index */
+     while (num < size)
+          num <<= 1;
+
+     events    = new Event[num]();
+     mask      = num - 1;
+     pos       = 0;
+     recording = 1;
+
+     D_INFO( "DirectFB/TaskTrace: Recording last %u task events\n", num );
+
+     return DFB_OK;
+}
+
+void
+TaskTrace::Stop()
+{
+     D_DEBUG_AT( DirectFB_TaskTrace, "TaskTrace::%s()\n", __FUNCTION__ );
+
+     /* record() increments 'writers' before checking 'recording', so after this no one writes any more */
+     D_SYNC_FETCH_AND_CLEAR( &recording );
+
+     while (writers)
+          direct_thread_sleep( 100 );
+}
+
+void
+TaskTrace::Shutdown()
+{
+     Event *old;
+
+     D_DEBUG_AT( DirectFB_TaskTrace, "TaskTrace::%s()\n", __FUNCTION__ );
+
+     Stop();
+
+     direct_mutex_lock( &lock );
+
+     old    = events;
+     events = NULL;
+
+     direct_mutex_unlock( &lock );
+
+     delete[] old;
+}
+
+void
+TaskTrace::record( Type         type,
+                   const Task  *task,
+                   const Task  *other,
+                   const void  *object,
+                   unsigned int data )
+{
+     unsigned long  index;
+     Event         *event;
+
+     D_SYNC_ADD( &writers, 1 );
+
+     if (!recording) {
+          D_SYNC_ADD( &writers, -1 );
+          return;
+     }
+
+     index = D_SYNC_ADD_AND_FETCH( &pos, 1 ) - 1;
+     event = &events[index & mask];
+
+     event->seq    = 0;
+     event->ts     = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
+     event->task   = task;
+     event->other  = other;
+     event->name   = *task->TypeName();
+     event->object = object;
+     event->data   = data;
+     event->tid    = direct_gettid();
+     event->type   = type;
+
+     /* publish the slot, a reader skips slots not matching their index (being written or overwritten) */
+     D_SYNC_ADD( &event->seq, index + 1 );
+
+     D_SYNC_ADD( &writers, -1 );
+}
+
+/*********************************************************************************************************************/
+
+namespace {
+
+struct Life {
+     const Task   *task;
+     const char   *name;
+     long long     ts[TaskTrace::DONE + 1];
+     unsigned int  tid;        // thread running the task
+     unsigned int  flush_tid;  // thread flushing the task
+     long          pred;       // predecessor finishing last
+     bool          critical;
+
+     Life( const Task *task, const char *name )
+          :
+          task( task ),
+          name( name ),
+          tid( 0 ),
+          flush_tid( 0 ),
+          pred( -1 ),
+          critical( false )
+     {
+          memset( ts, 0, sizeof(ts) );
+     }
+
+     bool complete() const
+     {
+          return ts[TaskTrace::RUN] && ts[TaskTrace::DONE];
+     }
+};
+
+struct Dependency {
+     size_t        from;
+     size_t        to;
+     const void   *object;
+     unsigned int  data;
+};
+
+class Timeline {
+public:
+     std::vector<Life>              records;
+     std::vector<Dependency>        edges;
+     std::map<const Task*,size_t>   current;
+
+     /* returns the record of the task's current life, a new one is started if there's none or on 'repeat' */
+     size_t get( const Task *task, const char *name, bool repeat )
+     {
+          std::map<const Task*,size_t>::iterator it = current.find( task );
+
+          if (it != current.end() && !repeat)
+               return it->second;
+
+          records.push_back( Life( task, name ) );
+
+          return current[task] = records.size() - 1;
+     }
+
+     void add( const TaskTrace::Event &event )
+     {
+          if (event.type == TaskTrace::EDGE) {
+               Dependency edge;
+
+               edge.from   = get( event.task, event.name, false );
+               edge.to     = get( event.other, NULL, false );
+               edge.object = event.object;
+               edge.data   = event.data;
+
+               edges.push_back( edge );
+               return;
+          }
+
+          size_t  index  = get( event.task, event.name, event.type == TaskTrace::FLUSH );
+          Life   *life   = &records[index];
+
+          /* same event again without a flush, e.g. slaves or a reused address */
+          if (life->ts[event.type]) {
+               index  = get( event.task, event.name, true );
+               life = &records[index];
+          }
+
+          life->name           = event.name;
+          life->ts[event.type] = event.ts;
+
+          switch (event.type) {
+               case TaskTrace::FLUSH:
+                    life->flush_tid = event.tid;
+                    break;
+
+               case TaskTrace::RUN:
+                    life->tid = event.tid;
+                    break;
+
+               default:
+                    break;
+          }
+     }
+
+     /* marks the chain of predecessors which finished last, ending with the last task done */
+     long critical()
+     {
+          long   last  = -1;
+          long   index;
+          size_t count = 0;
+
+          for (size_t i=0; i<edges.size(); i++) {
+               Life &from = records[edges[i].from];
+               Life &to   = records[edges[i].to];
+
+               if (!from.ts[TaskTrace::DONE])
+                    continue;
+
+               if (to.pred < 0 || records[to.pred].ts[TaskTrace::DONE] < from.ts[TaskTrace::DONE])
+                    to.pred = edges[i].from;
+          }
+
+          for (size_t i=0; i<records.size(); i++) {
+               if (records[i].complete() && (last < 0 || records[last].ts[TaskTrace::DONE] < records[i].ts[TaskTrace::DONE]))
+                    last = i;
+          }
+
+          for (index = last; index >= 0 && count < records.size(); index = records[index].pred, count++)
+               records[index].critical = true;
+
+          return last;
+     }
+};
+
+}
+
+DFBResult
+TaskTrace::Dump( const char *filename )
+{
+     DFBResult ret;
+
+     direct_mutex_lock( &lock );
+
+     ret = dump( filename );
+
+     direct_mutex_unlock( &lock );
+
+     return ret;
+}
+
+DFBResult
+TaskTrace::dump( const char *filename )
+{
+     Timeline       timeline;
+     unsigned long  start;
+     unsigned long  end;
+     long long      base = 0;
+     long           last;
+     FILE          *file;
+     const char    *sep  = "";
+     int            pid  = direct_getpid();
+
+     D_DEBUG_AT( DirectFB_TaskTrace, "TaskTrace::%s( '%s' )\n", __FUNCTION__, filename );
+
+     if (!events) {
+          D_ERROR( "DirectFB/TaskTrace: Not enabled, use 'task-trace' option!\n" );
+          return DFB_UNSUPPORTED;
+     }
+
+     end   = pos;
+     start = (end > mask + 1) ? end - mask - 1 : 0;
+
+     for (unsigned long i=start; i<end; i++) {
+          const Event event = events[i & mask];
+
+          if (event.seq != i + 1)
+               continue;
+
+          if (!base)
+               base = event.ts;
+
+          timeline.add( event );
+     }
+
+     last = timeline.critical();
+
+     file = fopen( filename, "w" );
+     if (!file) {
+          D_PERROR( "DirectFB/TaskTrace: Could not open '%s' for writing!\n", filename );
+          return DFB_IO;
+     }
+
+     fprintf( file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" );
+
+     for (size_t i=0; i<timeline.records.size(); i++) {
+          const Life   &life   = timeline.records[i];
+          const char   *name   = life.name ? life.name : "Task";
+
+          if (life.complete()) {
+               fprintf( file, "%s{\"name\":\"%s\",\"cat\":\"task\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":%d,\"tid\":%u,"
+                        "\"args\":{\"task\":\"%p\",\"critical\":%s}}", sep, name,
+                        life.ts[RUN] - base, life.ts[DONE] - life.ts[RUN], pid, life.tid,
+                        life.task, life.critical ? "true" : "false" );
+               sep = ",\n";
+          }
+
+          /* time waiting for dependencies (READY) and for a runner thread (emitted) */
+          if (life.ts[READY] && life.ts[EMIT]) {
+               fprintf( file, "%s{\"name\":\"blocked\",\"cat\":\"wait\",\"ph\":\"b\",\"id\":%zu,\"ts\":%lld,\"pid\":%d,\"tid\":%u,\"args\":{\"task\":\"%s\"}},\n"
+                        "{\"name\":\"blocked\",\"cat\":\"wait\",\"ph\":\"e\",\"id\":%zu,\"ts\":%lld,\"pid\":%d,\"tid\":%u}", sep,
+                        i, life.ts[READY] - base, pid, life.flush_tid, name, i, life.ts[EMIT] - base, pid, life.flush_tid );
+               sep = ",\n";
+          }
+
+          if (life.ts[EMIT] && life.ts[RUN]) {
+               fprintf( file, "%s{\"name\":\"queued\",\"cat\":\"wait\",\"ph\":\"b\",\"id\":%zu,\"ts\":%lld,\"pid\":%d,\"tid\":%u,\"args\":{\"task\":\"%s\"}},\n"
+                        "{\"name\":\"queued\",\"cat\":\"wait\",\"ph\":\"e\",\"id\":%zu,\"ts\":%lld,\"pid\":%d,\"tid\":%u}", sep,
+                        i, life.ts[EMIT] - base, pid, life.flush_tid, name, i, life.ts[RUN] - base, pid, life.flush_tid );
+               sep = ",\n";
+          }
+     }
+
+     /* dependencies as flow arrows from the running slice of one task to the other's */
+     for (size_t i=0; i<timeline.edges.size(); i++) {
+          const Dependency &edge = timeline.edges[i];
+          const Life       &from = timeline.records[edge.from];
+          const Life       &to   = timeline.records[edge.to];
+
+          if (!from.complete() || !to.complete())
+               continue;
+
+          fprintf( file, "%s{\"name\":\"surface %u\",\"cat\":\"%s\",\"ph\":\"s\",\"id\":%zu,\"ts\":%lld,\"pid\":%d,\"tid\":%u,\"args\":{\"allocation\":\"%p\"}},\n"
+                   "{\"name\":\"surface %u\",\"cat\":\"%s\",\"ph\":\"f\",\"bp\":\"e\",\"id\":%zu,\"ts\":%lld,\"pid\":%d,\"tid\":%u}", sep,
+                   edge.data, (to.critical && to.pred == (long) edge.from) ? "critical" : "dependency", i, from.ts[RUN] - base, pid, from.tid, edge.object,
+                   edge.data, (to.critical && to.pred == (long) edge.from) ? "critical" : "dependency", i, to.ts[RUN] - base, pid, to.tid );
+          sep = ",\n";
+     }
+
+     fprintf( file, "\n]}\n" );
+
+     fclose( file );
+
+     D_INFO( "DirectFB/TaskTrace: Wrote %zu tasks and %zu dependencies to '%s'\n", timeline.records.size(), timeline.edges.size(), filename );
+
+     if (last >= 0) {
+          std::vector<const Life*> path;
+
+          for (long index = last; index >= 0 && path.size() < timeline.records.size(); index = timeline.records[index].pred)
+               path.push_back( &timeline.records[index] );
+
+          D_INFO( "DirectFB/TaskTrace: Critical path of %zu tasks\n", path.size() );
+
+          for (size_t i=path.size(); i>0; i--) {
+               const Life *life = path[i-1];
+
+               D_INFO( "DirectFB/TaskTrace:   %-16s %p  blocked %6lld us, queued %6lld us, run %6lld us\n",
+                       life->name ? life->name : "Task", life->task,
+                       (life->ts[READY] && life->ts[EMIT]) ? life->ts[EMIT] - life->ts[READY] : 0LL,
+                       (life->ts[EMIT]  && life->ts[RUN])  ? life->ts[RUN]  - life->ts[EMIT]  : 0LL,
+                       life->ts[DONE] - life->ts[RUN] );
+          }
+     }
+
+     return DFB_OK;
+}
+
+
+}
+
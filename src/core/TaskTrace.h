@@ -0,0 +1,139 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+
+
+#ifndef ___DirectFB__TaskTrace__H___
+#define ___DirectFB__TaskTrace__H___
+
+
+#include <directfb.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <direct/os/mutex.h>
+
+
+DFBResult    TaskTrace_Dump( const char *filename );
+
+
+#ifdef __cplusplus
+}
+
+
+namespace DirectFB {
+
+
+class Task;
+
+
+/*
+ * Production tracing of tasks
+ *
+ * Events are written into a fixed size ring buffer without locking, the last slot written wins.
+ * Stop() ends recording and waits for writers still in record(), so the buffer can be exported and
+ * freed safely. Dump() and Shutdown() are serialized by a mutex.
+ *
+ * Dump() reconstructs the life of each task (flush -> ready -> emit -> run -> done) and the
+ * dependencies between them, writes them as Chrome trace event JSON and prints the critical path,
+ * i.e. the chain of dependencies that finished last.
+ */
+class TaskTrace
+{
+public:
+     typedef enum {
+          FLUSH,    // Flush() by the client
+          READY,    // Setup() by the TaskManager, dependencies are known
+          EMIT,     // no more blocking dependencies, pushed to the threads
+          RUN,      // picked up by a runner thread
+          DONE,     // Done() called
+          EDGE      // 'task' has to be done (or running) before 'other'
+     } Type;
+
+     typedef struct {
+          unsigned long  seq;      // index + 1, zero while being written
+          long long      ts;
+          const Task    *task;
+          const Task    *other;
+          const char    *name;
+          const void    *object;   // e.g. allocation causing the dependency
+          unsigned int   data;     // e.g. surface object id
+          unsigned int   tid;
+          unsigned int   type;
+     } Event;
+
+     static DFBResult Initialise( unsigned int size );
+     static void      Stop();
+     static void      Shutdown();
+     static DFBResult Dump( const char *filename );
+
+     static inline bool Enabled()
+     {
+          return events != NULL;
+     }
+
+     static inline void Record( Type         type,
+                                const Task  *task,
+                                const Task  *other  = NULL,
+                                const void  *object = NULL,
+                                unsigned int data   = 0 )
+     {
+          if (recording)
+               record( type, task, other, object, data );
+     }
+
+private:
+     static Event         *events;
+     static unsigned int   mask;
+     static unsigned long  pos;
+     static int            recording;   // cleared by Stop(), checked again by record()
+     static int            writers;     // calls of record() in progress
+     static DirectMutex    lock;        // Dump() and Shutdown()
+
+     static DFBResult dump( const char *filename );
+
+     static void record( Type         type,
+                         const Task  *task,
+                         const Task  *other,
+                         const void  *object,
+                         unsigned int data );
+};
+
+
+}
+
+
+#endif // __cplusplus
+
+
+#endif
+
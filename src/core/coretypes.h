@@ -66,7 +66,7 @@ typedef struct _CardState                    CardState;
 
 typedef struct __DFB_DFBFontManager          DFBFontManager;
 typedef struct __DFB_DFBFontCache            DFBFontCache;
-typedef struct __DFB_DFBFontCacheRow         DFBFontCacheRow;
+typedef struct __DFB_DFBFontCachePage        DFBFontCachePage;
 
 
 typedef struct __DFB_CoreGraphicsSerial      CoreGraphicsSerial;
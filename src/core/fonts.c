@@ -39,6 +39,7 @@
 
 #include <directfb.h>
 
+#include <core/CoreGraphicsStateClient.h>
 #include <core/core.h>
 #include <core/coredefs.h>
 #include <core/coretypes.h>
@@ -51,7 +52,9 @@
 #include <direct/hash.h>
 #include <direct/map.h>
 #include <direct/mem.h>
+#include <direct/memcpy.h>
 #include <direct/messages.h>
+#include <direct/thread.h>
 #include <direct/utf8.h>
 #include <direct/util.h>
 
@@ -66,7 +69,7 @@ D_DEBUG_DOMAIN( Core_FontSurfaces, "Core/Font/Surf", "DirectFB Core Font Surface
 
 D_DEBUG_DOMAIN( Font_Manager,      "Core/Font/Manager",  "DirectFB Core Font Manager" );
 D_DEBUG_DOMAIN( Font_Cache,        "Core/Font/Cache",    "DirectFB Core Font Cache" );
-D_DEBUG_DOMAIN( Font_CacheRow,     "Core/Font/CacheRow", "DirectFB Core Font Cache Row" );
+D_DEBUG_DOMAIN( Font_CachePage,    "Core/Font/CachePage", "DirectFB Core Font Cache Page" );
 
 /**********************************************************************************************************************/
 
@@ -75,6 +78,10 @@ static bool free_glyphs( DirectHash    *hash,
                          void          *value,
                          void          *ctx );
 
+static void free_text_runs( CoreFont *font );
+
+static void font_manager_stop_prerender( DFBFontManager *manager );
+
 /**********************************************************************************************************************/
 
 struct __DFB_DFBFontManager {
@@ -83,19 +90,30 @@ struct __DFB_DFBFontManager {
      CoreDFB            *core;
 
      pthread_mutex_t     lock;
+     int                 lock_count;
 
      DirectMap          *caches;
 
      unsigned int        max_rows;
-     unsigned int        num_rows;
-     unsigned long long  row_stamp;     // FIXME: lru calculation wrong if value overruns (non-fatal)
+     unsigned int        num_rows;      /* each page counts as the number of rows it's made of */
+     unsigned long long  stamp;         // FIXME: lru calculation wrong if value overruns (non-fatal)
+     unsigned long long  lock_stamp;    /* glyphs used since locking must not be evicted */
+
+     DFBFontManagerStats stats;
+
+     DirectMutex         prerender_lock;
+     DirectWaitQueue     prerender_wq;
+     DirectThread       *prerender_thread;
+     DirectLink         *prerender_jobs;
+     void               *prerender_job;  /* job being worked on by the thread */
+     bool                prerender_stop;
 };
 
 #define DFB_FONT_MANAGER_ASSERT( manager )                            \
      do {                                                             \
           D_MAGIC_ASSERT( manager, DFBFontManager );                  \
           D_ASSERT( (manager)->max_rows > 0 );                        \
-          D_ASSERT( (manager)->num_rows <= (manager)->max_rows );     \
+          D_ASSERT( (manager)->lock_count >= 0 );                     \
      } while (0)
 
 /**********************************************************************************************************************/
@@ -107,9 +125,11 @@ struct __DFB_DFBFontCache {
 
      DFBFontCacheType    type;
 
-     unsigned int        row_width;
+     unsigned int        page_width;
+     unsigned int        page_height;
+     unsigned int        page_rows;
 
-     DirectLink         *rows;
+     DirectLink         *pages;
 };
 
 #define DFB_FONT_CACHE_ASSERT( cache )                                \
@@ -119,7 +139,15 @@ struct __DFB_DFBFontCache {
 
 /**********************************************************************************************************************/
 
-struct __DFB_DFBFontCacheRow {
+#define DFB_FONT_CACHE_PAGE_NODES   64      /* maximum number of skyline segments */
+#define DFB_FONT_CACHE_PAGE_HOLES   32      /* maximum number of areas left by evicted glyphs */
+
+/*
+ * A glyph cache page is packed along a skyline, i.e. each glyph is placed at the lowest position
+ * above the glyphs already allocated. Areas of evicted glyphs are remembered as holes and reused,
+ * the whole page is reset once the last glyph has been evicted.
+ */
+struct __DFB_DFBFontCachePage {
      DirectLink          link;
 
      int                 magic;
@@ -129,14 +157,29 @@ struct __DFB_DFBFontCacheRow {
      unsigned long long  stamp;
 
      CoreSurface        *surface;
-     unsigned int        next_x;
 
-     DirectLink         *glyphs;
+     struct {
+          int            x;
+          int            y;             /* first free line */
+          int            w;
+     }                   nodes[DFB_FONT_CACHE_PAGE_NODES];
+     int                 num_nodes;
+
+     DFBRectangle        holes[DFB_FONT_CACHE_PAGE_HOLES];
+     int                 num_holes;
+
+     unsigned int        glyph_pixels;
+     bool                reused;        /* glyphs removed since the last flush, queued operations may read their cells */
+
+     DirectLink         *glyphs;        /* least recently used first */
 };
 
-#define DFB_FONT_CACHE_ROW_ASSERT( row )                              \
+#define DFB_FONT_CACHE_PAGE_ASSERT( page )                            \
      do {                                                             \
-          D_MAGIC_ASSERT( row, DFBFontCacheRow );                     \
+          D_MAGIC_ASSERT( page, DFBFontCachePage );                   \
+          D_ASSERT( (page)->num_nodes > 0 );                          \
+          D_ASSERT( (page)->num_nodes <= DFB_FONT_CACHE_PAGE_NODES ); \
+          D_ASSERT( (page)->num_holes <= DFB_FONT_CACHE_PAGE_HOLES ); \
      } while (0)
 
 /**********************************************************************************************************************/
@@ -228,6 +271,9 @@ dfb_font_manager_init( DFBFontManager *manager,
 
      direct_util_recursive_pthread_mutex_init( &manager->lock );
 
+     direct_mutex_init( &manager->prerender_lock );
+     direct_waitqueue_init( &manager->prerender_wq );
+
      D_MAGIC_SET( manager, DFBFontManager );
 
      return DFB_OK;
@@ -256,6 +302,14 @@ dfb_font_manager_deinit( DFBFontManager *manager )
 
      DFB_FONT_MANAGER_ASSERT( manager );
 
+     D_DEBUG_AT( Font_Manager, "  -> %llu evictions, %llu compactions\n",
+                 manager->stats.evictions, manager->stats.compactions );
+
+     font_manager_stop_prerender( manager );
+
+     direct_mutex_deinit( &manager->prerender_lock );
+     direct_waitqueue_deinit( &manager->prerender_wq );
+
      direct_map_iterate( manager->caches, destroy_caches, NULL );
      direct_map_destroy( manager->caches );
 
@@ -275,8 +329,9 @@ dfb_font_manager_lock( DFBFontManager *manager )
 
      pthread_mutex_lock( &manager->lock );
 
-     // FIXME: remember row stamp here, avoiding destruction of any row used before the unlock,
-     //        might happen with looong string and smaaaall maximum of rows
+     /* Glyphs used from now on are kept until the final unlock. */
+     if (!manager->lock_count++)
+          manager->lock_stamp = manager->stamp;
 
      return DFB_OK;
 }
@@ -287,9 +342,15 @@ dfb_font_manager_unlock( DFBFontManager *manager )
      D_DEBUG_AT( Font_Manager, "%s()\n", __func__ );
 
      DFB_FONT_MANAGER_ASSERT( manager );
+     D_ASSERT( manager->lock_count > 0 );
 
-     // FIXME: destroy LRU row until maximum number of rows is no longer exceeded,
-     //        might happen when rows are preserved due to being used after lock is called
+     /* Give back pages that exceeded the limit while glyphs were in use. */
+     if (!--manager->lock_count) {
+          while (manager->num_rows > manager->max_rows) {
+               if (dfb_font_manager_remove_lru_page( manager ))
+                    break;
+          }
+     }
 
      pthread_mutex_unlock( &manager->lock );
 
@@ -339,70 +400,130 @@ dfb_font_manager_get_cache( DFBFontManager          *manager,
 }
 
 typedef struct {
-     unsigned int     lru_stamp;
-     DFBFontCacheRow *lru_row;
-} FindLruRowContext;
+     unsigned long long  lru_stamp;
+     DFBFontCachePage   *lru_page;
+     unsigned long long  max_stamp;     /* only pages not used since */
+} FindLruPageContext;
 
 static DirectEnumerationResult
-find_lru_row( DirectMap *map,
-              void      *object,
-              void      *ctx )
+find_lru_page( DirectMap *map,
+               void      *object,
+               void      *ctx )
 {
      D_DEBUG_AT( Font_Manager, "%s( object %p )\n", __func__, object );
 
-     FindLruRowContext *context = ctx;
-     DFBFontCache      *cache   = object;
-     DFBFontCacheRow   *row;
+     FindLruPageContext *context = ctx;
+     DFBFontCache       *cache   = object;
+     DFBFontCachePage   *page;
 
      DFB_FONT_CACHE_ASSERT( cache );
 
-     direct_list_foreach (row, cache->rows) {
-          D_DEBUG_AT( Font_Manager, "  -> stamp %llu\n", row->stamp );
+     direct_list_foreach (page, cache->pages) {
+          D_DEBUG_AT( Font_Manager, "  -> stamp %llu\n", page->stamp );
+
+          if (page->stamp >= context->max_stamp)
+               continue;
 
-          if (!context->lru_row || context->lru_stamp > row->stamp) {
-               context->lru_row   = row;
-               context->lru_stamp = row->stamp;
+          if (!context->lru_page || context->lru_stamp > page->stamp) {
+               context->lru_page  = page;
+               context->lru_stamp = page->stamp;
           }
      }
 
      return DENUM_OK;
 }
 
+static DFBFontCachePage *
+font_manager_find_lru_page( DFBFontManager     *manager,
+                            unsigned long long  max_stamp )
+{
+     FindLruPageContext context;
+
+     context.lru_stamp = 0;
+     context.lru_page  = NULL;
+     context.max_stamp = max_stamp;
+
+     direct_map_iterate( manager->caches, find_lru_page, &context );
+
+     return context.lru_page;
+}
+
+static void
+font_manager_destroy_page( DFBFontManager   *manager,
+                           DFBFontCachePage *page )
+{
+     DFBFontCache *cache = page->cache;
+
+     DFB_FONT_CACHE_ASSERT( cache );
+
+     D_DEBUG_AT( Font_Manager, "  -> destroying page %p (stamp %llu)\n", page, page->stamp );
+
+     direct_list_remove( &cache->pages, &page->link );
+
+     dfb_font_cache_page_destroy( page );
+
+     /* Decrease row counter. */
+     D_ASSERT( manager->num_rows >= cache->page_rows );
+
+     manager->num_rows -= cache->page_rows;
+}
+
 DFBResult
-dfb_font_manager_remove_lru_row( DFBFontManager *manager )
+dfb_font_manager_remove_lru_page( DFBFontManager *manager )
 {
      D_DEBUG_AT( Font_Manager, "%s()\n", __func__ );
 
-     FindLruRowContext  context;
-     DFBFontCache      *cache;
+     DFBFontCachePage *page;
 
      DFB_FONT_MANAGER_ASSERT( manager );
 
-     context.lru_stamp = 0;
-     context.lru_row   = NULL;
-
-     direct_map_iterate( manager->caches, find_lru_row, &context );
-
-     if (!context.lru_row) {
-          D_ERROR( "Core/Font: Could not find any row (LRU)!\n" );
+     page = font_manager_find_lru_page( manager, ~0ULL );
+     if (!page) {
+          D_ERROR( "Core/Font: Could not find any page (LRU)!\n" );
           return DFB_ITEMNOTFOUND;
      }
 
-     D_DEBUG_AT( Font_Manager, "  -> row %p (stamp %llu)\n", context.lru_row, context.lru_row->stamp );
+     font_manager_destroy_page( manager, page );
 
-     cache = context.lru_row->cache;
-     DFB_FONT_CACHE_ASSERT( cache );
+     return DFB_OK;
+}
 
-     direct_list_remove( &cache->rows, &context.lru_row->link );
+DFBResult
+dfb_font_manager_get_stats( DFBFontManager      *manager,
+                            DFBFontManagerStats *ret_stats )
+{
+     D_DEBUG_AT( Font_Manager, "%s()\n", __func__ );
 
-     dfb_font_cache_row_destroy( context.lru_row );
+     DFB_FONT_MANAGER_ASSERT( manager );
+     D_ASSERT( ret_stats != NULL );
 
-     /* Decrease row counter. */
-     manager->num_rows--;
+     pthread_mutex_lock( &manager->lock );
+
+     *ret_stats = manager->stats;
+
+     ret_stats->num_rows = manager->num_rows;
+     ret_stats->max_rows = manager->max_rows;
+
+     pthread_mutex_unlock( &manager->lock );
 
      return DFB_OK;
 }
 
+void
+dfb_font_manager_dump_stats( DFBFontManager *manager )
+{
+     DFBFontManagerStats stats;
+
+     D_DEBUG_AT( Font_Manager, "%s()\n", __func__ );
+
+     dfb_font_manager_get_stats( manager, &stats );
+
+     D_INFO( "Core/Font: %u pages (%u/%u rows), %u glyphs filling %llu%%, %llu evictions, %llu compactions\n",
+             stats.num_pages, stats.num_rows, stats.max_rows, stats.num_glyphs,
+             stats.page_pixels ? stats.glyph_pixels * 100 / stats.page_pixels : 0,
+             stats.evictions, stats.compactions );
+}
+
 /**********************************************************************************************************************/
 /**********************************************************************************************************************/
 
@@ -462,15 +583,26 @@ dfb_font_cache_init( DFBFontCache           *cache,
      cache->type    = *type;
 
 
-     cache->row_width = 2048 * type->height / 64;
+     cache->page_width = 2048 * type->height / 64;
+
+     if (cache->page_width > dfb_config->max_font_row_width)
+          cache->page_width = dfb_config->max_font_row_width;
+
+     if (cache->page_width < type->height)
+          cache->page_width = type->height;
+
+     cache->page_width = (cache->page_width + 7) & ~7;
 
-     if (cache->row_width > dfb_config->max_font_row_width)
-          cache->row_width = dfb_config->max_font_row_width;
+     /* A page is made of several rows, but stays within the limits. */
+     cache->page_rows = MAX( dfb_config->font_cache_page_rows, 1 );
 
-     if (cache->row_width < type->height)
-          cache->row_width = type->height;
+     if (cache->page_rows > manager->max_rows)
+          cache->page_rows = manager->max_rows;
 
-     cache->row_width = (cache->row_width + 7) & ~7;
+     while (cache->page_rows > 1 && cache->page_rows * type->height > cache->page_width)
+          cache->page_rows--;
+
+     cache->page_height = cache->page_rows * type->height;
 
 
      D_MAGIC_SET( cache, DFBFontCache );
@@ -481,137 +613,459 @@ dfb_font_cache_init( DFBFontCache           *cache,
 DFBResult
 dfb_font_cache_deinit( DFBFontCache *cache )
 {
-     DFBFontCacheRow *row, *next;
+     DFBFontCachePage *page, *next;
 
      DFB_FONT_CACHE_ASSERT( cache );
 
-     direct_list_foreach_safe (row, next, cache->rows)
-          dfb_font_cache_row_destroy( row );
+     direct_list_foreach_safe (page, next, cache->pages) {
+          dfb_font_cache_page_destroy( page );
+
+          cache->manager->num_rows -= cache->page_rows;
+     }
 
-     cache->rows = NULL;
+     cache->pages = NULL;
 
      D_MAGIC_CLEAR( cache );
 
      return DFB_OK;
 }
 
+/*
+ * Lowest position for the area at the skyline segment, or -1 if it doesn't fit.
+ */
+static int
+page_skyline_fit( const DFBFontCachePage *page,
+                  int                     index,
+                  int                     width,
+                  int                     height )
+{
+     int           y         = 0;
+     int           remaining = width;
+     DFBFontCache *cache     = page->cache;
+
+     if (page->nodes[index].x + width > (int) cache->page_width)
+          return -1;
+
+     while (remaining > 0) {
+          D_ASSERT( index < page->num_nodes );
+
+          if (y < page->nodes[index].y)
+               y = page->nodes[index].y;
+
+          if (y + height > (int) cache->page_height)
+               return -1;
+
+          remaining -= page->nodes[index++].w;
+     }
+
+     return y;
+}
+
+static void
+page_skyline_insert( DFBFontCachePage *page,
+                     int               index,
+                     int               y,
+                     int               width,
+                     int               height )
+{
+     int i;
+     int x = page->nodes[index].x;
+
+     D_ASSERT( page->num_nodes < DFB_FONT_CACHE_PAGE_NODES );
+
+     /* Insert the new top segment... */
+     memmove( &page->nodes[index+1], &page->nodes[index], sizeof(page->nodes[0]) * (page->num_nodes - index) );
+
+     page->nodes[index].x = x;
+     page->nodes[index].y = y + height;
+     page->nodes[index].w = width;
+
+     page->num_nodes++;
+
+     /* ...shrink or remove the segments below... */
+     for (i=index+1; i<page->num_nodes; ) {
+          int shrink = x + width - page->nodes[i].x;
+
+          if (shrink <= 0)
+               break;
+
+          if (shrink < page->nodes[i].w) {
+               page->nodes[i].x += shrink;
+               page->nodes[i].w -= shrink;
+               break;
+          }
+
+          memmove( &page->nodes[i], &page->nodes[i+1], sizeof(page->nodes[0]) * (page->num_nodes - i - 1) );
+
+          page->num_nodes--;
+     }
+
+     /* ...and merge neighbours of the same height. */
+     for (i=0; i<page->num_nodes-1; ) {
+          if (page->nodes[i].y == page->nodes[i+1].y) {
+               page->nodes[i].w += page->nodes[i+1].w;
+
+               memmove( &page->nodes[i+1], &page->nodes[i+2], sizeof(page->nodes[0]) * (page->num_nodes - i - 2) );
+
+               page->num_nodes--;
+          }
+          else
+               i++;
+     }
+}
+
+static void
+page_add_hole( DFBFontCachePage *page,
+               int               x,
+               int               y,
+               int               w,
+               int               h )
+{
+     int          i;
+     DFBRectangle hole = { x, y, w, h };
+
+     if (w < 1 || h < 1)
+          return;
+
+     /* Merge with holes sharing a whole edge. */
+     for (i=0; i<page->num_holes; i++) {
+          DFBRectangle *other = &page->holes[i];
+
+          if (other->y == hole.y && other->h == hole.h &&
+              (other->x + other->w == hole.x || hole.x + hole.w == other->x))
+          {
+               hole.x  = MIN( hole.x, other->x );
+               hole.w += other->w;
+          }
+          else if (other->x == hole.x && other->w == hole.w &&
+                   (other->y + other->h == hole.y || hole.y + hole.h == other->y))
+          {
+               hole.y  = MIN( hole.y, other->y );
+               hole.h += other->h;
+          }
+          else
+               continue;
+
+          page->holes[i] = page->holes[--page->num_holes];
+
+          /* Start over, the grown hole may now share an edge with one checked before. */
+          i = -1;
+     }
+
+     /* Replace the smallest hole if there's no more room. */
+     if (page->num_holes == DFB_FONT_CACHE_PAGE_HOLES) {
+          int smallest = 0;
+
+          for (i=1; i<page->num_holes; i++) {
+               if (page->holes[i].w * page->holes[i].h < page->holes[smallest].w * page->holes[smallest].h)
+                    smallest = i;
+          }
+
+          if (page->holes[smallest].w * page->holes[smallest].h < hole.w * hole.h)
+               page->holes[smallest] = hole;
+
+          return;
+     }
+
+     page->holes[page->num_holes++] = hole;
+}
+
+static void
+page_reset( DFBFontCachePage *page )
+{
+     page->nodes[0].x = 0;
+     page->nodes[0].y = 0;
+     page->nodes[0].w = page->cache->page_width;
+
+     page->num_nodes = 1;
+     page->num_holes = 0;
+}
+
+static bool
+page_alloc( DFBFontCachePage *page,
+            int               width,
+            int               height,
+            DFBPoint         *ret_pos )
+{
+     int i;
+     int best   = -1;
+     int best_y = 0;
+
+     DFB_FONT_CACHE_PAGE_ASSERT( page );
+
+     /* Best fitting hole first... */
+     for (i=0; i<page->num_holes; i++) {
+          const DFBRectangle *hole = &page->holes[i];
+
+          if (hole->w >= width && hole->h >= height &&
+              (best < 0 || hole->w * hole->h < page->holes[best].w * page->holes[best].h))
+               best = i;
+     }
+
+     if (best >= 0) {
+          DFBRectangle hole = page->holes[best];
+
+          page->holes[best] = page->holes[--page->num_holes];
+
+          ret_pos->x = hole.x;
+          ret_pos->y = hole.y;
+
+          /* Give back the remainders. */
+          page_add_hole( page, hole.x + width, hole.y, hole.w - width, height );
+          page_add_hole( page, hole.x, hole.y + height, hole.w, hole.h - height );
+
+          return true;
+     }
+
+     /* ...otherwise bottom left on the skyline. */
+     if (page->num_nodes == DFB_FONT_CACHE_PAGE_NODES)
+          return false;
+
+     for (i=0; i<page->num_nodes; i++) {
+          int y = page_skyline_fit( page, i, width, height );
+
+          if (y >= 0 && (best < 0 || y < best_y || (y == best_y && page->nodes[i].w < page->nodes[best].w))) {
+               best   = i;
+               best_y = y;
+          }
+     }
+
+     if (best < 0)
+          return false;
+
+     ret_pos->x = page->nodes[best].x;
+     ret_pos->y = best_y;
+
+     page_skyline_insert( page, best, best_y, width, height );
+
+     return true;
+}
+
+static void
+page_remove_glyph( DFBFontCachePage *page,
+                   CoreGlyphData    *glyph )
+{
+     DFBFontManager *manager = page->cache->manager;
+
+     direct_list_remove( &page->glyphs, &glyph->link );
+
+     page->glyph_pixels -= glyph->cell.w * glyph->cell.h;
+     page->reused        = true;
+
+     manager->stats.num_glyphs--;
+     manager->stats.glyph_pixels -= glyph->cell.w * glyph->cell.h;
+
+     /* Reset the page if it got empty, otherwise remember the area. */
+     if (page->glyphs)
+          page_add_hole( page, glyph->start, glyph->start_y, glyph->cell.w, glyph->cell.h );
+     else
+          page_reset( page );
+}
+
+static void
+page_evict_glyph( DFBFontCachePage *page,
+                  CoreGlyphData    *glyph )
+{
+     CoreFont *font = glyph->font;
+
+     D_MAGIC_ASSERT( glyph, CoreGlyphData );
+     D_ASSERT( glyph->layer < D_ARRAY_SIZE(font->layers) );
+
+     D_DEBUG_AT( Font_CachePage, "  -> evicting glyph %u (stamp %llu)\n", glyph->index, glyph->stamp );
+
+     page_remove_glyph( page, glyph );
+
+     direct_hash_remove( font->layers[glyph->layer].glyph_hash, glyph->index );
+
+     /* Invalidate cached text runs. */
+     font->generation++;
+
+     if (glyph->index < 128)
+          font->layers[glyph->layer].glyph_data[glyph->index] = NULL;
+
+     D_MAGIC_CLEAR( glyph );
+     D_FREE( glyph );
+}
+
+/*
+ * Evicts glyphs of the page not used since locking the manager, oldest first, until the area fits.
+ */
+static bool
+page_evict( DFBFontCachePage *page,
+            int               width,
+            int               height,
+            DFBPoint         *ret_pos )
+{
+     DFBFontManager *manager = page->cache->manager;
+
+     while (page->glyphs) {
+          CoreGlyphData *glyph = (CoreGlyphData*) page->glyphs;
+
+          if (glyph->stamp >= manager->lock_stamp)
+               return false;
+
+          page_evict_glyph( page, glyph );
+
+          manager->stats.evictions++;
+
+          if (!page->glyphs)
+               manager->stats.compactions++;
+
+          if (page_alloc( page, width, height, ret_pos ))
+               return true;
+     }
+
+     return page_alloc( page, width, height, ret_pos );
+}
+
 DFBResult
-dfb_font_cache_get_row( DFBFontCache     *cache,
-                        unsigned int      width,
-                        DFBFontCacheRow **ret_row )
+dfb_font_cache_alloc( DFBFontCache      *cache,
+                      unsigned int       width,
+                      unsigned int       height,
+                      DFBFontCachePage **ret_page,
+                      DFBPoint          *ret_pos )
 {
-     DFBResult        ret;
-     DFBFontManager  *manager;
-     DFBFontCacheRow *row;
-     DFBFontCacheRow *best_row = NULL;
-     unsigned int     best_val = 0;
+     DFBResult         ret;
+     DFBFontManager   *manager;
+     DFBFontCachePage *page;
 
      DFB_FONT_CACHE_ASSERT( cache );
-     D_ASSERT( ret_row != NULL );
+     D_ASSERT( width > 0 );
+     D_ASSERT( height > 0 );
+     D_ASSERT( ret_page != NULL );
+     D_ASSERT( ret_pos != NULL );
 
      manager = cache->manager;
      DFB_FONT_MANAGER_ASSERT( manager );
 
-     /* Try freshest row first. */
-     row = (DFBFontCacheRow*) cache->rows;
-     if (row && row->next_x + width <= cache->row_width) {
-          *ret_row = row;
+     if (width > cache->page_width || height > cache->page_height)
+          return DFB_LIMITEXCEEDED;
 
-          return DFB_OK;
-     }
+     /* Try the freshest pages first. */
+     direct_list_foreach (page, cache->pages) {
+          if (page_alloc( page, width, height, ret_pos )) {
+               *ret_page = page;
 
-     /* Check for trailing space in each row. */
-     direct_list_foreach (row, cache->rows) {
-          DFB_FONT_CACHE_ROW_ASSERT( row );
-
-          /* If glyph fits... */
-          if (row->next_x + width <= cache->row_width) {
-               /* ...and no row yet or this row fits better... */
-               if (!best_row || best_val < row->next_x) {
-                    /* ...remember row */
-                    best_row = row;
-                    best_val = row->next_x;
-               }
+               return DFB_OK;
           }
      }
 
-     if (best_row) {
-          *ret_row = best_row;
+     /* Make room by evicting the least recently used glyphs. */
+     while (manager->num_rows + cache->page_rows > manager->max_rows) {
+          page = font_manager_find_lru_page( manager, manager->lock_stamp );
+          if (!page)
+               break;
 
-          return DFB_OK;
-     }
+          if (page->cache != cache) {
+               manager->stats.evictions += direct_list_count_elements_EXPENSIVE( page->glyphs );
 
+               font_manager_destroy_page( manager, page );
+               continue;
+          }
 
-     /*
-      * Need a new cache row
-      */
+          if (page_evict( page, width, height, ret_pos )) {
+               D_DEBUG_AT( Font_Cache, "  -> reusing page %p\n", page );
 
-     /* Maximum number of rows reached? */
-     if (manager->num_rows == manager->max_rows) {
-          /* Remove the least recently used row. */
-          ret = dfb_font_manager_remove_lru_row( manager );
-          if (ret)
-               return ret;
+               *ret_page = page;
+
+               return DFB_OK;
+          }
      }
 
-     D_ASSERT( manager->num_rows < manager->max_rows );
+     /* All glyphs in use? Exceeding the limit until the manager is unlocked. */
+     if (manager->num_rows + cache->page_rows > manager->max_rows)
+          D_DEBUG_AT( Font_Cache, "  -> exceeding maximum of %u rows\n", manager->max_rows );
 
-     /* Create another row. */
-     ret = dfb_font_cache_row_create( cache, &row );
+     /* Create another page. */
+     ret = dfb_font_cache_page_create( cache, &page );
      if (ret)
           return ret;
 
      /* Prepend to list (freshest is first). */
-     direct_list_prepend( &cache->rows, &row->link );
+     direct_list_prepend( &cache->pages, &page->link );
 
      /* Increase row counter in manager. */
-     manager->num_rows++;
+     manager->num_rows += cache->page_rows;
+
+     if (!page_alloc( page, width, height, ret_pos )) {
+          D_BUG( "%ux%u does not fit into empty %ux%u page", width, height, cache->page_width, cache->page_height );
+          return DFB_BUG;
+     }
 
-     *ret_row = row;
+     *ret_page = page;
 
      return DFB_OK;
 }
 
+void
+dfb_font_cache_page_add_glyph( DFBFontCachePage *page,
+                               CoreGlyphData    *glyph )
+{
+     DFBFontManager *manager;
+
+     DFB_FONT_CACHE_PAGE_ASSERT( page );
+     D_MAGIC_ASSERT( glyph, CoreGlyphData );
+
+     manager = page->cache->manager;
+
+     direct_list_append( &page->glyphs, &glyph->link );
+
+     page->glyph_pixels += glyph->cell.w * glyph->cell.h;
+
+     manager->stats.num_glyphs++;
+     manager->stats.glyph_pixels += glyph->cell.w * glyph->cell.h;
+}
+
+void
+dfb_font_cache_page_remove_glyph( DFBFontCachePage *page,
+                                  CoreGlyphData    *glyph )
+{
+     DFB_FONT_CACHE_PAGE_ASSERT( page );
+     D_MAGIC_ASSERT( glyph, CoreGlyphData );
+
+     page_remove_glyph( page, glyph );
+}
+
 /**********************************************************************************************************************/
 /**********************************************************************************************************************/
 
 DFBResult
-dfb_font_cache_row_create( DFBFontCache     *cache,
-                           DFBFontCacheRow **ret_row )
+dfb_font_cache_page_create( DFBFontCache      *cache,
+                            DFBFontCachePage **ret_page )
 {
-     DFBResult        ret;
-     DFBFontCacheRow *row;
+     DFBResult         ret;
+     DFBFontCachePage *page;
 
-     row = D_CALLOC( 1, sizeof(DFBFontCacheRow) );
-     if (!row)
+     page = D_CALLOC( 1, sizeof(DFBFontCachePage) );
+     if (!page)
           return D_OOM();
 
-     ret = dfb_font_cache_row_init( row, cache );
+     ret = dfb_font_cache_page_init( page, cache );
      if (ret) {
-          D_FREE( row );
+          D_FREE( page );
           return ret;
      }
 
-     *ret_row = row;
+     *ret_page = page;
 
      return DFB_OK;
 }
 
 DFBResult
-dfb_font_cache_row_destroy( DFBFontCacheRow *row )
+dfb_font_cache_page_destroy( DFBFontCachePage *page )
 {
-     DFB_FONT_CACHE_ROW_ASSERT( row );
+     DFB_FONT_CACHE_PAGE_ASSERT( page );
 
-     dfb_font_cache_row_deinit( row );
+     dfb_font_cache_page_deinit( page );
 
-     D_FREE( row );
+     D_FREE( page );
 
      return DFB_OK;
 }
 
 DFBResult
-dfb_font_cache_row_init( DFBFontCacheRow *row,
-                         DFBFontCache    *cache )
+dfb_font_cache_page_init( DFBFontCachePage *page,
+                          DFBFontCache     *cache )
 {
      DFBResult       ret;
      DFBFontManager *manager;
@@ -621,59 +1075,61 @@ dfb_font_cache_row_init( DFBFontCacheRow *row,
      manager = cache->manager;
      DFB_FONT_MANAGER_ASSERT( manager );
 
-     row->cache = cache;
+     page->cache = cache;
 
      /* Create a new font surface. */
      ret = dfb_surface_create_simple( manager->core,
-                                      cache->row_width,
-                                      cache->type.height,
+                                      cache->page_width,
+                                      cache->page_height,
                                       cache->type.pixel_format, DFB_COLORSPACE_DEFAULT(cache->type.pixel_format),
                                       cache->type.surface_caps,
                                       CSTF_FONT,
                                       dfb_config->font_resource_id,
-                                      NULL, &row->surface );
+                                      NULL, &page->surface );
      if (ret) {
           D_DERROR( ret, "Core/Font: Could not create font surface!\n" );
           return ret;
      }
 
-     D_DEBUG_AT( Core_FontSurfaces, "  -> new row %d - %dx%d %s\n", manager->num_rows,
-                 row->surface->config.size.w, row->surface->config.size.h,
-                 dfb_pixelformat_name(row->surface->config.format) );
+     D_DEBUG_AT( Core_FontSurfaces, "  -> new page %d - %dx%d %s\n", manager->stats.num_pages,
+                 page->surface->config.size.w, page->surface->config.size.h,
+                 dfb_pixelformat_name(page->surface->config.format) );
+
+     page_reset( page );
 
-     D_MAGIC_SET( row, DFBFontCacheRow );
+     page->stamp = manager->stamp++;
+
+     manager->stats.num_pages++;
+     manager->stats.page_pixels += cache->page_width * cache->page_height;
+
+     D_MAGIC_SET( page, DFBFontCachePage );
 
      return DFB_OK;
 }
 
 DFBResult
-dfb_font_cache_row_deinit( DFBFontCacheRow *row )
+dfb_font_cache_page_deinit( DFBFontCachePage *page )
 {
-     CoreGlyphData *glyph, *next;
-
-     DFB_FONT_CACHE_ROW_ASSERT( row );
+     CoreGlyphData  *glyph, *next;
+     DFBFontCache   *cache;
+     DFBFontManager *manager;
 
-     /* Kick out all glyphs. */
-     direct_list_foreach_safe (glyph, next, row->glyphs) {
-          CoreFont *font = glyph->font;
+     DFB_FONT_CACHE_PAGE_ASSERT( page );
 
-          D_MAGIC_ASSERT( glyph, CoreGlyphData );
-          D_ASSERT( glyph->layer < D_ARRAY_SIZE(font->layers) );
+     cache   = page->cache;
+     manager = cache->manager;
 
-          /*ret =*/ direct_hash_remove( font->layers[glyph->layer].glyph_hash, glyph->index );
-          //FIXME: use D_ASSERT( ret == DFB_OK );
+     /* Kick out all glyphs. */
+     direct_list_foreach_safe (glyph, next, page->glyphs)
+          page_evict_glyph( page, glyph );
 
-          if (glyph->index < 128)
-               font->layers[glyph->layer].glyph_data[glyph->index] = NULL;
 
-          D_MAGIC_CLEAR( glyph );
-          D_FREE( glyph );
-     }
+     dfb_surface_unref( page->surface );
 
+     manager->stats.num_pages--;
+     manager->stats.page_pixels -= cache->page_width * cache->page_height;
 
-     dfb_surface_unref( row->surface );
-
-     D_MAGIC_CLEAR( row );
+     D_MAGIC_CLEAR( page );
 
      return DFB_OK;
 }
@@ -748,6 +1204,8 @@ dfb_font_destroy( CoreFont *font )
 
      D_MAGIC_ASSERT( font, CoreFont );
 
+     dfb_font_prerender_cancel( font );
+
      dfb_font_dispose( font );
 
      for (i=0; i<DFB_FONT_MAX_LAYERS; i++)
@@ -788,12 +1246,16 @@ dfb_font_dispose( CoreFont *font )
 
      dfb_font_manager_lock( font->manager );
 
+     free_text_runs( font );
+
      for (i=0; i<DFB_FONT_MAX_LAYERS; i++) {
           direct_hash_iterate( font->layers[i].glyph_hash, free_glyphs, NULL );
 
           memset( font->layers[i].glyph_data, 0, sizeof(font->layers[i].glyph_data) );
      }
 
+     font->generation++;
+
      dfb_font_manager_unlock( font->manager );
 
      return DFB_OK;
@@ -801,18 +1263,36 @@ dfb_font_dispose( CoreFont *font )
 
 /**********************************************************************************************************************/
 
+static inline void
+glyph_touch( DFBFontManager *manager,
+             CoreGlyphData  *data )
+{
+     DFBFontCachePage *page = data->page;
+
+     if (page) {
+          data->stamp = page->stamp = manager->stamp++;
+
+          /* Keep the glyphs of the page in LRU order. */
+          if (data->link.next) {
+               direct_list_remove( &page->glyphs, &data->link );
+               direct_list_append( &page->glyphs, &data->link );
+          }
+     }
+}
+
 DFBResult
 dfb_font_get_glyph_data( CoreFont       *font,
                          unsigned int    index,
                          unsigned int    layer,
                          CoreGlyphData **ret_data )
 {
-     DFBResult        ret;
-     CoreGlyphData   *data;
-     int              align;
-     DFBFontManager  *manager;
-     DFBFontCache    *cache;
-     DFBFontCacheRow *row = NULL;
+     DFBResult         ret;
+     CoreGlyphData    *data;
+     int               align;
+     DFBPoint          pos;
+     DFBFontManager   *manager;
+     DFBFontCache     *cache;
+     DFBFontCachePage *page = NULL;
 
      D_DEBUG_AT( Core_Font, "%s( index %u, layer %u )\n", __FUNCTION__, index, layer );
 
@@ -830,7 +1310,9 @@ dfb_font_get_glyph_data( CoreFont       *font,
           if (data->retry)
                goto retry;
 
-          *ret_data = font->layers[layer].glyph_data[index];
+          glyph_touch( manager, data );
+
+          *ret_data = data;
           return DFB_OK;
      }
 
@@ -841,16 +1323,11 @@ dfb_font_get_glyph_data( CoreFont       *font,
 
           D_DEBUG_AT( Core_Font, "  -> already in cache (%p)\n", data );
 
-          row = data->row;
-          if (row) {
-               DFB_FONT_CACHE_ROW_ASSERT( row );
-
-               row->stamp = manager->row_stamp++;
-          }
-
           if (data->retry)
                goto retry;
 
+          glyph_touch( manager, data );
+
           *ret_data = data;
           return DFB_OK;
      }
@@ -877,11 +1354,19 @@ dfb_font_get_glyph_data( CoreFont       *font,
 retry:
      data->retry = false;
 
+     /* Release the area of a previous attempt. */
+     if (data->page) {
+          dfb_font_cache_page_remove_glyph( data->page, data );
+
+          data->page    = NULL;
+          data->surface = NULL;
+     }
+
      /* Get glyph data from font implementation */
      ret = font->GetGlyphData( font, index, data );
      if (ret) {
           D_DERROR( ret, "Core/Font: Could not get glyph info for index %d!\n", index );
-          data->start = data->width = data->height = 0;
+          data->start = data->start_y = data->width = data->height = 0;
 
           /* If the font module returned BUFFEREMPTY we will retry loading next time */
           if (ret == DFB_BUFFEREMPTY)
@@ -897,7 +1382,7 @@ retry:
 
      if (data->width < 1 || data->height < 1) {
           D_DEBUG_AT( Core_Font, "  -> zero size glyph bitmap!\n" );
-          data->start = data->width = data->height = 0;
+          data->start = data->start_y = data->width = data->height = 0;
           goto out;
      }
 
@@ -918,36 +1403,54 @@ retry:
           goto error;
      }
 
-     /* Check for a cache row (surface) to use */
-     ret = dfb_font_cache_get_row( cache, data->width, &row );
+     /* Keep glyphs aligned for the renderer. */
+     align = (8 / (DFB_BYTES_PER_PIXEL( font->pixel_format ) ? : 1)) *
+                  (DFB_PIXELFORMAT_ALIGNMENT( font->pixel_format ) + 1) - 1;
+
+     data->cell.w = (data->width + align) & ~align;
+     data->cell.h = data->height;
+
+     /* Find a place in one of the cache pages (surfaces) */
+     ret = dfb_font_cache_alloc( cache, data->cell.w, data->cell.h, &page, &pos );
      if (ret) {
-          D_DEBUG_AT( Core_Font, "  -> could not get row from cache!\n" );
+          D_DEBUG_AT( Core_Font, "  -> could not allocate %dx%d in cache!\n", data->cell.w, data->cell.h );
           goto error;
      }
 
      /*
-      * Add the glyph to the cache row
+      * Add the glyph to the cache page
       */
 
-     D_DEBUG_AT( Core_FontSurfaces, "  -> render %2d - %2dx%2d at %03d font <%p>\n",
-                 index, data->width, data->height, row->next_x, font );
+     D_DEBUG_AT( Core_FontSurfaces, "  -> render %2d - %2dx%2d at %03d,%03d font <%p>\n",
+                 index, data->width, data->height, pos.x, pos.y, font );
 
-     data->row     = row;
-     data->start   = row->next_x;
-     data->surface = row->surface;
+     data->page    = page;
+     data->start   = pos.x;
+     data->start_y = pos.y;
+     data->surface = page->surface;
 
-     align = (8 / (DFB_BYTES_PER_PIXEL( font->pixel_format ) ? : 1)) *
-                  (DFB_PIXELFORMAT_ALIGNMENT( font->pixel_format ) + 1) - 1;
+     dfb_font_cache_page_add_glyph( page, data );
 
-     row->next_x  += (data->width + align) & ~align;
+     glyph_touch( manager, data );
 
-     row->stamp = manager->row_stamp++;
+     /* Get operations drawing evicted glyphs going before the CPU writes into their cells, like IDirectFBSurface::Lock(). */
+     if (page->reused) {
+          CoreGraphicsStateClient_FlushCurrent( 0, CGSCFF_NONE );
+
+          page->reused = false;
+     }
 
      /* Render the glyph data into the surface. */
      ret = font->RenderGlyph( font, index, data );
      if (ret) {
           D_DEBUG_AT( Core_Font, "  -> rendering glyph failed!\n" );
-          data->start = data->width = data->height = 0;
+
+          /* Give back the cell while its position is still known. */
+          dfb_font_cache_page_remove_glyph( page, data );
+
+          data->page    = NULL;
+          data->surface = NULL;
+          data->start   = data->start_y = data->width = data->height = 0;
 
           /* If the font module returned BUFFEREMPTY we will retry loading next time */
           if (ret == DFB_BUFFEREMPTY)
@@ -964,9 +1467,6 @@ retry:
 
 out:
      if (!data->inserted) {
-          if (row)
-               direct_list_append( &row->glyphs, &data->link );
-
           direct_hash_insert( font->layers[layer].glyph_hash, index, data );
 
           if (index < 128)
@@ -981,6 +1481,13 @@ out:
 
 
 error:
+     if (data->inserted) {
+          direct_hash_remove( font->layers[layer].glyph_hash, index );
+
+          if (index < 128)
+               font->layers[layer].glyph_data[index] = NULL;
+     }
+
      D_MAGIC_CLEAR( data );
      D_FREE( data );
 
@@ -989,6 +1496,454 @@ error:
 
 /**********************************************************************************************************************/
 
+static unsigned int
+text_run_hash( DFBTextEncodingID  encoding,
+               const u8          *text,
+               int                bytes,
+               unsigned int       layers )
+{
+     int          i;
+     unsigned int hash = 2166136261u ^ (encoding << 8) ^ layers;
+
+     for (i=0; i<bytes; i++)
+          hash = (hash ^ text[i]) * 16777619u;
+
+     return hash;
+}
+
+static void
+text_run_destroy( CoreFont        *font,
+                  CoreFontTextRun *run )
+{
+     D_MAGIC_ASSERT( run, CoreFontTextRun );
+
+     direct_list_remove( &font->runs, &run->link );
+
+     D_ASSERT( font->num_runs > 0 );
+
+     font->num_runs--;
+
+     D_MAGIC_CLEAR( run );
+     D_FREE( run );
+}
+
+static void
+free_text_runs( CoreFont *font )
+{
+     CoreFontTextRun *run, *next;
+
+     direct_list_foreach_safe (run, next, font->runs)
+          text_run_destroy( font, run );
+
+     D_ASSERT( font->num_runs == 0 );
+}
+
+/*
+ * Decodes the string and positions the visible glyphs of each layer like dfb_gfxcard_drawstring() would.
+ */
+static DFBResult
+text_run_layout( CoreFont        *font,
+                 CoreFontTextRun *run )
+{
+     DFBResult    ret;
+     unsigned int indices[run->bytes];
+     int          i, l, num;
+
+     ret = dfb_font_decode_text( font, run->encoding, run->text, run->bytes, indices, &num );
+     if (ret)
+          return ret;
+
+     for (l=0; l<run->layers; l++) {
+          int          x    = 0;
+          int          y    = 0;
+          unsigned int prev = 0;
+
+          run->layer[l].num = 0;
+
+          for (i=0; i<num; i++) {
+               CoreGlyphData *glyph;
+               int            kern_x;
+               int            kern_y;
+               unsigned int   current = indices[i];
+
+               ret = dfb_font_get_glyph_data( font, current, l, &glyph );
+               if (ret) {
+                    prev = current;
+                    continue;
+               }
+
+               /* Glyphs to be loaded again next time would make the run stale. */
+               if (glyph->retry)
+                    return DFB_BUFFEREMPTY;
+
+               if (prev && font->GetKerning && font->GetKerning( font, prev, current, &kern_x, &kern_y) == DFB_OK) {
+                    x += kern_x << 8;
+                    y += kern_y << 8;
+               }
+
+               if (glyph->width) {
+                    int n = run->layer[l].num++;
+
+                    run->layer[l].glyphs[n] = glyph;
+                    run->layer[l].points[n] = (DFBPoint){ (x >> 8) + glyph->left, (y >> 8) + glyph->top };
+               }
+
+               x   += glyph->xadvance;
+               y   += glyph->yadvance;
+               prev = current;
+          }
+     }
+
+     /* Glyphs looked up since locking are not evicted, so the run is valid as of now. */
+     run->generation = font->generation;
+
+     return DFB_OK;
+}
+
+DFBResult
+dfb_font_get_text_run( CoreFont           *font,
+                       DFBTextEncodingID   encoding,
+                       const void         *text,
+                       int                 bytes,
+                       unsigned int        layers,
+                       CoreFontTextRun   **ret_run )
+{
+     DFBResult        ret;
+     int              i, l;
+     unsigned int     hash;
+     CoreFontTextRun *run;
+     DFBFontManager  *manager;
+
+     D_DEBUG_AT( Core_Font, "%s( %p [%d], layers %u )\n", __FUNCTION__, text, bytes, layers );
+
+     D_MAGIC_ASSERT( font, CoreFont );
+     D_ASSERT( text != NULL );
+     D_ASSERT( bytes > 0 );
+     D_ASSERT( layers > 0 && layers <= DFB_FONT_MAX_LAYERS );
+     D_ASSERT( ret_run != NULL );
+
+     manager = font->manager;
+     DFB_FONT_MANAGER_ASSERT( manager );
+
+     if (dfb_config->font_run_cache < 1 || bytes > DFB_FONT_TEXT_RUN_MAX_BYTES)
+          return DFB_UNSUPPORTED;
+
+     hash = text_run_hash( encoding, text, bytes, layers );
+
+     direct_list_foreach (run, font->runs) {
+          D_MAGIC_ASSERT( run, CoreFontTextRun );
+
+          if (run->hash == hash && run->bytes == bytes && run->encoding == encoding &&
+              run->layers == layers && !memcmp( run->text, text, bytes ))
+               break;
+     }
+
+     if (run) {
+          /* Most recently used first. */
+          direct_list_remove( &font->runs, &run->link );
+          direct_list_prepend( &font->runs, &run->link );
+
+          if (run->generation == font->generation) {
+               D_DEBUG_AT( Core_Font, "  -> cached run %p\n", run );
+
+               /* Keep the glyphs from being evicted as long as the run is used. */
+               for (l=0; l<layers; l++) {
+                    for (i=0; i<run->layer[l].num; i++)
+                         glyph_touch( manager, run->layer[l].glyphs[i] );
+               }
+
+               *ret_run = run;
+
+               return DFB_OK;
+          }
+
+          D_DEBUG_AT( Core_Font, "  -> stale run %p, laying out again\n", run );
+     }
+     else {
+          u8 *ptr;
+
+          /* Drop the least recently used run. */
+          if (font->num_runs >= dfb_config->font_run_cache)
+               text_run_destroy( font, (CoreFontTextRun*) font->runs->prev );
+
+          /* The text and one glyph pointer and position per byte and layer follow the run. */
+          run = D_CALLOC( 1, sizeof(CoreFontTextRun) +
+                             layers * bytes * (sizeof(CoreGlyphData*) + sizeof(DFBPoint)) + bytes );
+          if (!run)
+               return D_OOM();
+
+          ptr = (u8*) (run + 1);
+
+          for (l=0; l<layers; l++) {
+               run->layer[l].glyphs = (CoreGlyphData**) ptr;
+               ptr += bytes * sizeof(CoreGlyphData*);
+
+               run->layer[l].points = (DFBPoint*) ptr;
+               ptr += bytes * sizeof(DFBPoint);
+          }
+
+          run->hash     = hash;
+          run->encoding = encoding;
+          run->layers   = layers;
+          run->bytes    = bytes;
+          run->text     = ptr;
+
+          direct_memcpy( run->text, text, bytes );
+
+          D_MAGIC_SET( run, CoreFontTextRun );
+
+          direct_list_prepend( &font->runs, &run->link );
+
+          font->num_runs++;
+     }
+
+     ret = text_run_layout( font, run );
+     if (ret) {
+          text_run_destroy( font, run );
+          return ret;
+     }
+
+     D_DEBUG_AT( Core_Font, "  -> laid out run %p (%d glyphs)\n", run, run->layer[0].num );
+
+     *ret_run = run;
+
+     return DFB_OK;
+}
+
+/**********************************************************************************************************************/
+
+#define DFB_FONT_PRERENDER_CHUNK  8     /* glyphs rendered per locking of the manager */
+
+typedef struct {
+     DirectLink          link;
+
+     int                 magic;
+
+     CoreFont           *font;
+     unsigned int        layers;
+     bool                cancelled;
+
+     int                 num;
+     int                 pos;           /* next index to be rendered */
+     unsigned int       *indices;
+} CoreFontPrerenderJob;
+
+static void
+prerender_job_destroy( CoreFontPrerenderJob *job )
+{
+     D_MAGIC_ASSERT( job, CoreFontPrerenderJob );
+
+     D_MAGIC_CLEAR( job );
+     D_FREE( job );
+}
+
+/*
+ * Renders glyphs of the queued jobs in small chunks, so drawing threads only wait for a few glyphs at most.
+ */
+static void *
+prerender_thread( DirectThread *thread,
+                  void         *arg )
+{
+     DFBFontManager *manager = arg;
+
+     D_DEBUG_AT( Font_Manager, "%s()\n", __func__ );
+
+     direct_mutex_lock( &manager->prerender_lock );
+
+     while (!manager->prerender_stop) {
+          int                   i, l, end;
+          CoreFontPrerenderJob *job = (CoreFontPrerenderJob*) manager->prerender_jobs;
+
+          if (!job) {
+               direct_waitqueue_wait( &manager->prerender_wq, &manager->prerender_lock );
+               continue;
+          }
+
+          D_MAGIC_ASSERT( job, CoreFontPrerenderJob );
+
+          manager->prerender_job = job;
+
+          direct_mutex_unlock( &manager->prerender_lock );
+
+
+          end = MIN( job->pos + DFB_FONT_PRERENDER_CHUNK, job->num );
+
+          dfb_font_manager_lock( manager );
+
+          for (i=job->pos; i<end; i++) {
+               for (l=0; l<job->layers; l++) {
+                    CoreGlyphData *glyph;
+
+                    dfb_font_get_glyph_data( job->font, job->indices[i], l, &glyph );
+               }
+          }
+
+          dfb_font_manager_unlock( manager );
+
+          job->pos = end;
+
+
+          direct_mutex_lock( &manager->prerender_lock );
+
+          manager->prerender_job = NULL;
+
+          if (job->cancelled || job->pos == job->num) {
+               D_DEBUG_AT( Font_Manager, "  -> %s job %p (%d glyphs)\n",
+                           job->cancelled ? "cancelled" : "finished", job, job->num );
+
+               direct_list_remove( &manager->prerender_jobs, &job->link );
+
+               prerender_job_destroy( job );
+          }
+
+          /* Wake up cancellation. */
+          direct_waitqueue_broadcast( &manager->prerender_wq );
+     }
+
+     direct_mutex_unlock( &manager->prerender_lock );
+
+     return NULL;
+}
+
+static void
+font_manager_stop_prerender( DFBFontManager *manager )
+{
+     CoreFontPrerenderJob *job, *next;
+
+     if (manager->prerender_thread) {
+          direct_mutex_lock( &manager->prerender_lock );
+
+          manager->prerender_stop = true;
+
+          direct_waitqueue_broadcast( &manager->prerender_wq );
+
+          direct_mutex_unlock( &manager->prerender_lock );
+
+
+          direct_thread_join( manager->prerender_thread );
+          direct_thread_destroy( manager->prerender_thread );
+
+          manager->prerender_thread = NULL;
+     }
+
+     direct_list_foreach_safe (job, next, manager->prerender_jobs)
+          prerender_job_destroy( job );
+
+     manager->prerender_jobs = NULL;
+}
+
+DFBResult
+dfb_font_prerender( CoreFont           *font,
+                    const unsigned int *indices,
+                    int                 num,
+                    unsigned int        layers,
+                    bool                async )
+{
+     int                   i, l;
+     DFBFontManager       *manager;
+     CoreFontPrerenderJob *job;
+
+     D_DEBUG_AT( Core_Font, "%s( %d glyphs, layers %u%s )\n", __FUNCTION__, num, layers, async ? ", async" : "" );
+
+     D_MAGIC_ASSERT( font, CoreFont );
+     D_ASSERT( indices != NULL || num == 0 );
+     D_ASSERT( layers > 0 && layers <= DFB_FONT_MAX_LAYERS );
+
+     manager = font->manager;
+     DFB_FONT_MANAGER_ASSERT( manager );
+
+     if (num < 1)
+          return DFB_OK;
+
+     if (!async) {
+          dfb_font_manager_lock( manager );
+
+          for (i=0; i<num; i++) {
+               for (l=0; l<layers; l++) {
+                    CoreGlyphData *glyph;
+
+                    dfb_font_get_glyph_data( font, indices[i], l, &glyph );
+               }
+          }
+
+          dfb_font_manager_unlock( manager );
+
+          return DFB_OK;
+     }
+
+     job = D_CALLOC( 1, sizeof(CoreFontPrerenderJob) + num * sizeof(unsigned int) );
+     if (!job)
+          return D_OOM();
+
+     job->font    = font;
+     job->layers  = layers;
+     job->num     = num;
+     job->indices = (unsigned int*) (job + 1);
+
+     direct_memcpy( job->indices, indices, num * sizeof(unsigned int) );
+
+     D_MAGIC_SET( job, CoreFontPrerenderJob );
+
+     direct_mutex_lock( &manager->prerender_lock );
+
+     if (!manager->prerender_thread) {
+          manager->prerender_thread = direct_thread_create( DTT_DEFAULT, prerender_thread, manager, "Font Prerender" );
+          if (!manager->prerender_thread) {
+               direct_mutex_unlock( &manager->prerender_lock );
+               prerender_job_destroy( job );
+               return DFB_INIT;
+          }
+     }
+
+     direct_list_append( &manager->prerender_jobs, &job->link );
+
+     direct_waitqueue_broadcast( &manager->prerender_wq );
+
+     direct_mutex_unlock( &manager->prerender_lock );
+
+     return DFB_OK;
+}
+
+void
+dfb_font_prerender_cancel( CoreFont *font )
+{
+     DFBFontManager       *manager;
+     CoreFontPrerenderJob *job, *next;
+
+     D_DEBUG_AT( Core_Font, "%s()\n", __FUNCTION__ );
+
+     D_MAGIC_ASSERT( font, CoreFont );
+
+     manager = font->manager;
+     DFB_FONT_MANAGER_ASSERT( manager );
+
+     direct_mutex_lock( &manager->prerender_lock );
+
+     direct_list_foreach_safe (job, next, manager->prerender_jobs) {
+          D_MAGIC_ASSERT( job, CoreFontPrerenderJob );
+
+          if (job->font != font)
+               continue;
+
+          /* The thread removes the job it's working on. */
+          if (job == manager->prerender_job) {
+               job->cancelled = true;
+               continue;
+          }
+
+          direct_list_remove( &manager->prerender_jobs, &job->link );
+
+          prerender_job_destroy( job );
+     }
+
+     while (manager->prerender_job && ((CoreFontPrerenderJob*) manager->prerender_job)->font == font)
+          direct_waitqueue_wait( &manager->prerender_wq, &manager->prerender_lock );
+
+     direct_mutex_unlock( &manager->prerender_lock );
+}
+
+/**********************************************************************************************************************/
+
 DFBResult
 dfb_font_register_encoding( CoreFont                    *font,
                             const char                  *name,
@@ -1166,8 +2121,8 @@ free_glyphs( DirectHash    *hash,
 {
      D_DEBUG_AT( Core_Font, "%s( %lu )\n", __FUNCTION__, key );
 
-     CoreGlyphData   *data = value;
-     DFBFontCacheRow *row;
+     CoreGlyphData    *data = value;
+     DFBFontCachePage *page;
 
      D_MAGIC_ASSERT( data, CoreGlyphData );
 
@@ -1177,32 +2132,14 @@ free_glyphs( DirectHash    *hash,
      direct_hash_remove( hash, key );
 
 
-     row = data->row;
-     if (row) {
-          DFB_FONT_CACHE_ROW_ASSERT( row );
-
-          /* Remove glyph from cache row. */
-          direct_list_remove( &row->glyphs, &data->link );
+     page = data->page;
+     if (page) {
+          /* Remove glyph from cache page. */
+          dfb_font_cache_page_remove_glyph( page, data );
 
-          /* If cache row got empty, destroy it. */
-          if (!row->glyphs) {
-               DFBFontManager *manager;
-               DFBFontCache   *cache = row->cache;
-
-               DFB_FONT_CACHE_ASSERT( cache );
-
-               manager = cache->manager;
-               DFB_FONT_MANAGER_ASSERT( manager );
-
-               /* Remove row from cache. */
-               direct_list_remove( &cache->rows, &row->link );
-
-               /* Destroy row. */
-               dfb_font_cache_row_destroy( row );
-
-               /* Decrease row counter in manager. */
-               manager->num_rows--;
-          }
+          /* If cache page got empty, destroy it. */
+          if (!page->glyphs)
+               font_manager_destroy_page( page->cache->manager, page );
      }
 
 
@@ -1212,4 +2149,3 @@ free_glyphs( DirectHash    *hash,
 
      return true;
 }
-
@@ -51,6 +51,17 @@ typedef struct {
      DFBSurfaceCapabilities   surface_caps;
 } DFBFontCacheType;
 
+typedef struct {
+     unsigned int             num_rows;       /* rows in use, each page counts as several rows */
+     unsigned int             max_rows;
+     unsigned int             num_pages;
+     unsigned int             num_glyphs;
+     unsigned long long       page_pixels;    /* area of all pages */
+     unsigned long long       glyph_pixels;   /* area used by cached glyphs, i.e. fill ratio is glyph/page pixels */
+     unsigned long long       evictions;      /* glyphs evicted to make room for others */
+     unsigned long long       compactions;    /* pages emptied by evictions and reused as a whole */
+} DFBFontManagerStats;
+
 
 DFBResult dfb_font_manager_create        ( CoreDFB                 *core,
                                            DFBFontManager         **ret_manager );
@@ -66,7 +77,13 @@ DFBResult dfb_font_manager_get_cache     ( DFBFontManager          *manager,
                                            const DFBFontCacheType  *type,
                                            DFBFontCache           **ret_cache );
 
-DFBResult dfb_font_manager_remove_lru_row( DFBFontManager          *manager );
+DFBResult dfb_font_manager_remove_lru_page( DFBFontManager         *manager );
+
+DFBResult dfb_font_manager_get_stats     ( DFBFontManager          *manager,
+                                           DFBFontManagerStats     *ret_stats );
+
+/* Prints the stats, see 'renderer-stats' option */
+void      dfb_font_manager_dump_stats    ( DFBFontManager          *manager );
 
 DFBResult dfb_font_cache_create          ( DFBFontManager          *manager,
                                            const DFBFontCacheType  *type,
@@ -76,16 +93,27 @@ DFBResult dfb_font_cache_init            ( DFBFontCache            *cache,
                                            DFBFontManager          *manager,
                                            const DFBFontCacheType  *type );
 DFBResult dfb_font_cache_deinit          ( DFBFontCache            *cache );
-DFBResult dfb_font_cache_get_row         ( DFBFontCache            *cache,
-                                           unsigned int             width,
-                                           DFBFontCacheRow        **ret_row );
 
-DFBResult dfb_font_cache_row_create      ( DFBFontCache            *cache,
-                                           DFBFontCacheRow        **ret_row );
-DFBResult dfb_font_cache_row_destroy     ( DFBFontCacheRow         *row );
-DFBResult dfb_font_cache_row_init        ( DFBFontCacheRow         *row,
+/*
+ * Finds room for a glyph in one of the cache's pages, evicting least recently used glyphs if needed.
+ */
+DFBResult dfb_font_cache_alloc           ( DFBFontCache            *cache,
+                                           unsigned int             width,
+                                           unsigned int             height,
+                                           DFBFontCachePage       **ret_page,
+                                           DFBPoint                *ret_pos );
+
+DFBResult dfb_font_cache_page_create     ( DFBFontCache            *cache,
+                                           DFBFontCachePage       **ret_page );
+DFBResult dfb_font_cache_page_destroy    ( DFBFontCachePage        *page );
+DFBResult dfb_font_cache_page_init       ( DFBFontCachePage        *page,
                                            DFBFontCache            *cache );
-DFBResult dfb_font_cache_row_deinit      ( DFBFontCacheRow         *row );
+DFBResult dfb_font_cache_page_deinit     ( DFBFontCachePage        *page );
+
+void      dfb_font_cache_page_add_glyph  ( DFBFontCachePage        *page,
+                                           CoreGlyphData           *glyph );
+void      dfb_font_cache_page_remove_glyph( DFBFontCachePage       *page,
+                                           CoreGlyphData           *glyph );
 
 
 
@@ -95,37 +123,41 @@ DFBResult dfb_font_cache_row_deinit      ( DFBFontCacheRow         *row );
  * glyph struct
  */
 struct _CoreGlyphData {
-     DirectLink       link;
+     DirectLink          link;
 
-     CoreFont        *font;
+     CoreFont           *font;
 
-     unsigned int     index;
-     unsigned int     layer;
+     unsigned int        index;
+     unsigned int        layer;
 
-     CoreSurface     *surface;              /* contains bitmap of glyph         */
-     int              start;                /* x offset of glyph in surface     */
-     int              width;                /* width of the glyphs bitmap       */
-     int              height;               /* height of the glyphs bitmap      */
-     int              left;                 /* x offset of the glyph            */
-     int              top;                  /* y offset of the glyph            */
-     int              xadvance;             /* placement of next glyph          */
-     int              yadvance;
+     CoreSurface        *surface;           /* contains bitmap of glyph         */
+     int                 start;             /* x offset of glyph in surface     */
+     int                 start_y;           /* y offset of glyph in surface     */
+     int                 width;             /* width of the glyphs bitmap       */
+     int                 height;            /* height of the glyphs bitmap      */
+     int                 left;              /* x offset of the glyph            */
+     int                 top;               /* y offset of the glyph            */
+     int                 xadvance;          /* placement of next glyph          */
+     int                 yadvance;
 
-     int              magic;
+     int                 magic;
 
-     DFBFontCacheRow *row;
+     DFBFontCachePage   *page;
+     DFBDimension        cell;              /* area reserved in the page        */
+     unsigned long long  stamp;             /* last use, for LRU eviction       */
 
-     bool             inserted;
-     bool             retry;
+     bool                inserted;
+     bool                retry;
 };
 
 #define CORE_GLYPH_DATA_DEBUG_AT(Domain, data)                                       \
      do {                                                                            \
           D_DEBUG_AT( Domain, "  -> index    %d\n", (data)->index );                 \
           D_DEBUG_AT( Domain, "  -> layer    %d\n", (data)->layer );                 \
-          D_DEBUG_AT( Domain, "  -> row      %p\n", (data)->row );                   \
+          D_DEBUG_AT( Domain, "  -> page     %p\n", (data)->page );                  \
           D_DEBUG_AT( Domain, "  -> surface  %p\n", (data)->surface );               \
           D_DEBUG_AT( Domain, "  -> start    %d\n", (data)->start );                 \
+          D_DEBUG_AT( Domain, "  -> start_y  %d\n", (data)->start_y );               \
           D_DEBUG_AT( Domain, "  -> width    %d\n", (data)->width );                 \
           D_DEBUG_AT( Domain, "  -> height   %d\n", (data)->height );                \
           D_DEBUG_AT( Domain, "  -> left     %d\n", (data)->left );                  \
@@ -168,6 +200,34 @@ typedef enum {
 
 #define DFB_FONT_MAX_LAYERS 2
 
+/*
+ * longest string (in bytes) kept in the text run cache
+ */
+#define DFB_FONT_TEXT_RUN_MAX_BYTES 256
+
+/*
+ * laid out string, cached per font
+ */
+typedef struct {
+     DirectLink                    link;
+
+     int                           magic;
+
+     unsigned int                  hash;
+     DFBTextEncodingID             encoding;
+     unsigned int                  layers;
+     int                           bytes;
+     u8                           *text;
+
+     unsigned int                  generation;    /* glyph generation of the font when laid out */
+
+     struct {
+          int                      num;           /* number of visible glyphs         */
+          CoreGlyphData          **glyphs;
+          DFBPoint                *points;        /* relative to the origin           */
+     } layer[DFB_FONT_MAX_LAYERS];
+} CoreFontTextRun;
+
 /*
  * font struct
  */
@@ -230,6 +290,10 @@ struct _CoreFont {
      int                           underline_thickness;
 
      CoreFontFlags                 flags;
+
+     DirectLink                   *runs;          /* text run cache, most recent first */
+     int                           num_runs;
+     unsigned int                  generation;    /* increased whenever glyphs are removed */
 };
 
 #define CORE_FONT_DEBUG_AT(Domain, font)                                             \
@@ -287,6 +351,35 @@ DFBResult dfb_font_get_glyph_data( CoreFont        *font,
                                    unsigned int     layer,
                                    CoreGlyphData  **glyph_data );
 
+/*
+ * Renders glyphs into the cache ahead of drawing, either before returning or in a background thread.
+ */
+DFBResult dfb_font_prerender( CoreFont           *font,
+                              const unsigned int *indices,
+                              int                 num,
+                              unsigned int        layers,
+                              bool                async );
+
+/*
+ * Drops pending background rendering of the font, waiting for glyphs being rendered.
+ *
+ * The font must not be locked.
+ */
+void dfb_font_prerender_cancel( CoreFont *font );
+
+/*
+ * Looks up the laid out string in the text run cache, laying it out on a miss.
+ *
+ * The font must be locked, the run and its glyphs are valid until unlocking.
+ * Returns DFB_UNSUPPORTED if the string can't be cached, e.g. it's too long.
+ */
+DFBResult dfb_font_get_text_run( CoreFont           *font,
+                                 DFBTextEncodingID   encoding,
+                                 const void         *text,
+                                 int                 bytes,
+                                 unsigned int        layers,
+                                 CoreFontTextRun   **ret_run );
+
 
 /*
  * Called by font module to register encoding implementations.
@@ -3679,6 +3679,63 @@ font_state_restore( CardState *state,
      }
 }
 
+/*
+ * Blits the glyphs of each layer with one call per glyph cache surface.
+ */
+static void
+draw_text_run( const CoreFontTextRun   *run,
+               int                      x,
+               int                      y,
+               CardState               *state,
+               CoreGraphicsStateClient *client )
+{
+     int i, j, l;
+
+     D_MAGIC_ASSERT( run, CoreFontTextRun );
+
+     for (l=run->layers-1; l>=0; l--) {
+          int           num = run->layer[l].num;
+          DFBPoint      points[num ? : 1];
+          DFBRectangle  rects[num ? : 1];
+          bool          done[num ? : 1];
+
+          if (run->layers > 1)
+               dfb_state_set_color( state, &state->colors[l] );
+
+          memset( done, 0, sizeof(done) );
+
+          for (i=0; i<num; i++) {
+               CoreSurface *source;
+               int          num_blits = 0;
+
+               if (done[i])
+                    continue;
+
+               source = run->layer[l].glyphs[i]->surface;
+
+               /* Gather the remaining glyphs on the same surface. */
+               for (j=i; j<num; j++) {
+                    const CoreGlyphData *glyph = run->layer[l].glyphs[j];
+
+                    if (done[j] || glyph->surface != source)
+                         continue;
+
+                    points[num_blits] = (DFBPoint){ x + run->layer[l].points[j].x, y + run->layer[l].points[j].y };
+                    rects[num_blits]  = (DFBRectangle){ glyph->start, glyph->start_y, glyph->width, glyph->height };
+
+                    num_blits++;
+
+                    done[j] = true;
+               }
+
+               if (source != state->source)
+                    dfb_state_set_source( state, source );
+
+               CoreGraphicsStateClient_Blit( client, rects, points, num_blits );
+          }
+     }
+}
+
 void
 dfb_gfxcard_drawstring( const u8 *text, int bytes,
                         DFBTextEncodingID encoding, int x, int y,
@@ -3699,6 +3756,7 @@ dfb_gfxcard_drawstring( const u8 *text, int bytes,
      int           ox = x;
      int           oy = y;
      CardState    *state;
+     CoreFontTextRun *run;
 
      if (encoding == DTEID_UTF8)
           D_DEBUG_AT( Core_GraphicsOps, "%s( '%s' [%d], %d,%d, %p, %p )\n",
@@ -3730,15 +3788,21 @@ dfb_gfxcard_drawstring( const u8 *text, int bytes,
           }
      }
 
-     /* Decode string to character indices. */
-     ret = dfb_font_decode_text( font, encoding, text, bytes, indices, &num );
-     if (ret)
-          return;
-
      font_state_prepare( state, &state_backup, font, surface, !(flags & DSTF_BLEND_FUNCS) );
 
      dfb_font_lock( font );
 
+     /* Strings drawn again skip decoding and layout. */
+     if (dfb_font_get_text_run( font, encoding, text, bytes, layers, &run ) == DFB_OK) {
+          draw_text_run( run, ox, oy, state, client );
+          goto out;
+     }
+
+     /* Decode string to character indices. */
+     ret = dfb_font_decode_text( font, encoding, text, bytes, indices, &num );
+     if (ret)
+          goto out;
+
      for (l=layers-1; l>=0; l--) {
           x = ox << 8;
           y = oy << 8;
@@ -3776,7 +3840,7 @@ dfb_gfxcard_drawstring( const u8 *text, int bytes,
                     }
 
                     points[num_blits] = (DFBPoint){ (x >> 8) + glyph->left, (y >> 8) + glyph->top };
-                    rects[num_blits]  = (DFBRectangle){ glyph->start, 0, glyph->width, glyph->height };
+                    rects[num_blits]  = (DFBRectangle){ glyph->start, glyph->start_y, glyph->width, glyph->height };
 
                     num_blits++;
                }
@@ -3792,6 +3856,7 @@ dfb_gfxcard_drawstring( const u8 *text, int bytes,
           }
      }
 
+out:
      dfb_font_unlock( font );
 
      font_state_restore( state, &state_backup );
@@ -3829,7 +3894,7 @@ void dfb_gfxcard_drawglyph( CoreGlyphData **glyph, int x, int y,
 
           /* blit glyph */
           if (glyph[l]->width) {
-               DFBRectangle rect  = { glyph[l]->start, 0, glyph[l]->width, glyph[l]->height };
+               DFBRectangle rect  = { glyph[l]->start, glyph[l]->start_y, glyph[l]->width, glyph[l]->height };
                DFBPoint     point = { x + glyph[l]->left, y + glyph[l]->top };
 
                dfb_state_set_source( state, glyph[l]->surface );
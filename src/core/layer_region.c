@@ -32,6 +32,8 @@
 
 #include <config.h>
 
+#include <string.h>
+
 #include <directfb.h>
 
 #include <core/coredefs.h>
@@ -224,6 +226,8 @@ dfb_layer_region_create( CoreLayerContext  *context,
 
      region->state = CLRSF_FROZEN;
 
+     dfb_layer_region_damage_reset( region );
+
      if (shared->description.surface_accessor)
           region->surface_accessor = shared->description.surface_accessor;
      else
@@ -414,6 +418,9 @@ dfb_layer_region_set_surface( CoreLayerRegion *region,
           return DFB_FUSION;
 
      if (region->surface != surface) {
+          /* Content of the new surface's buffers is unknown. */
+          dfb_layer_region_damage_reset( region );
+
           /* Setup hardware for the new surface if the region is realized. */
           if (D_FLAGS_IS_SET( region->state, CLRSF_REALIZED )) {
                ret = dfb_layer_region_set( region, &region->config, CLRCF_SURFACE | CLRCF_PALETTE, surface );
@@ -595,6 +602,10 @@ dfb_layer_region_flip_update( CoreLayerRegion     *region,
      if (!(surface->frametime_config.flags & DFTCF_INTERVAL))
           dfb_screen_get_frame_interval( layer->screen, &surface->frametime_config.interval );
 
+     /* Record the damage of this flip for the current back buffer. */
+     if (!(flags & DSFLIP_UPDATE))
+          dfb_layer_region_damage_flip( region, surface, update, flags );
+
      if (flags & DSFLIP_UPDATE)
           goto update_only;
 
@@ -824,6 +835,9 @@ dfb_layer_region_flip_update_stereo( CoreLayerRegion     *region,
      if (!(surface->frametime_config.flags & DFTCF_INTERVAL))
           dfb_screen_get_frame_interval( layer->screen, &surface->frametime_config.interval );
 
+     /* No damage history for stereo regions. */
+     dfb_layer_region_damage_reset( region );
+
      if (flags & DSFLIP_UPDATE)
           goto update_only;
 
@@ -1005,6 +1019,203 @@ out:
      return ret;
 }
 
+DFBResult
+dfb_layer_region_get_damage( CoreLayerRegion *region,
+                             DFBUpdates      *ret_damage )
+{
+     DFBResult              ret = DFB_OK;
+     int                    i;
+     u32                    frame;
+     CoreSurface           *surface;
+     CoreSurfaceBuffer     *buffer;
+     CoreLayerRegionDamage *damage;
+
+     D_DEBUG_AT( Core_Layers, "%s( %p )\n", __FUNCTION__, region );
+
+     D_ASSERT( region != NULL );
+     D_ASSERT( ret_damage != NULL );
+
+     /* Lock the region. */
+     if (dfb_layer_region_lock( region ))
+          return DFB_FUSION;
+
+     surface = region->surface;
+     if (!surface || (region->config.options & DLOP_STEREO)) {
+          dfb_layer_region_unlock( region );
+          return DFB_UNSUPPORTED;
+     }
+
+     damage = &region->damage;
+
+     dfb_surface_lock( surface );
+
+     buffer = surface->num_buffers ? dfb_surface_get_buffer3( surface, CSBR_BACK, DSSE_LEFT, surface->flips ) : NULL;
+
+     dfb_surface_unlock( surface );
+
+     for (i=0; i<MAX_SURFACE_BUFFERS; i++) {
+          if (buffer && damage->buffers[i].buffer == buffer)
+               break;
+     }
+
+     if (i == MAX_SURFACE_BUFFERS) {
+          D_DEBUG_AT( Core_Layers, "  -> unknown back buffer %p\n", buffer );
+          ret = DFB_ITEMNOTFOUND;
+     }
+     else if (damage->frame - damage->buffers[i].frame > CORE_LAYER_REGION_DAMAGE_FRAMES) {
+          D_DEBUG_AT( Core_Layers, "  -> back buffer %p too old (age %u)\n", buffer, damage->frame - damage->buffers[i].frame );
+          ret = DFB_LIMITEXCEEDED;
+     }
+     else {
+          D_DEBUG_AT( Core_Layers, "  -> back buffer %p, age %u\n", buffer, damage->frame - damage->buffers[i].frame );
+
+          for (frame = damage->buffers[i].frame + 1; frame != damage->frame + 1; frame++) {
+               const DFBUpdates *updates = &damage->frames[frame % CORE_LAYER_REGION_DAMAGE_FRAMES];
+               int               n;
+
+               for (n=0; n<updates->num_regions; n++)
+                    dfb_updates_add( ret_damage, &updates->regions[n] );
+          }
+     }
+
+     /* Unlock the region. */
+     dfb_layer_region_unlock( region );
+
+     return ret;
+}
+
+DFBResult
+dfb_layer_region_add_damage( CoreLayerRegion *region,
+                             const DFBRegion *regions,
+                             int              num_regions )
+{
+     int i;
+
+     D_DEBUG_AT( Core_Layers, "%s( %p, %p [%d] )\n", __FUNCTION__, region, regions, num_regions );
+
+     D_ASSERT( region != NULL );
+     D_ASSERT( regions != NULL || num_regions == 0 );
+
+     /* Lock the region. */
+     if (dfb_layer_region_lock( region ))
+          return DFB_FUSION;
+
+     for (i=0; i<num_regions; i++) {
+          DFB_REGION_ASSERT( &regions[i] );
+
+          dfb_updates_add( &region->damage.pending, &regions[i] );
+     }
+
+     /* Unlock the region. */
+     dfb_layer_region_unlock( region );
+
+     return DFB_OK;
+}
+
+static void
+damage_record_buffer( CoreLayerRegionDamage *damage,
+                      CoreSurfaceBuffer     *buffer )
+{
+     int i;
+     int slot = 0;
+
+     /* Remember the frame in the buffer's slot, or take the oldest one. */
+     for (i=0; i<MAX_SURFACE_BUFFERS; i++) {
+          if (damage->buffers[i].buffer == buffer) {
+               slot = i;
+               break;
+          }
+
+          if (!damage->buffers[i].buffer ||
+              (damage->buffers[slot].buffer && damage->buffers[i].frame < damage->buffers[slot].frame))
+               slot = i;
+     }
+
+     damage->buffers[slot].buffer = buffer;
+     damage->buffers[slot].frame  = damage->frame;
+}
+
+void
+dfb_layer_region_damage_flip( CoreLayerRegion     *region,
+                              CoreSurface         *surface,
+                              const DFBRegion     *update,
+                              DFBSurfaceFlipFlags  flags )
+{
+     int                    i;
+     bool                   swap;
+     CoreSurfaceBuffer     *buffer;
+     CoreLayerRegionDamage *damage;
+     DFBUpdates            *frame;
+
+     D_ASSERT( region != NULL );
+     D_MAGIC_ASSERT( surface, CoreSurface );
+     FUSION_SKIRMISH_ASSERT( &surface->lock );
+
+     damage = &region->damage;
+
+     if (!surface->num_buffers) {
+          dfb_layer_region_damage_reset( region );
+          return;
+     }
+
+     buffer = dfb_surface_get_buffer3( surface, CSBR_BACK, DSSE_LEFT, surface->flips );
+
+     damage->frame++;
+
+     frame = &damage->frames[damage->frame % CORE_LAYER_REGION_DAMAGE_FRAMES];
+
+     dfb_updates_reset( frame );
+
+     if (damage->pending.num_regions) {
+          for (i=0; i<damage->pending.num_regions; i++)
+               dfb_updates_add( frame, &damage->pending.regions[i] );
+
+          dfb_updates_reset( &damage->pending );
+     }
+     else if (update)
+          dfb_updates_add( frame, update );
+     else
+          dfb_updates_add_rect( frame, 0, 0, surface->config.size.w, surface->config.size.h );
+
+     /* Same decision as in the flip itself. */
+     swap = (region->config.buffermode == DLBM_TRIPLE || region->config.buffermode == DLBM_BACKVIDEO) &&
+            ((flags & DSFLIP_SWAP) ||
+             (!(flags & DSFLIP_BLIT) && !surface->rotation &&
+              (!update || (update->x1 == 0 &&
+                           update->y1 == 0 &&
+                           update->x2 == surface->config.size.w - 1 &&
+                           update->y2 == surface->config.size.h - 1))));
+
+     D_DEBUG_AT( Core_Layers, "  -> frame %u, back buffer %p, %d regions%s\n",
+                 damage->frame, buffer, frame->num_regions, swap ? ", swap" : "" );
+
+     damage_record_buffer( damage, buffer );
+
+     /* Copying the update to the front buffer leaves both up to date. */
+     if (!swap)
+          damage_record_buffer( damage, dfb_surface_get_buffer3( surface, CSBR_FRONT, DSSE_LEFT, surface->flips ) );
+}
+
+void
+dfb_layer_region_damage_reset( CoreLayerRegion *region )
+{
+     int                    i;
+     CoreLayerRegionDamage *damage;
+
+     D_DEBUG_AT( Core_Layers, "%s( %p )\n", __FUNCTION__, region );
+
+     D_ASSERT( region != NULL );
+
+     damage = &region->damage;
+
+     memset( damage->buffers, 0, sizeof(damage->buffers) );
+
+     dfb_updates_init( &damage->pending, damage->pending_regions, CORE_LAYER_REGION_DAMAGE_REGIONS );
+
+     for (i=0; i<CORE_LAYER_REGION_DAMAGE_FRAMES; i++)
+          dfb_updates_init( &damage->frames[i], damage->frame_regions[i], CORE_LAYER_REGION_DAMAGE_REGIONS );
+}
+
 DFBResult
 dfb_layer_region_set_configuration( CoreLayerRegion            *region,
                                     CoreLayerRegionConfig      *config,
@@ -1242,6 +1453,10 @@ _dfb_layer_region_surface_listener( const void *msg_data, void *ctx )
      if (dfb_layer_region_lock( region ))
           return RS_OK;
 
+     /* Buffers have been reallocated. */
+     if (flags & CSNF_SIZEFORMAT)
+          dfb_layer_region_damage_reset( region );
+
      if (D_FLAGS_ARE_SET( region->state, CLRSF_REALIZED | CLRSF_CONFIGURED ) &&
          !D_FLAGS_IS_SET( region->state, CLRSF_FROZEN ))
      {
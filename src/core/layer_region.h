@@ -34,6 +34,7 @@
 #define __CORE__LAYER_REGION_H__
 
 #include <directfb.h>
+#include <directfb_util.h>
 
 #include <core/coretypes.h>
 #include <core/layers.h>
@@ -98,6 +99,24 @@ DFBResult dfb_layer_region_flip_update2  ( CoreLayerRegion      *region,
                                            long long             pts,
                                            DFB_DisplayTask     **ret_task );
 
+/*
+ * Damage history (buffer age)
+ *
+ * Adds the damage of all flips since the current back buffer was drawn to 'ret_damage', so that only these areas
+ * need to be repainted instead of copying back the front buffer. Returns DFB_ITEMNOTFOUND if the buffer's content
+ * is unknown, e.g. after (re)allocation, or DFB_LIMITEXCEEDED if it's older than the history, in both cases the
+ * whole region needs to be repainted.
+ */
+DFBResult dfb_layer_region_get_damage( CoreLayerRegion      *region,
+                                       DFBUpdates           *ret_damage );
+
+/*
+ * Adds damage drawn into the back buffer for the next flip, otherwise the flip's update region is recorded.
+ */
+DFBResult dfb_layer_region_add_damage( CoreLayerRegion      *region,
+                                       const DFBRegion      *regions,
+                                       int                   num_regions );
+
 /*
  * Configuration
  */
@@ -185,6 +185,27 @@ typedef enum {
      CLRSF_ALL        = 0x0000001F
 } CoreLayerRegionStateFlags;
 
+#define CORE_LAYER_REGION_DAMAGE_FRAMES   4    /* history length, i.e. maximum buffer age */
+#define CORE_LAYER_REGION_DAMAGE_REGIONS  8    /* regions per frame before using the bounding box */
+
+/*
+ * Damage history of the flip chain (buffer age).
+ */
+typedef struct {
+     u32                         frame;      /* number of recorded flips */
+
+     DFBUpdates                  pending;    /* damage added for the next flip */
+     DFBRegion                   pending_regions[CORE_LAYER_REGION_DAMAGE_REGIONS];
+
+     DFBUpdates                  frames[CORE_LAYER_REGION_DAMAGE_FRAMES];  /* damage of the last flips */
+     DFBRegion                   frame_regions[CORE_LAYER_REGION_DAMAGE_FRAMES][CORE_LAYER_REGION_DAMAGE_REGIONS];
+
+     struct {
+          CoreSurfaceBuffer     *buffer;     /* back buffer at the time of the flip */
+          u32                    frame;      /* last frame drawn into it */
+     } buffers[MAX_SURFACE_BUFFERS];
+} CoreLayerRegionDamage;
+
 struct __DFB_CoreLayerRegion {
      FusionObject                object;
 
@@ -213,6 +234,8 @@ struct __DFB_CoreLayerRegion {
      DFBDisplayLayerID           layer_id;
 
      u32                         surface_flip_count;
+
+     CoreLayerRegionDamage       damage;
 };
 
 
@@ -232,6 +255,16 @@ DFBResult dfb_layer_context_activate  ( CoreLayerContext *context );
    dfb_layer_remove_context() and dfb_layer_suspend(). */
 DFBResult dfb_layer_context_deactivate( CoreLayerContext *context );
 
+/* Called with the region and surface locked before flipping a mono region,
+   records the pending damage or the update for the current back buffer. */
+void dfb_layer_region_damage_flip ( CoreLayerRegion     *region,
+                                    CoreSurface         *surface,
+                                    const DFBRegion     *update,
+                                    DFBSurfaceFlipFlags  flags );
+
+/* Called whenever the content of the buffers gets unknown. */
+void dfb_layer_region_damage_reset( CoreLayerRegion     *region );
+
 /* global reactions */
 ReactionResult _dfb_layer_region_surface_listener( const void *msg_data,
                                                    void       *ctx );
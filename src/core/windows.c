@@ -1666,7 +1666,77 @@ dfb_window_set_opaque( CoreWindow      *window,
      config.opaque.x2 = window->config.bounds.w - 1;
      config.opaque.y2 = window->config.bounds.h - 1;
 
-     if (region && !dfb_region_region_intersect( &config.opaque, region ))
+     config.opaque_regions[0]  = config.opaque;
+     config.num_opaque_regions = 1;
+
+     if (region && !dfb_region_region_intersect( &config.opaque_regions[0], region ))
+          ret = DFB_INVAREA;
+     else {
+          config.opaque = config.opaque_regions[0];
+
+          ret = dfb_wm_set_window_config( window, &config, CWCF_OPAQUE );
+     }
+
+     /* Unlock the window stack. */
+     dfb_windowstack_unlock( stack );
+
+     return ret;
+}
+
+DFBResult
+dfb_window_set_opaque_regions( CoreWindow      *window,
+                               const DFBRegion *regions,
+                               unsigned int     num_regions )
+{
+     DFBResult         ret;
+     unsigned int      i;
+     int               largest = -1;
+     CoreWindowConfig  config;
+     CoreWindowStack  *stack = window->stack;
+
+     D_MAGIC_ASSERT( window, CoreWindow );
+     D_ASSERT( regions != NULL );
+
+     if (!num_regions || num_regions > DFB_WINDOW_OPAQUE_REGIONS_MAX)
+          return DFB_INVARG;
+
+     /* Lock the window stack. */
+     if (dfb_windowstack_lock( stack ))
+          return DFB_FUSION;
+
+     /* Never call WM after destroying the window. */
+     if (DFB_WINDOW_DESTROYED( window )) {
+          dfb_windowstack_unlock( stack );
+          return DFB_DESTROYED;
+     }
+
+     config.num_opaque_regions = 0;
+
+     for (i=0; i<num_regions; i++) {
+          DFBRegion *opaque = &config.opaque_regions[config.num_opaque_regions];
+          int        area;
+
+          DFB_REGION_ASSERT( &regions[i] );
+
+          opaque->x1 = 0;
+          opaque->y1 = 0;
+          opaque->x2 = window->config.bounds.w - 1;
+          opaque->y2 = window->config.bounds.h - 1;
+
+          /* skip regions outside of the window */
+          if (!dfb_region_region_intersect( opaque, &regions[i] ))
+               continue;
+
+          area = (opaque->x2 - opaque->x1 + 1) * (opaque->y2 - opaque->y1 + 1);
+          if (area > largest) {
+               config.opaque = *opaque;
+               largest       = area;
+          }
+
+          config.num_opaque_regions++;
+     }
+
+     if (!config.num_opaque_regions)
           ret = DFB_INVAREA;
      else
           ret = dfb_wm_set_window_config( window, &config, CWCF_OPAQUE );
@@ -1677,6 +1747,40 @@ dfb_window_set_opaque( CoreWindow      *window,
      return ret;
 }
 
+void
+dfb_window_clip_opaque_regions( CoreWindowConfig *config )
+{
+     unsigned int i;
+     unsigned int num     = 0;
+     int          largest = -1;
+     DFBRegion    clip    = { 0, 0, config->bounds.w - 1, config->bounds.h - 1 };
+
+     D_ASSERT( config != NULL );
+
+     for (i=0; i<config->num_opaque_regions; i++) {
+          DFBRegion region = config->opaque_regions[i];
+          int       area;
+
+          /* drop regions outside of the window */
+          if (!dfb_region_region_intersect( &region, &clip ))
+               continue;
+
+          area = (region.x2 - region.x1 + 1) * (region.y2 - region.y1 + 1);
+          if (area > largest) {
+               config->opaque = region;
+               largest        = area;
+          }
+
+          config->opaque_regions[num++] = region;
+     }
+
+     config->num_opaque_regions = num;
+
+     /* Without any region left, keep the single one clipped, or make the whole window opaque. */
+     if (!num && !dfb_region_region_intersect( &config->opaque, &clip ))
+          config->opaque = clip;
+}
+
 DFBResult
 dfb_window_change_events( CoreWindow         *window,
                           DFBWindowEventType  disable,
@@ -82,6 +82,8 @@ struct __DFB_CoreWindowConfig {
      DFBColor                 color;          /* color for DWCAPS_COLOR, never premultiplied! */
      u32                      color_key;      /* transparent pixel */
      DFBRegion                opaque;         /* region of the window forced to be opaque */
+     DFBRegion                opaque_regions[DFB_WINDOW_OPAQUE_REGIONS_MAX]; /* all opaque regions, if any */
+     unsigned int             num_opaque_regions; /* number of opaque regions, 'opaque' is the largest */
      int                      z;              /* stereoscopic offset used to establish perceived depth */
 
      DFBWindowKeySelection    key_selection;  /* how to filter keys in focus */
@@ -304,6 +306,20 @@ DFBResult
 dfb_window_set_opaque( CoreWindow      *window,
                        const DFBRegion *region );
 
+/*
+ * sets several opaque regions, the largest one is also set as the single opaque region
+ */
+DFBResult
+dfb_window_set_opaque_regions( CoreWindow      *window,
+                               const DFBRegion *regions,
+                               unsigned int     num_regions );
+
+/*
+ * clips the opaque regions to the window size after resizing, used by window managers
+ */
+void
+dfb_window_clip_opaque_regions( CoreWindowConfig *config );
+
 /*
  * manipulates the event mask
  */
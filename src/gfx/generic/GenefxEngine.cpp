@@ -42,6 +42,7 @@
 extern "C" {
 #include <direct/debug.h>
 #include <direct/messages.h>
+#include <direct/util.h>
 
 #include <core/core.h>
 #include <core/palette.h>
@@ -51,6 +52,7 @@ extern "C" {
 
 #include <gfx/clip.h>
 #include <gfx/convert.h>
+#include <gfx/util.h>
 #include <gfx/generic/generic.h>
 }
 
@@ -143,7 +145,8 @@ private:
           TYPE_DRAW_LINES,
           TYPE_BLIT,
           TYPE_STRETCHBLIT,
-          TYPE_TEXTURE_TRIANGLES
+          TYPE_TEXTURE_TRIANGLES,
+          TYPE_TEXTURE_TRIANGLES_BINNED
      } Type;
 
      typedef Util::PacketBuffer<> Commands;
@@ -156,6 +159,19 @@ private:
      unsigned int             tile_count;
      unsigned int             tile_number;
      StateModificationFlags   modified;
+     DFBRegion                bins[Graphics::Renderer::Setup::TILE_MAX];
+
+     /* returns the mask of tiles (bins) touched by the bounding box of a triangle */
+     inline u32 binTriangle( const DFBRegion &bounds ) const {
+          u32 mask = 0;
+
+          for (unsigned int i=0; i<tile_count; i++) {
+               if (dfb_region_region_intersects( &bounds, &bins[i] ))
+                    mask |= 1u << i;
+          }
+
+          return mask;
+     }
 
      inline void addDrawingWeight( unsigned int w ) {
           weight += 10 + (w << weight_shift_draw);
@@ -195,7 +211,7 @@ private:
 public:
      GenefxEngine( unsigned int cores = 1 )
           :
-          threads( "Genefx", cores < 8 ? cores : 8 )
+          threads( "Genefx", cores < 8 ? cores : 8, DTT_DEFAULT, dfb_config->software_pinning )
      {
           D_DEBUG_AT( DirectFB_GenefxEngine, "GenefxEngine::%s( cores %d )\n", __FUNCTION__, cores );
 
@@ -229,6 +245,13 @@ public:
                setup->tasks[i] = new GenefxTask( this, setup->clips[i], setup->tiles, i );
           }
 
+          /* The first task records the commands and sorts triangles into the tiles for the others. */
+          GenefxTask *master = (GenefxTask *) setup->tasks[0];
+
+          for (unsigned int i=0; i<setup->tiles; i++)
+               master->bins[i] = setup->clips[i];
+
+          /* Commands are recorded once into the first task, the others replay them clipped to their tile. */
           setup->tiles_render = 1;
 
           return DFB_OK;
@@ -733,6 +756,9 @@ public:
           D_DEBUG_AT( DirectFB_GenefxEngine, "GenefxEngine::%s( %d )  <- clip %d,%d-%dx%d\n", __FUNCTION__, num,
                       DFB_RECTANGLE_VALS_FROM_REGION(&mytask->clip) );
 
+          if (mytask->tile_count > 1)
+               return TextureTrianglesBinned( mytask, vertices, num, formation );
+
           u32 *buf = (u32*) mytask->commands.GetBuffer( 4 * (3 + num * 4) );
 
           if (!buf)
@@ -757,6 +783,118 @@ public:
           return DFB_OK;
      }
 
+private:
+     /*
+      * Records the triangles as a list, each one preceded by the mask of tiles its bounding box overlaps.
+      *
+      * Every tile replays only its own triangles instead of setting up all of them just to clip them away,
+      * triangles outside of the clip are dropped here already.
+      */
+     DFBResult TextureTrianglesBinned( GenefxTask             *mytask,
+                                       const DFBVertex1616    *vertices,
+                                       unsigned int            num,
+                                       DFBTriangleFormation    formation )
+     {
+          unsigned int triangles;
+
+          D_DEBUG_AT( DirectFB_GenefxEngine, "GenefxEngine::%s( %d, tiles %d )\n", __FUNCTION__, num, mytask->tile_count );
+
+          if (num < 3)
+               return DFB_OK;
+
+          switch (formation) {
+               case DTTF_LIST:
+                    triangles = num / 3;
+                    break;
+
+               case DTTF_STRIP:
+               case DTTF_FAN:
+                    triangles = num - 2;
+                    break;
+
+               default:
+                    D_BUG( "unknown formation %d", formation );
+                    return DFB_BUG;
+          }
+
+          u32 *buf = (u32*) mytask->commands.GetBuffer( 4 * (2 + triangles * 13) );
+
+          if (!buf)
+               return DFB_NOSYSTEMMEMORY;
+
+          u32 *count_ptr = buf + 1;
+          u32  count     = 0;
+
+          *buf++ = GenefxTask::TYPE_TEXTURE_TRIANGLES_BINNED;
+          *buf++ = 0;
+
+          for (unsigned int n=0; n<triangles; n++) {
+               const DFBVertex1616 *v[3];
+
+               switch (formation) {
+                    case DTTF_LIST:
+                         v[0] = &vertices[n*3+0];
+                         v[1] = &vertices[n*3+1];
+                         v[2] = &vertices[n*3+2];
+                         break;
+
+                    case DTTF_STRIP:
+                         v[0] = &vertices[n+0];
+                         v[1] = &vertices[n+1];
+                         v[2] = &vertices[n+2];
+                         break;
+
+                    default:
+                         v[0] = &vertices[0];
+                         v[1] = &vertices[n+1];
+                         v[2] = &vertices[n+2];
+                         break;
+               }
+
+               DFBRegion bounds;
+
+               bounds.x1 = bounds.x2 = v[0]->x >> 16;
+               bounds.y1 = bounds.y2 = v[0]->y >> 16;
+
+               for (int i=1; i<3; i++) {
+                    int x = v[i]->x >> 16;
+                    int y = v[i]->y >> 16;
+
+                    if (bounds.x1 > x) bounds.x1 = x;
+                    if (bounds.x2 < x) bounds.x2 = x;
+                    if (bounds.y1 > y) bounds.y1 = y;
+                    if (bounds.y2 < y) bounds.y2 = y;
+               }
+
+               if (!dfb_region_region_intersect( &bounds, &mytask->clip ))
+                    continue;
+
+               u32 mask = mytask->binTriangle( bounds );
+
+               if (!mask)
+                    continue;
+
+               *buf++ = mask;
+
+               for (int i=0; i<3; i++) {
+                    *buf++ = v[i]->x >> 16;
+                    *buf++ = v[i]->y >> 16;
+                    *buf++ = v[i]->s;
+                    *buf++ = v[i]->t;
+               }
+
+               count++;
+          }
+
+          *count_ptr = count;
+
+          mytask->addBlittingWeight( count * 30000 );
+
+          mytask->commands.PutBuffer( buf );
+
+          return DFB_OK;
+     }
+
 };
 
 
@@ -823,6 +961,26 @@ GenefxTask::Finalise()
      SurfaceTask::Finalise();
 }
 
+/*
+ * Runs gAcquireSetup() only if the state has been modified or a different function is used,
+ * so consecutive primitives with the same state share one pipeline setup.
+ */
+static inline bool
+acquireSetup( CardState           *state,
+              DFBAccelerationMask  accel,
+              DFBAccelerationMask *setup_accel,
+              bool                *setup_ok )
+{
+     if (*setup_accel != accel) {
+          *setup_ok    = gAcquireSetup( state, accel );
+          *setup_accel = accel;
+     }
+     else
+          D_DEBUG_AT( DirectFB_GenefxTask, "  -> reusing setup for 0x%08x\n", accel );
+
+     return *setup_ok;
+}
+
 DFBResult
 GenefxTask::Run()
 {
@@ -842,6 +1000,8 @@ GenefxTask::Run()
      CardState            state;
      bool                 single_tile;
      bool                 disable_rendering = false;
+     DFBAccelerationMask  setup_accel       = DFXL_NONE;
+     bool                 setup_ok          = false;
 
      D_DEBUG_AT( DirectFB_GenefxTask, "GenefxTask::%s()\n", __FUNCTION__ );
 
@@ -871,6 +1031,10 @@ GenefxTask::Run()
           for (unsigned int i=0; i<size; i++) {
                D_DEBUG_AT( DirectFB_GenefxTask, "  -> [%d]\n", i );
 
+               /* Any state change except the clip invalidates the pipeline set up for the previous primitives. */
+               if (buffer[i] < GenefxTask::TYPE_FILL_RECTS && buffer[i] != GenefxTask::TYPE_SET_CLIP)
+                    setup_accel = DFXL_NONE;
+
                switch (buffer[i]) {
                     case GenefxTask::TYPE_SET_DESTINATION:
                          D_DEBUG_AT( DirectFB_GenefxTask, "  -> SET_DESTINATION\n" );
@@ -1035,8 +1199,7 @@ GenefxTask::Run()
                          num = buffer[++i];
                          D_DEBUG_AT( DirectFB_GenefxTask, "  -> num %d\n", num );
 
-                         // TODO: run gAcquireSetup in Engine, requires lots of Genefx changes :(
-                         if (!disable_rendering && gAcquireSetup( &state, DFXL_FILLRECTANGLE )) {
+                         if (!disable_rendering && acquireSetup( &state, DFXL_FILLRECTANGLE, &setup_accel, &setup_ok )) {
                               for (u32 n=0; n<num; n++) {
                                    int x = buffer[++i];
                                    int y = buffer[++i];
@@ -1063,8 +1226,7 @@ GenefxTask::Run()
                          num = buffer[++i];
                          D_DEBUG_AT( DirectFB_GenefxTask, "  -> num %d\n", num );
 
-                         // TODO: run gAcquireSetup in Engine, requires lots of Genefx changes :(
-                         if (!disable_rendering && gAcquireSetup( &state, DFXL_DRAWLINE )) {
+                         if (!disable_rendering && acquireSetup( &state, DFXL_DRAWLINE, &setup_accel, &setup_ok )) {
                               for (u32 n=0; n<num; n++) {
                                    int x1 = buffer[++i];
                                    int y1 = buffer[++i];
@@ -1091,8 +1253,7 @@ GenefxTask::Run()
                          num = buffer[++i];
                          D_DEBUG_AT( DirectFB_GenefxTask, "  -> num %d\n", num );
 
-                         // TODO: run gAcquireSetup in Engine, requires lots of Genefx changes :(
-                         if (!disable_rendering && gAcquireSetup( &state, DFXL_BLIT )) {
+                         if (!disable_rendering && acquireSetup( &state, DFXL_BLIT, &setup_accel, &setup_ok )) {
                               for (u32 n=0; n<num; n++) {
                                    int x  = buffer[++i];
                                    int y  = buffer[++i];
@@ -1109,11 +1270,20 @@ GenefxTask::Run()
 
                                    if (single_tile)
                                         gBlit( &state, &rect, dx, dy );
-                                   else if (dfb_clip_blit_precheck( &state.clip, rect.w, rect.h, dx, dy )) {
-                                        dfb_clip_blit( &state.clip, &rect, &dx, &dy );  // FIXME: support rotation!
-                                        //dfb_clip_blit_flipped_rotated( &mytask->clip, &rect, &drect, blittingflags );
+                                   else {
+                                        DFBSurfaceBlittingFlags flags = state.blittingflags;
+                                        DFBRectangle            drect = { dx, dy, w, h };
 
-                                        gBlit( &state, &rect, dx, dy );
+                                        dfb_simplify_blittingflags( &flags );
+
+                                        if (flags & DSBLIT_ROTATE90)
+                                             D_UTIL_SWAP( drect.w, drect.h );
+
+                                        if (dfb_clip_blit_precheck( &state.clip, drect.w, drect.h, drect.x, drect.y )) {
+                                             dfb_clip_blit_flipped_rotated( &state.clip, &rect, &drect, flags );
+
+                                             gBlit( &state, &rect, drect.x, drect.y );
+                                        }
                                    }
                               }
                          }
@@ -1127,8 +1297,7 @@ GenefxTask::Run()
                          num = buffer[++i];
                          D_DEBUG_AT( DirectFB_GenefxTask, "  -> num %d\n", num );
 
-                         // TODO: run gAcquireSetup in Engine, requires lots of Genefx changes :(
-                         if (!disable_rendering && gAcquireSetup( &state, DFXL_STRETCHBLIT )) {
+                         if (!disable_rendering && acquireSetup( &state, DFXL_STRETCHBLIT, &setup_accel, &setup_ok )) {
                               for (u32 n=0; n<num; n++) {
                                    DFBRectangle srect;
                                    DFBRectangle drect;
@@ -1163,8 +1332,7 @@ GenefxTask::Run()
                          formation = (DFBTriangleFormation) buffer[++i];
                          D_DEBUG_AT( DirectFB_GenefxTask, "  -> formation %d\n", formation );
 
-                         // TODO: run gAcquireSetup in Engine, requires lots of Genefx changes :(
-                         if (!disable_rendering && gAcquireSetup( &state, DFXL_TEXTRIANGLES )) {
+                         if (!disable_rendering && acquireSetup( &state, DFXL_TEXTRIANGLES, &setup_accel, &setup_ok )) {
                               Util::TempArray<GenefxVertexAffine> v( num );
 
                               for (u32 n=0; n<num; n++) {
@@ -1181,6 +1349,41 @@ GenefxTask::Run()
 
                          break;
 
+                    case GenefxTask::TYPE_TEXTURE_TRIANGLES_BINNED:
+                         D_DEBUG_AT( DirectFB_GenefxTask, "  -> TEXTURE_TRIANGLES_BINNED\n" );
+
+                         num = buffer[++i];
+                         D_DEBUG_AT( DirectFB_GenefxTask, "  -> num       %d\n", num );
+
+                         if (num && !disable_rendering && acquireSetup( &state, DFXL_TEXTRIANGLES, &setup_accel, &setup_ok )) {
+                              Util::TempArray<GenefxVertexAffine> v( num * 3 );
+                              u32                                 count = 0;
+
+                              /* Pick the triangles sorted into this tile, rendering them as a list. */
+                              for (u32 n=0; n<num; n++) {
+                                   if (!(buffer[++i] & (1u << tile_number))) {
+                                        i += 12;
+                                        continue;
+                                   }
+
+                                   for (int k=0; k<3; k++, count++) {
+                                        v.array[count].x = buffer[++i];
+                                        v.array[count].y = buffer[++i];
+                                        v.array[count].s = buffer[++i];
+                                        v.array[count].t = buffer[++i];
+                                   }
+                              }
+
+                              D_DEBUG_AT( DirectFB_GenefxTask, "  -> %d in tile %d\n", count / 3, tile_number );
+
+                              if (count)
+                                   Genefx_TextureTrianglesAffine( &state, v.array, count, DTTF_LIST, &state.clip );
+                         }
+                         else
+                              i += num * 13;
+
+                         break;
+
                     default:
                          D_BUG( "unknown type %d", buffer[i] );
                }
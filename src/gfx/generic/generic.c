@@ -40,6 +40,11 @@
 
 #include <pthread.h>
 
+#if defined(USE_NEON) && !defined(__aarch64__) && defined(HAVE_GETAUXVAL)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
 #include <directfb.h>
 
 #include <core/core.h>
@@ -82,10 +87,24 @@ static const u8 lookup2to8[] = { 0x00, 0x55, 0xaa, 0xff};
 
 static int use_mmx = 0;
 
+static const char *use_simd = NULL;
+
 #ifdef USE_MMX
 static void gInit_MMX( void );
 #endif
 
+#ifdef USE_SSE2
+static void gInit_SSE2( void );
+#endif
+
+#ifdef USE_AVX2
+static void gInit_AVX2( void );
+#endif
+
+#ifdef USE_NEON
+static void gInit_NEON( void );
+#endif
+
 #if SIZEOF_LONG == 8
 static void gInit_64bit( void );
 #endif
@@ -4655,7 +4674,7 @@ static void Sop_a8_TEX_to_Dacc( GenefxState *gfxs )
      }
 }
 
-static const GenefxFunc Sop_PFI_TEX_to_Dacc[DFB_NUM_PIXELFORMATS] = {
+static GenefxFunc Sop_PFI_TEX_to_Dacc[DFB_NUM_PIXELFORMATS] = {
      [DFB_PIXELFORMAT_INDEX(DSPF_ARGB1555)] = Sop_argb1555_TEX_to_Dacc,
      [DFB_PIXELFORMAT_INDEX(DSPF_RGB16)]    = Sop_rgb16_TEX_to_Dacc,
      [DFB_PIXELFORMAT_INDEX(DSPF_RGB24)]    = Sop_rgb24_TEX_to_Dacc,
@@ -7946,7 +7965,7 @@ static const GenefxFunc Dacc_modulate_mask_argb_from_PFI[DFB_NUM_PIXELFORMATS] =
 
 /********************************* misc accumulator operations ****************/
 
-static void Dacc_premultiply( GenefxState *gfxs )
+static void Dacc_premultiply_C( GenefxState *gfxs )
 {
      int                w = gfxs->length+1;
      GenefxAccumulator *D = gfxs->Dacc;
@@ -7964,6 +7983,8 @@ static void Dacc_premultiply( GenefxState *gfxs )
      }
 }
 
+static GenefxFunc Dacc_premultiply = Dacc_premultiply_C;
+
 static void Dacc_premultiply_color_alpha( GenefxState *gfxs )
 {
      int                w  = gfxs->length+1;
@@ -8263,7 +8284,7 @@ static void Bop_argb_blend_alphachannel_src_invsrc_Aop_argb8565( GenefxState *gf
      }
 }
 
-static const GenefxFunc Bop_argb_blend_alphachannel_src_invsrc_Aop_PFI[DFB_NUM_PIXELFORMATS] = {
+static GenefxFunc Bop_argb_blend_alphachannel_src_invsrc_Aop_PFI[DFB_NUM_PIXELFORMATS] = {
      [DFB_PIXELFORMAT_INDEX(DSPF_ARGB1555)] = NULL,
      [DFB_PIXELFORMAT_INDEX(DSPF_RGB16)]    = Bop_argb_blend_alphachannel_src_invsrc_Aop_rgb16,
      [DFB_PIXELFORMAT_INDEX(DSPF_RGB24)]    = NULL,
@@ -8428,7 +8449,7 @@ static void Bop_argb_blend_alphachannel_one_invsrc_premultiply_Aop_argb( GenefxS
 #undef SET_PIXEL_DUFFS_DEVICE
 #undef SET_PIXEL
 
-static const GenefxFunc Bop_argb_blend_alphachannel_one_invsrc_premultiply_Aop_PFI[DFB_NUM_PIXELFORMATS] = {
+static GenefxFunc Bop_argb_blend_alphachannel_one_invsrc_premultiply_Aop_PFI[DFB_NUM_PIXELFORMATS] = {
      [DFB_PIXELFORMAT_INDEX(DSPF_ARGB1555)] = NULL,
      [DFB_PIXELFORMAT_INDEX(DSPF_RGB16)]    = NULL,
      [DFB_PIXELFORMAT_INDEX(DSPF_RGB24)]    = NULL,
@@ -8473,6 +8494,123 @@ static const GenefxFunc Bop_argb_blend_alphachannel_one_invsrc_premultiply_Aop_P
 
 /**********************************************************************************************************************/
 
+/*
+ * Fused blending of ARGB sources.
+ *
+ * Does the same as the accumulator chain built by gAcquireSetup() for
+ * DSBLIT_BLEND_ALPHACHANNEL with DSBF_SRCALPHA/DSBF_INVSRCALPHA, or with
+ * DSBF_ONE/DSBF_INVSRCALPHA plus DSBLIT_SRC_PREMULTIPLY, optionally combined
+ * with DSBLIT_COLORIZE and/or DSBLIT_BLEND_COLORALPHA, but in a single pass
+ * and without touching the accumulator buffers. Resulting colors are identical.
+ *
+ * The less precise functions above are still preferred for the cases they
+ * cover, unless gInit_SSE2() replaced them.
+ */
+
+#define FUSED_COLORIZE     0x1  /* DSBLIT_COLORIZE */
+#define FUSED_COLORALPHA   0x2  /* DSBLIT_BLEND_COLORALPHA */
+#define FUSED_PREMULTIPLY  0x4  /* DSBLIT_SRC_PREMULTIPLY with DSBF_ONE instead of DSBF_SRCALPHA */
+
+#define FUSED_NUM          8
+
+static __inline__ __attribute__((always_inline)) u32
+blend_argb_fused( u32 s, u32 d, const GenefxAccumulator *Cacc, const int fused, const bool dst_alpha )
+{
+     u32 sa = s >> 24;
+     u32 srb, sag, drb, dag;
+     u32 inv;
+
+     /* opaque pixels just replace the destination */
+     if (!(fused & (FUSED_COLORALPHA | FUSED_COLORIZE)) && sa == 0xff)
+          return s;
+
+     /* Dacc_modulation[] */
+     if (fused & FUSED_COLORALPHA)
+          sa = (Cacc->RGB.a * sa) >> 8;
+
+     if (fused & FUSED_COLORIZE) {
+          srb = (((Cacc->RGB.r * ((s >> 16) & 0xff)) >> 8) << 16) |
+                 ((Cacc->RGB.b * ( s        & 0xff)) >> 8);
+          sag =  ((Cacc->RGB.g * ((s >>  8) & 0xff)) >> 8) | (sa << 16);
+     }
+     else {
+          srb = s & 0x00ff00ff;
+          sag = ((s >> 8) & 0xff) | (sa << 16);
+     }
+
+     /*
+      * Dacc_premultiply or Xacc_blend_srcalpha on the source, both scale by
+      * (sa + 1), the latter also the alpha. Then Xacc_blend_invsrcalpha on the
+      * destination and Sacc_add_to_Dacc, which can not exceed 0xff for these
+      * blend functions. Two channels are processed at once, their products
+      * are below 0x10000 and can not overlap.
+      */
+     srb = ((srb * (sa + 1)) >> 8) & 0x00ff00ff;
+     sag = ((sag * (sa + 1)) >> 8) & 0x00ff00ff;
+
+     if (fused & FUSED_PREMULTIPLY)
+          sag = (sag & 0xff) | (sa << 16);
+
+     inv = 0x100 - sa;
+
+     drb = (((d       & 0x00ff00ff) * inv) >> 8) & 0x00ff00ff;
+     dag = ((((d >> 8) & 0x00ff00ff) * inv) >> 8) & 0x00ff00ff;
+
+     if (!dst_alpha)
+          return 0xff000000 | (srb + drb) | (((sag + dag) << 8) & 0x0000ff00);
+
+     return (srb + drb) | ((sag + dag) << 8);
+}
+
+/* ARGB */
+#define DST_TYPE u32
+#define DST_ALPHA true
+#define DST_TO_ARGB( d ) (d)
+#define ARGB_TO_DST( p ) (p)
+#define Bop_argb_OP_Aop_PFI( op ) Bop_argb_##op##_Aop_argb
+#include "template_blend_argb.h"
+
+/* RGB32 */
+#define DST_TYPE u32
+#define DST_ALPHA false
+#define DST_TO_ARGB( d ) (d)
+#define ARGB_TO_DST( p ) (p)
+#define Bop_argb_OP_Aop_PFI( op ) Bop_argb_##op##_Aop_rgb32
+#include "template_blend_argb.h"
+
+/* RGB16 */
+#define DST_TYPE u16
+#define DST_ALPHA false
+#define DST_TO_ARGB( d ) (0xff000000                              | \
+                          (EXPAND_5to8( (d) >> 11         ) << 16) | \
+                          (EXPAND_6to8( ((d) >> 5) & 0x3f ) <<  8) | \
+                          (EXPAND_5to8( (d) & 0x1f        )      ))
+#define ARGB_TO_DST( p ) PIXEL_RGB16( ((p) >> 16) & 0xff, ((p) >> 8) & 0xff, (p) & 0xff )
+#define Bop_argb_OP_Aop_PFI( op ) Bop_argb_##op##_Aop_rgb16
+#include "template_blend_argb.h"
+
+#define BLEND_FUSED_FUNCS( dst )                                                                                              \
+     {                                                                                                                        \
+          [0]                                                     = Bop_argb_blend_srcalpha_Aop_##dst,                        \
+          [FUSED_COLORIZE]                                        = Bop_argb_blend_srcalpha_colorize_Aop_##dst,               \
+          [FUSED_COLORALPHA]                                      = Bop_argb_blend_srcalpha_coloralpha_Aop_##dst,             \
+          [FUSED_COLORIZE | FUSED_COLORALPHA]                     = Bop_argb_blend_srcalpha_colorize_coloralpha_Aop_##dst,    \
+          [FUSED_PREMULTIPLY]                                     = Bop_argb_blend_premultiply_Aop_##dst,                     \
+          [FUSED_PREMULTIPLY | FUSED_COLORIZE]                    = Bop_argb_blend_premultiply_colorize_Aop_##dst,            \
+          [FUSED_PREMULTIPLY | FUSED_COLORALPHA]                  = Bop_argb_blend_premultiply_coloralpha_Aop_##dst,          \
+          [FUSED_PREMULTIPLY | FUSED_COLORIZE | FUSED_COLORALPHA] = Bop_argb_blend_premultiply_colorize_coloralpha_Aop_##dst, \
+     }
+
+static GenefxFunc Bop_argb_blend_fused_Aop_PFI[DFB_NUM_PIXELFORMATS][FUSED_NUM] = {
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB16)]    = BLEND_FUSED_FUNCS( rgb16 ),
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB32)]    = BLEND_FUSED_FUNCS( rgb32 ),
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]     = BLEND_FUSED_FUNCS( argb ),
+};
+
+#undef BLEND_FUSED_FUNCS
+
+/**********************************************************************************************************************/
+
 /* A8/A1 to YCbCr */
 static void Dacc_Alpha_to_YCbCr( GenefxState *gfxs )
 {
@@ -8569,6 +8707,35 @@ static bool has_mmx( void )
 }
 #endif
 
+#ifdef USE_SSE2
+static bool has_sse2( void )
+{
+     __builtin_cpu_init();
+
+     return __builtin_cpu_supports( "sse2" );
+}
+#endif
+
+#ifdef USE_AVX2
+static bool has_avx2( void )
+{
+     __builtin_cpu_init();
+
+     return __builtin_cpu_supports( "avx2" );
+}
+#endif
+
+#ifdef USE_NEON
+static bool has_neon( void )
+{
+#if defined(__aarch64__) || !defined(HAVE_GETAUXVAL)
+     return true;
+#else
+     return (getauxval( AT_HWCAP ) & HWCAP_NEON) ? true : false;
+#endif
+}
+#endif
+
 void gGetDriverInfo( GraphicsDriverInfo *info )
 {
      snprintf( info->name,
@@ -8601,6 +8768,46 @@ void gGetDriverInfo( GraphicsDriverInfo *info )
      }
 #endif
 
+#ifdef USE_SSE2
+     if (has_sse2()) {
+          if (!dfb_config->simd) {
+               D_INFO( "DirectFB/Genefx: SSE2 detected, but disabled by option 'no-simd'\n");
+          }
+          else {
+               gInit_SSE2();
+
+#ifdef USE_AVX2
+               if (has_avx2())
+                    gInit_AVX2();
+#endif
+
+               snprintf( info->name, DFB_GRAPHICS_DRIVER_INFO_NAME_LENGTH,
+                         "%s Software Driver", use_simd );
+
+               D_INFO( "DirectFB/Genefx: %s detected and enabled\n", use_simd );
+          }
+     }
+#endif
+
+#ifdef USE_NEON
+     if (has_neon()) {
+          if (!dfb_config->simd) {
+               D_INFO( "DirectFB/Genefx: NEON detected, but disabled by option 'no-simd'\n");
+          }
+          else {
+               gInit_NEON();
+
+               snprintf( info->name, DFB_GRAPHICS_DRIVER_INFO_NAME_LENGTH,
+                         "NEON Software Driver" );
+
+               D_INFO( "DirectFB/Genefx: NEON detected and enabled\n" );
+          }
+     }
+     else {
+          D_INFO( "DirectFB/Genefx: No NEON detected\n" );
+     }
+#endif
+
      snprintf( info->vendor, DFB_GRAPHICS_DRIVER_INFO_VENDOR_LENGTH, "directfb.org" );
 
      info->version.major = 0;
@@ -8613,7 +8820,7 @@ void gGetDeviceInfo( GraphicsDeviceInfo *info )
                "Software Rasterizer" );
 
      snprintf( info->vendor, DFB_GRAPHICS_DEVICE_INFO_VENDOR_LENGTH,
-               use_mmx ? "MMX" : "Generic" );
+               use_simd ? use_simd : use_mmx ? "MMX" : "Generic" );
 
      info->caps.accel    = DFXL_NONE;
      info->caps.flags    = 0;
@@ -8899,6 +9106,197 @@ gAcquireUnlockBuffers( CardState *state )
      return DFB_OK;
 }
 
+/**********************************************************************************************************************/
+
+/*
+ * Cache of resolved function chains
+ *
+ * Applications usually switch between a handful of state combinations only, e.g. text, icons and opaque
+ * fills. The function chain and the constants computed by gAcquireSetup() only depend on the state values
+ * below, so the last SETUP_CACHE_SIZE results are kept and reused, replacing the least recently used one.
+ *
+ * States involving palettes are not cached, as the chain depends on the palette contents.
+ */
+
+#define SETUP_CACHE_SIZE 32
+
+typedef struct {
+     DFBAccelerationMask      accel;
+
+     DFBSurfacePixelFormat    dst_format;
+     DFBSurfacePixelFormat    src_format;
+     DFBSurfacePixelFormat    mask_format;
+
+     DFBSurfaceCapabilities   dst_caps;
+     DFBSurfaceCapabilities   src_caps;
+     DFBSurfaceCapabilities   mask_caps;
+
+     DFBSurfaceDrawingFlags   drawingflags;
+     DFBSurfaceBlittingFlags  blittingflags;
+     DFBSurfaceBlendFunction  src_blend;
+     DFBSurfaceBlendFunction  dst_blend;
+
+     DFBColor                 color;
+     u32                      src_colorkey;
+     u32                      dst_colorkey;
+} GenefxSetupKey;
+
+typedef struct {
+     GenefxSetupKey           key;
+     u32                      hash;
+     u64                      stamp;     /* last use, zero if unused */
+
+     GenefxFunc               funcs[32];
+
+     DFBColor                 color;
+     u32                      Cop;
+     u8                       YCop;
+     u8                       CbCop;
+     u8                       CrCop;
+     u32                      Dkey;
+     u32                      Skey;
+     GenefxAccumulator        Cacc;
+     GenefxAccumulator        SCacc;
+     int                      Astep;
+     int                      Bstep;
+     int                      Ostep;
+     bool                     need_accumulator;
+     bool                     Sop_is_Bop;
+} GenefxSetupCacheEntry;
+
+static GenefxSetupCacheEntry setup_cache[SETUP_CACHE_SIZE];
+static u64                   setup_cache_stamp;
+static DirectMutex           setup_cache_lock = DIRECT_MUTEX_INITIALIZER(setup_cache_lock);
+
+static bool
+setup_cache_key( const CardState *state, DFBAccelerationMask accel, GenefxSetupKey *key, u32 *ret_hash )
+{
+     const u32    *words = (const u32*) key;
+     u32           hash  = 2166136261u;
+     unsigned int  i;
+
+     if (DFB_PIXELFORMAT_IS_INDEXED( state->destination->config.format ))
+          return false;
+
+     /* padding has to be zero for hashing and comparison */
+     memset( key, 0, sizeof(GenefxSetupKey) );
+
+     key->accel        = accel;
+     key->dst_format   = state->destination->config.format;
+     key->dst_caps     = state->destination->config.caps;
+     key->drawingflags = state->drawingflags;
+     key->src_blend    = state->src_blend;
+     key->dst_blend    = state->dst_blend;
+     key->color        = state->color;
+     key->dst_colorkey = state->dst_colorkey;
+
+     if (DFB_BLITTING_FUNCTION( accel )) {
+          if (DFB_PIXELFORMAT_IS_INDEXED( state->source->config.format ) ||
+              (state->blittingflags & DSBLIT_INDEX_TRANSLATION))
+               return false;
+
+          key->src_format    = state->source->config.format;
+          key->src_caps      = state->source->config.caps;
+          key->blittingflags = state->blittingflags;
+          key->src_colorkey  = state->src_colorkey;
+
+          if (state->blittingflags & (DSBLIT_SRC_MASK_ALPHA | DSBLIT_SRC_MASK_COLOR)) {
+               key->mask_format = state->source_mask->config.format;
+               key->mask_caps   = state->source_mask->config.caps;
+          }
+     }
+
+     for (i=0; i<sizeof(GenefxSetupKey)/4; i++)
+          hash = (hash ^ words[i]) * 16777619u;
+
+     *ret_hash = hash;
+
+     return true;
+}
+
+static bool
+setup_cache_fetch( GenefxState *gfxs, const GenefxSetupKey *key, u32 hash )
+{
+     int i;
+
+     direct_mutex_lock( &setup_cache_lock );
+
+     for (i=0; i<SETUP_CACHE_SIZE; i++) {
+          GenefxSetupCacheEntry *entry = &setup_cache[i];
+
+          if (entry->stamp && entry->hash == hash && !memcmp( &entry->key, key, sizeof(GenefxSetupKey) )) {
+               entry->stamp = ++setup_cache_stamp;
+
+               direct_memcpy( gfxs->funcs, entry->funcs, sizeof(gfxs->funcs) );
+
+               gfxs->color            = entry->color;
+               gfxs->Cop              = entry->Cop;
+               gfxs->YCop             = entry->YCop;
+               gfxs->CbCop            = entry->CbCop;
+               gfxs->CrCop            = entry->CrCop;
+               gfxs->Dkey             = entry->Dkey;
+               gfxs->Skey             = entry->Skey;
+               gfxs->Cacc             = entry->Cacc;
+               gfxs->SCacc            = entry->SCacc;
+               gfxs->Astep            = entry->Astep;
+               gfxs->Bstep            = entry->Bstep;
+               gfxs->Ostep            = entry->Ostep;
+               gfxs->need_accumulator = entry->need_accumulator;
+
+               if (entry->Sop_is_Bop)
+                    gfxs->Sop = gfxs->Bop;
+
+               direct_mutex_unlock( &setup_cache_lock );
+
+               return true;
+          }
+     }
+
+     direct_mutex_unlock( &setup_cache_lock );
+
+     return false;
+}
+
+static void
+setup_cache_store( const GenefxState *gfxs, const GenefxSetupKey *key, u32 hash )
+{
+     int                    i;
+     GenefxSetupCacheEntry *entry = &setup_cache[0];
+
+     direct_mutex_lock( &setup_cache_lock );
+
+     /* pick an unused or the least recently used entry */
+     for (i=1; i<SETUP_CACHE_SIZE && entry->stamp; i++) {
+          if (setup_cache[i].stamp < entry->stamp)
+               entry = &setup_cache[i];
+     }
+
+     entry->key   = *key;
+     entry->hash  = hash;
+     entry->stamp = ++setup_cache_stamp;
+
+     direct_memcpy( entry->funcs, gfxs->funcs, sizeof(entry->funcs) );
+
+     entry->color            = gfxs->color;
+     entry->Cop              = gfxs->Cop;
+     entry->YCop             = gfxs->YCop;
+     entry->CbCop            = gfxs->CbCop;
+     entry->CrCop            = gfxs->CrCop;
+     entry->Dkey             = gfxs->Dkey;
+     entry->Skey             = gfxs->Skey;
+     entry->Cacc             = gfxs->Cacc;
+     entry->SCacc            = gfxs->SCacc;
+     entry->Astep            = gfxs->Astep;
+     entry->Bstep            = gfxs->Bstep;
+     entry->Ostep            = gfxs->Ostep;
+     entry->need_accumulator = gfxs->need_accumulator;
+     entry->Sop_is_Bop       = (gfxs->Sop == gfxs->Bop);
+
+     direct_mutex_unlock( &setup_cache_lock );
+}
+
+/**********************************************************************************************************************/
+
 bool
 gAcquireSetup( CardState *state, DFBAccelerationMask accel )
 {
@@ -8912,7 +9310,10 @@ gAcquireSetup( CardState *state, DFBAccelerationMask accel )
      DFBColor     color       = state->color;
      bool         src_ycbcr   = false;
      bool         dst_ycbcr   = false;
+     bool         cacheable;
+     u32          cache_hash  = 0;
 
+     GenefxSetupKey           cache_key;
      DFBSurfaceBlittingFlags  simpld_blittingflags = state->blittingflags;
 
      dfb_simplify_blittingflags( &simpld_blittingflags );
@@ -9056,6 +9457,12 @@ gAcquireSetup( CardState *state, DFBAccelerationMask accel )
           }
      }
 
+     /* everything below only depends on the state values in the key */
+     cacheable = setup_cache_key( state, accel, &cache_key, &cache_hash );
+
+     if (cacheable && setup_cache_fetch( gfxs, &cache_key, cache_hash ))
+          goto out;
+
      /* premultiply source (color) */
      if (DFB_DRAWING_FUNCTION(accel) && (state->drawingflags & DSDRAW_SRC_PREMULTIPLY)) {
           u16 ca = color.a + 1;
@@ -9543,6 +9950,27 @@ gAcquireSetup( CardState *state, DFBAccelerationMask accel )
                          break;
                     }
                }
+               if ((simpld_blittingflags & ~(DSBLIT_COLORIZE | DSBLIT_BLEND_COLORALPHA |
+                                             DSBLIT_SRC_PREMULTIPLY)) == DSBLIT_BLEND_ALPHACHANNEL &&
+                   state->src_blend == ((simpld_blittingflags & DSBLIT_SRC_PREMULTIPLY) ? DSBF_ONE : DSBF_SRCALPHA) &&
+                   state->dst_blend == DSBF_INVSRCALPHA &&
+                   gfxs->src_format == DSPF_ARGB)
+               {
+                    int fused = ((simpld_blittingflags & DSBLIT_COLORIZE)         ? FUSED_COLORIZE    : 0) |
+                                ((simpld_blittingflags & DSBLIT_BLEND_COLORALPHA) ? FUSED_COLORALPHA  : 0) |
+                                ((simpld_blittingflags & DSBLIT_SRC_PREMULTIPLY)  ? FUSED_PREMULTIPLY : 0);
+
+                    if (Bop_argb_blend_fused_Aop_PFI[dst_pfi][fused]) {
+                         /* same modulation values as used by the accumulator chain */
+                         gfxs->Cacc.RGB.a = color.a + 1;
+                         gfxs->Cacc.RGB.r = color.r + 1;
+                         gfxs->Cacc.RGB.g = color.g + 1;
+                         gfxs->Cacc.RGB.b = color.b + 1;
+
+                         *funcs++ = Bop_argb_blend_fused_Aop_PFI[dst_pfi][fused];
+                         break;
+                    }
+               }
                if (((simpld_blittingflags == (DSBLIT_COLORIZE | DSBLIT_BLEND_ALPHACHANNEL |
                                               DSBLIT_SRC_PREMULTIPLY) &&
                      state->src_blend == DSBF_ONE)
@@ -9949,7 +10377,15 @@ gAcquireSetup( CardState *state, DFBAccelerationMask accel )
 
      *funcs = NULL;
 
-     // FIXME
+     if (cacheable)
+          setup_cache_store( gfxs, &cache_key, cache_hash );
+
+out:
+     /*
+      * Remember the serials of the surfaces locked above (sources only when locked for blitting) and
+      * validate the clip against the destination size. This does not depend on the function chain,
+      * so a cached chain needs it as well.
+      */
      dfb_state_update( state, state->flags & CSF_SOURCE_LOCKED );
 
      return true;
@@ -10047,6 +10483,173 @@ static void gInit_MMX( void )
 #endif
 
 
+#ifdef USE_SSE2
+
+#include "generic_sse2.h"
+
+/*
+ * patches function pointers to SSE2 functions
+ */
+static void gInit_SSE2( void )
+{
+     int i;
+
+     use_simd = "SSE2";
+
+/********************************* Cop_to_Aop_PFI ********************************/
+     Cop_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB16)] = Cop_to_Aop_16_SSE2;
+     Cop_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Cop_to_Aop_32_SSE2;
+     Cop_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Cop_to_Aop_32_SSE2;
+     Cop_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_AiRGB)] = Cop_to_Aop_32_SSE2;
+/********************************* Sop_PFI_to_Dacc *******************************/
+     Sop_PFI_to_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_RGB16)] = Sop_rgb16_to_Dacc_SSE2;
+     Sop_PFI_to_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Sop_rgb32_to_Dacc_SSE2;
+     Sop_PFI_to_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Sop_argb_to_Dacc_SSE2;
+/********************************* Sacc_to_Aop_PFI *******************************/
+     Sacc_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB16)] = Sacc_to_Aop_rgb16_SSE2;
+     Sacc_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Sacc_to_Aop_rgb32_SSE2;
+     Sacc_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Sacc_to_Aop_argb_SSE2;
+/********************************* Xacc_blend ************************************/
+     Xacc_blend[DSBF_SRCALPHA-1]    = Xacc_blend_srcalpha_SSE2;
+     Xacc_blend[DSBF_INVSRCALPHA-1] = Xacc_blend_invsrcalpha_SSE2;
+/********************************* Dacc_modulation *******************************/
+     Dacc_modulation[DSBLIT_BLEND_ALPHACHANNEL |
+                     DSBLIT_BLEND_COLORALPHA]   = Dacc_modulate_alpha_SSE2;
+     Dacc_modulation[DSBLIT_COLORIZE]           = Dacc_modulate_rgb_SSE2;
+     Dacc_modulation[DSBLIT_COLORIZE |
+                     DSBLIT_BLEND_ALPHACHANNEL] = Dacc_modulate_rgb_SSE2;
+     Dacc_modulation[DSBLIT_BLEND_ALPHACHANNEL |
+                     DSBLIT_BLEND_COLORALPHA |
+                     DSBLIT_COLORIZE]           = Dacc_modulate_argb_SSE2;
+/********************************* misc accumulator operations *******************/
+     Dacc_premultiply  = Dacc_premultiply_SSE2;
+     SCacc_add_to_Dacc = SCacc_add_to_Dacc_SSE2;
+     Sacc_add_to_Dacc  = Sacc_add_to_Dacc_SSE2;
+/********************************* Bop_argb_blend_*_Aop_PFI **********************/
+     Bop_argb_blend_alphachannel_src_invsrc_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB16)] = Bop_argb_blend_srcalpha_Aop_rgb16_SSE2;
+     Bop_argb_blend_alphachannel_src_invsrc_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Bop_argb_blend_srcalpha_Aop_rgb32_SSE2;
+
+     Bop_argb_blend_alphachannel_one_invsrc_premultiply_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Bop_argb_blend_premultiply_Aop_rgb32_SSE2;
+     Bop_argb_blend_alphachannel_one_invsrc_premultiply_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Bop_argb_blend_premultiply_Aop_argb_SSE2;
+
+     for (i = 0; i < FUSED_NUM; i++) {
+          Bop_argb_blend_fused_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB16)][i] = Bop_argb_blend_fused_Aop_rgb16_SSE2[i];
+          Bop_argb_blend_fused_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)][i] = Bop_argb_blend_fused_Aop_rgb32_SSE2[i];
+          Bop_argb_blend_fused_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)][i]  = Bop_argb_blend_fused_Aop_argb_SSE2[i];
+     }
+/********************************* smooth scaling spans **************************/
+     gStretchSpans.hline_32     = stretch_hline_32_SSE2;
+     gStretchSpans.vline_32     = stretch_vline_32_SSE2;
+     gStretchSpans.area_line_32 = stretch_area_line_32_SSE2;
+     gStretchSpans.area_span_32 = stretch_area_span_32_SSE2;
+}
+
+#endif
+
+
+#ifdef USE_AVX2
+
+#include "generic_avx2.h"
+
+/*
+ * patches function pointers to AVX2 functions, after gInit_SSE2()
+ */
+static void gInit_AVX2( void )
+{
+     use_simd = "AVX2";
+
+/********************************* Cop_to_Aop_PFI ********************************/
+     Cop_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Cop_to_Aop_32_AVX2;
+     Cop_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Cop_to_Aop_32_AVX2;
+     Cop_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_AiRGB)] = Cop_to_Aop_32_AVX2;
+/********************************* Sop_PFI_to_Dacc *******************************/
+     Sop_PFI_to_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Sop_rgb32_to_Dacc_AVX2;
+     Sop_PFI_to_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Sop_argb_to_Dacc_AVX2;
+/********************************* Sop_PFI_TEX_to_Dacc ***************************/
+     Sop_PFI_TEX_to_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Sop_rgb32_TEX_to_Dacc_AVX2;
+     Sop_PFI_TEX_to_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Sop_argb_TEX_to_Dacc_AVX2;
+/********************************* Bop_PFI_TEX_to_Aop_PFI ************************/
+     Bop_PFI_TEX_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Bop_32_TEX_to_Aop_AVX2;
+     Bop_PFI_TEX_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Bop_32_TEX_to_Aop_AVX2;
+     Bop_PFI_TEX_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ABGR)]  = Bop_32_TEX_to_Aop_AVX2;
+     Bop_PFI_TEX_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_AiRGB)] = Bop_32_TEX_to_Aop_AVX2;
+     Bop_PFI_TEX_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_AYUV)]  = Bop_32_TEX_to_Aop_AVX2;
+/********************************* Sacc_to_Aop_PFI *******************************/
+     Sacc_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Sacc_to_Aop_rgb32_AVX2;
+     Sacc_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Sacc_to_Aop_argb_AVX2;
+/********************************* Xacc_blend ************************************/
+     Xacc_blend[DSBF_SRCALPHA-1]    = Xacc_blend_srcalpha_AVX2;
+     Xacc_blend[DSBF_INVSRCALPHA-1] = Xacc_blend_invsrcalpha_AVX2;
+/********************************* Dacc_modulation *******************************/
+     Dacc_modulation[DSBLIT_BLEND_ALPHACHANNEL |
+                     DSBLIT_BLEND_COLORALPHA]   = Dacc_modulate_alpha_AVX2;
+     Dacc_modulation[DSBLIT_COLORIZE]           = Dacc_modulate_rgb_AVX2;
+     Dacc_modulation[DSBLIT_COLORIZE |
+                     DSBLIT_BLEND_ALPHACHANNEL] = Dacc_modulate_rgb_AVX2;
+     Dacc_modulation[DSBLIT_BLEND_ALPHACHANNEL |
+                     DSBLIT_BLEND_COLORALPHA |
+                     DSBLIT_COLORIZE]           = Dacc_modulate_argb_AVX2;
+/********************************* misc accumulator operations *******************/
+     Dacc_premultiply  = Dacc_premultiply_AVX2;
+     Sacc_add_to_Dacc  = Sacc_add_to_Dacc_AVX2;
+/********************************* smooth scaling spans **************************/
+     gStretchSpans.vline_32     = stretch_vline_32_AVX2;
+     gStretchSpans.area_line_32 = stretch_area_line_32_AVX2;
+}
+
+#endif
+
+
+#ifdef USE_NEON
+
+#include "generic_neon.h"
+
+/*
+ * patches function pointers to NEON functions
+ */
+static void gInit_NEON( void )
+{
+     use_simd = "NEON";
+
+/********************************* Cop_to_Aop_PFI ********************************/
+     Cop_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB16)] = Cop_to_Aop_16_NEON;
+     Cop_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Cop_to_Aop_32_NEON;
+     Cop_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Cop_to_Aop_32_NEON;
+     Cop_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_AiRGB)] = Cop_to_Aop_32_NEON;
+/********************************* Sop_PFI_to_Dacc *******************************/
+     Sop_PFI_to_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_RGB16)] = Sop_rgb16_to_Dacc_NEON;
+     Sop_PFI_to_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Sop_rgb32_to_Dacc_NEON;
+     Sop_PFI_to_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Sop_argb_to_Dacc_NEON;
+/********************************* Sacc_to_Aop_PFI *******************************/
+     Sacc_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB16)] = Sacc_to_Aop_rgb16_NEON;
+     Sacc_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Sacc_to_Aop_rgb32_NEON;
+     Sacc_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Sacc_to_Aop_argb_NEON;
+/********************************* Xacc_blend ************************************/
+     Xacc_blend[DSBF_SRCALPHA-1]    = Xacc_blend_srcalpha_NEON;
+     Xacc_blend[DSBF_INVSRCALPHA-1] = Xacc_blend_invsrcalpha_NEON;
+/********************************* Dacc_modulation *******************************/
+     Dacc_modulation[DSBLIT_BLEND_ALPHACHANNEL |
+                     DSBLIT_BLEND_COLORALPHA]   = Dacc_modulate_alpha_NEON;
+     Dacc_modulation[DSBLIT_COLORIZE]           = Dacc_modulate_rgb_NEON;
+     Dacc_modulation[DSBLIT_COLORIZE |
+                     DSBLIT_BLEND_ALPHACHANNEL] = Dacc_modulate_rgb_NEON;
+     Dacc_modulation[DSBLIT_BLEND_ALPHACHANNEL |
+                     DSBLIT_BLEND_COLORALPHA |
+                     DSBLIT_COLORIZE]           = Dacc_modulate_argb_NEON;
+/********************************* misc accumulator operations *******************/
+     Dacc_premultiply  = Dacc_premultiply_NEON;
+     SCacc_add_to_Dacc = SCacc_add_to_Dacc_NEON;
+     Sacc_add_to_Dacc  = Sacc_add_to_Dacc_NEON;
+/********************************* smooth scaling spans **************************/
+     gStretchSpans.hline_32     = stretch_hline_32_NEON;
+     gStretchSpans.vline_32     = stretch_vline_32_NEON;
+     gStretchSpans.area_line_32 = stretch_area_line_32_NEON;
+     gStretchSpans.area_span_32 = stretch_area_span_32_NEON;
+}
+
+#endif
+
+
 #if SIZEOF_LONG == 8
 
 #include "generic_64.h"
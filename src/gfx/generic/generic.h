@@ -187,6 +187,31 @@ typedef struct {
 
 /**********************************************************************************************************************/
 
+/*
+ * Span functions of the smooth scalers, replaced by optimized versions in gGetDriverInfo().
+ *
+ * All channels are interpolated separately, a ratio or weight of 256 (bilinear) or
+ * 32768 in total (area) selects the second/all operand(s).
+ */
+typedef struct {
+     /* dst[x] = lerp( src[offsets[x]], src[offsets[x]+1], ratios[x] ), NULL to use the generic scalers */
+     void (*hline_32)    ( u32 *dst, const u32 *src, const int *offsets, const int *ratios, int width );
+
+     /* dst[x] = lerp( top[x], bottom[x], ratio ) & mask, NULL to use the generic scalers */
+     void (*vline_32)    ( u32 *dst, const u32 *top, const u32 *bottom, int ratio, int width, u32 mask );
+
+     /* acc[x*4+c] += src[x].c * weight */
+     void (*area_line_32)( u32 *acc, const u32 *src, int weight, int width );
+
+     /* dst[x] = sum( acc[first[x]+i] / 128 * weights[n++] ) / 2^23 & mask for i < count[x] */
+     void (*area_span_32)( u32 *dst, const u32 *acc, const int *first, const int *count, const int *weights,
+                           int width, u32 mask );
+} GenefxStretchSpans;
+
+extern GenefxStretchSpans gStretchSpans;
+
+/**********************************************************************************************************************/
+
 void gGetDriverInfo( GraphicsDriverInfo *info );
 void gGetDeviceInfo( GraphicsDeviceInfo *info );
 
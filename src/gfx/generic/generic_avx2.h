@@ -0,0 +1,592 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+
+#include <immintrin.h>
+
+/*
+ * AVX2 versions of the 32 bit accumulator functions, four accumulators per
+ * register. These are installed on top of the SSE2 set, so everything not
+ * covered here (e.g. RGB16) keeps using the SSE2 routines.
+ */
+
+#define AVX2_FUNC __attribute__((target("avx2")))
+
+static inline AVX2_FUNC __m256i
+acc_alpha_AVX2( __m256i acc )
+{
+     return _mm256_shufflehi_epi16( _mm256_shufflelo_epi16( acc, 0xFF ), 0xFF );
+}
+
+static inline AVX2_FUNC __m256i
+acc_valid_AVX2( __m256i acc )
+{
+     return _mm256_cmpeq_epi16( _mm256_and_si256( acc_alpha_AVX2( acc ), _mm256_set1_epi16( (short) 0xF000 ) ),
+                                _mm256_setzero_si256() );
+}
+
+static inline AVX2_FUNC __m256i
+acc_mul_AVX2( __m256i a, __m256i b )
+{
+     __m256i lo = _mm256_mullo_epi16( a, b );
+     __m256i hi = _mm256_mulhi_epu16( a, b );
+
+     return _mm256_or_si256( _mm256_srli_epi16( lo, 8 ), _mm256_slli_epi16( hi, 8 ) );
+}
+
+static inline AVX2_FUNC __m256i
+acc_clamp_AVX2( __m256i x )
+{
+     return _mm256_min_epu16( x, _mm256_set1_epi16( 0xFF ) );
+}
+
+/* packs two registers of four accumulators into eight pixels, in order */
+static inline AVX2_FUNC __m256i
+acc_pack_AVX2( __m256i lo, __m256i hi )
+{
+     return _mm256_permute4x64_epi64( _mm256_packus_epi16( lo, hi ), 0xD8 );
+}
+
+static inline AVX2_FUNC __m256i
+acc_pack_mask_AVX2( __m256i lo, __m256i hi )
+{
+     return _mm256_permute4x64_epi64( _mm256_packs_epi16( lo, hi ), 0xD8 );
+}
+
+/********************************* Cop_to_Aop_PFI *****************************/
+
+static AVX2_FUNC void Cop_to_Aop_32_AVX2( GenefxState *gfxs )
+{
+     int      w   = gfxs->length;
+     u32     *D   = gfxs->Aop[0];
+     u32      Cop = gfxs->Cop;
+     __m256i  c;
+
+     while (w && ((long)D & 31)) {
+          *D++ = Cop;
+          --w;
+     }
+
+     c = _mm256_set1_epi32( Cop );
+
+     while (w >= 32) {
+          _mm256_store_si256( (__m256i*) D,     c );
+          _mm256_store_si256( (__m256i*) D + 1, c );
+          _mm256_store_si256( (__m256i*) D + 2, c );
+          _mm256_store_si256( (__m256i*) D + 3, c );
+
+          D += 32;
+          w -= 32;
+     }
+
+     while (w >= 8) {
+          _mm256_store_si256( (__m256i*) D, c );
+
+          D += 8;
+          w -= 8;
+     }
+
+     while (w--)
+          *D++ = Cop;
+}
+
+/********************************* Sop_PFI_to_Dacc ****************************/
+
+static inline AVX2_FUNC void
+Sop_32_to_Dacc_AVX2( GenefxState *gfxs, u32 amask )
+{
+     int                w = gfxs->length;
+     u32               *S = gfxs->Sop[0];
+     GenefxAccumulator *D = gfxs->Dacc;
+     __m128i            a = _mm_set1_epi32( amask );
+
+     while (w >= 8) {
+          __m128i s0 = _mm_or_si128( _mm_loadu_si128( (__m128i*) S ),     a );
+          __m128i s1 = _mm_or_si128( _mm_loadu_si128( (__m128i*) S + 1 ), a );
+
+          _mm256_storeu_si256( (__m256i*) &D[0], _mm256_cvtepu8_epi16( s0 ) );
+          _mm256_storeu_si256( (__m256i*) &D[4], _mm256_cvtepu8_epi16( s1 ) );
+
+          S += 8;
+          D += 8;
+          w -= 8;
+     }
+
+     while (w--) {
+          u32 s = *S++ | amask;
+
+          D->RGB.a = s >> 24;
+          D->RGB.r = (s >> 16) & 0xff;
+          D->RGB.g = (s >>  8) & 0xff;
+          D->RGB.b =  s        & 0xff;
+
+          ++D;
+     }
+}
+
+static AVX2_FUNC void Sop_argb_to_Dacc_AVX2( GenefxState *gfxs )
+{
+     if (gfxs->Ostep != 1) {
+          Sop_argb_to_Dacc( gfxs );
+          return;
+     }
+
+     Sop_32_to_Dacc_AVX2( gfxs, 0 );
+}
+
+static AVX2_FUNC void Sop_rgb32_to_Dacc_AVX2( GenefxState *gfxs )
+{
+     if (gfxs->Ostep != 1) {
+          Sop_rgb32_to_Dacc( gfxs );
+          return;
+     }
+
+     Sop_32_to_Dacc_AVX2( gfxs, 0xff000000 );
+}
+
+/********************************* Sacc_to_Aop_PFI ****************************/
+
+static inline AVX2_FUNC void
+Sacc_to_Aop_32_AVX2( GenefxState *gfxs, bool alpha )
+{
+     int                w     = gfxs->length;
+     GenefxAccumulator *S     = gfxs->Sacc;
+     u32               *D     = gfxs->Aop[0];
+     __m256i            amask = _mm256_set1_epi32( alpha ? 0 : 0xff000000 );
+
+     while (w >= 8) {
+          __m256i s0 = _mm256_loadu_si256( (__m256i*) &S[0] );
+          __m256i s1 = _mm256_loadu_si256( (__m256i*) &S[4] );
+          __m256i m  = acc_pack_mask_AVX2( acc_valid_AVX2( s0 ), acc_valid_AVX2( s1 ) );
+          __m256i p  = acc_pack_AVX2( acc_clamp_AVX2( s0 ), acc_clamp_AVX2( s1 ) );
+
+          p = _mm256_or_si256( p, amask );
+
+          if (_mm256_movemask_epi8( m ) == -1)
+               _mm256_storeu_si256( (__m256i*) D, p );
+          else
+               _mm256_storeu_si256( (__m256i*) D, _mm256_blendv_epi8( _mm256_loadu_si256( (__m256i*) D ), p, m ) );
+
+          S += 8;
+          D += 8;
+          w -= 8;
+     }
+
+     while (w--) {
+          if (!(S->RGB.a & 0xF000))
+               *D = SACC_TO_PIXEL_32( *S, alpha ? ((S->RGB.a & 0xFF00) ? 0xFF : S->RGB.a) : 0xFF );
+
+          ++S;
+          ++D;
+     }
+}
+
+static AVX2_FUNC void Sacc_to_Aop_argb_AVX2( GenefxState *gfxs )
+{
+     if (gfxs->Astep != 1) {
+          Sacc_to_Aop_argb( gfxs );
+          return;
+     }
+
+     Sacc_to_Aop_32_AVX2( gfxs, true );
+}
+
+static AVX2_FUNC void Sacc_to_Aop_rgb32_AVX2( GenefxState *gfxs )
+{
+     if (gfxs->Astep != 1) {
+          Sacc_to_Aop_rgb32( gfxs );
+          return;
+     }
+
+     Sacc_to_Aop_32_AVX2( gfxs, false );
+}
+
+/********************************* Xacc_blend *********************************/
+
+static inline AVX2_FUNC void
+Xacc_blend_alpha_AVX2( GenefxState *gfxs, bool inverse )
+{
+     int                w = gfxs->length;
+     GenefxAccumulator *X = gfxs->Xacc;
+     GenefxAccumulator *Y = gfxs->Yacc;
+     GenefxAccumulator *S = gfxs->Sacc;
+     __m256i            sa;
+     u16                Sa = 0;
+
+     if (S) {
+          __m256i base = _mm256_set1_epi16( inverse ? 0x100 : 1 );
+
+          while (w >= 4) {
+               __m256i y = _mm256_loadu_si256( (__m256i*) Y );
+
+               sa = acc_alpha_AVX2( _mm256_loadu_si256( (__m256i*) S ) );
+               sa = inverse ? _mm256_sub_epi16( base, sa ) : _mm256_add_epi16( base, sa );
+
+               _mm256_storeu_si256( (__m256i*) X, _mm256_blendv_epi8( y, acc_mul_AVX2( sa, y ), acc_valid_AVX2( y ) ) );
+
+               X += 4;
+               Y += 4;
+               S += 4;
+               w -= 4;
+          }
+     }
+     else {
+          Sa = inverse ? 0x100 - gfxs->color.a : gfxs->color.a + 1;
+          sa = _mm256_set1_epi16( Sa );
+
+          while (w >= 4) {
+               __m256i y = _mm256_loadu_si256( (__m256i*) Y );
+
+               _mm256_storeu_si256( (__m256i*) X, _mm256_blendv_epi8( y, acc_mul_AVX2( sa, y ), acc_valid_AVX2( y ) ) );
+
+               X += 4;
+               Y += 4;
+               w -= 4;
+          }
+     }
+
+     while (w--) {
+          if (!(Y->RGB.a & 0xF000)) {
+               if (S)
+                    Sa = inverse ? 0x100 - S->RGB.a : S->RGB.a + 1;
+
+               X->RGB.r = (Sa * Y->RGB.r) >> 8;
+               X->RGB.g = (Sa * Y->RGB.g) >> 8;
+               X->RGB.b = (Sa * Y->RGB.b) >> 8;
+               X->RGB.a = (Sa * Y->RGB.a) >> 8;
+          } else
+               *X = *Y;
+
+          ++X;
+          ++Y;
+
+          if (S)
+               ++S;
+     }
+}
+
+static AVX2_FUNC void Xacc_blend_srcalpha_AVX2( GenefxState *gfxs )
+{
+     Xacc_blend_alpha_AVX2( gfxs, false );
+}
+
+static AVX2_FUNC void Xacc_blend_invsrcalpha_AVX2( GenefxState *gfxs )
+{
+     Xacc_blend_alpha_AVX2( gfxs, true );
+}
+
+/********************************* Dacc_modulation ****************************/
+
+static inline AVX2_FUNC void
+Dacc_modulate_AVX2( GenefxState *gfxs, u16 a, u16 r, u16 g, u16 b )
+{
+     int                w = gfxs->length;
+     GenefxAccumulator *D = gfxs->Dacc;
+     __m256i            c = _mm256_set_epi16( a, r, g, b, a, r, g, b, a, r, g, b, a, r, g, b );
+
+     while (w >= 4) {
+          __m256i d = _mm256_loadu_si256( (__m256i*) D );
+
+          _mm256_storeu_si256( (__m256i*) D, _mm256_blendv_epi8( d, acc_mul_AVX2( c, d ), acc_valid_AVX2( d ) ) );
+
+          D += 4;
+          w -= 4;
+     }
+
+     while (w--) {
+          if (!(D->RGB.a & 0xF000)) {
+               D->RGB.a = (a * D->RGB.a) >> 8;
+               D->RGB.r = (r * D->RGB.r) >> 8;
+               D->RGB.g = (g * D->RGB.g) >> 8;
+               D->RGB.b = (b * D->RGB.b) >> 8;
+          }
+
+          ++D;
+     }
+}
+
+static AVX2_FUNC void Dacc_modulate_alpha_AVX2( GenefxState *gfxs )
+{
+     Dacc_modulate_AVX2( gfxs, gfxs->Cacc.RGB.a, 0x100, 0x100, 0x100 );
+}
+
+static AVX2_FUNC void Dacc_modulate_rgb_AVX2( GenefxState *gfxs )
+{
+     Dacc_modulate_AVX2( gfxs, 0x100, gfxs->Cacc.RGB.r, gfxs->Cacc.RGB.g, gfxs->Cacc.RGB.b );
+}
+
+static AVX2_FUNC void Dacc_modulate_argb_AVX2( GenefxState *gfxs )
+{
+     Dacc_modulate_AVX2( gfxs, gfxs->Cacc.RGB.a, gfxs->Cacc.RGB.r, gfxs->Cacc.RGB.g, gfxs->Cacc.RGB.b );
+}
+
+/********************************* misc accumulator operations ****************/
+
+static AVX2_FUNC void Dacc_premultiply_AVX2( GenefxState *gfxs )
+{
+     int                w   = gfxs->length;
+     GenefxAccumulator *D   = gfxs->Dacc;
+     __m256i            one = _mm256_set_epi16( 0x100, 1, 1, 1, 0x100, 1, 1, 1, 0x100, 1, 1, 1, 0x100, 1, 1, 1 );
+     __m256i            rgb = _mm256_set_epi16( 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1 );
+
+     while (w >= 4) {
+          __m256i d  = _mm256_loadu_si256( (__m256i*) D );
+          __m256i da = _mm256_add_epi16( _mm256_and_si256( acc_alpha_AVX2( d ), rgb ), one );
+
+          _mm256_storeu_si256( (__m256i*) D, _mm256_blendv_epi8( d, acc_mul_AVX2( da, d ), acc_valid_AVX2( d ) ) );
+
+          D += 4;
+          w -= 4;
+     }
+
+     while (w--) {
+          if (!(D->RGB.a & 0xF000)) {
+               u16 Da = D->RGB.a + 1;
+
+               D->RGB.r = (Da * D->RGB.r) >> 8;
+               D->RGB.g = (Da * D->RGB.g) >> 8;
+               D->RGB.b = (Da * D->RGB.b) >> 8;
+          }
+
+          ++D;
+     }
+}
+
+static AVX2_FUNC void Sacc_add_to_Dacc_AVX2( GenefxState *gfxs )
+{
+     int                w = gfxs->length;
+     GenefxAccumulator *S = gfxs->Sacc;
+     GenefxAccumulator *D = gfxs->Dacc;
+
+     while (w >= 4) {
+          __m256i d = _mm256_loadu_si256( (__m256i*) D );
+          __m256i s = _mm256_loadu_si256( (__m256i*) S );
+
+          _mm256_storeu_si256( (__m256i*) D, _mm256_blendv_epi8( d, _mm256_add_epi16( d, s ), acc_valid_AVX2( d ) ) );
+
+          D += 4;
+          S += 4;
+          w -= 4;
+     }
+
+     while (w--) {
+          if (!(D->RGB.a & 0xF000)) {
+               D->RGB.a += S->RGB.a;
+               D->RGB.r += S->RGB.r;
+               D->RGB.g += S->RGB.g;
+               D->RGB.b += S->RGB.b;
+          }
+
+          ++D;
+          ++S;
+     }
+}
+
+/********************************* smooth scaling spans ***********************/
+
+static AVX2_FUNC void
+stretch_vline_32_AVX2( u32 *dst, const u32 *top, const u32 *bottom, int ratio, int width, u32 mask )
+{
+     __m256i zero = _mm256_setzero_si256();
+     __m256i r    = _mm256_set1_epi16( ratio );
+     __m256i ir   = _mm256_set1_epi16( 256 - ratio );
+     __m256i m    = _mm256_set1_epi32( mask );
+
+     while (width >= 8) {
+          __m256i t  = _mm256_loadu_si256( (const __m256i*) top );
+          __m256i b  = _mm256_loadu_si256( (const __m256i*) bottom );
+
+          /* unpack and pack work per 128 bit lane, so the pixel order is preserved */
+          __m256i lo = _mm256_srli_epi16( _mm256_add_epi16( _mm256_mullo_epi16( _mm256_unpacklo_epi8( t, zero ), ir ),
+                                                            _mm256_mullo_epi16( _mm256_unpacklo_epi8( b, zero ), r ) ), 8 );
+          __m256i hi = _mm256_srli_epi16( _mm256_add_epi16( _mm256_mullo_epi16( _mm256_unpackhi_epi8( t, zero ), ir ),
+                                                            _mm256_mullo_epi16( _mm256_unpackhi_epi8( b, zero ), r ) ), 8 );
+
+          _mm256_storeu_si256( (__m256i*) dst, _mm256_and_si256( _mm256_packus_epi16( lo, hi ), m ) );
+
+          dst    += 8;
+          top    += 8;
+          bottom += 8;
+          width  -= 8;
+     }
+
+     if (width)
+          stretch_vline_32_SSE2( dst, top, bottom, ratio, width, mask );
+}
+
+/* adds the products of sixteen 16 bit words and w to sixteen 32 bit accumulators */
+static inline AVX2_FUNC void
+area_madd_AVX2( u32 *acc, __m256i v, __m256i w )
+{
+     __m256i lo = _mm256_mullo_epi16( v, w );
+     __m256i hi = _mm256_mulhi_epu16( v, w );
+     __m256i p0 = _mm256_unpacklo_epi16( lo, hi );     /* products 0-3 and 8-11 */
+     __m256i p1 = _mm256_unpackhi_epi16( lo, hi );     /* products 4-7 and 12-15 */
+
+     _mm256_storeu_si256( (__m256i*) (acc + 0), _mm256_add_epi32( _mm256_loadu_si256( (const __m256i*) (acc + 0) ),
+                                                                  _mm256_permute2x128_si256( p0, p1, 0x20 ) ) );
+     _mm256_storeu_si256( (__m256i*) (acc + 8), _mm256_add_epi32( _mm256_loadu_si256( (const __m256i*) (acc + 8) ),
+                                                                  _mm256_permute2x128_si256( p0, p1, 0x31 ) ) );
+}
+
+static AVX2_FUNC void
+stretch_area_line_32_AVX2( u32 *acc, const u32 *src, int weight, int width )
+{
+     __m256i w = _mm256_set1_epi16( weight );
+
+     while (width >= 8) {
+          area_madd_AVX2( acc,      _mm256_cvtepu8_epi16( _mm_loadu_si128( (const __m128i*) src ) ),       w );
+          area_madd_AVX2( acc + 16, _mm256_cvtepu8_epi16( _mm_loadu_si128( (const __m128i*) (src + 4) ) ), w );
+
+          acc   += 32;
+          src   += 8;
+          width -= 8;
+     }
+
+     if (width)
+          stretch_area_line_32_SSE2( acc, src, weight, width );
+}
+
+/********************************* texture fetch ******************************/
+
+/* source offsets (s>>16) + (t>>16) * pitch of eight consecutive pixels, advancing s and t */
+static inline AVX2_FUNC __m256i
+tex_offsets_AVX2( __m256i *s, __m256i *t, __m256i ds, __m256i dt, __m256i pitch )
+{
+     __m256i offsets = _mm256_add_epi32( _mm256_srai_epi32( *s, 16 ),
+                                         _mm256_mullo_epi32( _mm256_srai_epi32( *t, 16 ), pitch ) );
+
+     *s = _mm256_add_epi32( *s, ds );
+     *t = _mm256_add_epi32( *t, dt );
+
+     return offsets;
+}
+
+static AVX2_FUNC void Bop_32_TEX_to_Aop_AVX2( GenefxState *gfxs )
+{
+     int        w     = gfxs->length;
+     int        s     = gfxs->s;
+     int        t     = gfxs->t;
+     int        SperD = gfxs->SperD;
+     int        TperD = gfxs->TperD;
+     const u32 *S     = gfxs->Bop[0];
+     u32       *D     = gfxs->Aop[0];
+     int        sp4   = gfxs->src_pitch / 4;
+     __m256i    steps = _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 );
+     __m256i    vs    = _mm256_add_epi32( _mm256_set1_epi32( s ), _mm256_mullo_epi32( steps, _mm256_set1_epi32( SperD ) ) );
+     __m256i    vt    = _mm256_add_epi32( _mm256_set1_epi32( t ), _mm256_mullo_epi32( steps, _mm256_set1_epi32( TperD ) ) );
+     __m256i    ds    = _mm256_set1_epi32( SperD * 8 );
+     __m256i    dt    = _mm256_set1_epi32( TperD * 8 );
+     __m256i    pitch = _mm256_set1_epi32( sp4 );
+
+     while (w >= 8) {
+          __m256i offsets = tex_offsets_AVX2( &vs, &vt, ds, dt, pitch );
+
+          _mm256_storeu_si256( (__m256i*) D, _mm256_i32gather_epi32( (const int*) S, offsets, 4 ) );
+
+          s += SperD * 8;
+          t += TperD * 8;
+          D += 8;
+          w -= 8;
+     }
+
+     while (w--) {
+          *D++ = S[(s>>16) + (t>>16) * sp4];
+
+          s += SperD;
+          t += TperD;
+     }
+}
+
+static inline AVX2_FUNC void
+Sop_32_TEX_to_Dacc_AVX2( GenefxState *gfxs, u32 amask )
+{
+     int                w     = gfxs->length;
+     int                s     = gfxs->s;
+     int                t     = gfxs->t;
+     int                SperD = gfxs->SperD;
+     int                TperD = gfxs->TperD;
+     const u32         *S     = gfxs->Sop[0];
+     GenefxAccumulator *D     = gfxs->Dacc;
+     int                sp4   = gfxs->src_pitch / 4;
+     __m256i            steps = _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 );
+     __m256i            vs    = _mm256_add_epi32( _mm256_set1_epi32( s ), _mm256_mullo_epi32( steps, _mm256_set1_epi32( SperD ) ) );
+     __m256i            vt    = _mm256_add_epi32( _mm256_set1_epi32( t ), _mm256_mullo_epi32( steps, _mm256_set1_epi32( TperD ) ) );
+     __m256i            ds    = _mm256_set1_epi32( SperD * 8 );
+     __m256i            dt    = _mm256_set1_epi32( TperD * 8 );
+     __m256i            pitch = _mm256_set1_epi32( sp4 );
+     __m256i            a     = _mm256_set1_epi32( amask );
+
+     while (w >= 8) {
+          __m256i offsets = tex_offsets_AVX2( &vs, &vt, ds, dt, pitch );
+          __m256i p       = _mm256_or_si256( _mm256_i32gather_epi32( (const int*) S, offsets, 4 ), a );
+
+          _mm256_storeu_si256( (__m256i*) &D[0], _mm256_cvtepu8_epi16( _mm256_castsi256_si128( p ) ) );
+          _mm256_storeu_si256( (__m256i*) &D[4], _mm256_cvtepu8_epi16( _mm256_extracti128_si256( p, 1 ) ) );
+
+          s += SperD * 8;
+          t += TperD * 8;
+          D += 8;
+          w -= 8;
+     }
+
+     while (w--) {
+          u32 p = S[(s>>16) + (t>>16) * sp4] | amask;
+
+          D->RGB.a = p >> 24;
+          D->RGB.r = (p >> 16) & 0xff;
+          D->RGB.g = (p >>  8) & 0xff;
+          D->RGB.b =  p        & 0xff;
+
+          ++D;
+          s += SperD;
+          t += TperD;
+     }
+}
+
+static AVX2_FUNC void Sop_argb_TEX_to_Dacc_AVX2( GenefxState *gfxs )
+{
+     if (gfxs->Ostep != 1) {
+          Sop_argb_TEX_to_Dacc( gfxs );
+          return;
+     }
+
+     Sop_32_TEX_to_Dacc_AVX2( gfxs, 0 );
+}
+
+static AVX2_FUNC void Sop_rgb32_TEX_to_Dacc_AVX2( GenefxState *gfxs )
+{
+     if (gfxs->Ostep != 1) {
+          Sop_rgb32_TEX_to_Dacc( gfxs );
+          return;
+     }
+
+     Sop_32_TEX_to_Dacc_AVX2( gfxs, 0xff000000 );
+}
@@ -0,0 +1,648 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+
+#include <arm_neon.h>
+
+/*
+ * NEON versions of the hot accumulator functions.
+ *
+ * The accumulators are de-interleaved with vld4/vst4, so each register holds
+ * one channel of eight accumulators. Entries with 0xF000 set in the alpha word
+ * are skipped by the color keying stages and have to be left untouched.
+ */
+
+/* (a * b) >> 8 truncated to 16 bit, same as the C code storing into u16 */
+static inline uint16x8_t
+acc_mul_NEON( uint16x8_t a, uint16x8_t b )
+{
+     return vcombine_u16( vshrn_n_u32( vmull_u16( vget_low_u16( a ),  vget_low_u16( b ) ),  8 ),
+                          vshrn_n_u32( vmull_u16( vget_high_u16( a ), vget_high_u16( b ) ), 8 ) );
+}
+
+/* returns 0xFFFF for accumulators that are marked by 0xF000 */
+static inline uint16x8_t
+acc_skip_NEON( uint16x8_t a )
+{
+     return vtstq_u16( a, vdupq_n_u16( 0xF000 ) );
+}
+
+static inline bool
+acc_none_NEON( uint8x8_t mask )
+{
+     return vget_lane_u64( vreinterpret_u64_u8( mask ), 0 ) == 0;
+}
+
+/********************************* Cop_to_Aop_PFI *****************************/
+
+static void Cop_to_Aop_16_NEON( GenefxState *gfxs )
+{
+     int         w   = gfxs->length;
+     u16        *D   = gfxs->Aop[0];
+     u16         Cop = gfxs->Cop;
+     uint16x8_t  c   = vdupq_n_u16( Cop );
+
+     while (w >= 32) {
+          vst1q_u16( D,      c );
+          vst1q_u16( D +  8, c );
+          vst1q_u16( D + 16, c );
+          vst1q_u16( D + 24, c );
+
+          D += 32;
+          w -= 32;
+     }
+
+     while (w >= 8) {
+          vst1q_u16( D, c );
+
+          D += 8;
+          w -= 8;
+     }
+
+     while (w--)
+          *D++ = Cop;
+}
+
+static void Cop_to_Aop_32_NEON( GenefxState *gfxs )
+{
+     int         w   = gfxs->length;
+     u32        *D   = gfxs->Aop[0];
+     u32         Cop = gfxs->Cop;
+     uint32x4_t  c   = vdupq_n_u32( Cop );
+
+     while (w >= 16) {
+          vst1q_u32( D,      c );
+          vst1q_u32( D +  4, c );
+          vst1q_u32( D +  8, c );
+          vst1q_u32( D + 12, c );
+
+          D += 16;
+          w -= 16;
+     }
+
+     while (w >= 4) {
+          vst1q_u32( D, c );
+
+          D += 4;
+          w -= 4;
+     }
+
+     while (w--)
+          *D++ = Cop;
+}
+
+/********************************* Sop_PFI_to_Dacc ****************************/
+
+static inline void
+Sop_32_to_Dacc_NEON( GenefxState *gfxs, bool alpha )
+{
+     int                w = gfxs->length;
+     u32               *S = gfxs->Sop[0];
+     GenefxAccumulator *D = gfxs->Dacc;
+
+     while (w >= 8) {
+          uint8x8x4_t  s = vld4_u8( (const u8*) S );
+          uint16x8x4_t d;
+
+          d.val[0] = vmovl_u8( s.val[0] );
+          d.val[1] = vmovl_u8( s.val[1] );
+          d.val[2] = vmovl_u8( s.val[2] );
+          d.val[3] = alpha ? vmovl_u8( s.val[3] ) : vdupq_n_u16( 0xff );
+
+          vst4q_u16( (u16*) D, d );
+
+          S += 8;
+          D += 8;
+          w -= 8;
+     }
+
+     while (w--) {
+          u32 s = *S++;
+
+          D->RGB.a = alpha ? s >> 24 : 0xff;
+          D->RGB.r = (s >> 16) & 0xff;
+          D->RGB.g = (s >>  8) & 0xff;
+          D->RGB.b =  s        & 0xff;
+
+          ++D;
+     }
+}
+
+static void Sop_argb_to_Dacc_NEON( GenefxState *gfxs )
+{
+     if (gfxs->Ostep != 1) {
+          Sop_argb_to_Dacc( gfxs );
+          return;
+     }
+
+     Sop_32_to_Dacc_NEON( gfxs, true );
+}
+
+static void Sop_rgb32_to_Dacc_NEON( GenefxState *gfxs )
+{
+     if (gfxs->Ostep != 1) {
+          Sop_rgb32_to_Dacc( gfxs );
+          return;
+     }
+
+     Sop_32_to_Dacc_NEON( gfxs, false );
+}
+
+static void Sop_rgb16_to_Dacc_NEON( GenefxState *gfxs )
+{
+     int                w = gfxs->length;
+     u16               *S = gfxs->Sop[0];
+     GenefxAccumulator *D = gfxs->Dacc;
+
+     if (gfxs->Ostep != 1) {
+          Sop_rgb16_to_Dacc( gfxs );
+          return;
+     }
+
+     while (w >= 8) {
+          uint16x8_t   s = vld1q_u16( S );
+          uint16x8_t   r = vshrq_n_u16( s, 11 );
+          uint16x8_t   g = vandq_u16( vshrq_n_u16( s, 5 ), vdupq_n_u16( 0x3f ) );
+          uint16x8_t   b = vandq_u16( s, vdupq_n_u16( 0x1f ) );
+          uint16x8x4_t d;
+
+          d.val[0] = vorrq_u16( vshlq_n_u16( b, 3 ), vshrq_n_u16( b, 2 ) );
+          d.val[1] = vorrq_u16( vshlq_n_u16( g, 2 ), vshrq_n_u16( g, 4 ) );
+          d.val[2] = vorrq_u16( vshlq_n_u16( r, 3 ), vshrq_n_u16( r, 2 ) );
+          d.val[3] = vdupq_n_u16( 0xff );
+
+          vst4q_u16( (u16*) D, d );
+
+          S += 8;
+          D += 8;
+          w -= 8;
+     }
+
+     while (w--) {
+          u16 s = *S++;
+
+          D->RGB.a = 0xff;
+          D->RGB.r = EXPAND_5to8( s >> 11 );
+          D->RGB.g = EXPAND_6to8( (s >> 5) & 0x3f );
+          D->RGB.b = EXPAND_5to8( s & 0x1f );
+
+          ++D;
+     }
+}
+
+/********************************* Sacc_to_Aop_PFI ****************************/
+
+#define SACC_CLAMP( x ) (((x) & 0xFF00) ? 0xFF : (x))
+
+static inline void
+Sacc_to_Aop_32_NEON( GenefxState *gfxs, bool alpha )
+{
+     int                w   = gfxs->length;
+     GenefxAccumulator *S   = gfxs->Sacc;
+     u32               *D   = gfxs->Aop[0];
+     uint16x8_t         max = vdupq_n_u16( 0xff );
+
+     while (w >= 8) {
+          uint16x8x4_t s    = vld4q_u16( (const u16*) S );
+          uint8x8_t    skip = vmovn_u16( acc_skip_NEON( s.val[3] ) );
+          uint8x8x4_t  p;
+
+          p.val[0] = vmovn_u16( vminq_u16( s.val[0], max ) );
+          p.val[1] = vmovn_u16( vminq_u16( s.val[1], max ) );
+          p.val[2] = vmovn_u16( vminq_u16( s.val[2], max ) );
+          p.val[3] = alpha ? vmovn_u16( vminq_u16( s.val[3], max ) ) : vdup_n_u8( 0xff );
+
+          if (!acc_none_NEON( skip )) {
+               uint8x8x4_t d = vld4_u8( (const u8*) D );
+
+               p.val[0] = vbsl_u8( skip, d.val[0], p.val[0] );
+               p.val[1] = vbsl_u8( skip, d.val[1], p.val[1] );
+               p.val[2] = vbsl_u8( skip, d.val[2], p.val[2] );
+               p.val[3] = vbsl_u8( skip, d.val[3], p.val[3] );
+          }
+
+          vst4_u8( (u8*) D, p );
+
+          S += 8;
+          D += 8;
+          w -= 8;
+     }
+
+     while (w--) {
+          if (!(S->RGB.a & 0xF000))
+               *D = PIXEL_ARGB( alpha ? SACC_CLAMP( S->RGB.a ) : 0xFF,
+                                SACC_CLAMP( S->RGB.r ), SACC_CLAMP( S->RGB.g ), SACC_CLAMP( S->RGB.b ) );
+
+          ++S;
+          ++D;
+     }
+}
+
+static void Sacc_to_Aop_argb_NEON( GenefxState *gfxs )
+{
+     if (gfxs->Astep != 1) {
+          Sacc_to_Aop_argb( gfxs );
+          return;
+     }
+
+     Sacc_to_Aop_32_NEON( gfxs, true );
+}
+
+static void Sacc_to_Aop_rgb32_NEON( GenefxState *gfxs )
+{
+     if (gfxs->Astep != 1) {
+          Sacc_to_Aop_rgb32( gfxs );
+          return;
+     }
+
+     Sacc_to_Aop_32_NEON( gfxs, false );
+}
+
+static void Sacc_to_Aop_rgb16_NEON( GenefxState *gfxs )
+{
+     int                w   = gfxs->length;
+     GenefxAccumulator *S   = gfxs->Sacc;
+     u16               *D   = gfxs->Aop[0];
+     uint16x8_t         max = vdupq_n_u16( 0xff );
+
+     if (gfxs->Astep != 1) {
+          Sacc_to_Aop_rgb16( gfxs );
+          return;
+     }
+
+     while (w >= 8) {
+          uint16x8x4_t s    = vld4q_u16( (const u16*) S );
+          uint16x8_t   skip = acc_skip_NEON( s.val[3] );
+          uint16x8_t   r    = vandq_u16( vminq_u16( s.val[2], max ), vdupq_n_u16( 0xF8 ) );
+          uint16x8_t   g    = vandq_u16( vminq_u16( s.val[1], max ), vdupq_n_u16( 0xFC ) );
+          uint16x8_t   b    = vshrq_n_u16( vminq_u16( s.val[0], max ), 3 );
+          uint16x8_t   p;
+
+          p = vorrq_u16( vorrq_u16( vshlq_n_u16( r, 8 ), vshlq_n_u16( g, 3 ) ), b );
+
+          vst1q_u16( D, vbslq_u16( skip, vld1q_u16( D ), p ) );
+
+          S += 8;
+          D += 8;
+          w -= 8;
+     }
+
+     while (w--) {
+          if (!(S->RGB.a & 0xF000))
+               *D = PIXEL_RGB16( SACC_CLAMP( S->RGB.r ), SACC_CLAMP( S->RGB.g ), SACC_CLAMP( S->RGB.b ) );
+
+          ++S;
+          ++D;
+     }
+}
+
+#undef SACC_CLAMP
+
+/********************************* Xacc_blend *********************************/
+
+static inline void
+Xacc_blend_alpha_NEON( GenefxState *gfxs, bool inverse )
+{
+     int                w  = gfxs->length;
+     GenefxAccumulator *X  = gfxs->Xacc;
+     GenefxAccumulator *Y  = gfxs->Yacc;
+     GenefxAccumulator *S  = gfxs->Sacc;
+     u16                Sa = inverse ? 0x100 - gfxs->color.a : gfxs->color.a + 1;
+     uint16x8_t         sa = vdupq_n_u16( Sa );
+
+     while (w >= 8) {
+          uint16x8x4_t y    = vld4q_u16( (const u16*) Y );
+          uint16x8_t   skip = acc_skip_NEON( y.val[3] );
+          uint16x8x4_t x;
+
+          if (S) {
+               uint16x8x4_t s = vld4q_u16( (const u16*) S );
+
+               sa = inverse ? vsubq_u16( vdupq_n_u16( 0x100 ), s.val[3] ) : vaddq_u16( s.val[3], vdupq_n_u16( 1 ) );
+
+               S += 8;
+          }
+
+          x.val[0] = vbslq_u16( skip, y.val[0], acc_mul_NEON( sa, y.val[0] ) );
+          x.val[1] = vbslq_u16( skip, y.val[1], acc_mul_NEON( sa, y.val[1] ) );
+          x.val[2] = vbslq_u16( skip, y.val[2], acc_mul_NEON( sa, y.val[2] ) );
+          x.val[3] = vbslq_u16( skip, y.val[3], acc_mul_NEON( sa, y.val[3] ) );
+
+          vst4q_u16( (u16*) X, x );
+
+          X += 8;
+          Y += 8;
+          w -= 8;
+     }
+
+     while (w--) {
+          if (!(Y->RGB.a & 0xF000)) {
+               if (S)
+                    Sa = inverse ? 0x100 - S->RGB.a : S->RGB.a + 1;
+
+               X->RGB.r = (Sa * Y->RGB.r) >> 8;
+               X->RGB.g = (Sa * Y->RGB.g) >> 8;
+               X->RGB.b = (Sa * Y->RGB.b) >> 8;
+               X->RGB.a = (Sa * Y->RGB.a) >> 8;
+          } else
+               *X = *Y;
+
+          ++X;
+          ++Y;
+
+          if (S)
+               ++S;
+     }
+}
+
+static void Xacc_blend_srcalpha_NEON( GenefxState *gfxs )
+{
+     Xacc_blend_alpha_NEON( gfxs, false );
+}
+
+static void Xacc_blend_invsrcalpha_NEON( GenefxState *gfxs )
+{
+     Xacc_blend_alpha_NEON( gfxs, true );
+}
+
+/********************************* Dacc_modulation ****************************/
+
+static inline void
+Dacc_modulate_NEON( GenefxState *gfxs, u16 a, u16 r, u16 g, u16 b )
+{
+     int                w = gfxs->length;
+     GenefxAccumulator *D = gfxs->Dacc;
+
+     while (w >= 8) {
+          uint16x8x4_t d    = vld4q_u16( (const u16*) D );
+          uint16x8_t   skip = acc_skip_NEON( d.val[3] );
+
+          d.val[0] = vbslq_u16( skip, d.val[0], acc_mul_NEON( vdupq_n_u16( b ), d.val[0] ) );
+          d.val[1] = vbslq_u16( skip, d.val[1], acc_mul_NEON( vdupq_n_u16( g ), d.val[1] ) );
+          d.val[2] = vbslq_u16( skip, d.val[2], acc_mul_NEON( vdupq_n_u16( r ), d.val[2] ) );
+          d.val[3] = vbslq_u16( skip, d.val[3], acc_mul_NEON( vdupq_n_u16( a ), d.val[3] ) );
+
+          vst4q_u16( (u16*) D, d );
+
+          D += 8;
+          w -= 8;
+     }
+
+     while (w--) {
+          if (!(D->RGB.a & 0xF000)) {
+               D->RGB.a = (a * D->RGB.a) >> 8;
+               D->RGB.r = (r * D->RGB.r) >> 8;
+               D->RGB.g = (g * D->RGB.g) >> 8;
+               D->RGB.b = (b * D->RGB.b) >> 8;
+          }
+
+          ++D;
+     }
+}
+
+static void Dacc_modulate_alpha_NEON( GenefxState *gfxs )
+{
+     Dacc_modulate_NEON( gfxs, gfxs->Cacc.RGB.a, 0x100, 0x100, 0x100 );
+}
+
+static void Dacc_modulate_rgb_NEON( GenefxState *gfxs )
+{
+     Dacc_modulate_NEON( gfxs, 0x100, gfxs->Cacc.RGB.r, gfxs->Cacc.RGB.g, gfxs->Cacc.RGB.b );
+}
+
+static void Dacc_modulate_argb_NEON( GenefxState *gfxs )
+{
+     Dacc_modulate_NEON( gfxs, gfxs->Cacc.RGB.a, gfxs->Cacc.RGB.r, gfxs->Cacc.RGB.g, gfxs->Cacc.RGB.b );
+}
+
+/********************************* misc accumulator operations ****************/
+
+static void Dacc_premultiply_NEON( GenefxState *gfxs )
+{
+     int                w = gfxs->length;
+     GenefxAccumulator *D = gfxs->Dacc;
+
+     while (w >= 8) {
+          uint16x8x4_t d    = vld4q_u16( (const u16*) D );
+          uint16x8_t   skip = acc_skip_NEON( d.val[3] );
+          uint16x8_t   da   = vaddq_u16( d.val[3], vdupq_n_u16( 1 ) );
+
+          d.val[0] = vbslq_u16( skip, d.val[0], acc_mul_NEON( da, d.val[0] ) );
+          d.val[1] = vbslq_u16( skip, d.val[1], acc_mul_NEON( da, d.val[1] ) );
+          d.val[2] = vbslq_u16( skip, d.val[2], acc_mul_NEON( da, d.val[2] ) );
+
+          vst4q_u16( (u16*) D, d );
+
+          D += 8;
+          w -= 8;
+     }
+
+     while (w--) {
+          if (!(D->RGB.a & 0xF000)) {
+               u16 Da = D->RGB.a + 1;
+
+               D->RGB.r = (Da * D->RGB.r) >> 8;
+               D->RGB.g = (Da * D->RGB.g) >> 8;
+               D->RGB.b = (Da * D->RGB.b) >> 8;
+          }
+
+          ++D;
+     }
+}
+
+static void SCacc_add_to_Dacc_NEON( GenefxState *gfxs )
+{
+     int                w     = gfxs->length;
+     GenefxAccumulator *D     = gfxs->Dacc;
+     GenefxAccumulator  SCacc = gfxs->SCacc;
+
+     while (w >= 8) {
+          uint16x8x4_t d    = vld4q_u16( (const u16*) D );
+          uint16x8_t   skip = acc_skip_NEON( d.val[3] );
+
+          d.val[0] = vbslq_u16( skip, d.val[0], vaddq_u16( d.val[0], vdupq_n_u16( SCacc.RGB.b ) ) );
+          d.val[1] = vbslq_u16( skip, d.val[1], vaddq_u16( d.val[1], vdupq_n_u16( SCacc.RGB.g ) ) );
+          d.val[2] = vbslq_u16( skip, d.val[2], vaddq_u16( d.val[2], vdupq_n_u16( SCacc.RGB.r ) ) );
+          d.val[3] = vbslq_u16( skip, d.val[3], vaddq_u16( d.val[3], vdupq_n_u16( SCacc.RGB.a ) ) );
+
+          vst4q_u16( (u16*) D, d );
+
+          D += 8;
+          w -= 8;
+     }
+
+     while (w--) {
+          if (!(D->RGB.a & 0xF000)) {
+               D->RGB.a += SCacc.RGB.a;
+               D->RGB.r += SCacc.RGB.r;
+               D->RGB.g += SCacc.RGB.g;
+               D->RGB.b += SCacc.RGB.b;
+          }
+
+          ++D;
+     }
+}
+
+static void Sacc_add_to_Dacc_NEON( GenefxState *gfxs )
+{
+     int                w = gfxs->length;
+     GenefxAccumulator *S = gfxs->Sacc;
+     GenefxAccumulator *D = gfxs->Dacc;
+
+     while (w >= 8) {
+          uint16x8x4_t d    = vld4q_u16( (const u16*) D );
+          uint16x8x4_t s    = vld4q_u16( (const u16*) S );
+          uint16x8_t   skip = acc_skip_NEON( d.val[3] );
+
+          d.val[0] = vbslq_u16( skip, d.val[0], vaddq_u16( d.val[0], s.val[0] ) );
+          d.val[1] = vbslq_u16( skip, d.val[1], vaddq_u16( d.val[1], s.val[1] ) );
+          d.val[2] = vbslq_u16( skip, d.val[2], vaddq_u16( d.val[2], s.val[2] ) );
+          d.val[3] = vbslq_u16( skip, d.val[3], vaddq_u16( d.val[3], s.val[3] ) );
+
+          vst4q_u16( (u16*) D, d );
+
+          D += 8;
+          S += 8;
+          w -= 8;
+     }
+
+     while (w--) {
+          if (!(D->RGB.a & 0xF000)) {
+               D->RGB.a += S->RGB.a;
+               D->RGB.r += S->RGB.r;
+               D->RGB.g += S->RGB.g;
+               D->RGB.b += S->RGB.b;
+          }
+
+          ++D;
+          ++S;
+     }
+}
+
+/********************************* smooth scaling spans ***********************/
+
+static void
+stretch_hline_32_NEON( u32 *dst, const u32 *src, const int *offsets, const int *ratios, int width )
+{
+     int x;
+
+     for (x=0; x<width; x++) {
+          /* left and right pixel as 16 bit words, weighted by (256 - r) and r */
+          uint16x8_t p = vmovl_u8( vreinterpret_u8_u32( vld1_u32( src + offsets[x] ) ) );
+          uint16x8_t r = vcombine_u16( vdup_n_u16( 256 - ratios[x] ), vdup_n_u16( ratios[x] ) );
+
+          p = vmulq_u16( p, r );
+
+          dst[x] = vget_lane_u32( vreinterpret_u32_u8( vshrn_n_u16( vcombine_u16( vadd_u16( vget_low_u16( p ),
+                                                                                             vget_high_u16( p ) ),
+                                                                                   vdup_n_u16( 0 ) ), 8 ) ), 0 );
+     }
+}
+
+static void
+stretch_vline_32_NEON( u32 *dst, const u32 *top, const u32 *bottom, int ratio, int width, u32 mask )
+{
+     uint8x16_t m = vreinterpretq_u8_u32( vdupq_n_u32( mask ) );
+
+     while (width >= 4) {
+          uint8x16_t t  = vreinterpretq_u8_u32( vld1q_u32( top ) );
+          uint8x16_t b  = vreinterpretq_u8_u32( vld1q_u32( bottom ) );
+          uint16x8_t lo = vmlaq_n_u16( vmulq_n_u16( vmovl_u8( vget_low_u8( t ) ), 256 - ratio ),
+                                       vmovl_u8( vget_low_u8( b ) ), ratio );
+          uint16x8_t hi = vmlaq_n_u16( vmulq_n_u16( vmovl_u8( vget_high_u8( t ) ), 256 - ratio ),
+                                       vmovl_u8( vget_high_u8( b ) ), ratio );
+
+          vst1q_u32( dst, vreinterpretq_u32_u8( vandq_u8( vcombine_u8( vshrn_n_u16( lo, 8 ), vshrn_n_u16( hi, 8 ) ), m ) ) );
+
+          dst    += 4;
+          top    += 4;
+          bottom += 4;
+          width  -= 4;
+     }
+
+     while (width--) {
+          uint16x8_t v = vmlaq_n_u16( vmulq_n_u16( vmovl_u8( vreinterpret_u8_u32( vdup_n_u32( *top++ ) ) ), 256 - ratio ),
+                                      vmovl_u8( vreinterpret_u8_u32( vdup_n_u32( *bottom++ ) ) ), ratio );
+
+          *dst++ = vget_lane_u32( vreinterpret_u32_u8( vshrn_n_u16( v, 8 ) ), 0 ) & mask;
+     }
+}
+
+static void
+stretch_area_line_32_NEON( u32 *acc, const u32 *src, int weight, int width )
+{
+     while (width >= 4) {
+          uint8x16_t s  = vreinterpretq_u8_u32( vld1q_u32( src ) );
+          uint16x8_t lo = vmovl_u8( vget_low_u8( s ) );
+          uint16x8_t hi = vmovl_u8( vget_high_u8( s ) );
+
+          vst1q_u32( acc +  0, vmlal_n_u16( vld1q_u32( acc +  0 ), vget_low_u16( lo ),  weight ) );
+          vst1q_u32( acc +  4, vmlal_n_u16( vld1q_u32( acc +  4 ), vget_high_u16( lo ), weight ) );
+          vst1q_u32( acc +  8, vmlal_n_u16( vld1q_u32( acc +  8 ), vget_low_u16( hi ),  weight ) );
+          vst1q_u32( acc + 12, vmlal_n_u16( vld1q_u32( acc + 12 ), vget_high_u16( hi ), weight ) );
+
+          acc   += 16;
+          src   += 4;
+          width -= 4;
+     }
+
+     while (width--) {
+          u32 s = *src++;
+
+          acc[0] += ((s      ) & 0xff) * weight;
+          acc[1] += ((s >>  8) & 0xff) * weight;
+          acc[2] += ((s >> 16) & 0xff) * weight;
+          acc[3] += ((s >> 24)       ) * weight;
+
+          acc += 4;
+     }
+}
+
+static void
+stretch_area_span_32_NEON( u32 *dst, const u32 *acc, const int *first, const int *count, const int *weights,
+                           int width, u32 mask )
+{
+     while (width--) {
+          const u32  *a   = acc + *first++ * 4;
+          int         n   = *count++;
+          uint32x4_t  sum = vdupq_n_u32( 1 << 22 );
+
+          while (n--) {
+               sum = vmlaq_n_u32( sum, vrshrq_n_u32( vld1q_u32( a ), 7 ), *weights++ );
+
+               a += 4;
+          }
+
+          /* sum >> 23 */
+          uint16x4_t v = vshrn_n_u32( sum, 16 );
+
+          *dst++ = vget_lane_u32( vreinterpret_u32_u8( vshrn_n_u16( vcombine_u16( v, v ), 7 ) ), 0 ) & mask;
+     }
+}
@@ -0,0 +1,973 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+
+#include <emmintrin.h>
+
+/*
+ * SSE2 versions of the hot accumulator functions.
+ *
+ * One register holds two accumulators (b, g, r, a as 16 bit words). Entries
+ * with 0xF000 set in the alpha word are skipped by the color keying stages
+ * and have to be left untouched, just like the C versions do.
+ */
+
+#define SSE2_FUNC __attribute__((target("sse2")))
+
+/* returns 0xFFFF in all words of accumulators that are not marked by 0xF000 */
+static inline SSE2_FUNC __m128i
+acc_valid_SSE2( __m128i acc )
+{
+     __m128i a = _mm_shufflehi_epi16( _mm_shufflelo_epi16( acc, 0xFF ), 0xFF );
+
+     return _mm_cmpeq_epi16( _mm_and_si128( a, _mm_set1_epi16( (short) 0xF000 ) ), _mm_setzero_si128() );
+}
+
+static inline SSE2_FUNC __m128i
+acc_alpha_SSE2( __m128i acc )
+{
+     return _mm_shufflehi_epi16( _mm_shufflelo_epi16( acc, 0xFF ), 0xFF );
+}
+
+/* (a * b) >> 8 truncated to 16 bit, same as the C code storing into u16 */
+static inline SSE2_FUNC __m128i
+acc_mul_SSE2( __m128i a, __m128i b )
+{
+     __m128i lo = _mm_mullo_epi16( a, b );
+     __m128i hi = _mm_mulhi_epu16( a, b );
+
+     return _mm_or_si128( _mm_srli_epi16( lo, 8 ), _mm_slli_epi16( hi, 8 ) );
+}
+
+static inline SSE2_FUNC __m128i
+acc_select_SSE2( __m128i mask, __m128i a, __m128i b )
+{
+     return _mm_or_si128( _mm_and_si128( mask, a ), _mm_andnot_si128( mask, b ) );
+}
+
+/* min( x, 0xFF ) */
+static inline SSE2_FUNC __m128i
+acc_clamp_SSE2( __m128i x )
+{
+     return _mm_sub_epi16( x, _mm_subs_epu16( x, _mm_set1_epi16( 0xFF ) ) );
+}
+
+/********************************* Cop_to_Aop_PFI *****************************/
+
+static SSE2_FUNC void Cop_to_Aop_16_SSE2( GenefxState *gfxs )
+{
+     int      w   = gfxs->length;
+     u16     *D   = gfxs->Aop[0];
+     u16      Cop = gfxs->Cop;
+     __m128i  c;
+
+     while (w && ((long)D & 15)) {
+          *D++ = Cop;
+          --w;
+     }
+
+     c = _mm_set1_epi16( Cop );
+
+     while (w >= 32) {
+          _mm_store_si128( (__m128i*) D,      c );
+          _mm_store_si128( (__m128i*) D +  1, c );
+          _mm_store_si128( (__m128i*) D +  2, c );
+          _mm_store_si128( (__m128i*) D +  3, c );
+
+          D += 32;
+          w -= 32;
+     }
+
+     while (w >= 8) {
+          _mm_store_si128( (__m128i*) D, c );
+
+          D += 8;
+          w -= 8;
+     }
+
+     while (w--)
+          *D++ = Cop;
+}
+
+static SSE2_FUNC void Cop_to_Aop_32_SSE2( GenefxState *gfxs )
+{
+     int      w   = gfxs->length;
+     u32     *D   = gfxs->Aop[0];
+     u32      Cop = gfxs->Cop;
+     __m128i  c;
+
+     while (w && ((long)D & 15)) {
+          *D++ = Cop;
+          --w;
+     }
+
+     c = _mm_set1_epi32( Cop );
+
+     while (w >= 16) {
+          _mm_store_si128( (__m128i*) D,      c );
+          _mm_store_si128( (__m128i*) D +  1, c );
+          _mm_store_si128( (__m128i*) D +  2, c );
+          _mm_store_si128( (__m128i*) D +  3, c );
+
+          D += 16;
+          w -= 16;
+     }
+
+     while (w >= 4) {
+          _mm_store_si128( (__m128i*) D, c );
+
+          D += 4;
+          w -= 4;
+     }
+
+     while (w--)
+          *D++ = Cop;
+}
+
+/********************************* Sop_PFI_to_Dacc ****************************/
+
+static SSE2_FUNC void Sop_argb_to_Dacc_SSE2( GenefxState *gfxs )
+{
+     int                w    = gfxs->length;
+     u32               *S    = gfxs->Sop[0];
+     GenefxAccumulator *D    = gfxs->Dacc;
+     __m128i            zero = _mm_setzero_si128();
+
+     if (gfxs->Ostep != 1) {
+          Sop_argb_to_Dacc( gfxs );
+          return;
+     }
+
+     while (w >= 4) {
+          __m128i s = _mm_loadu_si128( (__m128i*) S );
+
+          _mm_storeu_si128( (__m128i*) &D[0], _mm_unpacklo_epi8( s, zero ) );
+          _mm_storeu_si128( (__m128i*) &D[2], _mm_unpackhi_epi8( s, zero ) );
+
+          S += 4;
+          D += 4;
+          w -= 4;
+     }
+
+     while (w--) {
+          u32 s = *S++;
+
+          D->RGB.a = s >> 24;
+          D->RGB.r = (s >> 16) & 0xff;
+          D->RGB.g = (s >>  8) & 0xff;
+          D->RGB.b =  s        & 0xff;
+
+          ++D;
+     }
+}
+
+static SSE2_FUNC void Sop_rgb32_to_Dacc_SSE2( GenefxState *gfxs )
+{
+     int                w    = gfxs->length;
+     u32               *S    = gfxs->Sop[0];
+     GenefxAccumulator *D    = gfxs->Dacc;
+     __m128i            zero = _mm_setzero_si128();
+     __m128i            amask = _mm_set1_epi32( 0xff000000 );
+
+     if (gfxs->Ostep != 1) {
+          Sop_rgb32_to_Dacc( gfxs );
+          return;
+     }
+
+     while (w >= 4) {
+          __m128i s = _mm_or_si128( _mm_loadu_si128( (__m128i*) S ), amask );
+
+          _mm_storeu_si128( (__m128i*) &D[0], _mm_unpacklo_epi8( s, zero ) );
+          _mm_storeu_si128( (__m128i*) &D[2], _mm_unpackhi_epi8( s, zero ) );
+
+          S += 4;
+          D += 4;
+          w -= 4;
+     }
+
+     while (w--) {
+          u32 s = *S++;
+
+          D->RGB.a = 0xff;
+          D->RGB.r = (s >> 16) & 0xff;
+          D->RGB.g = (s >>  8) & 0xff;
+          D->RGB.b =  s        & 0xff;
+
+          ++D;
+     }
+}
+
+static SSE2_FUNC void Sop_rgb16_to_Dacc_SSE2( GenefxState *gfxs )
+{
+     int                w    = gfxs->length;
+     u16               *S    = gfxs->Sop[0];
+     GenefxAccumulator *D    = gfxs->Dacc;
+     __m128i            m5   = _mm_set1_epi16( 0x1f );
+     __m128i            m6   = _mm_set1_epi16( 0x3f );
+     __m128i            a    = _mm_set1_epi16( 0xff );
+
+     if (gfxs->Ostep != 1) {
+          Sop_rgb16_to_Dacc( gfxs );
+          return;
+     }
+
+     while (w >= 8) {
+          __m128i s = _mm_loadu_si128( (__m128i*) S );
+          __m128i r = _mm_srli_epi16( s, 11 );
+          __m128i g = _mm_and_si128( _mm_srli_epi16( s, 5 ), m6 );
+          __m128i b = _mm_and_si128( s, m5 );
+          __m128i bg, ra;
+
+          r = _mm_or_si128( _mm_slli_epi16( r, 3 ), _mm_srli_epi16( r, 2 ) );
+          g = _mm_or_si128( _mm_slli_epi16( g, 2 ), _mm_srli_epi16( g, 4 ) );
+          b = _mm_or_si128( _mm_slli_epi16( b, 3 ), _mm_srli_epi16( b, 2 ) );
+
+          bg = _mm_unpacklo_epi16( b, g );
+          ra = _mm_unpacklo_epi16( r, a );
+
+          _mm_storeu_si128( (__m128i*) &D[0], _mm_unpacklo_epi32( bg, ra ) );
+          _mm_storeu_si128( (__m128i*) &D[2], _mm_unpackhi_epi32( bg, ra ) );
+
+          bg = _mm_unpackhi_epi16( b, g );
+          ra = _mm_unpackhi_epi16( r, a );
+
+          _mm_storeu_si128( (__m128i*) &D[4], _mm_unpacklo_epi32( bg, ra ) );
+          _mm_storeu_si128( (__m128i*) &D[6], _mm_unpackhi_epi32( bg, ra ) );
+
+          S += 8;
+          D += 8;
+          w -= 8;
+     }
+
+     while (w--) {
+          u16 s = *S++;
+
+          D->RGB.a = 0xff;
+          D->RGB.r = EXPAND_5to8( s >> 11 );
+          D->RGB.g = EXPAND_6to8( (s >> 5) & 0x3f );
+          D->RGB.b = EXPAND_5to8( s & 0x1f );
+
+          ++D;
+     }
+}
+
+/********************************* Sacc_to_Aop_PFI ****************************/
+
+#define SACC_TO_PIXEL_32( S, A )                                          \
+     PIXEL_ARGB( (A),                                                     \
+                 ((S).RGB.r & 0xFF00) ? 0xFF : (S).RGB.r,                 \
+                 ((S).RGB.g & 0xFF00) ? 0xFF : (S).RGB.g,                 \
+                 ((S).RGB.b & 0xFF00) ? 0xFF : (S).RGB.b )
+
+static inline SSE2_FUNC void
+Sacc_to_Aop_32_SSE2( GenefxState *gfxs, bool alpha )
+{
+     int                w     = gfxs->length;
+     GenefxAccumulator *S     = gfxs->Sacc;
+     u32               *D     = gfxs->Aop[0];
+     __m128i            amask = _mm_set1_epi32( alpha ? 0 : 0xff000000 );
+
+     while (w >= 4) {
+          __m128i s0 = _mm_loadu_si128( (__m128i*) &S[0] );
+          __m128i s1 = _mm_loadu_si128( (__m128i*) &S[2] );
+          __m128i m  = _mm_packs_epi16( acc_valid_SSE2( s0 ), acc_valid_SSE2( s1 ) );
+          __m128i p  = _mm_packus_epi16( acc_clamp_SSE2( s0 ), acc_clamp_SSE2( s1 ) );
+
+          p = _mm_or_si128( p, amask );
+
+          if (_mm_movemask_epi8( m ) == 0xffff)
+               _mm_storeu_si128( (__m128i*) D, p );
+          else
+               _mm_storeu_si128( (__m128i*) D, acc_select_SSE2( m, p, _mm_loadu_si128( (__m128i*) D ) ) );
+
+          S += 4;
+          D += 4;
+          w -= 4;
+     }
+
+     while (w--) {
+          if (!(S->RGB.a & 0xF000))
+               *D = SACC_TO_PIXEL_32( *S, alpha ? ((S->RGB.a & 0xFF00) ? 0xFF : S->RGB.a) : 0xFF );
+
+          ++S;
+          ++D;
+     }
+}
+
+static SSE2_FUNC void Sacc_to_Aop_argb_SSE2( GenefxState *gfxs )
+{
+     if (gfxs->Astep != 1) {
+          Sacc_to_Aop_argb( gfxs );
+          return;
+     }
+
+     Sacc_to_Aop_32_SSE2( gfxs, true );
+}
+
+static SSE2_FUNC void Sacc_to_Aop_rgb32_SSE2( GenefxState *gfxs )
+{
+     if (gfxs->Astep != 1) {
+          Sacc_to_Aop_rgb32( gfxs );
+          return;
+     }
+
+     Sacc_to_Aop_32_SSE2( gfxs, false );
+}
+
+static SSE2_FUNC void Sacc_to_Aop_rgb16_SSE2( GenefxState *gfxs )
+{
+     int                w  = gfxs->length;
+     GenefxAccumulator *S  = gfxs->Sacc;
+     u16               *D  = gfxs->Aop[0];
+     __m128i            mr = _mm_set1_epi32( 0xF800 );
+     __m128i            mg = _mm_set1_epi32( 0x07E0 );
+     __m128i            mb = _mm_set1_epi32( 0x001F );
+
+     if (gfxs->Astep != 1) {
+          Sacc_to_Aop_rgb16( gfxs );
+          return;
+     }
+
+     while (w >= 8) {
+          __m128i s0 = _mm_loadu_si128( (__m128i*) &S[0] );
+          __m128i s1 = _mm_loadu_si128( (__m128i*) &S[2] );
+          __m128i s2 = _mm_loadu_si128( (__m128i*) &S[4] );
+          __m128i s3 = _mm_loadu_si128( (__m128i*) &S[6] );
+          __m128i m0 = _mm_packs_epi16( acc_valid_SSE2( s0 ), acc_valid_SSE2( s1 ) );
+          __m128i m1 = _mm_packs_epi16( acc_valid_SSE2( s2 ), acc_valid_SSE2( s3 ) );
+          __m128i p0 = _mm_packus_epi16( acc_clamp_SSE2( s0 ), acc_clamp_SSE2( s1 ) );
+          __m128i p1 = _mm_packus_epi16( acc_clamp_SSE2( s2 ), acc_clamp_SSE2( s3 ) );
+          __m128i m, p;
+
+          /* RGB32_TO_RGB16 on four pixels each */
+          p0 = _mm_or_si128( _mm_or_si128( _mm_and_si128( _mm_srli_epi32( p0, 8 ), mr ),
+                                           _mm_and_si128( _mm_srli_epi32( p0, 5 ), mg ) ),
+                             _mm_and_si128( _mm_srli_epi32( p0, 3 ), mb ) );
+          p1 = _mm_or_si128( _mm_or_si128( _mm_and_si128( _mm_srli_epi32( p1, 8 ), mr ),
+                                           _mm_and_si128( _mm_srli_epi32( p1, 5 ), mg ) ),
+                             _mm_and_si128( _mm_srli_epi32( p1, 3 ), mb ) );
+
+          /* sign extend for the signed saturation of packs */
+          p0 = _mm_srai_epi32( _mm_slli_epi32( p0, 16 ), 16 );
+          p1 = _mm_srai_epi32( _mm_slli_epi32( p1, 16 ), 16 );
+
+          p = _mm_packs_epi32( p0, p1 );
+          m = _mm_packs_epi32( m0, m1 );
+
+          if (_mm_movemask_epi8( m ) == 0xffff)
+               _mm_storeu_si128( (__m128i*) D, p );
+          else
+               _mm_storeu_si128( (__m128i*) D, acc_select_SSE2( m, p, _mm_loadu_si128( (__m128i*) D ) ) );
+
+          S += 8;
+          D += 8;
+          w -= 8;
+     }
+
+     while (w--) {
+          if (!(S->RGB.a & 0xF000))
+               *D = PIXEL_RGB16( (S->RGB.r & 0xFF00) ? 0xFF : S->RGB.r,
+                                 (S->RGB.g & 0xFF00) ? 0xFF : S->RGB.g,
+                                 (S->RGB.b & 0xFF00) ? 0xFF : S->RGB.b );
+
+          ++S;
+          ++D;
+     }
+}
+
+/********************************* Xacc_blend *********************************/
+
+static inline SSE2_FUNC void
+Xacc_blend_alpha_SSE2( GenefxState *gfxs, bool inverse )
+{
+     int                w = gfxs->length;
+     GenefxAccumulator *X = gfxs->Xacc;
+     GenefxAccumulator *Y = gfxs->Yacc;
+     GenefxAccumulator *S = gfxs->Sacc;
+
+     if (S) {
+          __m128i base = _mm_set1_epi16( inverse ? 0x100 : 1 );
+
+          while (w >= 2) {
+               __m128i y  = _mm_loadu_si128( (__m128i*) Y );
+               __m128i sa = acc_alpha_SSE2( _mm_loadu_si128( (__m128i*) S ) );
+
+               sa = inverse ? _mm_sub_epi16( base, sa ) : _mm_add_epi16( base, sa );
+
+               _mm_storeu_si128( (__m128i*) X, acc_select_SSE2( acc_valid_SSE2( y ), acc_mul_SSE2( sa, y ), y ) );
+
+               X += 2;
+               Y += 2;
+               S += 2;
+               w -= 2;
+          }
+
+          if (w) {
+               if (!(Y->RGB.a & 0xF000)) {
+                    u16 Sa = inverse ? 0x100 - S->RGB.a : S->RGB.a + 1;
+
+                    X->RGB.r = (Sa * Y->RGB.r) >> 8;
+                    X->RGB.g = (Sa * Y->RGB.g) >> 8;
+                    X->RGB.b = (Sa * Y->RGB.b) >> 8;
+                    X->RGB.a = (Sa * Y->RGB.a) >> 8;
+               } else
+                    *X = *Y;
+          }
+     }
+     else {
+          u16     Sa = inverse ? 0x100 - gfxs->color.a : gfxs->color.a + 1;
+          __m128i sa = _mm_set1_epi16( Sa );
+
+          while (w >= 2) {
+               __m128i y = _mm_loadu_si128( (__m128i*) Y );
+
+               _mm_storeu_si128( (__m128i*) X, acc_select_SSE2( acc_valid_SSE2( y ), acc_mul_SSE2( sa, y ), y ) );
+
+               X += 2;
+               Y += 2;
+               w -= 2;
+          }
+
+          if (w) {
+               if (!(Y->RGB.a & 0xF000)) {
+                    X->RGB.r = (Sa * Y->RGB.r) >> 8;
+                    X->RGB.g = (Sa * Y->RGB.g) >> 8;
+                    X->RGB.b = (Sa * Y->RGB.b) >> 8;
+                    X->RGB.a = (Sa * Y->RGB.a) >> 8;
+               } else
+                    *X = *Y;
+          }
+     }
+}
+
+static SSE2_FUNC void Xacc_blend_srcalpha_SSE2( GenefxState *gfxs )
+{
+     Xacc_blend_alpha_SSE2( gfxs, false );
+}
+
+static SSE2_FUNC void Xacc_blend_invsrcalpha_SSE2( GenefxState *gfxs )
+{
+     Xacc_blend_alpha_SSE2( gfxs, true );
+}
+
+/********************************* Dacc_modulation ****************************/
+
+/* multiplies each channel with the corresponding word of 'c' (0x100 keeps the channel) */
+static inline SSE2_FUNC void
+Dacc_modulate_SSE2( GenefxState *gfxs, u16 a, u16 r, u16 g, u16 b )
+{
+     int                w = gfxs->length;
+     GenefxAccumulator *D = gfxs->Dacc;
+     __m128i            c = _mm_set_epi16( a, r, g, b, a, r, g, b );
+
+     while (w >= 2) {
+          __m128i d = _mm_loadu_si128( (__m128i*) D );
+
+          _mm_storeu_si128( (__m128i*) D, acc_select_SSE2( acc_valid_SSE2( d ), acc_mul_SSE2( c, d ), d ) );
+
+          D += 2;
+          w -= 2;
+     }
+
+     if (w && !(D->RGB.a & 0xF000)) {
+          D->RGB.a = (a * D->RGB.a) >> 8;
+          D->RGB.r = (r * D->RGB.r) >> 8;
+          D->RGB.g = (g * D->RGB.g) >> 8;
+          D->RGB.b = (b * D->RGB.b) >> 8;
+     }
+}
+
+static SSE2_FUNC void Dacc_modulate_alpha_SSE2( GenefxState *gfxs )
+{
+     Dacc_modulate_SSE2( gfxs, gfxs->Cacc.RGB.a, 0x100, 0x100, 0x100 );
+}
+
+static SSE2_FUNC void Dacc_modulate_rgb_SSE2( GenefxState *gfxs )
+{
+     Dacc_modulate_SSE2( gfxs, 0x100, gfxs->Cacc.RGB.r, gfxs->Cacc.RGB.g, gfxs->Cacc.RGB.b );
+}
+
+static SSE2_FUNC void Dacc_modulate_argb_SSE2( GenefxState *gfxs )
+{
+     Dacc_modulate_SSE2( gfxs, gfxs->Cacc.RGB.a, gfxs->Cacc.RGB.r, gfxs->Cacc.RGB.g, gfxs->Cacc.RGB.b );
+}
+
+/********************************* misc accumulator operations ****************/
+
+static SSE2_FUNC void Dacc_premultiply_SSE2( GenefxState *gfxs )
+{
+     int                w    = gfxs->length;
+     GenefxAccumulator *D    = gfxs->Dacc;
+     __m128i            one  = _mm_set_epi16( 0x100, 1, 1, 1, 0x100, 1, 1, 1 );
+     __m128i            rgb  = _mm_set_epi16( 0, -1, -1, -1, 0, -1, -1, -1 );
+
+     while (w >= 2) {
+          __m128i d  = _mm_loadu_si128( (__m128i*) D );
+          __m128i da = _mm_add_epi16( _mm_and_si128( acc_alpha_SSE2( d ), rgb ), one );
+
+          _mm_storeu_si128( (__m128i*) D, acc_select_SSE2( acc_valid_SSE2( d ), acc_mul_SSE2( da, d ), d ) );
+
+          D += 2;
+          w -= 2;
+     }
+
+     if (w && !(D->RGB.a & 0xF000)) {
+          u16 Da = D->RGB.a + 1;
+
+          D->RGB.r = (Da * D->RGB.r) >> 8;
+          D->RGB.g = (Da * D->RGB.g) >> 8;
+          D->RGB.b = (Da * D->RGB.b) >> 8;
+     }
+}
+
+static SSE2_FUNC void SCacc_add_to_Dacc_SSE2( GenefxState *gfxs )
+{
+     int                w     = gfxs->length;
+     GenefxAccumulator *D     = gfxs->Dacc;
+     GenefxAccumulator  SCacc = gfxs->SCacc;
+     __m128i            c     = _mm_set_epi16( SCacc.RGB.a, SCacc.RGB.r, SCacc.RGB.g, SCacc.RGB.b,
+                                               SCacc.RGB.a, SCacc.RGB.r, SCacc.RGB.g, SCacc.RGB.b );
+
+     while (w >= 2) {
+          __m128i d = _mm_loadu_si128( (__m128i*) D );
+
+          _mm_storeu_si128( (__m128i*) D, acc_select_SSE2( acc_valid_SSE2( d ), _mm_add_epi16( d, c ), d ) );
+
+          D += 2;
+          w -= 2;
+     }
+
+     if (w && !(D->RGB.a & 0xF000)) {
+          D->RGB.a += SCacc.RGB.a;
+          D->RGB.r += SCacc.RGB.r;
+          D->RGB.g += SCacc.RGB.g;
+          D->RGB.b += SCacc.RGB.b;
+     }
+}
+
+static SSE2_FUNC void Sacc_add_to_Dacc_SSE2( GenefxState *gfxs )
+{
+     int                w = gfxs->length;
+     GenefxAccumulator *S = gfxs->Sacc;
+     GenefxAccumulator *D = gfxs->Dacc;
+
+     while (w >= 2) {
+          __m128i d = _mm_loadu_si128( (__m128i*) D );
+          __m128i s = _mm_loadu_si128( (__m128i*) S );
+
+          _mm_storeu_si128( (__m128i*) D, acc_select_SSE2( acc_valid_SSE2( d ), _mm_add_epi16( d, s ), d ) );
+
+          D += 2;
+          S += 2;
+          w -= 2;
+     }
+
+     if (w && !(D->RGB.a & 0xF000)) {
+          D->RGB.a += S->RGB.a;
+          D->RGB.r += S->RGB.r;
+          D->RGB.g += S->RGB.g;
+          D->RGB.b += S->RGB.b;
+     }
+}
+
+/********************************* Bop_argb_blend_fused_Aop_PFI ***************/
+
+/* see blend_argb_fused(), two pixels in accumulator layout */
+static inline SSE2_FUNC __m128i
+blend_argb_fused_SSE2( __m128i s, __m128i d, __m128i mod, const int fused )
+{
+     __m128i sa, sa1;
+
+     if (fused & (FUSED_COLORIZE | FUSED_COLORALPHA))
+          s = _mm_srli_epi16( _mm_mullo_epi16( s, mod ), 8 );
+
+     sa  = acc_alpha_SSE2( s );
+     sa1 = _mm_add_epi16( sa, _mm_set1_epi16( 1 ) );
+
+     if (fused & FUSED_PREMULTIPLY)
+          s = acc_select_SSE2( _mm_set_epi16( 0, -1, -1, -1, 0, -1, -1, -1 ),
+                               _mm_srli_epi16( _mm_mullo_epi16( s, sa1 ), 8 ), s );
+     else
+          s = _mm_srli_epi16( _mm_mullo_epi16( s, sa1 ), 8 );
+
+     d = _mm_srli_epi16( _mm_mullo_epi16( d, _mm_sub_epi16( _mm_set1_epi16( 0x100 ), sa ) ), 8 );
+
+     return _mm_add_epi16( s, d );
+}
+
+static inline SSE2_FUNC void
+Bop_argb_blend_fused_Aop_32_SSE2( GenefxState *gfxs, const int fused, const bool dst_alpha )
+{
+     int                      w    = gfxs->length;
+     const u32               *S    = gfxs->Bop[0];
+     u32                     *D    = gfxs->Aop[0];
+     const GenefxAccumulator  Cacc = gfxs->Cacc;
+     const __m128i            zero = _mm_setzero_si128();
+     const __m128i            fill = _mm_set1_epi32( dst_alpha ? 0 : 0xff000000 );
+     __m128i                  mod;
+
+     if (gfxs->Astep != 1 || gfxs->Bstep != 1) {
+          if (dst_alpha)
+               Bop_argb_blend_fused_Aop_argb( gfxs, fused );
+          else
+               Bop_argb_blend_fused_Aop_rgb32( gfxs, fused );
+          return;
+     }
+
+     mod = _mm_set_epi16( (fused & FUSED_COLORALPHA) ? Cacc.RGB.a : 0x100,
+                          (fused & FUSED_COLORIZE)   ? Cacc.RGB.r : 0x100,
+                          (fused & FUSED_COLORIZE)   ? Cacc.RGB.g : 0x100,
+                          (fused & FUSED_COLORIZE)   ? Cacc.RGB.b : 0x100,
+                          (fused & FUSED_COLORALPHA) ? Cacc.RGB.a : 0x100,
+                          (fused & FUSED_COLORIZE)   ? Cacc.RGB.r : 0x100,
+                          (fused & FUSED_COLORIZE)   ? Cacc.RGB.g : 0x100,
+                          (fused & FUSED_COLORIZE)   ? Cacc.RGB.b : 0x100 );
+
+     while (w >= 4) {
+          __m128i s = _mm_loadu_si128( (const __m128i*) S );
+
+          /* skip four fully transparent source pixels */
+          if (_mm_movemask_epi8( _mm_cmpeq_epi32( _mm_srli_epi32( s, 24 ), zero ) ) != 0xFFFF) {
+               __m128i d  = _mm_loadu_si128( (const __m128i*) D );
+               __m128i lo = blend_argb_fused_SSE2( _mm_unpacklo_epi8( s, zero ),
+                                                   _mm_unpacklo_epi8( d, zero ), mod, fused );
+               __m128i hi = blend_argb_fused_SSE2( _mm_unpackhi_epi8( s, zero ),
+                                                   _mm_unpackhi_epi8( d, zero ), mod, fused );
+
+               _mm_storeu_si128( (__m128i*) D, _mm_or_si128( _mm_packus_epi16( lo, hi ), fill ) );
+          }
+
+          S += 4;
+          D += 4;
+          w -= 4;
+     }
+
+     while (w--) {
+          if (*S >> 24)
+               *D = blend_argb_fused( *S, *D, &Cacc, fused, dst_alpha );
+
+          ++S;
+          ++D;
+     }
+}
+
+/* same as above, but with eight RGB16 pixels in planar 16 bit words per iteration */
+static inline SSE2_FUNC void
+Bop_argb_blend_fused_Aop_16_SSE2( GenefxState *gfxs, const int fused )
+{
+     int                      w    = gfxs->length;
+     const u32               *S    = gfxs->Bop[0];
+     u16                     *D    = gfxs->Aop[0];
+     const GenefxAccumulator  Cacc = gfxs->Cacc;
+     const __m128i            zero = _mm_setzero_si128();
+     const __m128i            mask = _mm_set1_epi32( 0xff );
+     const __m128i            one  = _mm_set1_epi16( 1 );
+     const __m128i            ca   = _mm_set1_epi16( Cacc.RGB.a );
+     const __m128i            cr   = _mm_set1_epi16( Cacc.RGB.r );
+     const __m128i            cg   = _mm_set1_epi16( Cacc.RGB.g );
+     const __m128i            cb   = _mm_set1_epi16( Cacc.RGB.b );
+
+     if (gfxs->Astep != 1 || gfxs->Bstep != 1) {
+          Bop_argb_blend_fused_Aop_rgb16( gfxs, fused );
+          return;
+     }
+
+     while (w >= 8) {
+          __m128i s0 = _mm_loadu_si128( (const __m128i*) S );
+          __m128i s1 = _mm_loadu_si128( (const __m128i*) (S + 4) );
+          __m128i sa = _mm_packs_epi32( _mm_srli_epi32( s0, 24 ), _mm_srli_epi32( s1, 24 ) );
+
+          /* skip eight fully transparent source pixels */
+          if (_mm_movemask_epi8( _mm_cmpeq_epi16( sa, zero ) ) != 0xFFFF) {
+               __m128i d  = _mm_loadu_si128( (const __m128i*) D );
+               __m128i sr = _mm_packs_epi32( _mm_and_si128( _mm_srli_epi32( s0, 16 ), mask ),
+                                             _mm_and_si128( _mm_srli_epi32( s1, 16 ), mask ) );
+               __m128i sg = _mm_packs_epi32( _mm_and_si128( _mm_srli_epi32( s0, 8 ), mask ),
+                                             _mm_and_si128( _mm_srli_epi32( s1, 8 ), mask ) );
+               __m128i sb = _mm_packs_epi32( _mm_and_si128( s0, mask ), _mm_and_si128( s1, mask ) );
+               __m128i dr = _mm_srli_epi16( d, 11 );
+               __m128i dg = _mm_and_si128( _mm_srli_epi16( d, 5 ), _mm_set1_epi16( 0x3f ) );
+               __m128i db = _mm_and_si128( d, _mm_set1_epi16( 0x1f ) );
+               __m128i sa1, inv;
+
+               /* EXPAND_5to8() and EXPAND_6to8() */
+               dr = _mm_or_si128( _mm_slli_epi16( dr, 3 ), _mm_srli_epi16( dr, 2 ) );
+               dg = _mm_or_si128( _mm_slli_epi16( dg, 2 ), _mm_srli_epi16( dg, 4 ) );
+               db = _mm_or_si128( _mm_slli_epi16( db, 3 ), _mm_srli_epi16( db, 2 ) );
+
+               if (fused & FUSED_COLORALPHA)
+                    sa = _mm_srli_epi16( _mm_mullo_epi16( sa, ca ), 8 );
+
+               if (fused & FUSED_COLORIZE) {
+                    sr = _mm_srli_epi16( _mm_mullo_epi16( sr, cr ), 8 );
+                    sg = _mm_srli_epi16( _mm_mullo_epi16( sg, cg ), 8 );
+                    sb = _mm_srli_epi16( _mm_mullo_epi16( sb, cb ), 8 );
+               }
+
+               /* premultiply or DSBF_SRCALPHA, both scale the color by the same factor */
+               sa1 = _mm_add_epi16( sa, one );
+               inv = _mm_sub_epi16( _mm_set1_epi16( 0x100 ), sa );
+
+               sr = _mm_add_epi16( _mm_srli_epi16( _mm_mullo_epi16( sr, sa1 ), 8 ),
+                                   _mm_srli_epi16( _mm_mullo_epi16( dr, inv ), 8 ) );
+               sg = _mm_add_epi16( _mm_srli_epi16( _mm_mullo_epi16( sg, sa1 ), 8 ),
+                                   _mm_srli_epi16( _mm_mullo_epi16( dg, inv ), 8 ) );
+               sb = _mm_add_epi16( _mm_srli_epi16( _mm_mullo_epi16( sb, sa1 ), 8 ),
+                                   _mm_srli_epi16( _mm_mullo_epi16( db, inv ), 8 ) );
+
+               /* PIXEL_RGB16() */
+               d = _mm_or_si128( _mm_or_si128( _mm_slli_epi16( _mm_srli_epi16( sr, 3 ), 11 ),
+                                               _mm_slli_epi16( _mm_srli_epi16( sg, 2 ), 5 ) ),
+                                 _mm_srli_epi16( sb, 3 ) );
+
+               _mm_storeu_si128( (__m128i*) D, d );
+          }
+
+          S += 8;
+          D += 8;
+          w -= 8;
+     }
+
+     while (w--) {
+          if (*S >> 24) {
+               u32 d = blend_argb_fused( *S, 0xff000000                           |
+                                             (EXPAND_5to8( *D >> 11 )          << 16) |
+                                             (EXPAND_6to8( (*D >> 5) & 0x3f )  <<  8) |
+                                             (EXPAND_5to8( *D & 0x1f )             ),
+                                         &Cacc, fused, false );
+
+               *D = PIXEL_RGB16( (d >> 16) & 0xff, (d >> 8) & 0xff, d & 0xff );
+          }
+
+          ++S;
+          ++D;
+     }
+}
+
+#define BLEND_FUSED_FUNC_SSE2( name, fused )                                      \
+static SSE2_FUNC void Bop_argb_blend_##name##_Aop_argb_SSE2( GenefxState *gfxs )  \
+{                                                                                 \
+     Bop_argb_blend_fused_Aop_32_SSE2( gfxs, fused, true );                       \
+}                                                                                 \
+                                                                                  \
+static SSE2_FUNC void Bop_argb_blend_##name##_Aop_rgb32_SSE2( GenefxState *gfxs ) \
+{                                                                                 \
+     Bop_argb_blend_fused_Aop_32_SSE2( gfxs, fused, false );                      \
+}                                                                                 \
+                                                                                  \
+static SSE2_FUNC void Bop_argb_blend_##name##_Aop_rgb16_SSE2( GenefxState *gfxs ) \
+{                                                                                 \
+     Bop_argb_blend_fused_Aop_16_SSE2( gfxs, fused );                             \
+}
+
+BLEND_FUSED_FUNC_SSE2( srcalpha,                         0 )
+BLEND_FUSED_FUNC_SSE2( srcalpha_colorize,                FUSED_COLORIZE )
+BLEND_FUSED_FUNC_SSE2( srcalpha_coloralpha,              FUSED_COLORALPHA )
+BLEND_FUSED_FUNC_SSE2( srcalpha_colorize_coloralpha,     FUSED_COLORIZE | FUSED_COLORALPHA )
+BLEND_FUSED_FUNC_SSE2( premultiply,                      FUSED_PREMULTIPLY )
+BLEND_FUSED_FUNC_SSE2( premultiply_colorize,             FUSED_PREMULTIPLY | FUSED_COLORIZE )
+BLEND_FUSED_FUNC_SSE2( premultiply_coloralpha,           FUSED_PREMULTIPLY | FUSED_COLORALPHA )
+BLEND_FUSED_FUNC_SSE2( premultiply_colorize_coloralpha,  FUSED_PREMULTIPLY | FUSED_COLORIZE | FUSED_COLORALPHA )
+
+#undef BLEND_FUSED_FUNC_SSE2
+
+static const GenefxFunc Bop_argb_blend_fused_Aop_argb_SSE2[FUSED_NUM] = {
+     [0]                                                      = Bop_argb_blend_srcalpha_Aop_argb_SSE2,
+     [FUSED_COLORIZE]                                         = Bop_argb_blend_srcalpha_colorize_Aop_argb_SSE2,
+     [FUSED_COLORALPHA]                                       = Bop_argb_blend_srcalpha_coloralpha_Aop_argb_SSE2,
+     [FUSED_COLORIZE | FUSED_COLORALPHA]                      = Bop_argb_blend_srcalpha_colorize_coloralpha_Aop_argb_SSE2,
+     [FUSED_PREMULTIPLY]                                      = Bop_argb_blend_premultiply_Aop_argb_SSE2,
+     [FUSED_PREMULTIPLY | FUSED_COLORIZE]                     = Bop_argb_blend_premultiply_colorize_Aop_argb_SSE2,
+     [FUSED_PREMULTIPLY | FUSED_COLORALPHA]                   = Bop_argb_blend_premultiply_coloralpha_Aop_argb_SSE2,
+     [FUSED_PREMULTIPLY | FUSED_COLORIZE | FUSED_COLORALPHA]  = Bop_argb_blend_premultiply_colorize_coloralpha_Aop_argb_SSE2,
+};
+
+static const GenefxFunc Bop_argb_blend_fused_Aop_rgb32_SSE2[FUSED_NUM] = {
+     [0]                                                      = Bop_argb_blend_srcalpha_Aop_rgb32_SSE2,
+     [FUSED_COLORIZE]                                         = Bop_argb_blend_srcalpha_colorize_Aop_rgb32_SSE2,
+     [FUSED_COLORALPHA]                                       = Bop_argb_blend_srcalpha_coloralpha_Aop_rgb32_SSE2,
+     [FUSED_COLORIZE | FUSED_COLORALPHA]                      = Bop_argb_blend_srcalpha_colorize_coloralpha_Aop_rgb32_SSE2,
+     [FUSED_PREMULTIPLY]                                      = Bop_argb_blend_premultiply_Aop_rgb32_SSE2,
+     [FUSED_PREMULTIPLY | FUSED_COLORIZE]                     = Bop_argb_blend_premultiply_colorize_Aop_rgb32_SSE2,
+     [FUSED_PREMULTIPLY | FUSED_COLORALPHA]                   = Bop_argb_blend_premultiply_coloralpha_Aop_rgb32_SSE2,
+     [FUSED_PREMULTIPLY | FUSED_COLORIZE | FUSED_COLORALPHA]  = Bop_argb_blend_premultiply_colorize_coloralpha_Aop_rgb32_SSE2,
+};
+
+static const GenefxFunc Bop_argb_blend_fused_Aop_rgb16_SSE2[FUSED_NUM] = {
+     [0]                                                      = Bop_argb_blend_srcalpha_Aop_rgb16_SSE2,
+     [FUSED_COLORIZE]                                         = Bop_argb_blend_srcalpha_colorize_Aop_rgb16_SSE2,
+     [FUSED_COLORALPHA]                                       = Bop_argb_blend_srcalpha_coloralpha_Aop_rgb16_SSE2,
+     [FUSED_COLORIZE | FUSED_COLORALPHA]                      = Bop_argb_blend_srcalpha_colorize_coloralpha_Aop_rgb16_SSE2,
+     [FUSED_PREMULTIPLY]                                      = Bop_argb_blend_premultiply_Aop_rgb16_SSE2,
+     [FUSED_PREMULTIPLY | FUSED_COLORIZE]                     = Bop_argb_blend_premultiply_colorize_Aop_rgb16_SSE2,
+     [FUSED_PREMULTIPLY | FUSED_COLORALPHA]                   = Bop_argb_blend_premultiply_coloralpha_Aop_rgb16_SSE2,
+     [FUSED_PREMULTIPLY | FUSED_COLORIZE | FUSED_COLORALPHA]  = Bop_argb_blend_premultiply_colorize_coloralpha_Aop_rgb16_SSE2,
+};
+
+/********************************* smooth scaling spans ***********************/
+
+/* (a * (256 - r) + b * r) >> 8 for each 16 bit word */
+static inline SSE2_FUNC __m128i
+lerp_SSE2( __m128i a, __m128i b, __m128i r )
+{
+     __m128i ir = _mm_sub_epi16( _mm_set1_epi16( 256 ), r );
+
+     return _mm_srli_epi16( _mm_add_epi16( _mm_mullo_epi16( a, ir ), _mm_mullo_epi16( b, r ) ), 8 );
+}
+
+/* two pixels interpolated between src[offset] and src[offset+1] as 16 bit words */
+static inline SSE2_FUNC __m128i
+hline_pair_SSE2( const u32 *src, int o0, int o1, int r0, int r1 )
+{
+     __m128i zero = _mm_setzero_si128();
+     __m128i p0   = _mm_unpacklo_epi8( _mm_loadl_epi64( (const __m128i*) (src + o0) ), zero );
+     __m128i p1   = _mm_unpacklo_epi8( _mm_loadl_epi64( (const __m128i*) (src + o1) ), zero );
+
+     return lerp_SSE2( _mm_unpacklo_epi64( p0, p1 ), _mm_unpackhi_epi64( p0, p1 ),
+                       _mm_unpacklo_epi64( _mm_set1_epi16( r0 ), _mm_set1_epi16( r1 ) ) );
+}
+
+static SSE2_FUNC void
+stretch_hline_32_SSE2( u32 *dst, const u32 *src, const int *offsets, const int *ratios, int width )
+{
+     int x;
+
+     for (x=0; x+4<=width; x+=4) {
+          __m128i a = hline_pair_SSE2( src, offsets[x],   offsets[x+1], ratios[x],   ratios[x+1] );
+          __m128i b = hline_pair_SSE2( src, offsets[x+2], offsets[x+3], ratios[x+2], ratios[x+3] );
+
+          _mm_storeu_si128( (__m128i*) (dst + x), _mm_packus_epi16( a, b ) );
+     }
+
+     for (; x<width; x++) {
+          __m128i a = hline_pair_SSE2( src, offsets[x], offsets[x], ratios[x], ratios[x] );
+
+          dst[x] = _mm_cvtsi128_si32( _mm_packus_epi16( a, a ) );
+     }
+}
+
+static SSE2_FUNC void
+stretch_vline_32_SSE2( u32 *dst, const u32 *top, const u32 *bottom, int ratio, int width, u32 mask )
+{
+     int     x;
+     __m128i zero = _mm_setzero_si128();
+     __m128i r    = _mm_set1_epi16( ratio );
+     __m128i m    = _mm_set1_epi32( mask );
+
+     for (x=0; x+4<=width; x+=4) {
+          __m128i t  = _mm_loadu_si128( (const __m128i*) (top + x) );
+          __m128i b  = _mm_loadu_si128( (const __m128i*) (bottom + x) );
+          __m128i lo = lerp_SSE2( _mm_unpacklo_epi8( t, zero ), _mm_unpacklo_epi8( b, zero ), r );
+          __m128i hi = lerp_SSE2( _mm_unpackhi_epi8( t, zero ), _mm_unpackhi_epi8( b, zero ), r );
+
+          _mm_storeu_si128( (__m128i*) (dst + x), _mm_and_si128( _mm_packus_epi16( lo, hi ), m ) );
+     }
+
+     for (; x<width; x++) {
+          __m128i v = lerp_SSE2( _mm_unpacklo_epi8( _mm_cvtsi32_si128( top[x] ), zero ),
+                                 _mm_unpacklo_epi8( _mm_cvtsi32_si128( bottom[x] ), zero ), r );
+
+          dst[x] = _mm_cvtsi128_si32( _mm_packus_epi16( v, v ) ) & mask;
+     }
+}
+
+/* adds the products of eight 16 bit words and w to eight 32 bit accumulators */
+static inline SSE2_FUNC void
+area_madd_SSE2( u32 *acc, __m128i v, __m128i w )
+{
+     __m128i lo = _mm_mullo_epi16( v, w );
+     __m128i hi = _mm_mulhi_epu16( v, w );
+
+     _mm_storeu_si128( (__m128i*) (acc + 0), _mm_add_epi32( _mm_loadu_si128( (const __m128i*) (acc + 0) ),
+                                                            _mm_unpacklo_epi16( lo, hi ) ) );
+     _mm_storeu_si128( (__m128i*) (acc + 4), _mm_add_epi32( _mm_loadu_si128( (const __m128i*) (acc + 4) ),
+                                                            _mm_unpackhi_epi16( lo, hi ) ) );
+}
+
+static SSE2_FUNC void
+stretch_area_line_32_SSE2( u32 *acc, const u32 *src, int weight, int width )
+{
+     __m128i zero = _mm_setzero_si128();
+     __m128i w    = _mm_set1_epi16( weight );
+
+     while (width >= 4) {
+          __m128i s = _mm_loadu_si128( (const __m128i*) src );
+
+          area_madd_SSE2( acc,     _mm_unpacklo_epi8( s, zero ), w );
+          area_madd_SSE2( acc + 8, _mm_unpackhi_epi8( s, zero ), w );
+
+          acc   += 16;
+          src   += 4;
+          width -= 4;
+     }
+
+     while (width--) {
+          u32 s = *src++;
+
+          acc[0] += ((s      ) & 0xff) * weight;
+          acc[1] += ((s >>  8) & 0xff) * weight;
+          acc[2] += ((s >> 16) & 0xff) * weight;
+          acc[3] += ((s >> 24)       ) * weight;
+
+          acc += 4;
+     }
+}
+
+static SSE2_FUNC void
+stretch_area_span_32_SSE2( u32 *dst, const u32 *acc, const int *first, const int *count, const int *weights,
+                           int width, u32 mask )
+{
+     __m128i round = _mm_set1_epi32( 64 );
+
+     while (width--) {
+          const u32 *a   = acc + *first++ * 4;
+          int        n   = *count++;
+          __m128i    sum = _mm_set1_epi32( 1 << 22 );
+
+          while (n--) {
+               /* (a + 64) >> 7 fits into 16 bits, duplicate it as the high word is zero */
+               __m128i v  = _mm_srli_epi32( _mm_add_epi32( _mm_loadu_si128( (const __m128i*) a ), round ), 7 );
+               __m128i w  = _mm_set1_epi32( *weights++ );
+               __m128i lo = _mm_mullo_epi16( v, w );
+               __m128i hi = _mm_mulhi_epu16( v, w );
+
+               /* only the even words contain the product */
+               sum = _mm_add_epi32( sum, _mm_or_si128( _mm_and_si128( lo, _mm_set1_epi32( 0xffff ) ),
+                                                       _mm_slli_epi32( hi, 16 ) ) );
+
+               a += 4;
+          }
+
+          sum = _mm_srli_epi32( sum, 23 );
+          sum = _mm_packs_epi32( sum, sum );
+
+          *dst++ = _mm_cvtsi128_si32( _mm_packus_epi16( sum, sum ) ) & mask;
+     }
+}
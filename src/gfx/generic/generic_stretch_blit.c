@@ -65,6 +65,58 @@
 
 #include "generic.h"
 
+/**********************************************************************************************************************/
+/*** Span functions ***************************************************************************************************/
+/**********************************************************************************************************************/
+
+static void
+area_line_32_C( u32 *acc, const u32 *src, int weight, int width )
+{
+     while (width--) {
+          u32 s = *src++;
+
+          acc[0] += ((s      ) & 0xff) * weight;
+          acc[1] += ((s >>  8) & 0xff) * weight;
+          acc[2] += ((s >> 16) & 0xff) * weight;
+          acc[3] += ((s >> 24)       ) * weight;
+
+          acc += 4;
+     }
+}
+
+static void
+area_span_32_C( u32 *dst, const u32 *acc, const int *first, const int *count, const int *weights, int width, u32 mask )
+{
+     while (width--) {
+          const u32 *a = acc + *first++ * 4;
+          int        n = *count++;
+          u32        b = 1 << 22;
+          u32        g = 1 << 22;
+          u32        r = 1 << 22;
+          u32        c = 1 << 22;
+
+          while (n--) {
+               int w = *weights++;
+
+               b += ((a[0] + 64) >> 7) * w;
+               g += ((a[1] + 64) >> 7) * w;
+               r += ((a[2] + 64) >> 7) * w;
+               c += ((a[3] + 64) >> 7) * w;
+
+               a += 4;
+          }
+
+          *dst++ = ((c >> 23) << 24 | (r >> 23) << 16 | (g >> 23) << 8 | (b >> 23)) & mask;
+     }
+}
+
+GenefxStretchSpans gStretchSpans = {
+     .hline_32     = NULL,
+     .vline_32     = NULL,
+     .area_line_32 = area_line_32_C,
+     .area_span_32 = area_span_32_C,
+};
+
 /**********************************************************************************************************************/
 /**********************************************************************************************************************/
 
@@ -304,6 +356,127 @@ static const StretchFunctionTable *stretch_tables[DFB_NUM_PIXELFORMATS] = {
 
 /**********************************************************************************************************************/
 
+/*
+ * Calculates the coverage of the source pixels by each destination pixel from d0 to d1,
+ * as weights normalized to 32768 per destination pixel. Returns the number of weights.
+ */
+static int
+area_weights( int src_size, int dst_size, int d0, int d1, int *first, int *count, int *weights )
+{
+     int d;
+     int n = 0;
+
+     for (d=d0; d<=d1; d++) {
+          u64 s0   = ((u64) d    * src_size << 16) / dst_size;
+          u64 s1   = ((u64)(d+1) * src_size << 16) / dst_size;
+          u64 span = s1 - s0;
+          int sum  = 0;
+          int i;
+
+          D_ASSERT( span >= 0x10000 );
+
+          *first = s0 >> 16;
+          *count = 0;
+
+          for (i=*first; ((u64) i << 16) < s1; i++) {
+               u64 a = MAX( s0, (u64) i << 16 );
+               u64 b = MIN( s1, (u64)(i+1) << 16 );
+               int w = (b - a) * 32768 / span;
+
+               weights[n++] = w;
+               sum += w;
+
+               (*count)++;
+          }
+
+          /* avoid losing the rounding error */
+          weights[n-1] += 32768 - sum;
+
+          first++;
+          count++;
+     }
+
+     return n;
+}
+
+/*
+ * Area averaging for large down scales of 32 bit formats with 8 bits per channel,
+ * where the bilinear filter would skip most of the source pixels.
+ */
+__attribute__((noinline))
+static bool
+stretch_area_32( CardState *state, DFBRectangle *srect, DFBRectangle *drect )
+{
+     GenefxState *gfxs = state->gfxs;
+     DFBRegion    clip;
+     int          cw, sx0, sw;
+     int          x, y;
+     int         *first;
+     int         *count;
+     int         *hweights;
+     int          vfirst;
+     int          vcount;
+     int         *vweights;
+     u32         *acc;
+     u8          *dst;
+     const u8    *src;
+     u32          mask = (gfxs->dst_format == DSPF_RGB32) ? 0x00ffffff : 0xffffffff;
+
+     clip = state->clip;
+
+     if (!dfb_region_rectangle_intersect( &clip, drect ))
+          return false;
+
+     dfb_region_translate( &clip, - drect->x, - drect->y );
+
+     cw = clip.x2 - clip.x1 + 1;
+
+     first = D_MALLOC( sizeof(int) * (cw * 2 + cw * (srect->w / drect->w + 2) + srect->h / drect->h + 2) +
+                       sizeof(u32) * 4 * (srect->w + 1) );
+     if (!first) {
+          D_OOM();
+          return false;
+     }
+
+     count    = first + cw;
+     hweights = count + cw;
+     vweights = hweights + cw * (srect->w / drect->w + 2);
+     acc      = (u32*)(vweights + srect->h / drect->h + 2);
+
+     area_weights( srect->w, drect->w, clip.x1, clip.x2, first, count, hweights );
+
+     /* accumulate only the source columns used by the clipped destination */
+     sx0 = first[0];
+     sw  = first[cw-1] + count[cw-1] - sx0;
+
+     for (x=0; x<cw; x++)
+          first[x] -= sx0;
+
+     dst = gfxs->dst_org[0] + (drect->y + clip.y1) * gfxs->dst_pitch + (drect->x + clip.x1) * 4;
+     src = gfxs->src_org[0] + srect->y * gfxs->src_pitch + (srect->x + sx0) * 4;
+
+     for (y=clip.y1; y<=clip.y2; y++) {
+          int i;
+
+          area_weights( srect->h, drect->h, y, y, &vfirst, &vcount, vweights );
+
+          memset( acc, 0, sizeof(u32) * 4 * sw );
+
+          for (i=0; i<vcount; i++) {
+               if (vweights[i])
+                    gStretchSpans.area_line_32( acc, (const u32*)(src + (vfirst + i) * gfxs->src_pitch), vweights[i], sw );
+          }
+
+          gStretchSpans.area_span_32( (u32*) dst, acc, first, count, hweights, cw, mask );
+
+          dst += gfxs->dst_pitch;
+     }
+
+     D_FREE( first );
+
+     return true;
+}
+
 __attribute__((noinline))
 static bool
 stretch_hvx_planar( CardState *state, DFBRectangle *srect, DFBRectangle *drect, bool down )
@@ -415,6 +588,21 @@ stretch_hvx( CardState *state, DFBRectangle *srect, DFBRectangle *drect )
      if (state->blittingflags & DSBLIT_SRC_PREMULTIPLY && !DFB_PIXELFORMAT_IS_INDEXED( gfxs->src_format ))
           return false;
 
+     if (down && !state->blittingflags && gfxs->src_format == gfxs->dst_format &&
+         (srect->w >= drect->w * 2 || srect->h >= drect->h * 2))
+     {
+          switch (gfxs->dst_format) {
+               case DSPF_ARGB:
+               case DSPF_ABGR:
+               case DSPF_AiRGB:
+               case DSPF_RGB32:
+                    return stretch_area_32( state, srect, drect );
+
+               default:
+                    break;
+          }
+     }
+
      if (DFB_PIXELFORMAT_INDEX(gfxs->dst_format) >= D_ARRAY_SIZE(stretch_tables))
           return false;
 
@@ -868,6 +1056,9 @@ void gStretchBlit( CardState *state, DFBRectangle *srect, DFBRectangle *drect )
      Bop_advance = Genefx_Bop_next;
      Aop_advance = Genefx_Aop_next;
 
+     /* Reset the steps changed below for a previous blit, the setup is kept for several blits. */
+     gfxs->Astep = gfxs->Bstep = 1;
+
      switch ((unsigned int)rotflip_blittingflags) {
           case DSBLIT_FLIP_HORIZONTAL:
                gfxs->Astep *= -1;
@@ -8,6 +8,14 @@
 #define SOURCE_TYPE_AUTO
 #endif
 
+/* the span functions handle neither color keys nor source lookups */
+#if !defined (COLOR_KEY) && !defined (KEY_PROTECT)
+#define HVX_VLINE_32
+#ifdef SOURCE_LOOKUP_AUTO
+#define HVX_HLINE_32
+#endif
+#endif
+
 #if 0
 #define HVX_DEBUG(x...)  direct_log_printf( NULL, x )
 #else
@@ -36,6 +44,11 @@
      long  ratios[cw];
      u32  *dst32;
 
+#ifdef HVX_HLINE_32
+     int   span_offsets[cw];
+     int   span_ratios[cw];
+#endif
+
 #if defined (COLOR_KEY) || defined (KEY_PROTECT)
      u32   dt;
 #endif
@@ -52,6 +65,11 @@
      for (x=0; x<cw; x++) {
           ratios[x] = POINT_TO_RATIO( point, hfraq );
 
+#ifdef HVX_HLINE_32
+          span_offsets[x] = POINT_L( point, hfraq );
+          span_ratios[x]  = ratios[x];
+#endif
+
           point += hfraq;
      }
 
@@ -84,6 +102,13 @@
                     /*
                      * Horizontal interpolation
                      */
+#ifdef HVX_HLINE_32
+                    if (gStretchSpans.hline_32) {
+                         gStretchSpans.hline_32( lbT, (const u32*) srcT, span_offsets, span_ratios, cw );
+                         gStretchSpans.hline_32( lbB, (const u32*) srcB, span_offsets, span_ratios, cw );
+                    }
+                    else
+#endif
                     for (x=0, point=point0; x<cw; x++, point += hfraq) {
                          long pl = POINT_L( point, hfraq );
                          HVX_DEBUG("%ld,%ld %lu  (%lu/%lu)   0x%x  0x%x\n", x, y, pl,
@@ -113,6 +138,11 @@
                     /*
                      * Horizontal interpolation
                      */
+#ifdef HVX_HLINE_32
+                    if (gStretchSpans.hline_32)
+                         gStretchSpans.hline_32( lbB, (const u32*) srcB, span_offsets, span_ratios, cw );
+                    else
+#endif
                     for (x=0, point=point0; x<cw; x++, point += hfraq) {
                          long pl = POINT_L( point, hfraq );
                          HVX_DEBUG("%ld,%ld %lu  (%lu/%lu)   0x%x  0x%x\n", x, y, pl,
@@ -136,6 +166,11 @@
            */
           X = LINE_TO_RATIO( line, vfraq );
 
+#ifdef HVX_VLINE_32
+          if (gStretchSpans.vline_32)
+               gStretchSpans.vline_32( dst32, lbT, lbB, X, cw, X_00FF00FF | X_FF00FF00 );
+          else
+#endif
           for (x=0; x<cw; x++) {
 #if defined (COLOR_KEY) || defined (KEY_PROTECT)
                dt = ((((((lbB[x] & X_00FF00FF) - (lbT[x] & X_00FF00FF))*X) >> SHIFT_R8) + (lbT[x] & X_00FF00FF)) & X_00FF00FF) +
@@ -162,6 +197,9 @@
      }
 }
 
+#undef HVX_VLINE_32
+#undef HVX_HLINE_32
+
 #ifdef SOURCE_LOOKUP_AUTO
 #undef SOURCE_LOOKUP_AUTO
 #undef SOURCE_LOOKUP
@@ -0,0 +1,94 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+
+
+
+
+/*
+ * Single pass blending of an ARGB source (see blend_argb_fused()).
+ *
+ * Example:
+ * #define DST_TYPE u16
+ * #define DST_ALPHA false
+ * #define DST_TO_ARGB( d ) (0xff000000 | ...)
+ * #define ARGB_TO_DST( p ) PIXEL_RGB16( ... )
+ * #define Bop_argb_OP_Aop_PFI( op ) Bop_argb_##op##_Aop_rgb16
+ * #include "template_blend_argb.h"
+ */
+
+/********************************* Bop_argb_blend_fused_Aop_PFI ***************/
+
+static __inline__ __attribute__((always_inline)) void
+Bop_argb_OP_Aop_PFI(blend_fused)( GenefxState *gfxs, const int fused )
+{
+     int                      w     = gfxs->length + 1;
+     int                      Sstep = gfxs->Bstep;
+     int                      Dstep = gfxs->Astep;
+     const u32               *S     = gfxs->Bop[0];
+     DST_TYPE                *D     = gfxs->Aop[0];
+     const GenefxAccumulator  Cacc  = gfxs->Cacc;
+
+     while (--w) {
+          u32 s = *S;
+
+          /* fully transparent source pixels leave the destination unchanged */
+          if (s >> 24)
+               *D = ARGB_TO_DST( blend_argb_fused( s, DST_TO_ARGB( *D ), &Cacc, fused, DST_ALPHA ) );
+
+          S += Sstep;
+          D += Dstep;
+     }
+}
+
+#define BLEND_FUSED_FUNC( name, fused )                                         \
+static void Bop_argb_OP_Aop_PFI(blend_##name)( GenefxState *gfxs )              \
+{                                                                               \
+     Bop_argb_OP_Aop_PFI(blend_fused)( gfxs, fused );                           \
+}
+
+BLEND_FUSED_FUNC( srcalpha,                         0 )
+BLEND_FUSED_FUNC( srcalpha_colorize,                FUSED_COLORIZE )
+BLEND_FUSED_FUNC( srcalpha_coloralpha,              FUSED_COLORALPHA )
+BLEND_FUSED_FUNC( srcalpha_colorize_coloralpha,     FUSED_COLORIZE | FUSED_COLORALPHA )
+BLEND_FUSED_FUNC( premultiply,                      FUSED_PREMULTIPLY )
+BLEND_FUSED_FUNC( premultiply_colorize,             FUSED_PREMULTIPLY | FUSED_COLORIZE )
+BLEND_FUSED_FUNC( premultiply_coloralpha,           FUSED_PREMULTIPLY | FUSED_COLORALPHA )
+BLEND_FUSED_FUNC( premultiply_colorize_coloralpha,  FUSED_PREMULTIPLY | FUSED_COLORIZE | FUSED_COLORALPHA )
+
+/******************************************************************************/
+
+#undef BLEND_FUSED_FUNC
+
+#undef DST_TYPE
+#undef DST_ALPHA
+#undef DST_TO_ARGB
+#undef ARGB_TO_DST
+#undef Bop_argb_OP_Aop_PFI
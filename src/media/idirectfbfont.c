@@ -46,6 +46,8 @@
 #include <media/idirectfbfont.h>
 #include <media/idirectfbdatabuffer.h>
 
+#include <misc/conf.h>
+
 #include "misc/util.h"
 
 
@@ -827,6 +829,63 @@ IDirectFBFont_GetDescription( IDirectFBFont      *thiz,
      return DFB_OK;
 }
 
+/*
+ * Render the glyphs of the characters in the text into the glyph cache.
+ */
+static DFBResult
+prerender_text( CoreFont              *font,
+                DFBTextEncodingID      encoding,
+                const void            *text,
+                int                    bytes,
+                DFBFontPrerenderFlags  flags )
+{
+     DFBResult     ret;
+     int           num;
+     unsigned int *indices;
+
+     indices = D_MALLOC( bytes * sizeof(unsigned int) );
+     if (!indices)
+          return D_OOM();
+
+     dfb_font_lock( font );
+
+     ret = dfb_font_decode_text( font, encoding, text, bytes, indices, &num );
+
+     dfb_font_unlock( font );
+
+     if (ret == DFB_OK)
+          ret = dfb_font_prerender( font, indices, num, (flags & DFPRF_OUTLINE) ? 2 : 1, flags & DFPRF_ASYNC );
+
+     D_FREE( indices );
+
+     return ret;
+}
+
+static DFBResult
+IDirectFBFont_Prerender( IDirectFBFont         *thiz,
+                         const void            *text,
+                         int                    bytes,
+                         DFBFontPrerenderFlags  flags )
+{
+     DIRECT_INTERFACE_GET_DATA(IDirectFBFont)
+
+     D_DEBUG_AT( Font, "%s( %p, %d, 0x%08x )\n", __FUNCTION__, thiz, bytes, flags );
+
+     if (!text || (flags & ~DFPRF_ALL))
+          return DFB_INVARG;
+
+     if ((flags & DFPRF_OUTLINE) && !(data->font->attributes & DFFA_OUTLINED))
+          return DFB_UNSUPPORTED;
+
+     if (bytes < 0)
+          bytes = strlen( text );
+
+     if (!bytes)
+          return DFB_OK;
+
+     return prerender_text( data->font, data->encoding, text, bytes, flags );
+}
+
 /**********************************************************************************************************************/
 
 DFBResult
@@ -856,6 +915,12 @@ IDirectFBFont_Construct( IDirectFBFont *thiz, CoreFont *font )
      thiz->GetGlyphExtentsXY = IDirectFBFont_GetGlyphExtentsXY;
      thiz->GetUnderline = IDirectFBFont_GetUnderline;
      thiz->GetDescription = IDirectFBFont_GetDescription;
+     thiz->Prerender = IDirectFBFont_Prerender;
+
+     /* Warm up the glyph cache with the configured characters. */
+     if (dfb_config->font_prerender && dfb_config->font_prerender[0])
+          prerender_text( font, DTEID_UTF8, dfb_config->font_prerender, strlen( dfb_config->font_prerender ),
+                          DFPRF_ASYNC | ((font->attributes & DFFA_OUTLINED) ? DFPRF_OUTLINE : DFPRF_NONE) );
 
      return DFB_OK;
 }
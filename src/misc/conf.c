@@ -123,6 +123,9 @@ static const char *config_usage_strings[]  = {
      "  [no-]sync                      Do `sync()' (default=no)\n",
 #ifdef USE_MMX
      "  [no-]mmx                       Enable mmx support\n"
+#endif
+#if defined(USE_SSE2) || defined(USE_NEON)
+     "  [no-]simd                      Enable SSE2/AVX2/NEON software rendering routines\n"
 #endif
      "  [no-]agp[=<mode>]              Enable AGP support\n"
      "  [no-]thrifty-surface-buffers   Free sysmem instance on xfer to video memory\n"
@@ -191,6 +194,12 @@ static const char *config_usage_strings[]  = {
      "  [no-]task-manager              Use experimental task manager (default: no)\n"
      "  [no-]force-frametime           Call GetFrameTime() before each Flip() automatically\n"
      "  software-cores=<num>           Set number of threads to use for software rendering\n"
+     "  software-tiles=<layout>        Split software rendering into rows, columns or blocks\n"
+     "  [no-]software-pinning          Bind each software rendering thread to one CPU (default: no)\n"
+     "  [no-]renderer-coalesce         Merge and reorder fills and blits before rendering (default: no)\n"
+     "  [no-]renderer-stats=[<ms>]     Print counters of each engine and the glyph cache periodically (default 1000)\n"
+     "  [no-]task-trace=[<events>]     Record task timestamps and dependencies in a ring buffer (default 65536)\n"
+     "  task-trace-file=<file>         Write recorded task trace as Chrome trace event JSON at shutdown\n"
      "\n",
      "  x11-borderless[=<x>.<y>]       Disable X11 window borders, optionally position window\n"
      "  [no-]matrox-sgram              Use Matrox SGRAM features\n"
@@ -214,6 +223,10 @@ static const char *config_usage_strings[]  = {
      "\n"
      "  max-font-rows=<number>         Maximum number of glyph cache rows (total for all fonts)\n"
      "  max-font-row-width=<pixels>    Maximum width of glyph cache row surface\n"
+     "  font-cache-page-rows=<number>  Rows per glyph cache page (packed atlas surface, default 8)\n"
+     "  font-run-cache=<number>        Laid out strings cached per font for DrawString (default 64, 0 disables)\n"
+     "  font-prerender=<characters>    Render these (UTF-8) characters of each new font in the background\n"
+     "  font-cache-dir=<directory>     Keep glyphs rendered by FreeType in DGIFF files for the next start\n"
      "  graphics-state-call-limit=<n>  Set FusionCall quota for graphics state object (default 5000)\n"
      "\n",
      " Window surface swapping policy:\n"
@@ -471,6 +484,7 @@ static void config_allocate( void )
      dfb_config->banner                   = true;
      dfb_config->deinit_check             = true;
      dfb_config->mmx                      = true;
+     dfb_config->simd                     = true;
      dfb_config->vt                       = true;
      dfb_config->vt_switch                = true;
      dfb_config->vt_num                   = -1;
@@ -517,8 +531,10 @@ static void config_allocate( void )
      fusion_vector_init( &dfb_config->tslib_devices, 2, NULL );
 
 
-     dfb_config->max_font_rows      = 99;
-     dfb_config->max_font_row_width = 2048;
+     dfb_config->max_font_rows        = 99;
+     dfb_config->max_font_row_width   = 2048;
+     dfb_config->font_cache_page_rows = 8;
+     dfb_config->font_run_cache       = 64;
 
      dfb_config->core_sighandler    = true;
 
@@ -966,6 +982,12 @@ DFBResult dfb_config_set( const char *name, const char *value )
      if (strcmp (name, "no-mmx" ) == 0) {
           dfb_config->mmx = false;
      } else
+     if (strcmp (name, "simd" ) == 0) {
+          dfb_config->simd = true;
+     } else
+     if (strcmp (name, "no-simd" ) == 0) {
+          dfb_config->simd = false;
+     } else
      if (strcmp (name, "agp" ) == 0) {
           if (value) {
                int mode;
@@ -1857,6 +1879,71 @@ DFBResult dfb_config_set( const char *name, const char *value )
                return DFB_INVARG;
           }
      } else
+     if (strcmp (name, "font-cache-page-rows" ) == 0) {
+          if (value) {
+               char *error;
+               unsigned long rows;
+
+               rows = strtoul( value, &error, 10 );
+
+               if (*error) {
+                    D_ERROR( "DirectFB/Config '%s': Error in value '%s'!\n", name, error );
+                    return DFB_INVARG;
+               }
+
+               if (rows < 1) {
+                    D_ERROR("DirectFB/Config '%s': Invalid value specified!\n", name);
+                    return DFB_INVARG;
+               }
+
+               dfb_config->font_cache_page_rows = rows;
+          }
+          else {
+               D_ERROR( "DirectFB/Config '%s': No value specified!\n", name );
+               return DFB_INVARG;
+          }
+     } else
+     if (strcmp (name, "font-run-cache" ) == 0) {
+          if (value) {
+               char *error;
+               unsigned long runs;
+
+               runs = strtoul( value, &error, 10 );
+
+               if (*error) {
+                    D_ERROR( "DirectFB/Config '%s': Error in value '%s'!\n", name, error );
+                    return DFB_INVARG;
+               }
+
+               dfb_config->font_run_cache = runs;
+          }
+          else {
+               D_ERROR( "DirectFB/Config '%s': No value specified!\n", name );
+               return DFB_INVARG;
+          }
+     } else
+     if (strcmp (name, "font-prerender" ) == 0) {
+          if (value) {
+               if (dfb_config->font_prerender)
+                    D_FREE( dfb_config->font_prerender );
+               dfb_config->font_prerender = D_STRDUP( value );
+          }
+          else {
+               D_ERROR( "DirectFB/Config '%s': No characters specified!\n", name );
+               return DFB_INVARG;
+          }
+     } else
+     if (strcmp (name, "font-cache-dir" ) == 0) {
+          if (value) {
+               if (dfb_config->font_cache_dir)
+                    D_FREE( dfb_config->font_cache_dir );
+               dfb_config->font_cache_dir = D_STRDUP( value );
+          }
+          else {
+               D_ERROR( "DirectFB/Config '%s': No directory name specified!\n", name );
+               return DFB_INVARG;
+          }
+     } else
      if (strcmp (name, "graphics-state-call-limit" ) == 0) {
           if (value) {
                char *error;
@@ -2091,6 +2178,90 @@ DFBResult dfb_config_set( const char *name, const char *value )
                return DFB_INVARG;
           }
      } else
+     if (strcmp (name, "software-tiles" ) == 0) {
+          if (value) {
+               if (strcmp( value, "rows" ) == 0) {
+                    dfb_config->software_tiles = DCST_ROWS;
+               } else
+               if (strcmp( value, "columns" ) == 0) {
+                    dfb_config->software_tiles = DCST_COLUMNS;
+               } else
+               if (strcmp( value, "blocks" ) == 0) {
+                    dfb_config->software_tiles = DCST_BLOCKS;
+               } else {
+                    D_ERROR( "DirectFB/Config '%s': Unknown layout '%s'!\n", name, value );
+                    return DFB_INVARG;
+               }
+          }
+          else {
+               D_ERROR("DirectFB/Config '%s': No value specified!\n", name);
+               return DFB_INVARG;
+          }
+     } else
+     if (strcmp (name, "software-pinning" ) == 0) {
+          dfb_config->software_pinning = true;
+     } else
+     if (strcmp (name, "no-software-pinning" ) == 0) {
+          dfb_config->software_pinning = false;
+     } else
+     if (strcmp (name, "renderer-coalesce" ) == 0) {
+          dfb_config->renderer_coalesce = true;
+     } else
+     if (strcmp (name, "no-renderer-coalesce" ) == 0) {
+          dfb_config->renderer_coalesce = false;
+     } else
+     if (strcmp (name, "renderer-stats" ) == 0) {
+          if (value) {
+               char *error;
+               unsigned long interval;
+
+               interval = strtoul( value, &error, 10 );
+
+               if (*error) {
+                    D_ERROR( "DirectFB/Config '%s': Error in value '%s'!\n", name, error );
+                    return DFB_INVARG;
+               }
+
+               dfb_config->renderer_stats = interval;
+          }
+          else
+               dfb_config->renderer_stats = 1000;
+     } else
+     if (strcmp (name, "no-renderer-stats" ) == 0) {
+          dfb_config->renderer_stats = 0;
+     } else
+     if (strcmp (name, "task-trace" ) == 0) {
+          if (value) {
+               char *error;
+               unsigned long events;
+
+               events = strtoul( value, &error, 10 );
+
+               if (*error) {
+                    D_ERROR( "DirectFB/Config '%s': Error in value '%s'!\n", name, error );
+                    return DFB_INVARG;
+               }
+
+               dfb_config->task_trace = events;
+          }
+          else
+               dfb_config->task_trace = 65536;
+     } else
+     if (strcmp (name, "no-task-trace" ) == 0) {
+          dfb_config->task_trace = 0;
+     } else
+     if (strcmp (name, "task-trace-file" ) == 0) {
+          if (value) {
+               if (dfb_config->task_trace_file)
+                    D_FREE( dfb_config->task_trace_file );
+
+               dfb_config->task_trace_file = D_STRDUP( value );
+          }
+          else {
+               D_ERROR( "DirectFB/Config '%s': No file name specified!\n", name );
+               return DFB_INVARG;
+          }
+     } else
      if (strcmp (name, "resource-manager" ) == 0) {
           if (value) {
                if (dfb_config->resource_manager)
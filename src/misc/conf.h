@@ -75,6 +75,12 @@ typedef enum {
      DCWF_ALL                           = 0x00000013
 } DFBConfigWarnFlags;
 
+typedef enum {
+     DCST_ROWS,                                   /* horizontal bands, one per core */
+     DCST_COLUMNS,                                /* vertical bands, one per core */
+     DCST_BLOCKS                                  /* cache sized blocks, at least one per core */
+} DFBConfigSoftwareTiles;
+
 typedef struct
 {
      bool      mouse_motion_compression;          /* use motion compression? */
@@ -94,6 +100,7 @@ typedef struct
      bool      hardware_only;                     /* disable software fallbacks */
 
      bool      mmx;                               /* mmx support */
+     bool      simd;                              /* sse2/avx2/neon support */
 
      bool      banner;                            /* startup banner */
 
@@ -265,6 +272,10 @@ typedef struct
 
      int           max_font_rows;
      int           max_font_row_width;
+     int           font_cache_page_rows;           /* rows per glyph cache page, each page counts as that many rows */
+     int           font_run_cache;                 /* laid out strings cached per font, 0 disables */
+     char         *font_prerender;                 /* characters rendered for each new font in the background */
+     char         *font_cache_dir;                 /* directory of DGIFF glyph caches written by the FT2 provider */
 
      bool          core_sighandler;
 
@@ -306,6 +317,14 @@ typedef struct
 
      bool          task_manager;
      unsigned int  software_cores;
+     DFBConfigSoftwareTiles software_tiles;
+     bool          software_pinning;              /* Bind software rendering threads to one CPU each. */
+
+     bool          renderer_coalesce;             /* Merge consecutive fills and blits with the same state. */
+     unsigned int  renderer_stats;                /* Interval in ms for printing renderer counters, 0 to disable. */
+
+     unsigned int  task_trace;                    /* Number of task events kept in the trace ring buffer, 0 to disable. */
+     char         *task_trace_file;               /* Chrome trace event JSON file written at shutdown. */
 
      DFBSurfacePixelFormat image_format;
 
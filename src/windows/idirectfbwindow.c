@@ -582,6 +582,31 @@ IDirectFBWindow_SetOpaqueRegion( IDirectFBWindow *thiz,
      return CoreWindow_SetOpaque( data->window, &region );
 }
 
+static DFBResult
+IDirectFBWindow_SetOpaqueRegions( IDirectFBWindow *thiz,
+                                  const DFBRegion *regions,
+                                  unsigned int     num_regions )
+{
+     unsigned int i;
+
+     DIRECT_INTERFACE_GET_DATA(IDirectFBWindow)
+
+     D_DEBUG_AT( IDirectFB_Window, "%s( %u )\n", __FUNCTION__, num_regions );
+
+     if (data->destroyed)
+          return DFB_DESTROYED;
+
+     if (!regions || !num_regions || num_regions > DFB_WINDOW_OPAQUE_REGIONS_MAX)
+          return DFB_INVARG;
+
+     for (i=0; i<num_regions; i++) {
+          if (regions[i].x1 > regions[i].x2 || regions[i].y1 > regions[i].y2)
+               return DFB_INVAREA;
+     }
+
+     return CoreWindow_SetOpaqueRegions( data->window, regions, num_regions );
+}
+
 static DFBResult
 IDirectFBWindow_SetOpacity( IDirectFBWindow *thiz,
                             u8               opacity )
@@ -1584,6 +1609,7 @@ IDirectFBWindow_Construct( IDirectFBWindow *thiz,
      thiz->SetGeometry = IDirectFBWindow_SetGeometry;
      thiz->SetTypeHint = IDirectFBWindow_SetTypeHint;
      thiz->ChangeHintFlags = IDirectFBWindow_ChangeHintFlags;
+     thiz->SetOpaqueRegions = IDirectFBWindow_SetOpaqueRegions;
 
      return DFB_OK;
 }
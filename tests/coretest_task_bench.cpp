@@ -0,0 +1,226 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This file is subject to the terms and conditions of the MIT License:
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation
+   files (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <directfb.h>    // include here to prevent it being included indirectly causing nested extern "C"
+
+#include <direct/Types++.h>
+
+extern "C" {
+#include <direct/atomic.h>
+#include <direct/clock.h>
+#include <direct/messages.h>
+#include <direct/thread.h>
+}
+
+#include <core/Fifo.h>
+#include <core/Task.h>
+
+
+/*
+ * Measures items per second going through the TaskManager submission queue with 1..N producer threads,
+ * first for the queue types alone, then for simple tasks going through the TaskManager.
+ */
+
+static int max_producers = 4;
+static int num_items     = 200000;
+
+/**********************************************************************************************************************/
+
+template <typename Q>
+class QueueBench
+{
+public:
+     static void *
+     producer( DirectThread *thread,
+               void         *arg )
+     {
+          Q *queue = (Q*) arg;
+
+          for (int i=0; i<num_items; i++)
+               queue->push( (DirectFB::Task*) (long) (i + 1) );
+
+          return NULL;
+     }
+
+     static void
+     run( const char *name,
+          int         producers )
+     {
+          Q             queue;
+          DirectThread *threads[producers];
+          long long     t1, t2;
+          long long     total = (long long) producers * num_items;
+
+          t1 = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
+
+          for (int i=0; i<producers; i++)
+               threads[i] = direct_thread_create( DTT_DEFAULT, producer, &queue, "Producer" );
+
+          for (long long n=0; n<total; n++)
+               queue.pull();
+
+          t2 = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
+
+          for (int i=0; i<producers; i++) {
+               direct_thread_join( threads[i] );
+               direct_thread_destroy( threads[i] );
+          }
+
+          D_INFO( "CoreTest/TaskBench: %-14s %2d producers -> %10lld items/sec\n",
+                  name, producers, total * 1000000LL / (t2 - t1 ? : 1) );
+     }
+};
+
+/**********************************************************************************************************************/
+
+static int tasks_done;
+
+static DFBResult
+task_run( void     *ctx,
+          DFB_Task *task )
+{
+     Task_Done( task );
+
+     D_SYNC_ADD( &tasks_done, 1 );
+
+     return DFB_OK;
+}
+
+static void *
+task_producer( DirectThread *thread,
+               void         *arg )
+{
+     for (int i=0; i<num_items; i++)
+          SimpleTask_Create( NULL, task_run, NULL, NULL );
+
+     return NULL;
+}
+
+static void
+run_tasks( int producers )
+{
+     DirectThread *threads[producers];
+     long long     t1, t2;
+     int           total = producers * num_items;
+
+     tasks_done = 0;
+
+     t1 = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
+
+     for (int i=0; i<producers; i++)
+          threads[i] = direct_thread_create( DTT_DEFAULT, task_producer, NULL, "Producer" );
+
+     while (*(volatile int*) &tasks_done < total)
+          direct_thread_sleep( 100 );
+
+     t2 = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
+
+     for (int i=0; i<producers; i++) {
+          direct_thread_join( threads[i] );
+          direct_thread_destroy( threads[i] );
+     }
+
+     D_INFO( "CoreTest/TaskBench: %-14s %2d producers -> %10lld tasks/sec\n",
+             "TaskManager", producers, total * 1000000LL / (t2 - t1 ? : 1) );
+}
+
+/**********************************************************************************************************************/
+
+static DFBBoolean
+parse_command_line( int argc, char *argv[] )
+{
+     for (int i=1; i<argc; i++) {
+          if (!strcmp( argv[i], "-p" ) && i + 1 < argc)
+               max_producers = atoi( argv[++i] );
+          else if (!strcmp( argv[i], "-n" ) && i + 1 < argc)
+               num_items = atoi( argv[++i] );
+          else {
+               fprintf( stderr, "Usage: %s [-p <max producers>] [-n <items per producer>]\n", argv[0] );
+               return DFB_FALSE;
+          }
+     }
+
+     return (max_producers > 0 && num_items > 0) ? DFB_TRUE : DFB_FALSE;
+}
+
+int
+main( int argc, char *argv[] )
+{
+     DFBResult  ret;
+     IDirectFB *dfb;
+
+     /* Initialize DirectFB. */
+     ret = DirectFBInit( &argc, &argv );
+     if (ret) {
+          D_DERROR( ret, "CoreTest/TaskBench: DirectFBInit() failed!\n" );
+          return ret;
+     }
+
+     if (!parse_command_line( argc, argv ))
+          return -1;
+
+     DirectFBSetOption( "task-manager", NULL );
+
+
+     for (int i=1; i<=max_producers; i++)
+          QueueBench< DirectFB::FIFO<DirectFB::Task*> >::run( "FIFO", i );
+
+     for (int i=1; i<=max_producers; i++)
+          QueueBench< DirectFB::LockFreeFIFO<DirectFB::Task*> >::run( "LockFreeFIFO", i );
+
+
+     /* Create super interface, which starts the TaskManager. */
+     ret = DirectFBCreate( &dfb );
+     if (ret) {
+          D_DERROR( ret, "CoreTest/TaskBench: DirectFBCreate() failed!\n" );
+          return ret;
+     }
+
+     for (int i=1; i<=max_producers; i++)
+          run_tasks( i );
+
+     /* Shutdown DirectFB. */
+     dfb->Release( dfb );
+
+     return 0;
+}
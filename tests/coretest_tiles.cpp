@@ -0,0 +1,131 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This file is subject to the terms and conditions of the MIT License:
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation
+   files (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <config.h>
+
+#include <directfb.h>    // include here to prevent it being included indirectly causing nested extern "C"
+
+#include <direct/Types++.h>
+
+extern "C" {
+#include <direct/messages.h>
+
+#include <misc/conf.h>
+}
+
+#include <core/Renderer.h>
+
+
+/*
+ * Checks that the tiles of each layout cover the whole destination exactly once,
+ * in particular for sizes which are not a multiple of the number of tiles.
+ */
+
+static const DFBConfigSoftwareTiles layouts[] = { DCST_ROWS, DCST_COLUMNS, DCST_BLOCKS };
+static const char                  *names[]   = { "rows", "columns", "blocks" };
+
+static const DFBDimension sizes[] = {
+     {    1,    1 }, {    7,    3 }, {    3, 1000 }, {   13,   17 }, {   63,    9 },
+     {  100,   37 }, {  333,  201 }, {  640,  480 }, { 1021,  769 }, { 1920, 1080 },
+     { 4093, 2161 }
+};
+
+static bool
+check_setup( int                    width,
+             int                    height,
+             unsigned int           cores,
+             unsigned int           layout )
+{
+     DirectFB::Graphics::Renderer::Setup setup( width, height, cores, layouts[layout] );
+
+     long long area = 0;
+
+     for (unsigned int i=0; i<setup.tiles; i++) {
+          const DFBRegion *clip = &setup.clips[i];
+
+          if (clip->x1 < 0 || clip->y1 < 0 || clip->x2 >= width || clip->y2 >= height ||
+              clip->x1 > clip->x2 || clip->y1 > clip->y2)
+          {
+               D_ERROR( "CoreTest/Tiles: %dx%d, %u cores, %s: tile %u (%d,%d-%d,%d) is empty or outside!\n",
+                        width, height, cores, names[layout], i, DFB_REGION_VALS( clip ) );
+               return false;
+          }
+
+          for (unsigned int n=0; n<i; n++) {
+               if (dfb_region_region_intersects( &setup.clips[n], clip )) {
+                    D_ERROR( "CoreTest/Tiles: %dx%d, %u cores, %s: tiles %u and %u overlap!\n",
+                             width, height, cores, names[layout], n, i );
+                    return false;
+               }
+          }
+
+          area += (long long)(clip->x2 - clip->x1 + 1) * (clip->y2 - clip->y1 + 1);
+     }
+
+     /* Without overlaps, the same area means all pixels are covered. */
+     if (area != (long long) width * height) {
+          D_ERROR( "CoreTest/Tiles: %dx%d, %u cores, %s: tiles cover %lld of %d pixels!\n",
+                   width, height, cores, names[layout], area, width * height );
+          return false;
+     }
+
+     return true;
+}
+
+int
+main( int argc, char *argv[] )
+{
+     int failed = 0;
+
+     for (unsigned int s=0; s<D_ARRAY_SIZE(sizes); s++) {
+          for (unsigned int cores=1; cores<=DirectFB::Graphics::Renderer::Setup::TILE_MAX; cores++) {
+               for (unsigned int layout=0; layout<D_ARRAY_SIZE(layouts); layout++) {
+                    if (!check_setup( sizes[s].w, sizes[s].h, cores, layout ))
+                         failed++;
+               }
+          }
+     }
+
+     if (failed) {
+          D_ERROR( "CoreTest/Tiles: %d setups failed!\n", failed );
+          return 1;
+     }
+
+     D_INFO( "CoreTest/Tiles: OK\n" );
+
+     return 0;
+}
@@ -0,0 +1,190 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This file is subject to the terms and conditions of the MIT License:
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation
+   files (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <config.h>
+
+#include <stdio.h>
+
+#include <direct/messages.h>
+
+#include <directfb.h>
+
+/*
+ * Checks that blits from a surface to itself see all operations issued before them,
+ * in particular with 'renderer-coalesce' which merges and reorders fills and blits.
+ */
+
+#define BLACK  0xff000000
+#define WHITE  0xffffffff
+
+/**********************************************************************************************************************/
+
+static u32
+get_pixel( IDirectFBSurface *surface,
+           int               x,
+           int               y )
+{
+     DFBResult  ret;
+     void      *data;
+     int        pitch;
+     u32        pixel;
+
+     ret = surface->Lock( surface, DSLF_READ, &data, &pitch );
+     if (ret) {
+          D_DERROR( ret, "DFBTest/BlitSelf: IDirectFBSurface::Lock() failed!\n" );
+          return 0;
+     }
+
+     pixel = ((u32*)((u8*) data + y * pitch))[x];
+
+     surface->Unlock( surface );
+
+     return pixel;
+}
+
+static bool
+check_pixel( IDirectFBSurface *surface,
+             int               x,
+             int               y,
+             u32               expected )
+{
+     u32 pixel = get_pixel( surface, x, y );
+
+     if (pixel != expected) {
+          D_ERROR( "DFBTest/BlitSelf: Pixel at %d,%d is 0x%08x instead of 0x%08x!\n", x, y, pixel, expected );
+          return false;
+     }
+
+     return true;
+}
+
+/**********************************************************************************************************************/
+
+/*
+ * A fill of the source area must not be merged with an earlier fill of the same state,
+ * which would move it in front of the blit.
+ */
+static bool
+test_fill_after_blit( IDirectFBSurface *surface )
+{
+     DFBRectangle rect = { 0, 0, 16, 16 };
+
+     surface->Clear( surface, 0, 0, 0, 0xff );
+
+     surface->SetColor( surface, 0xff, 0xff, 0xff, 0xff );
+     surface->FillRectangle( surface, 100, 0, 4, 4 );
+
+     surface->Blit( surface, surface, &rect, 32, 0 );
+
+     surface->FillRectangle( surface, 0, 0, 16, 16 );
+
+     return check_pixel( surface, 32, 0, BLACK ) && check_pixel( surface, 0, 0, WHITE );
+}
+
+/*
+ * A blit of the source area must not be merged with an earlier blit of the same state,
+ * which would move it in front of the fill.
+ */
+static bool
+test_blit_after_fill( IDirectFBSurface *surface )
+{
+     DFBRectangle rect = { 0, 0, 16, 16 };
+
+     surface->Clear( surface, 0, 0, 0, 0xff );
+
+     surface->Blit( surface, surface, &rect, 32, 0 );
+
+     surface->SetColor( surface, 0xff, 0xff, 0xff, 0xff );
+     surface->FillRectangle( surface, 0, 0, 16, 16 );
+
+     surface->Blit( surface, surface, &rect, 64, 0 );
+
+     return check_pixel( surface, 32, 0, BLACK ) && check_pixel( surface, 64, 0, WHITE );
+}
+
+/**********************************************************************************************************************/
+
+int
+main( int argc, char *argv[] )
+{
+     DFBResult              ret;
+     DFBSurfaceDescription  desc;
+     IDirectFB             *dfb;
+     IDirectFBSurface      *surface = NULL;
+
+     /* Initialize DirectFB. */
+     ret = DirectFBInit( &argc, &argv );
+     if (ret) {
+          D_DERROR( ret, "DFBTest/BlitSelf: DirectFBInit() failed!\n" );
+          return ret;
+     }
+
+     /* Reordering is what this test is about. */
+     DirectFBSetOption( "renderer-coalesce", NULL );
+
+     /* Create super interface. */
+     ret = DirectFBCreate( &dfb );
+     if (ret) {
+          D_DERROR( ret, "DFBTest/BlitSelf: DirectFBCreate() failed!\n" );
+          return ret;
+     }
+
+     desc.flags       = DSDESC_WIDTH | DSDESC_HEIGHT | DSDESC_PIXELFORMAT;
+     desc.width       = 128;
+     desc.height      = 16;
+     desc.pixelformat = DSPF_ARGB;
+
+     ret = dfb->CreateSurface( dfb, &desc, &surface );
+     if (ret) {
+          D_DERROR( ret, "DFBTest/BlitSelf: IDirectFB::CreateSurface() failed!\n" );
+          goto out;
+     }
+
+     if (!test_fill_after_blit( surface ) || !test_blit_after_fill( surface ))
+          ret = DFB_FAILURE;
+     else
+          D_INFO( "DFBTest/BlitSelf: OK\n" );
+
+out:
+     if (surface)
+          surface->Release( surface );
+
+     /* Shutdown DirectFB. */
+     dfb->Release( dfb );
+
+     return ret;
+}
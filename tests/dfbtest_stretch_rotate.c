@@ -0,0 +1,261 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This file is subject to the terms and conditions of the MIT License:
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation
+   files (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <config.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <direct/messages.h>
+
+#include <directfb.h>
+
+/*
+ * Checks that rotated or flipped stretch blits issued back to back give the same result
+ * as each of them rendered on its own, i.e. that no blit depends on the one before.
+ */
+
+#define SRC_W   16
+#define SRC_H    8
+#define DST_W   96
+#define DST_H   96
+
+static const DFBSurfaceBlittingFlags flags[] = {
+     DSBLIT_ROTATE90,
+     DSBLIT_ROTATE90 | DSBLIT_FLIP_HORIZONTAL,
+     DSBLIT_ROTATE90 | DSBLIT_FLIP_VERTICAL,
+     DSBLIT_ROTATE270,
+     DSBLIT_ROTATE180,
+     DSBLIT_FLIP_HORIZONTAL,
+     DSBLIT_FLIP_VERTICAL
+};
+
+static const DFBRectangle rects[] = {
+     {  0,  0, 24, 40 },
+     { 40, 30, 32, 56 }
+};
+
+/**********************************************************************************************************************/
+
+static DFBResult
+create_surface( IDirectFB         *dfb,
+                int                width,
+                int                height,
+                IDirectFBSurface **ret_surface )
+{
+     DFBSurfaceDescription desc;
+
+     desc.flags       = DSDESC_WIDTH | DSDESC_HEIGHT | DSDESC_PIXELFORMAT;
+     desc.width       = width;
+     desc.height      = height;
+     desc.pixelformat = DSPF_ARGB;
+
+     return dfb->CreateSurface( dfb, &desc, ret_surface );
+}
+
+static DFBResult
+fill_source( IDirectFBSurface *source )
+{
+     DFBResult  ret;
+     void      *data;
+     int        pitch;
+     int        x, y;
+
+     ret = source->Lock( source, DSLF_WRITE, &data, &pitch );
+     if (ret)
+          return ret;
+
+     /* Every pixel differs, so any wrong step shows up. */
+     for (y=0; y<SRC_H; y++) {
+          u32 *line = (u32*)((u8*) data + y * pitch);
+
+          for (x=0; x<SRC_W; x++)
+               line[x] = 0xff000000 | (x * 16 << 16) | (y * 32 << 8) | (x + y * SRC_W);
+     }
+
+     return source->Unlock( source );
+}
+
+/*
+ * Renders both stretch blits, waiting for the first one to finish before the second one if 'separate' is set.
+ */
+static DFBResult
+render( IDirectFBSurface        *dest,
+        IDirectFBSurface        *source,
+        DFBSurfaceBlittingFlags  blittingflags,
+        bool                     separate )
+{
+     DFBResult     ret;
+     void         *data;
+     int           pitch;
+     unsigned int  i;
+     DFBRectangle  srect = { 0, 0, SRC_W, SRC_H };
+
+     dest->Clear( dest, 0, 0, 0, 0 );
+
+     dest->SetBlittingFlags( dest, blittingflags );
+
+     for (i=0; i<D_ARRAY_SIZE(rects); i++) {
+          ret = dest->StretchBlit( dest, source, &srect, &rects[i] );
+          if (ret)
+               return ret;
+
+          if (separate) {
+               ret = dest->Lock( dest, DSLF_READ, &data, &pitch );
+               if (ret)
+                    return ret;
+
+               dest->Unlock( dest );
+          }
+     }
+
+     return DFB_OK;
+}
+
+static bool
+compare( IDirectFBSurface        *a,
+         IDirectFBSurface        *b,
+         DFBSurfaceBlittingFlags  blittingflags )
+{
+     bool  equal = true;
+     void *data_a, *data_b;
+     int   pitch_a, pitch_b;
+     int   y;
+
+     if (a->Lock( a, DSLF_READ, &data_a, &pitch_a ))
+          return false;
+
+     if (b->Lock( b, DSLF_READ, &data_b, &pitch_b )) {
+          a->Unlock( a );
+          return false;
+     }
+
+     for (y=0; y<DST_H; y++) {
+          if (memcmp( (u8*) data_a + y * pitch_a, (u8*) data_b + y * pitch_b, DST_W * 4 )) {
+               D_ERROR( "DFBTest/StretchRotate: Blitting flags 0x%08x differ in line %d!\n", blittingflags, y );
+               equal = false;
+               break;
+          }
+     }
+
+     b->Unlock( b );
+     a->Unlock( a );
+
+     return equal;
+}
+
+/**********************************************************************************************************************/
+
+int
+main( int argc, char *argv[] )
+{
+     DFBResult         ret;
+     unsigned int      i;
+     IDirectFB        *dfb;
+     IDirectFBSurface *source   = NULL;
+     IDirectFBSurface *combined = NULL;
+     IDirectFBSurface *separate = NULL;
+
+     /* Initialize DirectFB. */
+     ret = DirectFBInit( &argc, &argv );
+     if (ret) {
+          D_DERROR( ret, "DFBTest/StretchRotate: DirectFBInit() failed!\n" );
+          return ret;
+     }
+
+     /* Create super interface. */
+     ret = DirectFBCreate( &dfb );
+     if (ret) {
+          D_DERROR( ret, "DFBTest/StretchRotate: DirectFBCreate() failed!\n" );
+          return ret;
+     }
+
+     ret = create_surface( dfb, SRC_W, SRC_H, &source );
+     if (ret) {
+          D_DERROR( ret, "DFBTest/StretchRotate: IDirectFB::CreateSurface() failed!\n" );
+          goto out;
+     }
+
+     ret = create_surface( dfb, DST_W, DST_H, &combined );
+     if (ret) {
+          D_DERROR( ret, "DFBTest/StretchRotate: IDirectFB::CreateSurface() failed!\n" );
+          goto out;
+     }
+
+     ret = create_surface( dfb, DST_W, DST_H, &separate );
+     if (ret) {
+          D_DERROR( ret, "DFBTest/StretchRotate: IDirectFB::CreateSurface() failed!\n" );
+          goto out;
+     }
+
+     ret = fill_source( source );
+     if (ret) {
+          D_DERROR( ret, "DFBTest/StretchRotate: Could not fill source!\n" );
+          goto out;
+     }
+
+     for (i=0; i<D_ARRAY_SIZE(flags); i++) {
+          ret = render( combined, source, flags[i], false );
+          if (!ret)
+               ret = render( separate, source, flags[i], true );
+          if (ret) {
+               D_DERROR( ret, "DFBTest/StretchRotate: StretchBlit() failed!\n" );
+               goto out;
+          }
+
+          if (!compare( combined, separate, flags[i] ))
+               ret = DFB_FAILURE;
+     }
+
+     if (!ret)
+          D_INFO( "DFBTest/StretchRotate: OK\n" );
+
+out:
+     if (separate)
+          separate->Release( separate );
+
+     if (combined)
+          combined->Release( combined );
+
+     if (source)
+          source->Release( source );
+
+     /* Shutdown DirectFB. */
+     dfb->Release( dfb );
+
+     return ret;
+}
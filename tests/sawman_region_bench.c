@@ -0,0 +1,520 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This file is subject to the terms and conditions of the MIT License:
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation
+   files (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <directfb.h>
+
+#include <direct/messages.h>
+#include <direct/util.h>
+
+#include <misc/conf.h>
+
+#include "region.h"
+
+
+static int num_windows = 32;
+static int num_updates = 100000;
+static int seed        = 23;
+
+/**********************************************************************************************************************/
+
+static int parse_cmdline ( int argc, char *argv[] );
+static int show_usage    ( void );
+
+/**********************************************************************************************************************/
+
+#define SCREEN_WIDTH        1920
+#define SCREEN_HEIGHT       1080
+
+#define UPDATES_PER_REPAINT 4
+
+typedef struct {
+     misc_box_t bounds;
+     bool       visible;
+     bool       translucent;
+     misc_box_t opaque;         /* opaque region of translucent windows, empty if none */
+} Window;
+
+static Window    **windows;
+static misc_box_t *updates;
+
+static void
+generate_stack( void )
+{
+     int i;
+
+     srand( seed );
+
+     windows = calloc( num_windows, sizeof(Window*) );
+     updates = calloc( num_updates, sizeof(misc_box_t) );
+
+     /* separate allocations like the window structures in the layout vector,
+        larger windows at the bottom, smaller ones on top */
+     for (i=0; i<num_windows; i++) {
+          Window *window = calloc( 1, sizeof(Window) );
+          int     w      = 64 + rand() % (1 + SCREEN_WIDTH  * (num_windows - i) / num_windows);
+          int     h      = 64 + rand() % (1 + SCREEN_HEIGHT * (num_windows - i) / num_windows);
+
+          window->bounds.x1   = rand() % SCREEN_WIDTH  - w / 2;
+          window->bounds.y1   = rand() % SCREEN_HEIGHT - h / 2;
+          window->bounds.x2   = window->bounds.x1 + w;
+          window->bounds.y2   = window->bounds.y1 + h;
+          window->visible     = (rand() % 8) != 0;
+          window->translucent = !(rand() % 3);
+
+          /* panels with blended decorations around opaque content */
+          if (window->translucent && (rand() % 2)) {
+               window->opaque.x1 = window->bounds.x1 + 16;
+               window->opaque.y1 = window->bounds.y1 + 16;
+               window->opaque.x2 = window->bounds.x2 - 16;
+               window->opaque.y2 = window->bounds.y2 - 16;
+          }
+
+          windows[i] = window;
+     }
+
+     for (i=0; i<num_updates; i++) {
+          int w = 16 + rand() % 400;
+          int h = 16 + rand() % 300;
+
+          updates[i].x1 = rand() % (SCREEN_WIDTH  - w);
+          updates[i].y1 = rand() % (SCREEN_HEIGHT - h);
+          updates[i].x2 = updates[i].x1 + w;
+          updates[i].y2 = updates[i].y1 + h;
+     }
+}
+
+/**********************************************************************************************************************/
+
+/*
+ * Splits the box along the stack like update_region4_r() does, counting the resulting fragments.
+ */
+
+static int
+find_linear( int               start,
+             const misc_box_t *box )
+{
+     int i;
+
+     for (i=start; i>=0; i--) {
+          const Window *window = windows[i];
+
+          if (window->visible &&
+              window->bounds.x1 < box->x2 && box->x1 < window->bounds.x2 &&
+              window->bounds.y1 < box->y2 && box->y1 < window->bounds.y2)
+               return i;
+     }
+
+     return -1;
+}
+
+static int
+split( const misc_boxes_t *boxes,
+       int                 start,
+       misc_box_t          box )
+{
+     int        i;
+     int        num = 0;
+     misc_box_t in;
+
+     i = boxes ? misc_boxes_find_last( boxes, start, &box ) : find_linear( start, &box );
+     if (i < 0)
+          return 1;
+
+     in.x1 = MAX( box.x1, windows[i]->bounds.x1 );
+     in.y1 = MAX( box.y1, windows[i]->bounds.y1 );
+     in.x2 = MIN( box.x2, windows[i]->bounds.x2 );
+     in.y2 = MIN( box.y2, windows[i]->bounds.y2 );
+
+     if (box.x1 != in.x1)
+          num += split( boxes, i - 1, (misc_box_t) { box.x1, in.y1, in.x1, in.y2 } );
+
+     if (box.y1 != in.y1)
+          num += split( boxes, i - 1, (misc_box_t) { box.x1, box.y1, box.x2, in.y1 } );
+
+     if (box.x2 != in.x2)
+          num += split( boxes, i - 1, (misc_box_t) { in.x2, in.y1, box.x2, in.y2 } );
+
+     if (box.y2 != in.y2)
+          num += split( boxes, i - 1, (misc_box_t) { box.x1, in.y2, box.x2, box.y2 } );
+
+     if (windows[i]->translucent)
+          num += split( boxes, i - 1, in );
+     else
+          num++;
+
+     return num;
+}
+
+static void
+bench_search( const char *name,
+              bool        use_boxes,
+              bool        simd )
+{
+     int                 i, n;
+     long long           fragments = 0;
+     DirectClock         clock;
+     misc_region_arena_t arena;
+     misc_boxes_t        boxes;
+
+     misc_region_arena_init( &arena, NULL, 0 );
+
+     dfb_config->simd = simd;
+
+     direct_clock_start( &clock );
+
+     for (n=0; n<num_updates; n++) {
+          /* rebuilt for every few updates like in repaint_tier() */
+          if (use_boxes && !(n % UPDATES_PER_REPAINT)) {
+               misc_region_arena_reset( &arena );
+
+               misc_boxes_init( &boxes, &arena, num_windows );
+
+               for (i=0; i<num_windows; i++)
+                    misc_boxes_set( &boxes, i, windows[i]->visible ? &windows[i]->bounds : NULL );
+          }
+
+          fragments += split( use_boxes ? &boxes : NULL, num_windows - 1, updates[n] );
+     }
+
+     direct_clock_stop( &clock );
+
+     D_INFO( "SaWMan/Region: %-16s %lld.%03lld sec (%lld fragments, %s)\n", name,
+             DIRECT_CLOCK_DIFF_SEC_MS( &clock ), fragments, (use_boxes && boxes.simd) ? "simd" : "scalar" );
+
+     misc_region_arena_deinit( &arena );
+}
+
+/**********************************************************************************************************************/
+
+/*
+ * Region operations of update_region2(), with heap or arena allocations.
+ */
+
+static void
+bench_regions( const char *name,
+               bool        use_arena )
+{
+     int                 i, n;
+     long long           rects = 0;
+     DirectClock         clock;
+     misc_region_arena_t arena;
+     long                buffer[1024];
+
+     misc_region_arena_init( &arena, buffer, sizeof(buffer) );
+
+     direct_clock_start( &clock );
+
+     for (n=0; n<num_updates; n++) {
+          misc_region_t dirty;
+
+          if (use_arena) {
+               misc_region_arena_reset( &arena );
+
+               misc_region_init_with_extents_in_arena( &dirty, &arena, &updates[n] );
+          }
+          else
+               misc_region_init_with_extents( &dirty, NULL, &updates[n] );
+
+          for (i=num_windows-1; i>=0; i--) {
+               misc_region_t visible;
+               misc_region_t render;
+               misc_region_t opt;
+
+               if (!windows[i]->visible)
+                    continue;
+
+               if (use_arena) {
+                    misc_region_init_boxes_in_arena( &visible, &arena, &windows[i]->bounds, 1 );
+                    misc_region_init_with_extents_in_arena( &render, &arena, &updates[n] );
+                    misc_region_init_in_arena( &opt, &arena );
+               }
+               else {
+                    misc_region_init_boxes( &visible, NULL, &windows[i]->bounds, 1 );
+                    misc_region_init_with_extents( &render, NULL, &updates[n] );
+                    misc_region_init( &opt, NULL );
+               }
+
+               misc_region_intersect( &render, &visible, &render );
+               misc_region_intersect( &opt, &render, &dirty );
+
+               rects += misc_region_n_rects( &opt );
+
+               if (!windows[i]->translucent)
+                    misc_region_subtract( &dirty, &dirty, &render );
+
+               misc_region_deinit( &opt );
+               misc_region_deinit( &render );
+               misc_region_deinit( &visible );
+          }
+
+          rects += misc_region_n_rects( &dirty );
+
+          misc_region_deinit( &dirty );
+     }
+
+     direct_clock_stop( &clock );
+
+     D_INFO( "SaWMan/Region: %-16s %lld.%03lld sec (%lld rectangles)\n", name,
+             DIRECT_CLOCK_DIFF_SEC_MS( &clock ), rects );
+
+     misc_region_arena_deinit( &arena );
+}
+
+/**********************************************************************************************************************/
+
+/*
+ * Front to back occlusion map like update_region5(), counting blended and copied pixels.
+ */
+
+static void
+bench_occlusion( const char *name,
+                 bool        use_opaque )
+{
+     int                 i, n;
+     long long           blended = 0;
+     long long           copied  = 0;
+     long long           cleared = 0;
+     DirectClock         clock;
+     misc_region_arena_t arena;
+     long                buffer[1024];
+
+     misc_region_arena_init( &arena, buffer, sizeof(buffer) );
+
+     direct_clock_start( &clock );
+
+     for (n=0; n<num_updates; n++) {
+          misc_region_t covered;
+          misc_region_t clear;
+
+          misc_region_arena_reset( &arena );
+
+          misc_region_init_in_arena( &covered, &arena );
+
+          for (i=num_windows-1; i>=0; i--) {
+               const Window *window = windows[i];
+               misc_box_t    box;
+               misc_region_t draw;
+               misc_region_t opaque;
+
+               box.x1 = MAX( updates[n].x1, window->bounds.x1 );
+               box.y1 = MAX( updates[n].y1, window->bounds.y1 );
+               box.x2 = MIN( updates[n].x2, window->bounds.x2 );
+               box.y2 = MIN( updates[n].y2, window->bounds.y2 );
+
+               if (!window->visible || box.x1 >= box.x2 || box.y1 >= box.y2)
+                    continue;
+
+               misc_region_init_with_extents_in_arena( &draw, &arena, &box );
+               misc_region_subtract( &draw, &draw, &covered );
+
+               if (misc_region_is_empty( &draw ))
+                    continue;
+
+               misc_region_init_in_arena( &opaque, &arena );
+
+               if (!window->translucent)
+                    misc_region_copy( &opaque, &draw );
+               else if (use_opaque && window->opaque.x1 < window->opaque.x2 && window->opaque.y1 < window->opaque.y2) {
+                    misc_region_t region;
+
+                    misc_region_init_boxes_in_arena( &region, &arena, &window->opaque, 1 );
+                    misc_region_intersect( &opaque, &draw, &region );
+               }
+
+               misc_region_union( &covered, &covered, &opaque );
+               misc_region_subtract( &draw, &draw, &opaque );
+
+               copied  += misc_region_n_pixels( &opaque );
+               blended += misc_region_n_pixels( &draw );
+
+               if (misc_region_contains_rectangle( &covered, &updates[n] ) == MISC_REGION_IN)
+                    break;
+          }
+
+          misc_region_init_with_extents_in_arena( &clear, &arena, &updates[n] );
+          misc_region_subtract( &clear, &clear, &covered );
+
+          cleared += misc_region_n_pixels( &clear );
+     }
+
+     direct_clock_stop( &clock );
+
+     D_INFO( "SaWMan/Region: %-16s %lld.%03lld sec (%lld blended, %lld copied, %lld background pixels)\n", name,
+             DIRECT_CLOCK_DIFF_SEC_MS( &clock ), blended, copied, cleared );
+
+     misc_region_arena_deinit( &arena );
+}
+
+/**********************************************************************************************************************/
+
+/*
+ * Intersection of the union of all windows with each update, clipping box by box, scalar or SIMD.
+ */
+
+static void
+bench_clip( const char *name,
+            bool        simd )
+{
+     int                 i, n;
+     long long           pixels = 0;
+     DirectClock         clock;
+     misc_region_t       windows_region;
+
+     dfb_config->simd = simd;
+
+     misc_region_init( &windows_region, NULL );
+
+     for (i=0; i<num_windows; i++) {
+          misc_region_t region;
+
+          if (!windows[i]->visible)
+               continue;
+
+          misc_region_init_boxes( &region, NULL, &windows[i]->bounds, 1 );
+          misc_region_union( &windows_region, &windows_region, &region );
+          misc_region_deinit( &region );
+     }
+
+     direct_clock_start( &clock );
+
+     for (n=0; n<num_updates; n++) {
+          misc_region_t render;
+
+          misc_region_init_with_extents( &render, NULL, &updates[n] );
+          misc_region_intersect( &render, &windows_region, &render );
+
+          pixels += misc_region_n_pixels( &render );
+
+          misc_region_deinit( &render );
+     }
+
+     direct_clock_stop( &clock );
+
+     D_INFO( "SaWMan/Region: %-16s %lld.%03lld sec (%d boxes, %lld pixels)\n", name,
+             DIRECT_CLOCK_DIFF_SEC_MS( &clock ), misc_region_n_rects( &windows_region ), pixels );
+
+     misc_region_deinit( &windows_region );
+}
+
+/**********************************************************************************************************************/
+
+int
+main( int argc, char *argv[] )
+{
+     int       i;
+     DFBResult ret;
+
+     ret = DirectFBInit( &argc, &argv );
+     if (ret) {
+          D_DERROR( ret, "SaWMan/Region: DirectFBInit() failed!\n" );
+          return ret;
+     }
+
+     if (parse_cmdline( argc, argv ))
+          return -1;
+
+     generate_stack();
+
+     D_INFO( "SaWMan/Region: %d windows, %d updates\n", num_windows, num_updates );
+
+     bench_search( "search linear", false, false );
+     bench_search( "search scalar", true, false );
+     bench_search( "search simd", true, true );
+
+     bench_clip( "clip scalar", false );
+     bench_clip( "clip simd", true );
+
+     bench_regions( "regions heap", false );
+     bench_regions( "regions arena", true );
+
+     bench_occlusion( "occlusion window", false );
+     bench_occlusion( "occlusion opaque", true );
+
+     for (i=0; i<num_windows; i++)
+          free( windows[i] );
+
+     free( updates );
+     free( windows );
+
+     return 0;
+}
+
+/**********************************************************************************************************************/
+
+static int
+parse_cmdline( int argc, char *argv[] )
+{
+     int i;
+
+     for (i=1; i<argc; i++) {
+          if (!strcmp( argv[i], "-w" ) && i + 1 < argc)
+               num_windows = atoi( argv[++i] );
+          else if (!strcmp( argv[i], "-u" ) && i + 1 < argc)
+               num_updates = atoi( argv[++i] );
+          else if (!strcmp( argv[i], "-s" ) && i + 1 < argc)
+               seed = atoi( argv[++i] );
+          else
+               return show_usage();
+     }
+
+     if (num_windows < 1 || num_updates < 1)
+          return show_usage();
+
+     return 0;
+}
+
+static int
+show_usage( void )
+{
+     fprintf( stderr, "\n"
+                      "Usage:\n"
+                      "   sawman_region_bench [options]\n"
+                      "\n"
+                      "Options:\n"
+                      "   -w <num>  Number of windows in the stack (default 32)\n"
+                      "   -u <num>  Number of updates (default 100000)\n"
+                      "   -s <num>  Random seed (default 23)\n"
+                      "\n"
+              );
+
+     return -1;
+}
@@ -0,0 +1,331 @@
+#include <config.h>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <direct/direct.h>
+#include <direct/mem.h>
+#include <direct/messages.h>
+#include <direct/thread.h>
+
+#include <voodoo/conf.h>
+#include <voodoo/link.h>
+
+
+/*
+ * Loopback test of the shared memory link (voodoo option 'link-shm')
+ *
+ * The client sends requests with a header and a pattern, the server thread checks them and replies with the
+ * inverted pattern. Request sizes are not a divisor of the ring size, so head and tail wrap around at varying
+ * positions, and the last request is larger than the ring, so both sides have to wait while the ring is full.
+ */
+
+#define UNIX_PATH_MAX    108
+
+#define RING_SIZE        (1024 * 1024)     /* SHM_RING_SIZE in link_unix.c */
+
+#define NUM_REQUESTS     2000
+#define MAX_REQUEST      20000
+#define WINDOW           16                /* requests in flight, replies must fit into the ring */
+#define LARGE_REQUEST    (RING_SIZE * 3 + 12345)
+
+typedef struct {
+     u32 serial;
+     u32 length;   /* 0 terminates the server */
+} Header;
+
+typedef struct {
+     VoodooLink *link;
+     bool        ok;   /* set by the server thread after the terminating request */
+} Server;
+
+/**********************************************************************************************************************/
+
+static u8
+pattern( u32 serial,
+         u32 offset )
+{
+     return (u8)(serial * 31 + offset * 7 + (offset >> 8));
+}
+
+static void
+fill( u8 *buf, u32 serial, u32 length, bool invert )
+{
+     u32 i;
+
+     for (i=0; i<length; i++)
+          buf[i] = invert ? ~pattern( serial, i ) : pattern( serial, i );
+}
+
+static bool
+check( const u8 *buf, u32 serial, u32 length, bool invert )
+{
+     u32 i;
+
+     for (i=0; i<length; i++) {
+          if (buf[i] != (u8)(invert ? ~pattern( serial, i ) : pattern( serial, i ))) {
+               D_ERROR( "Voodoo/Test: Mismatch in %s %u at offset %u of %u!\n",
+                        invert ? "reply" : "request", serial, i, length );
+               return false;
+          }
+     }
+
+     return true;
+}
+
+static u32
+request_length( u32 serial )
+{
+     return (serial * 7919) % MAX_REQUEST + 1;
+}
+
+static bool
+read_all( VoodooLink *link, void *buf, size_t length )
+{
+     size_t done = 0;
+
+     while (done < length) {
+          ssize_t ret = link->Read( link, (u8*) buf + done, length - done );
+
+          if (ret <= 0) {
+               D_ERROR( "Voodoo/Test: Read failed after %zu of %zu bytes!\n", done, length );
+               return false;
+          }
+
+          done += ret;
+     }
+
+     return true;
+}
+
+static bool
+write_all( VoodooLink *link, const void *buf, size_t length )
+{
+     if (link->Write( link, buf, length ) != (ssize_t) length) {
+          D_ERROR( "Voodoo/Test: Write of %zu bytes failed!\n", length );
+          return false;
+     }
+
+     return true;
+}
+
+/**********************************************************************************************************************/
+
+static void *
+server_main( DirectThread *thread, void *arg )
+{
+     Server     *server = arg;    /* closes the link when done */
+     VoodooLink *link   = server->link;
+     u8         *buf    = D_MALLOC( LARGE_REQUEST );
+
+     if (!buf) {
+          D_OOM();
+          link->Close( link );
+          return NULL;
+     }
+
+     while (true) {
+          Header header;
+
+          if (!read_all( link, &header, sizeof(header) ))
+               break;
+
+          if (!header.length) {
+               server->ok = true;
+               break;
+          }
+
+          if (header.length > LARGE_REQUEST) {
+               D_ERROR( "Voodoo/Test: Invalid request length %u!\n", header.length );
+               break;
+          }
+
+          if (!read_all( link, buf, header.length ) || !check( buf, header.serial, header.length, false ))
+               break;
+
+          fill( buf, header.serial, header.length, true );
+
+          if (!write_all( link, &header, sizeof(header) ) || !write_all( link, buf, header.length ))
+               break;
+     }
+
+     D_FREE( buf );
+
+     /* On failure, closing makes the client's reads and writes fail */
+     link->Close( link );
+
+     return NULL;
+}
+
+/**********************************************************************************************************************/
+
+static bool
+client_request( VoodooLink *link, u8 *buf, u32 serial, u32 length )
+{
+     Header header = { serial, length };
+
+     fill( buf, serial, length, false );
+
+     return write_all( link, &header, sizeof(header) ) && write_all( link, buf, length );
+}
+
+static bool
+client_reply( VoodooLink *link, u8 *buf, u32 serial, u32 length )
+{
+     Header header;
+
+     if (!read_all( link, &header, sizeof(header) ))
+          return false;
+
+     if (header.serial != serial || header.length != length) {
+          D_ERROR( "Voodoo/Test: Got reply %u (%u bytes), expected %u (%u bytes)!\n",
+                   header.serial, header.length, serial, length );
+          return false;
+     }
+
+     return read_all( link, buf, length ) && check( buf, serial, length, true );
+}
+
+static bool
+run_client( VoodooLink *link )
+{
+     u32  serial;
+     u8  *buf = D_MALLOC( LARGE_REQUEST );
+     bool ok  = true;
+
+     if (!buf) {
+          D_OOM();
+          return false;
+     }
+
+     /* Pipelined requests of odd sizes */
+     for (serial=1; ok && serial<=NUM_REQUESTS; serial += WINDOW) {
+          u32 i;
+
+          for (i=0; ok && i<WINDOW; i++)
+               ok = client_request( link, buf, serial + i, request_length( serial + i ) );
+
+          for (i=0; ok && i<WINDOW; i++)
+               ok = client_reply( link, buf, serial + i, request_length( serial + i ) );
+     }
+
+     /* Request and reply larger than the ring */
+     if (ok)
+          ok = client_request( link, buf, serial, LARGE_REQUEST ) && client_reply( link, buf, serial, LARGE_REQUEST );
+
+     /* Terminate the server */
+     if (ok) {
+          Header header = { 0, 0 };
+
+          ok = write_all( link, &header, sizeof(header) );
+     }
+
+     D_FREE( buf );
+
+     return ok;
+}
+
+/**********************************************************************************************************************/
+
+int
+main( int argc, char *argv[] )
+{
+     DirectResult        ret;
+     int                 lfd, cfd;
+     int                 fds[2];
+     char                path[64];
+     struct sockaddr_un  addr;
+     VoodooLink          client;
+     VoodooLink          server_link;
+     Server              server;
+     DirectThread       *thread;
+     bool                ok;
+
+     direct_initialize();
+
+     voodoo_config->link_shm = true;
+
+     /* Listen on an abstract socket, connecting is queued before accepting */
+     lfd = socket( PF_UNIX, SOCK_STREAM, 0 );
+     if (lfd < 0) {
+          D_PERROR( "Voodoo/Test: Could not create socket!\n" );
+          return 1;
+     }
+
+     snprintf( path, sizeof(path), "VoodooLinkShm.%d", getpid() );
+
+     memset( &addr, 0, sizeof(addr) );
+
+     addr.sun_family = AF_UNIX;
+
+     snprintf( addr.sun_path + 1, UNIX_PATH_MAX - 1, "%s", path );
+
+     if (bind( lfd, (struct sockaddr*) &addr, strlen(addr.sun_path+1)+1 + sizeof(addr.sun_family) ) || listen( lfd, 1 )) {
+          D_PERROR( "Voodoo/Test: Could not bind() or listen()!\n" );
+          close( lfd );
+          return 1;
+     }
+
+     ret = voodoo_link_init_local( &client, path, false );
+     if (ret) {
+          D_DERROR( ret, "Voodoo/Test: voodoo_link_init_local() failed!\n" );
+          close( lfd );
+          return 1;
+     }
+
+     if (!(client.code & VOODOO_LINK_CODE_SHM)) {
+          D_ERROR( "Voodoo/Test: Client did not set up shared memory!\n" );
+          client.Close( &client );
+          close( lfd );
+          return 1;
+     }
+
+     cfd = accept( lfd, NULL, NULL );
+
+     close( lfd );
+
+     if (cfd < 0) {
+          D_PERROR( "Voodoo/Test: Could not accept()!\n" );
+          client.Close( &client );
+          return 1;
+     }
+
+     fds[0] = fds[1] = cfd;
+
+     server.link = &server_link;
+     server.ok   = false;
+
+     ret = voodoo_link_init_fd( &server_link, fds );
+     if (ret) {
+          D_DERROR( ret, "Voodoo/Test: voodoo_link_init_fd() failed!\n" );
+          client.Close( &client );
+          return 1;
+     }
+
+     thread = direct_thread_create( DTT_DEFAULT, server_main, &server, "Voodoo Server" );
+
+     ok = run_client( &client );
+
+     /* On failure, closing the client makes the server's reads fail */
+     if (!ok)
+          client.Close( &client );
+
+     direct_thread_join( thread );
+     direct_thread_destroy( thread );
+
+     if (ok) {
+          ok = server.ok;
+
+          client.Close( &client );
+     }
+
+     direct_shutdown();
+
+     printf( "%s\n", ok ? "OK" : "FAILED" );
+
+     return ok ? 0 : 1;
+}
@@ -697,4 +697,3 @@ enum_graphics( void )
 
      printf( "\n" );
 }
-
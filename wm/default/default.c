@@ -1386,6 +1386,97 @@ update_region( CoreWindowStack *stack,
           draw_background( stack, state, &region );
 }
 
+/**************************************************************************************************/
+
+/*
+ * Using the damage history of the region, the back buffer is brought up to date by repainting
+ * everything that changed since it has been shown, instead of copying back after each flip.
+ */
+static inline bool
+use_damage_history( StackData *data )
+{
+     CoreLayerRegion *region = data->region;
+
+     D_ASSERT( region != NULL );
+
+     if (dfb_config->wm_fullscreen_updates || data->stack->rotation || (region->config.options & DLOP_STEREO))
+          return false;
+
+     return region->config.buffermode == DLBM_BACKVIDEO || region->config.buffermode == DLBM_TRIPLE;
+}
+
+static void
+repair_back_buffer( CoreWindowStack *stack,
+                    StackData       *data,
+                    WMData          *wmdata )
+{
+     int          i;
+     DFBRegion    regions[16];
+     DFBUpdates   damage;
+     CardState   *state   = &wmdata->state;
+     CoreSurface *surface = data->surface;
+
+     if (!use_damage_history( data ))
+          return;
+
+     /* With triple buffering the back buffer is repaired by the first update of a frame only. */
+     if (data->region->config.buffermode == DLBM_TRIPLE && data->updating.num_regions)
+          return;
+
+     dfb_updates_init( &damage, regions, D_ARRAY_SIZE(regions) );
+
+     if (dfb_layer_region_get_damage( data->region, &damage )) {
+          dfb_updates_reset( &damage );
+          dfb_updates_add_rect( &damage, 0, 0, surface->config.size.w, surface->config.size.h );
+     }
+
+     D_DEBUG_AT( WM_Default, "  -> repairing %d region(s) of the back buffer\n", damage.num_regions );
+
+     /* Set destination. */
+     state->destination  = surface;
+     state->modified    |= SMF_DESTINATION;
+
+     for (i=0; i<damage.num_regions; i++) {
+          DFBRegion dest = damage.regions[i];
+
+          if (!dfb_region_intersect( &dest, 0, 0, surface->config.size.w - 1, surface->config.size.h - 1 ))
+               continue;
+
+          D_DEBUG_AT( WM_Default, "    -> %4d,%4d - %4dx%4d  [%d]\n", DFB_RECTANGLE_VALS_FROM_REGION( &dest ), i );
+
+          /* Set clipping region. */
+          dfb_state_set_clip( state, &dest );
+
+          /* Compose damaged region. */
+          update_region( stack, data, state,
+                         fusion_vector_size( &data->windows ) - 1,
+                         DFB_REGION_VALS( &dest ) );
+
+          /* Redraw the cursor as shown in the front buffer. */
+          if (data->cursor_drawn && dfb_region_region_intersect( &dest, &data->cursor_region )) {
+               CoreGraphicsStateClient_Flush( &wmdata->client, 0, CGSCFF_NONE );
+
+               dfb_gfx_copy_regions_client( surface, CSBR_BACK, DSSE_LEFT, data->cursor_bs, CSBR_BACK, DSSE_LEFT, &dest, 1,
+                                            - data->cursor_region.x1, - data->cursor_region.y1, &wmdata->client );
+
+               /* Set destination. */
+               state->destination  = surface;
+               state->modified    |= SMF_DESTINATION;
+
+               /* Set clipping region. */
+               dfb_state_set_clip( state, &dest );
+
+               draw_cursor( stack, data, state, &data->cursor_region );
+          }
+     }
+
+     /* Reset destination. */
+     state->destination  = NULL;
+     state->modified    |= SMF_DESTINATION;
+
+     CoreGraphicsStateClient_Flush( &wmdata->client, 0, CGSCFF_NONE );
+}
+
 /**************************************************************************************************/
 /**************************************************************************************************/
 
@@ -1429,7 +1520,7 @@ defaultwm_surface_display_notify( void     *ctx,
                                                            data->updated.regions, data->updated.num_regions, 0, 0, &wmdata->client );
                          }
                     }
-                    else {
+                    else if (!use_damage_history( data )) {
                          /* Copy back the updated region. */
                          if (data->updated.num_regions) {
                               D_DEBUG_AT( WM_Default, "  -> copying %d updated regions (F->I) (left)\n", data->updated.num_regions );
@@ -1550,7 +1641,7 @@ flush_updating( StackData *data )
           dfb_layer_region_flip_update( data->region, &data->updated.bounding, DSFLIP_ONSYNC | DSFLIP_SWAP );
 
 
-     if (left_num_regions) {
+     if (left_num_regions && !use_damage_history( data )) {
           D_DEBUG_AT( WM_Default, "  -> copying %d updated regions (F->B)\n", left_num_regions );
 
           for (i=0; i<left_num_regions; i++) {
@@ -1597,6 +1688,9 @@ repaint_stack( CoreWindowStack     *stack,
 
      fusion_skirmish_prevail( &wmdata->update_skirmish );
 
+     /* Repaint what the back buffer is missing. */
+     repair_back_buffer( stack, data, wmdata );
+
      /* Set destination. */
      state->destination  = surface;
      state->modified    |= SMF_DESTINATION;
@@ -1657,6 +1751,10 @@ repaint_stack( CoreWindowStack     *stack,
 
      CoreGraphicsStateClient_Flush( &wmdata->client, 0, CGSCFF_NONE );
 
+     /* Record the actual damage for the flip. */
+     if (use_damage_history( data ))
+          dfb_layer_region_add_damage( region, flips, num_flips );
+
 
      switch (region->config.buffermode) {
           case DLBM_TRIPLE:
@@ -1682,7 +1780,7 @@ repaint_stack( CoreWindowStack     *stack,
 
                /* Copy back the updated region. */
 
-               if (!dfb_config->wm_fullscreen_updates)
+               if (!dfb_config->wm_fullscreen_updates && !use_damage_history( data ))
                     dfb_gfx_copy_regions_client( region->surface, CSBR_FRONT, DSSE_LEFT, region->surface, CSBR_BACK, DSSE_LEFT, updates, num_updates, 0, 0, &wmdata->client );
 
                break;
@@ -2291,8 +2389,7 @@ set_window_bounds( CoreWindow *window,
      new_region.x2 = width  - 1;
      new_region.y2 = height - 1;
 
-     if (!dfb_region_region_intersect( &window->config.opaque, &new_region ))
-          window->config.opaque = new_region;
+     dfb_window_clip_opaque_regions( &window->config );
 
      /* Update exposed area. */
      if (VISIBLE_WINDOW( window )) {
@@ -4125,8 +4222,12 @@ wm_set_window_config( CoreWindow             *window,
      if (flags & CWCF_COLOR_KEY)
           window->config.color_key = config->color_key;
 
-     if (flags & CWCF_OPAQUE)
-          window->config.opaque = config->opaque;
+     if (flags & CWCF_OPAQUE) {
+          window->config.opaque             = config->opaque;
+          window->config.num_opaque_regions = config->num_opaque_regions;
+
+          direct_memcpy( window->config.opaque_regions, config->opaque_regions, sizeof(config->opaque_regions) );
+     }
 
      if (flags & CWCF_OPACITY && !config->opacity)
           set_opacity( window, window_data, wm_data, config->opacity );
@@ -4543,6 +4644,10 @@ wm_update_cursor( CoreWindowStack       *stack,
           data->cursor_drawn = false;
      }
 
+     /* Repaint what the back buffer is missing. */
+     if (data->active)
+          repair_back_buffer( stack, data, wmdata );
+
      if (flags & CCUF_SIZE) {
           DFBDimension size = stack->cursor.size;
 
@@ -4634,6 +4739,10 @@ wm_update_cursor( CoreWindowStack       *stack,
           updates[updates_count++] = old_dest;
 
      if (updates_count) {
+          /* Record the actual damage for the flip. */
+          if (use_damage_history( data ))
+               dfb_layer_region_add_damage( primary, updates, updates_count );
+
           switch (primary->config.buffermode) {
                case DLBM_TRIPLE:
                     /* Add the updated region .*/
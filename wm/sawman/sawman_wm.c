@@ -497,8 +497,7 @@ set_window_bounds( SaWMan       *sawman,
      new_region.x2 = width  - 1;
      new_region.y2 = height - 1;
 
-     if (!dfb_region_region_intersect( &window->config.opaque, &new_region ))
-          window->config.opaque = new_region;
+     dfb_window_clip_opaque_regions( &window->config );
 
      /* Update exposed area. */
      if (SAWMAN_VISIBLE_WINDOW( window ) && (sawwin->flags & SWMWF_INSERTED)) {
@@ -1462,7 +1461,7 @@ sawman_surface_reaction( const void *msg_data,
                                                                           tier->right.updated.regions, tier->right.updated.num_regions, 0, 0, &wmdata->client );
                                         }
                                    }
-                                   else {
+                                   else if (!sawman_use_damage_history( tier )) {
                                         /* Copy back the updated region. */
                                         if (tier->left.updated.num_regions) {
                                              D_DEBUG_AT( SaWMan_Surface, "  -> copying %d updated regions (F->I) (left)\n", tier->left.updated.num_regions );
@@ -2875,8 +2874,12 @@ wm_set_window_config( CoreWindow             *window,
      if (flags & CWCF_COLOR_KEY)
           window->config.color_key = config->color_key;
 
-     if (flags & CWCF_OPAQUE)
-          window->config.opaque = config->opaque;
+     if (flags & CWCF_OPAQUE) {
+          window->config.opaque             = config->opaque;
+          window->config.num_opaque_regions = MIN( config->num_opaque_regions, DFB_WINDOW_OPAQUE_REGIONS_MAX );
+
+          direct_memcpy( window->config.opaque_regions, config->opaque_regions, sizeof(config->opaque_regions) );
+     }
 
      if (flags & CWCF_OPACITY && !config->opacity)
           sawman_set_opacity( sawman, sawwin, config->opacity );
@@ -4237,6 +4240,10 @@ wm_update_cursor( CoreWindowStack       *stack,
           tier->cursor_drawn = false;
      }
 
+     /* Repaint what the back buffer is missing. */
+     if (tier->active)
+          sawman_repair_back_buffer( sawman, tier, wmdata );
+
      if (flags & CCUF_SIZE) {
           D_DEBUG_AT( SaWMan_Cursor, "  -> resize\n" );
 
@@ -4329,6 +4336,10 @@ wm_update_cursor( CoreWindowStack       *stack,
      D_DEBUG_AT( SaWMan_Cursor, "  -> %d updates\n", updates_count );
 
      if (updates_count) {
+          /* Record the actual damage for the flip. */
+          if (sawman_use_damage_history( tier ))
+               dfb_layer_region_add_damage( primary, updates, updates_count );
+
           switch (primary->config.buffermode) {
                case DLBM_TRIPLE:
                     /* Add the updated region .*/